@@ -0,0 +1,225 @@
+/*
+ asset_archive.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ The game's graphics and font, packed into one file.
+*/
+
+#include <cstring>
+
+#include "asset_archive.h"
+#include "trace.h"
+
+static unsigned long long read_le(const unsigned char *data, int bytes)
+{
+	unsigned long long value = 0;
+	
+	for(int byte = 0; byte < bytes; byte++)
+	{
+		value |= (unsigned long long)data[byte] << (byte * 8);
+	}
+	
+	return value;
+}
+
+Asset_Archive::Asset_Archive()
+{
+	entry_count = 0;
+}
+
+bool Asset_Archive::open(const char *path)
+{
+	Trace_Zone zone("open_asset_archive", TRACE_IO);
+	
+	close();
+	
+	if(!file.open(path, true))
+	{
+		return false;
+	}
+	
+	const unsigned char *data = file.get_data();
+	long long size = file.get_size();
+	
+	if(size < ASSET_ARCHIVE_HEADER_SIZE || memcmp(data, ASSET_ARCHIVE_MAGIC, 4) != 0
+	   || read_le(data + 4, 2) != ASSET_ARCHIVE_VERSION || read_le(data + 6, 2) != ASSET_ENTRY_SIZE)
+	{
+		file.close();
+		return false;
+	}
+	
+	long long count = read_le(data + 8, 4);
+	
+	if(count * ASSET_ENTRY_SIZE > size - ASSET_ARCHIVE_HEADER_SIZE)
+	{
+		file.close();
+		return false;
+	}
+	
+	entry_count = (int)count;
+	
+	// Check every entry up front, so a damaged archive is ignored as a
+	// whole rather than failing an image at a time.
+	Asset_Entry asset;
+	
+	for(int entry = 0; entry < entry_count; entry++)
+	{
+		if(!read_entry(entry, asset))
+		{
+			close();
+			return false;
+		}
+	}
+	
+	return true;
+}
+
+void Asset_Archive::close()
+{
+	file.close();
+	entry_count = 0;
+}
+
+bool Asset_Archive::is_open()
+{
+	return file.is_open();
+}
+
+int Asset_Archive::get_count()
+{
+	return entry_count;
+}
+
+bool Asset_Archive::read_entry(int entry, Asset_Entry &asset)
+{
+	if(entry < 0 || entry >= entry_count)
+	{
+		return false;
+	}
+	
+	const unsigned char *data = file.get_data() + ASSET_ARCHIVE_HEADER_SIZE + entry * ASSET_ENTRY_SIZE;
+	const char *name = (const char *)data;
+	
+	if(memchr(name, 0, ASSET_NAME_SIZE) == NULL)
+	{
+		return false;
+	}
+	
+	asset.name = name;
+	data += ASSET_NAME_SIZE;
+	
+	asset.kind = (asset_kind)read_le(data, 4);
+	asset.width = (int)read_le(data + 4, 4);
+	asset.height = (int)read_le(data + 8, 4);
+	asset.pitch = (int)read_le(data + 12, 4);
+	
+	const unsigned int one = 1;
+	bool big_endian = *(const unsigned char *)&one == 0;
+	
+	for(int mask = 0; mask < 4; mask++)
+	{
+		unsigned int value = (unsigned int)read_le(data + 16 + mask * 4, 4);
+		
+		// The masks are for pixels read little-endian. Read big-endian,
+		// the same bytes are the other way round.
+		if(big_endian)
+		{
+			value = (value >> 24) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) | (value << 24);
+		}
+		
+		asset.masks[mask] = value;
+	}
+	
+	asset.offset = (long long)read_le(data + 32, 8);
+	asset.size = (long long)read_le(data + 40, 8);
+	
+	if(asset.offset < 0 || asset.size < 0 || asset.offset > file.get_size()
+	   || asset.size > file.get_size() - asset.offset)
+	{
+		return false;
+	}
+	
+	if(asset.kind == ASSET_IMAGE)
+	{
+		if(asset.width <= 0 || asset.height <= 0 || asset.pitch < asset.width * 4
+		   || (long long)asset.pitch * asset.height > asset.size || asset.offset % 4 != 0)
+		{
+			return false;
+		}
+	}
+	else if(asset.kind != ASSET_FILE)
+	{
+		return false;
+	}
+	
+	return true;
+}
+
+int Asset_Archive::find(const std::string &name)
+{
+	const unsigned char *index = file.get_data() + ASSET_ARCHIVE_HEADER_SIZE;
+	int low = 0;
+	int high = entry_count;
+	
+	while(low < high)
+	{
+		int middle = (low + high) / 2;
+		int order = strcmp((const char *)index + middle * ASSET_ENTRY_SIZE, name.c_str());
+		
+		if(order == 0)
+		{
+			return middle;
+		}
+		else if(order < 0)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+	
+	return -1;
+}
+
+bool Asset_Archive::get_asset(const std::string &name, Asset_Entry &asset)
+{
+	return read_entry(find(name), asset);
+}
+
+bool Asset_Archive::get_asset(int entry, Asset_Entry &asset)
+{
+	return read_entry(entry, asset);
+}
+
+unsigned char *Asset_Archive::get_data(const Asset_Entry &asset)
+{
+	if(!is_open())
+	{
+		return NULL;
+	}
+	
+	return file.get_writable_data() + asset.offset;
+}
+
+Asset_Archive *get_asset_archive()
+{
+	static Asset_Archive archive;
+	return &archive;
+}
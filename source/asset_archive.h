@@ -0,0 +1,119 @@
+/*
+ asset_archive.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ The game's graphics and font, packed into one file.
+
+ tools/pack_assets.cpp decodes every PNG ahead of time into 32-bit
+ pixels, in the order the screen keeps them, and packs them with the
+ font behind an index. The game maps the archive once when it starts,
+ and each image is a surface made around its pixels where they lie in
+ the mapping: nothing is read, decoded or copied until it's drawn.
+ Anything missing from the archive, or the whole archive if there
+ isn't one, is loaded from its own file as before.
+
+ This only reads the archive; load_image() and open_font() in
+ asset_preloader.cpp make surfaces and fonts from it.
+*/
+
+#ifndef ASSET_ARCHIVE
+#define ASSET_ARCHIVE
+
+#include <string>
+
+#include "mapped_file.h"
+
+const char ASSET_ARCHIVE_FILE[] = "assets.pak";
+
+// The file. All little-endian:
+//	"MPAK"
+//	uint16 version, uint16 size of an index entry
+//	uint32 number of entries, uint32 unused
+// then the index, sorted by name, each entry:
+//	the asset's path, as it is in the source directory, padded with
+//	zeros to ASSET_NAME_SIZE bytes
+//	uint32 kind (asset_kind)
+//	uint32 width, uint32 height, uint32 bytes per row
+//	uint32 red, green, blue and alpha masks
+//	uint64 offset of the data from the start of the file
+//	uint64 size of the data
+// then the data, each asset's starting on an ASSET_ALIGNMENT boundary.
+// Images are 32 bits a pixel, the masks saying which bits are which
+// when a pixel is read as a little-endian number; anything else is the
+// file as it was.
+const char ASSET_ARCHIVE_MAGIC[4] = { 'M', 'P', 'A', 'K' };
+const int ASSET_ARCHIVE_VERSION = 1;
+const int ASSET_ARCHIVE_HEADER_SIZE = 16;
+const int ASSET_NAME_SIZE = 64;
+const int ASSET_ENTRY_SIZE = ASSET_NAME_SIZE + 48;
+const int ASSET_ALIGNMENT = 16;
+
+enum asset_kind
+{
+	ASSET_FILE = 0,
+	ASSET_IMAGE = 1
+};
+
+struct Asset_Entry
+{
+	std::string name;
+	asset_kind kind;
+	int width;
+	int height;
+	int pitch;
+	unsigned int masks[4];	// Red, green, blue and alpha, for this machine.
+	long long offset;
+	long long size;
+};
+
+class Asset_Archive
+{
+	private:
+		// Mapped copy-on-write, as SDL wants surfaces' pixels writable.
+		Mapped_File file;
+		int entry_count;
+		
+		// Fills in an index entry. Returns false if there's no such entry.
+		bool read_entry(int entry, Asset_Entry &asset);
+		
+		// The index entry named, or -1.
+		int find(const std::string &name);
+		
+	public:
+		Asset_Archive();
+		
+		// Map an archive. Returns false, and leaves every asset to be
+		// loaded from its own file, if it's missing or isn't valid.
+		bool open(const char *path);
+		void close();
+		
+		bool is_open();
+		int get_count();
+		
+		// Looks up an asset by its path, e.g. "graphics/hud/hud.png".
+		bool get_asset(const std::string &name, Asset_Entry &asset);
+		bool get_asset(int entry, Asset_Entry &asset);
+		
+		// The asset's data in the mapping. NULL if no archive is open.
+		unsigned char *get_data(const Asset_Entry &asset);
+};
+
+// The archive the game's assets come from.
+Asset_Archive *get_asset_archive();
+
+#endif
@@ -0,0 +1,348 @@
+/*
+ asset_preloader.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Loads the game's images on a thread of its own, ahead of the screens
+ that show them.
+*/
+
+#include <dirent.h>
+
+#include "SDL/SDL.h"
+#include "SDL_image/SDL_image.h"
+#include "SDL_ttf/SDL_ttf.h"
+
+#include "asset_preloader.h"
+#include "asset_archive.h"
+#include "trace.h"
+
+// SDL_image isn't safe to call from two threads at once, so the PNGs
+// the loading thread and the game's thread decode take turns.
+static std::mutex decode_mutex;
+
+static const int PAGE_SIZE = 4096;
+
+// An image from the archive, or decoded from its file. If page_in is
+// set, an image from the archive has every page of its pixels read, so
+// they're in memory before it's first drawn.
+static SDL_Surface *read_image(const std::string &name, bool page_in, bool &from_archive)
+{
+	Asset_Archive *archive = get_asset_archive();
+	Asset_Entry asset;
+	
+	if(archive->get_asset(name, asset) && asset.kind == ASSET_IMAGE)
+	{
+		from_archive = true;
+		unsigned char *pixels = archive->get_data(asset);
+		
+		if(page_in)
+		{
+			volatile unsigned char touched = 0;
+			
+			for(long long byte = 0; byte < asset.size; byte += PAGE_SIZE)
+			{
+				touched += pixels[byte];
+			}
+		}
+		
+		return SDL_CreateRGBSurfaceFrom(pixels, asset.width, asset.height, 32, asset.pitch,
+		                                asset.masks[0], asset.masks[1], asset.masks[2], asset.masks[3]);
+	}
+	
+	from_archive = false;
+	
+	Trace_Zone zone("decode_image", TRACE_IO);
+	std::lock_guard<std::mutex> lock(decode_mutex);
+	
+	return IMG_Load(("./" + name).c_str());
+}
+
+Asset_Preloader::Asset_Preloader()
+{
+	next_order = 0;
+	stopping = false;
+	
+	images_loaded = 0;
+	images_waited_for = 0;
+	
+	loader = std::thread(&Asset_Preloader::loader_loop, this);
+}
+
+Asset_Preloader::~Asset_Preloader()
+{
+	stop();
+}
+
+std::map<std::string, Asset_Preloader::Preload_Entry>::iterator Asset_Preloader::find_next()
+{
+	std::map<std::string, Preload_Entry>::iterator found = entries.end();
+	
+	for(std::map<std::string, Preload_Entry>::iterator entry = entries.begin(); entry != entries.end(); entry++)
+	{
+		if(entry->second.state != PRELOAD_QUEUED)
+		{
+			continue;
+		}
+		
+		if(found == entries.end() || entry->second.priority < found->second.priority
+		   || (entry->second.priority == found->second.priority && entry->second.order < found->second.order))
+		{
+			found = entry;
+		}
+	}
+	
+	return found;
+}
+
+void Asset_Preloader::loader_loop()
+{
+	std::unique_lock<std::mutex> lock(entry_mutex);
+	
+	while(!stopping)
+	{
+		std::map<std::string, Preload_Entry>::iterator next = find_next();
+		
+		if(next == entries.end())
+		{
+			entry_condition.wait(lock);
+			continue;
+		}
+		
+		// Entries are never removed, so this stays valid unlocked.
+		Preload_Entry &entry = next->second;
+		std::string name = next->first;
+		entry.state = PRELOAD_LOADING;
+		
+		lock.unlock();
+		
+		bool from_archive;
+		SDL_Surface *surface;
+		
+		{
+			Trace_Zone zone("preload_image", TRACE_IO);
+			surface = read_image(name, true, from_archive);
+		}
+		
+		lock.lock();
+		
+		entry.surface = surface;
+		entry.from_archive = from_archive;
+		entry.state = PRELOAD_LOADED;
+		images_loaded++;
+		entry_condition.notify_all();
+	}
+}
+
+void Asset_Preloader::preload(const std::string &name, preload_priority priority)
+{
+	std::unique_lock<std::mutex> lock(entry_mutex);
+	
+	std::map<std::string, Preload_Entry>::iterator found = entries.find(name);
+	
+	if(found == entries.end())
+	{
+		Preload_Entry &entry = entries[name];
+		entry.state = PRELOAD_QUEUED;
+		entry.priority = priority;
+		entry.order = next_order++;
+		entry.surface = NULL;
+		entry.from_archive = false;
+	}
+	else if(found->second.state == PRELOAD_QUEUED && priority < found->second.priority)
+	{
+		found->second.priority = priority;
+	}
+	else
+	{
+		return;
+	}
+	
+	entry_condition.notify_all();
+}
+
+void Asset_Preloader::preload_directory(const std::string &directory, preload_priority priority)
+{
+	Asset_Archive *archive = get_asset_archive();
+	
+	// Whatever the archive holds is loaded from it, so that's where to look.
+	if(archive->is_open())
+	{
+		Asset_Entry asset;
+		
+		for(int entry = 0; entry < archive->get_count(); entry++)
+		{
+			if(archive->get_asset(entry, asset) && asset.kind == ASSET_IMAGE
+			   && asset.name.compare(0, directory.size(), directory) == 0
+			   && asset.name.find('/', directory.size()) == std::string::npos)
+			{
+				preload(asset.name, priority);
+			}
+		}
+		
+		return;
+	}
+	
+	DIR *dir = opendir(("./" + directory).c_str());
+	
+	if(dir == NULL)
+	{
+		return;
+	}
+	
+	while(struct dirent *item = readdir(dir))
+	{
+		std::string file = item->d_name;
+		
+		if(file[0] != '.' && file.size() > 4 && file.compare(file.size() - 4, 4, ".png") == 0)
+		{
+			preload(directory + file, priority);
+		}
+	}
+	
+	closedir(dir);
+}
+
+SDL_Surface *Asset_Preloader::take(const std::string &name)
+{
+	std::unique_lock<std::mutex> lock(entry_mutex);
+	
+	std::map<std::string, Preload_Entry>::iterator found = entries.find(name);
+	
+	if(found == entries.end())
+	{
+		return NULL;
+	}
+	
+	Preload_Entry &entry = found->second;
+	
+	if(entry.state == PRELOAD_QUEUED)
+	{
+		// Not started yet, so there's no sense waiting for it.
+		entry.state = PRELOAD_LOADING;
+		lock.unlock();
+		
+		bool from_archive;
+		SDL_Surface *surface = read_image(name, false, from_archive);
+		
+		lock.lock();
+		entry.surface = surface;
+		entry.from_archive = from_archive;
+		entry.state = PRELOAD_LOADED;
+	}
+	else if(entry.state == PRELOAD_LOADING)
+	{
+		Trace_Zone zone("wait_for_preload", TRACE_IO);
+		images_waited_for++;
+		
+		while(entry.state == PRELOAD_LOADING)
+		{
+			entry_condition.wait(lock);
+		}
+	}
+	
+	if(entry.state == PRELOAD_LOADED)
+	{
+		// Converted once here, rather than on every blit. The archive's
+		// pixels are in the screen's format already.
+		if(entry.surface != NULL && !entry.from_archive)
+		{
+			SDL_Surface *finished = SDL_DisplayFormatAlpha(entry.surface);
+			
+			if(finished != NULL)
+			{
+				SDL_FreeSurface(entry.surface);
+				entry.surface = finished;
+			}
+		}
+		
+		entry.state = PRELOAD_READY;
+	}
+	
+	if(entry.surface == NULL)
+	{
+		return NULL;
+	}
+	
+	// Shared: the caller's SDL_FreeSurface only drops its reference.
+	entry.surface->refcount++;
+	return entry.surface;
+}
+
+void Asset_Preloader::stop()
+{
+	{
+		std::unique_lock<std::mutex> lock(entry_mutex);
+		stopping = true;
+		entry_condition.notify_all();
+	}
+	
+	if(loader.joinable())
+	{
+		loader.join();
+	}
+}
+
+int Asset_Preloader::get_images_loaded()
+{
+	std::unique_lock<std::mutex> lock(entry_mutex);
+	
+	return images_loaded;
+}
+
+int Asset_Preloader::get_images_waited_for()
+{
+	std::unique_lock<std::mutex> lock(entry_mutex);
+	
+	return images_waited_for;
+}
+
+Asset_Preloader *get_asset_preloader()
+{
+	static Asset_Preloader preloader;
+	
+	return &preloader;
+}
+
+SDL_Surface *load_image(const std::string &name)
+{
+	SDL_Surface *surface = get_asset_preloader()->take(name);
+	
+	if(surface != NULL)
+	{
+		return surface;
+	}
+	
+	bool from_archive;
+	
+	return read_image(name, false, from_archive);
+}
+
+TTF_Font *open_font(const std::string &name, int size)
+{
+	Asset_Archive *archive = get_asset_archive();
+	Asset_Entry asset;
+	
+	if(archive->get_asset(name, asset) && asset.kind == ASSET_FILE)
+	{
+		// Closing the font frees the SDL_RWops but not the data, which
+		// stays in the archive.
+		return TTF_OpenFontRW(SDL_RWFromConstMem(archive->get_data(asset), (int)asset.size), 1, size);
+	}
+	
+	return TTF_OpenFont(("./" + name).c_str(), size);
+}
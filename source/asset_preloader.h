@@ -0,0 +1,137 @@
+/*
+ asset_preloader.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Loads the game's images on a thread of its own, ahead of the screens
+ that show them.
+
+ A screen, or the town for the buildings the player might go into
+ next, asks for a directory of images to be preloaded, at a priority.
+ The loading thread takes the most wanted image first and makes it a
+ surface: from the asset archive by paging its pixels in, otherwise by
+ decoding its PNG. When a screen calls load_image for it, the game's
+ thread finishes it into the screen's format (SDL wants that done
+ where the video is), and the preloaded surface is shared with the
+ screen rather than loaded again. One that's still loading is waited
+ for, and one that hasn't been started is loaded there and then.
+
+ Preloaded images are kept once loaded, so going back into a building
+ costs nothing. Everything together is a few tens of megabytes.
+*/
+
+#ifndef ASSET_PRELOADER
+#define ASSET_PRELOADER
+
+#include <string>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "SDL/SDL.h"
+#include "SDL_ttf/SDL_ttf.h"
+
+// Most wanted first.
+enum preload_priority
+{
+	PRELOAD_NEXT,		// Shown next, or as good as.
+	PRELOAD_LIKELY,		// Somewhere the player might well go.
+	PRELOAD_IDLE		// Anything else, while there's nothing better to do.
+};
+
+// Where a preloaded image is.
+enum preload_state
+{
+	PRELOAD_QUEUED,
+	PRELOAD_LOADING,
+	PRELOAD_LOADED,		// Loaded, waiting to be finished by the game's thread.
+	PRELOAD_READY		// Finished; handed out from here on.
+};
+
+class Asset_Preloader
+{
+	private:
+		struct Preload_Entry
+		{
+			preload_state state;
+			preload_priority priority;
+			int order;					// Equal priorities load in the order asked for.
+			SDL_Surface *surface;		// NULL if it couldn't be loaded.
+			bool from_archive;			// Already in the screen's format.
+		};
+		
+		// Every image asked for, by its path.
+		std::map<std::string, Preload_Entry> entries;
+		int next_order;
+		
+		// Guards everything above and the counts below. Never held
+		// while an image is loaded.
+		std::mutex entry_mutex;
+		std::condition_variable entry_condition;
+		
+		bool stopping;
+		
+		int images_loaded;
+		int images_waited_for;
+		
+		std::thread loader;
+		
+		void loader_loop();
+		
+		// The queued entry to load next, or entries.end(). Called with
+		// entry_mutex held.
+		std::map<std::string, Preload_Entry>::iterator find_next();
+		
+	public:
+		Asset_Preloader();
+		~Asset_Preloader();
+		
+		// Preload an image, or raise the priority of one already queued.
+		void preload(const std::string &name, preload_priority priority);
+		
+		// Preload every image in a directory, e.g. "graphics/bank/",
+		// but not those in directories under it.
+		void preload_directory(const std::string &directory, preload_priority priority);
+		
+		// The preloaded image, finished and shared with the caller, who
+		// frees it with SDL_FreeSurface as usual. NULL if it wasn't
+		// asked for, or couldn't be loaded. Only called by the game's
+		// thread.
+		SDL_Surface *take(const std::string &name);
+		
+		// Stop loading, leaving whatever's been loaded.
+		void stop();
+		
+		int get_images_loaded();
+		
+		// How many times the game had to wait for an image being loaded.
+		int get_images_waited_for();
+};
+
+// The preloader the game's screens load through.
+Asset_Preloader *get_asset_preloader();
+
+// Loads an image or a font by its path in the source directory, e.g.
+// "graphics/hud/hud.png": a preloaded image if there is one, otherwise
+// from the asset archive if it's there (see asset_archive.h) and from
+// its own file if not. An image from the archive is drawn straight from
+// the archive's pixels.
+SDL_Surface *load_image(const std::string &name);
+TTF_Font *open_font(const std::string &name, int size);
+
+#endif
@@ -0,0 +1,547 @@
+/*
+ autopilot.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Walks and digs the player to a target area of the mine.
+*/
+
+#include <cstring>		// For memset.
+#include <climits>
+
+#include "autopilot.h"
+#include "classes.h"
+#include "game_events.h"
+#include "trace.h"
+
+Autopilot::Autopilot()
+{
+	memset(search_stamp, 0, sizeof(search_stamp));
+	search_number = 0;
+	heap_size = 0;
+
+	route_start = 0;
+	route_length = 0;
+	route_step = 0;
+	route_cost = 0;
+
+	active = false;
+	target_x = 0;
+	target_y = 0;
+	target_width = 0;
+	target_height = 0;
+
+	stuck = 0;
+}
+
+// Lower scores first. Of equal scores, the one further from the start
+// is likely closer to the target.
+bool Autopilot::heap_less(int a, int b)
+{
+	int tile_a = heap[a];
+	int tile_b = heap[b];
+
+	if(score[tile_a] != score[tile_b])
+	{
+		return score[tile_a] < score[tile_b];
+	}
+
+	return cost[tile_a] > cost[tile_b];
+}
+
+void Autopilot::heap_swap(int a, int b)
+{
+	int tile = heap[a];
+	heap[a] = heap[b];
+	heap[b] = tile;
+
+	heap_position[heap[a]] = a;
+	heap_position[heap[b]] = b;
+}
+
+void Autopilot::heap_up(int position)
+{
+	while(position > 0)
+	{
+		int above = (position - 1) / 2;
+
+		if(!heap_less(position, above))
+		{
+			break;
+		}
+
+		heap_swap(position, above);
+		position = above;
+	}
+}
+
+void Autopilot::heap_down(int position)
+{
+	while(true)
+	{
+		int smallest = position;
+		int left = position * 2 + 1;
+		int right = left + 1;
+
+		if(left < heap_size && heap_less(left, smallest))
+		{
+			smallest = left;
+		}
+
+		if(right < heap_size && heap_less(right, smallest))
+		{
+			smallest = right;
+		}
+
+		if(smallest == position)
+		{
+			break;
+		}
+
+		heap_swap(position, smallest);
+		position = smallest;
+	}
+}
+
+void Autopilot::heap_push(int tile)
+{
+	heap[heap_size] = tile;
+	heap_position[tile] = heap_size;
+	heap_size++;
+
+	heap_up(heap_size - 1);
+}
+
+int Autopilot::heap_pop()
+{
+	int tile = heap[0];
+
+	heap_size--;
+
+	if(heap_size > 0)
+	{
+		heap[0] = heap[heap_size];
+		heap_position[heap[0]] = 0;
+		heap_down(0);
+	}
+
+	heap_position[tile] = -1;
+
+	return tile;
+}
+
+// Every step costs at least a turn, so the distance in turns never
+// overestimates.
+int Autopilot::estimate(int x, int y)
+{
+	int distance_x = 0;
+	int distance_y = 0;
+
+	if(x < target_x)
+	{
+		distance_x = target_x - x;
+	}
+	else if(x >= target_x + target_width)
+	{
+		distance_x = x - (target_x + target_width - 1);
+	}
+
+	if(y < target_y)
+	{
+		distance_y = target_y - y;
+	}
+	else if(y >= target_y + target_height)
+	{
+		distance_y = y - (target_y + target_height - 1);
+	}
+
+	return (distance_x + distance_y) * AUTOPILOT_TURN_COST;
+}
+
+// Follows PlayerData::change_location. Tiles that cost a turn to clear
+// before they can be walked on (granite, water) are counted as one step.
+int Autopilot::step_cost(PlayerData *player, MineData *mine, const unsigned char *tiles,
+						 int from_x, int from_y, int to_x, int to_y)
+{
+	if(to_x < 0 || to_y < 0 || to_x >= mine->get_map_x() || to_y >= mine->get_map_y())
+	{
+		return -1;
+	}
+
+	unsigned char tile = tiles[mine->get_index(to_x, to_y)];
+	materials contents = (materials)(tile & TILE_MATERIAL_MASK);
+
+	// Anything the player hasn't seen is priced as dirt.
+	if(!(tile & TILE_EXPLORED))
+	{
+		if(player->get_has_shovel())
+		{
+			return SHOVEL_DIG_COST + AUTOPILOT_TURN_COST;
+		}
+
+		return DIG_COST + AUTOPILOT_TURN_COST;
+	}
+
+	if(contents == GRANITE)
+	{
+		if(player->get_has_axe())
+		{
+			return GRANITE_DIG_COST + AUTOPILOT_TURN_COST;
+		}
+
+		return -1;
+	}
+	else if(contents == WATER)
+	{
+		if(player->get_has_bucket())
+		{
+			return BUCKET_COST + AUTOPILOT_TURN_COST;
+		}
+
+		return -1;
+	}
+	// A known spring or cave-in hurts the player every time.
+	else if(contents == SPRING || contents == CAVE_IN)
+	{
+		return -1;
+	}
+	// The shaft can only be travelled in the elevator, which costs a
+	// dollar a level on the way down.
+	else if(contents == SHAFT)
+	{
+		if(from_x != 0)
+		{
+			return -1;
+		}
+
+		if(to_y > from_y)
+		{
+			return 1 + AUTOPILOT_TURN_COST;
+		}
+	}
+
+	return AUTOPILOT_TURN_COST;
+}
+
+bool Autopilot::in_target(int x, int y)
+{
+	return x >= target_x && x < target_x + target_width
+		&& y >= target_y && y < target_y + target_height;
+}
+
+// Head for an area of the mine.
+bool Autopilot::set_target(PlayerData *player, MineData *mine, int x, int y, int width, int height)
+{
+	// Keep the area within the part of the mine the player can move in.
+	int right = x + width;
+	int bottom = y + height;
+
+	if(x < 0)
+	{
+		x = 0;
+	}
+
+	if(y < 0)
+	{
+		y = 0;
+	}
+
+	if(right > mine->get_map_x())
+	{
+		right = mine->get_map_x();
+	}
+
+	if(bottom > mine->get_map_y())
+	{
+		bottom = mine->get_map_y();
+	}
+
+	target_x = x;
+	target_y = y;
+	target_width = right - x;
+	target_height = bottom - y;
+
+	active = true;
+	stuck = 0;
+
+	if(target_width <= 0 || target_height <= 0 || !plan(player, mine))
+	{
+		active = false;
+		player->send_event(Game_Event(EVENT_AUTOPILOT_NO_ROUTE, x, y));
+		return false;
+	}
+
+	if(route_length == 0)
+	{
+		active = false;
+		player->send_event(Game_Event(EVENT_AUTOPILOT_ARRIVED, player->get_location_x(), player->get_location_y()));
+		return true;
+	}
+
+	player->send_event(Game_Event(EVENT_AUTOPILOT_ROUTE, target_x, target_y, NOTHING, route_length, route_cost));
+
+	return true;
+}
+
+bool Autopilot::head_for_tip(PlayerData *player, MineData *mine)
+{
+	if(!player->get_has_tip())
+	{
+		player->send_event(Game_Event(EVENT_AUTOPILOT_NO_TIP));
+		return false;
+	}
+
+	return set_target(player, mine, player->get_tip_x(), player->get_tip_y(),
+					  player->get_tip_width(), player->get_tip_height());
+}
+
+bool Autopilot::head_for_elevator(PlayerData *player, MineData *mine)
+{
+	for(int y = 0; y < mine->get_map_y(); y++)
+	{
+		if(mine->get_contents(0, y) == ELEVATOR)
+		{
+			return set_target(player, mine, 0, y, 1, 1);
+		}
+	}
+
+	player->send_event(Game_Event(EVENT_AUTOPILOT_NO_ROUTE));
+
+	return false;
+}
+
+// Plan the route from where the player is now.
+bool Autopilot::plan(PlayerData *player, MineData *mine)
+{
+	Trace_Zone zone("autopilot_plan", TRACE_LOGIC);
+
+	int start_x = player->get_location_x();
+	int start_y = player->get_location_y();
+
+	route_length = 0;
+	route_step = 0;
+	route_cost = 0;
+
+	if(start_x < 0 || start_y < 0 || start_x >= mine->get_map_x() || start_y >= mine->get_map_y())
+	{
+		return false;
+	}
+
+	const unsigned char *tiles = mine->get_tiles();
+
+	// Start a new search. Stamps from the old ones are forgotten, only
+	// needing a clear on the rare occasion the counter wraps around.
+	search_number++;
+
+	if(search_number == 0)
+	{
+		memset(search_stamp, 0, sizeof(search_stamp));
+		search_number = 1;
+	}
+
+	heap_size = 0;
+
+	int start = mine->get_index(start_x, start_y);
+	route_start = start;
+
+	search_stamp[start] = search_number;
+	cost[start] = 0;
+	score[start] = estimate(start_x, start_y);
+	parent[start] = -1;
+	closed[start] = false;
+	heap_push(start);
+
+	const int move_x[4] = { 1, -1, 0, 0 };
+	const int move_y[4] = { 0, 0, 1, -1 };
+
+	while(heap_size > 0)
+	{
+		int tile = heap_pop();
+		int x = tile % MINE_WIDTH;
+		int y = tile / MINE_WIDTH;
+
+		closed[tile] = true;
+
+		if(in_target(x, y))
+		{
+			// Count the steps back to the start, then lay them out in order.
+			for(int step = tile; step != start; step = parent[step])
+			{
+				route_length++;
+			}
+
+			int position = route_length;
+
+			for(int step = tile; step != start; step = parent[step])
+			{
+				position--;
+				route[position] = step;
+			}
+
+			route_cost = cost[tile] - route_length * AUTOPILOT_TURN_COST;
+
+			return true;
+		}
+
+		for(int move = 0; move < 4; move++)
+		{
+			int next_x = x + move_x[move];
+			int next_y = y + move_y[move];
+
+			int step = step_cost(player, mine, tiles, x, y, next_x, next_y);
+
+			if(step < 0)
+			{
+				continue;
+			}
+
+			int next = mine->get_index(next_x, next_y);
+
+			if(search_stamp[next] != search_number)
+			{
+				search_stamp[next] = search_number;
+				cost[next] = INT_MAX;
+				closed[next] = false;
+				heap_position[next] = -1;
+			}
+
+			if(closed[next] || cost[tile] + step >= cost[next])
+			{
+				continue;
+			}
+
+			cost[next] = cost[tile] + step;
+			score[next] = cost[next] + estimate(next_x, next_y);
+			parent[next] = tile;
+
+			if(heap_position[next] < 0)
+			{
+				heap_push(next);
+			}
+			else
+			{
+				heap_up(heap_position[next]);
+			}
+		}
+	}
+
+	return false;
+}
+
+// Take the next step of the route.
+bool Autopilot::step(PlayerData *player, MineData *mine)
+{
+	if(!active)
+	{
+		return false;
+	}
+
+	int next_x = route[route_step] % MINE_WIDTH;
+	int next_y = route[route_step] / MINE_WIDTH;
+
+	player->change_location(next_x, next_y, mine);
+
+	if(player->get_location_x() == next_x && player->get_location_y() == next_y)
+	{
+		route_step++;
+		stuck = 0;
+
+		if(in_target(next_x, next_y))
+		{
+			active = false;
+			player->send_event(Game_Event(EVENT_AUTOPILOT_ARRIVED, next_x, next_y));
+		}
+
+		return true;
+	}
+
+	// The player didn't move: granite was chipped, water bailed, or
+	// digging showed something the route didn't know about.
+	stuck++;
+
+	if(stuck > AUTOPILOT_MAX_STUCK)
+	{
+		active = false;
+		player->send_event(Game_Event(EVENT_AUTOPILOT_STOPPED, next_x, next_y));
+		return true;
+	}
+
+	// Only plan again if the next tile now costs more than planned. After
+	// chipping granite or bailing water it costs less, and the route stands.
+	int here = mine->get_index(player->get_location_x(), player->get_location_y());
+	int previous = route_start;
+
+	if(route_step > 0)
+	{
+		previous = route[route_step - 1];
+	}
+
+	int planned = cost[route[route_step]] - cost[previous];
+	int now = step_cost(player, mine, mine->get_tiles(), player->get_location_x(), player->get_location_y(),
+						next_x, next_y);
+
+	if(here == previous && now >= 0 && now <= planned)
+	{
+		return true;
+	}
+
+	if(!plan(player, mine))
+	{
+		active = false;
+		player->send_event(Game_Event(EVENT_AUTOPILOT_NO_ROUTE, target_x, target_y));
+	}
+
+	return true;
+}
+
+void Autopilot::stop()
+{
+	active = false;
+}
+
+bool Autopilot::is_active()
+{
+	return active;
+}
+
+int Autopilot::get_route_length()
+{
+	return route_length;
+}
+
+int Autopilot::get_route_cost()
+{
+	return route_cost;
+}
+
+int Autopilot::get_route_x(int step)
+{
+	return route[step] % MINE_WIDTH;
+}
+
+int Autopilot::get_route_y(int step)
+{
+	return route[step] / MINE_WIDTH;
+}
+
+// The autopilot used by the game. Kept out of the way of the stack.
+Autopilot *get_autopilot()
+{
+	static Autopilot autopilot;
+
+	return &autopilot;
+}
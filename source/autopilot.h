@@ -0,0 +1,132 @@
+/*
+ autopilot.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Walks and digs the player to a target area of the mine.
+
+ The route is the cheapest one by the same rules change_location
+ uses, planned with A* over the mine's packed tiles. Only what the
+ player knows is used: unexplored ground is priced as dirt, so when
+ digging turns up granite or a spring the route is planned again.
+
+ All the memory for planning is kept in the object, sized for the
+ largest mine, so planning never allocates. It's too big for the
+ stack; use get_autopilot() or new.
+*/
+
+#ifndef AUTOPILOT
+#define AUTOPILOT
+
+#include "classes.h"
+
+// What a turn is worth next to a dollar when choosing a route, so the
+// shortest of the cheapest routes is taken.
+const int AUTOPILOT_TURN_COST = 1;
+
+// Times the player can fail to move before the autopilot gives up.
+const int AUTOPILOT_MAX_STUCK = 4;
+
+class Autopilot
+{
+	private:
+		// Scratch for the search, one entry per tile. Entries are only
+		// valid if their tile's search_stamp matches the current search,
+		// so nothing needs clearing between searches.
+		unsigned int search_stamp[MINE_TILES];
+		unsigned int search_number;
+		int cost[MINE_TILES];			// Cheapest cost found from the start.
+		int score[MINE_TILES];			// Cost plus the estimate to the target.
+		int parent[MINE_TILES];			// Tile the cheapest cost came from.
+		bool closed[MINE_TILES];
+
+		// Open tiles as a binary heap on score, and each tile's place in
+		// it (-1 if not in it) so a cheaper cost can move it up.
+		int heap[MINE_TILES];
+		int heap_position[MINE_TILES];
+		int heap_size;
+
+		// The planned route, from the first step to the target. Until the
+		// next search, cost[] holds the cost of reaching each step.
+		int route_start;
+		int route[MINE_TILES];
+		int route_length;
+		int route_step;
+		int route_cost;			// Dollars, not counting turns.
+
+		// The area being headed for.
+		bool active;
+		int target_x;
+		int target_y;
+		int target_width;
+		int target_height;
+
+		int stuck;
+
+		// Heap operations.
+		bool heap_less(int a, int b);
+		void heap_swap(int a, int b);
+		void heap_up(int position);
+		void heap_down(int position);
+		void heap_push(int tile);
+		int heap_pop();
+
+		// Estimated cost from a tile to the target area.
+		int estimate(int x, int y);
+
+		// Cost to move from one tile to its neighbour, or -1 if the player can't.
+		int step_cost(PlayerData *player, MineData *mine, const unsigned char *tiles,
+					  int from_x, int from_y, int to_x, int to_y);
+
+		bool in_target(int x, int y);
+
+	public:
+		Autopilot();
+
+		// Head for an area of the mine. Plans the route straight away and
+		// reports it through the player's event sink.
+		// Returns false if there's no way there.
+		bool set_target(PlayerData *player, MineData *mine, int x, int y, int width, int height);
+		
+		// Head for the area the player's last tavern tip pointed to.
+		bool head_for_tip(PlayerData *player, MineData *mine);
+		
+		// Head back to wherever the elevator was left.
+		bool head_for_elevator(PlayerData *player, MineData *mine);
+
+		// Plan the route from where the player is now.
+		// Returns false if there's no way there.
+		bool plan(PlayerData *player, MineData *mine);
+
+		// Take the next step of the route, planning again if the mine
+		// turned out to be different. Returns false once stopped.
+		bool step(PlayerData *player, MineData *mine);
+
+		void stop();
+		bool is_active();
+
+		// The planned route.
+		int get_route_length();
+		int get_route_cost();
+		int get_route_x(int step);
+		int get_route_y(int step);
+};
+
+// The autopilot used by the game.
+Autopilot *get_autopilot();
+
+#endif
@@ -0,0 +1,374 @@
+/*
+ autosave.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Saves the game every so often, without the game waiting for the disk.
+*/
+
+#include <cstdio>
+
+#include "autosave.h"
+#include "trace.h"
+
+Autosave::Autosave()
+{
+	for(int slot = 0; slot < 3; slot++)
+	{
+		slots[slot].state = SLOT_FREE;
+	}
+	
+	next_order = 0;
+	stopping = false;
+	journal_broken = false;
+	checkpoints_written = 0;
+	batches_written = 0;
+	bytes_written = 0;
+	saves_failed = 0;
+	
+	last_turn = 0;
+	journal_bytes = 0;
+	need_checkpoint = true;
+	game_over = false;
+	
+	writer = std::thread(&Autosave::writer_loop, this);
+}
+
+Autosave::~Autosave()
+{
+	stop();
+}
+
+int Autosave::find_slot(autosave_slot_state state, int kind)
+{
+	int found = -1;
+	
+	for(int slot = 0; slot < 3; slot++)
+	{
+		if(slots[slot].state == state && (kind == -1 || slots[slot].kind == kind)
+		   && (found == -1 || slots[slot].order < slots[found].order))
+		{
+			found = slot;
+		}
+	}
+	
+	return found;
+}
+
+int Autosave::find_waiting_save(int save_slot)
+{
+	for(int slot = 0; slot < 3; slot++)
+	{
+		if(slots[slot].state == SLOT_PENDING && slots[slot].kind == SLOT_SAVE
+		   && slots[slot].save_slot == save_slot)
+		{
+			return slot;
+		}
+	}
+	
+	return -1;
+}
+
+void Autosave::hand_over(int slot)
+{
+	slots[slot].state = SLOT_PENDING;
+	slots[slot].order = next_order++;
+	slot_condition.notify_all();
+}
+
+void Autosave::writer_loop()
+{
+	std::unique_lock<std::mutex> lock(slot_mutex);
+	
+	while(true)
+	{
+		// The oldest waiting.
+		int slot = find_slot(SLOT_PENDING, -1);
+		
+		if(slot == -1)
+		{
+			if(stopping)
+			{
+				return;
+			}
+			
+			slot_condition.wait(lock);
+			continue;
+		}
+		
+		slots[slot].state = SLOT_WRITING;
+		Autosave_Slot &writing = slots[slot];
+		
+		lock.unlock();
+		
+		bool written = false;
+		long long bytes = 0;
+		
+		if(writing.kind == SLOT_BATCH)
+		{
+			// journal_broken is only changed by this thread.
+			written = !journal_broken && append_journal(writing.path, writing.batch);
+			bytes = writing.batch.data.size();
+		}
+		else if(writing.kind == SLOT_SAVE)
+		{
+			written = write_save_slot(writing.save_slot, writing.snapshot, writing.time_saved);
+		}
+		else
+		{
+			unsigned long long checksum = 0;
+			written = write_snapshot(writing.path, writing.snapshot, &checksum);
+			
+			// A journal that followed the old checkpoint would be put
+			// back onto the new one, so it's replaced straight after.
+			if(written && writing.kind == SLOT_CHECKPOINT)
+			{
+				written = start_journal(JOURNAL_FILE, checksum);
+			}
+		}
+		
+		lock.lock();
+		
+		if(writing.kind == SLOT_CHECKPOINT)
+		{
+			journal_broken = !written;
+		}
+		else if(writing.kind == SLOT_BATCH && !written)
+		{
+			journal_broken = true;
+		}
+		
+		if(!written)
+		{
+			saves_failed++;
+		}
+		else if(writing.kind == SLOT_BATCH)
+		{
+			batches_written++;
+			bytes_written += bytes;
+		}
+		else if(writing.kind == SLOT_CHECKPOINT)
+		{
+			checkpoints_written++;
+		}
+		
+		writing.state = SLOT_FREE;
+		slot_condition.notify_all();
+	}
+}
+
+bool Autosave::update(MineData *mine, PlayerData *player)
+{
+	int turn = player->get_turn_number();
+	
+	// A new game, or one loaded from earlier on.
+	if(turn < last_turn)
+	{
+		restart();
+		last_turn = turn;
+	}
+	
+	if(game_over || (turn < last_turn + JOURNAL_BATCH_TURNS && !need_checkpoint))
+	{
+		return false;
+	}
+	
+	// Don't wait for the writer, even to hand over.
+	std::unique_lock<std::mutex> lock(slot_mutex, std::try_to_lock);
+	
+	if(!lock.owns_lock() || stopping || find_slot(SLOT_PENDING, SLOT_CHECKPOINT) != -1
+	   || find_slot(SLOT_PENDING, SLOT_BATCH) != -1)
+	{
+		return false;
+	}
+	
+	if(journal_broken)
+	{
+		need_checkpoint = true;
+	}
+	
+	// The player's saves to two slots can both be waiting.
+	int slot = find_slot(SLOT_FREE, -1);
+	
+	if(slot == -1)
+	{
+		return false;
+	}
+	
+	if(need_checkpoint || journal_bytes >= JOURNAL_COMPACT_BYTES)
+	{
+		Trace_Zone zone("autosave_checkpoint", TRACE_IO);
+		
+		slots[slot].kind = SLOT_CHECKPOINT;
+		slots[slot].path = AUTOSAVE_FILE;
+		take_snapshot(mine, player, slots[slot].snapshot);
+		mine->forget_changes();
+		
+		need_checkpoint = false;
+		journal_bytes = 0;
+	}
+	else
+	{
+		Trace_Zone zone("autosave_batch", TRACE_IO);
+		
+		slots[slot].kind = SLOT_BATCH;
+		slots[slot].path = JOURNAL_FILE;
+		take_journal_batch(mine, player, slots[slot].batch);
+		
+		journal_bytes += slots[slot].batch.data.size();
+	}
+	
+	hand_over(slot);
+	last_turn = turn;
+	
+	return true;
+}
+
+void Autosave::restart()
+{
+	need_checkpoint = true;
+	game_over = false;
+}
+
+void Autosave::end_game()
+{
+	game_over = true;
+	need_checkpoint = true;
+	
+	std::unique_lock<std::mutex> lock(slot_mutex);
+	
+	// What's waiting is never written, and what's being written is
+	// waited for, so neither file comes back after it's removed.
+	for(int slot = 0; slot < 3; slot++)
+	{
+		if(slots[slot].state == SLOT_PENDING && slots[slot].kind != SLOT_SAVE)
+		{
+			slots[slot].state = SLOT_FREE;
+		}
+	}
+	
+	while(find_slot(SLOT_WRITING, SLOT_CHECKPOINT) != -1 || find_slot(SLOT_WRITING, SLOT_BATCH) != -1)
+	{
+		slot_condition.wait(lock);
+	}
+	
+	remove(AUTOSAVE_FILE);
+	remove(JOURNAL_FILE);
+}
+
+void Autosave::save(MineData *mine, PlayerData *player, int save_slot)
+{
+	std::unique_lock<std::mutex> lock(slot_mutex);
+	int slot = -1;
+	
+	while(!stopping)
+	{
+		// Replace a save to the same slot still waiting, or use a free
+		// slot. A save to another slot is left to be written.
+		slot = find_waiting_save(save_slot);
+		
+		if(slot == -1)
+		{
+			slot = find_slot(SLOT_FREE, -1);
+		}
+		
+		if(slot != -1)
+		{
+			break;
+		}
+		
+		slot_condition.wait(lock);
+	}
+	
+	if(stopping)
+	{
+		// Too late for the writer, which has stopped writing slots too.
+		lock.unlock();
+		
+		Save_Snapshot *snapshot = new Save_Snapshot;
+		take_snapshot(mine, player, *snapshot);
+		write_save_slot(save_slot, *snapshot, time(NULL));
+		delete snapshot;
+		return;
+	}
+	
+	slots[slot].kind = SLOT_SAVE;
+	slots[slot].save_slot = save_slot;
+	slots[slot].time_saved = time(NULL);
+	take_snapshot(mine, player, slots[slot].snapshot);
+	
+	hand_over(slot);
+}
+
+void Autosave::finish()
+{
+	std::unique_lock<std::mutex> lock(slot_mutex);
+	
+	while(find_slot(SLOT_PENDING, -1) != -1 || find_slot(SLOT_WRITING, -1) != -1)
+	{
+		slot_condition.wait(lock);
+	}
+}
+
+void Autosave::stop()
+{
+	{
+		std::unique_lock<std::mutex> lock(slot_mutex);
+		stopping = true;
+		slot_condition.notify_all();
+	}
+	
+	if(writer.joinable())
+	{
+		writer.join();
+	}
+}
+
+int Autosave::get_checkpoints_written()
+{
+	std::unique_lock<std::mutex> lock(slot_mutex);
+	
+	return checkpoints_written;
+}
+
+int Autosave::get_batches_written()
+{
+	std::unique_lock<std::mutex> lock(slot_mutex);
+	
+	return batches_written;
+}
+
+long long Autosave::get_bytes_written()
+{
+	std::unique_lock<std::mutex> lock(slot_mutex);
+	
+	return bytes_written;
+}
+
+int Autosave::get_saves_failed()
+{
+	std::unique_lock<std::mutex> lock(slot_mutex);
+	
+	return saves_failed;
+}
+
+Autosave *get_autosave()
+{
+	static Autosave autosave;
+	
+	return &autosave;
+}
@@ -0,0 +1,175 @@
+/*
+ autosave.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Saves the game every so often, and whenever the player asks, without
+ the game waiting for the disk.
+
+ The autosave is a full save (a checkpoint) followed by a journal of
+ what changed after it. Every JOURNAL_BATCH_TURNS turns the tiles the
+ mine has changed since the last batch, and the player, are appended
+ to the journal, which costs in proportion to what changed. Once the
+ journal has grown to JOURNAL_COMPACT_BYTES, or the game has been
+ started or loaded afresh, a new checkpoint is written and the journal
+ started again. A crash loses at most the turns since the last batch.
+
+ Copying a batch or a checkpoint out of the game takes microseconds,
+ and a thread of its own writes it while the game goes on. The mine
+ loop calls update on every pass; if the writer still has the last
+ autosave waiting, it tries again on the next pass, with the changes
+ kept in the mine until then. It never waits for the writing thread.
+*/
+
+#ifndef AUTOSAVE
+#define AUTOSAVE
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "classes.h"
+#include "save_load.h"
+
+// Turns between journal batches.
+const int JOURNAL_BATCH_TURNS = 5;
+
+// How big the journal gets before a new checkpoint is written. About
+// the size of a checkpoint.
+const int JOURNAL_COMPACT_BYTES = 24 * 1024;
+
+// What a slot holds for the writer.
+enum autosave_slot_kind
+{
+	SLOT_CHECKPOINT,	// A snapshot to write as the autosave, starting a new journal.
+	SLOT_BATCH,			// A batch to append to the journal.
+	SLOT_SAVE			// A snapshot to write to one of the player's save slots.
+};
+
+// Where a slot is.
+enum autosave_slot_state
+{
+	SLOT_FREE,
+	SLOT_PENDING,		// Waiting for the writer.
+	SLOT_WRITING
+};
+
+class Autosave
+{
+	private:
+		struct Autosave_Slot
+		{
+			autosave_slot_kind kind;
+			autosave_slot_state state;
+			int order;					// Slots are written in the order they were handed over.
+			
+			Save_Snapshot snapshot;
+			Journal_Batch batch;
+			const char *path;			// Where a checkpoint or batch goes.
+			int save_slot;				// Where a save of the player's goes, and when it was made.
+			time_t time_saved;
+		};
+		
+		// One being written, and at most one autosave and one save to
+		// each of the player's save slots waiting. The player saving to
+		// another slot can fill the last one, so both the autosave and
+		// the player's saves check for a free one.
+		Autosave_Slot slots[3];
+		int next_order;
+		
+		// Guards everything above and the counts below. Only held to
+		// hand over a slot, never while one is being written.
+		std::mutex slot_mutex;
+		std::condition_variable slot_condition;
+		
+		bool stopping;
+		
+		// A checkpoint or batch couldn't be written, so the batches after
+		// it would be put back onto the wrong game. They're dropped until
+		// a checkpoint is written.
+		bool journal_broken;
+		
+		int checkpoints_written;
+		int batches_written;
+		long long bytes_written;
+		int saves_failed;
+		
+		// Only used by the game's thread. The turn of the last autosave,
+		// how big the journal is, and whether a checkpoint is needed.
+		int last_turn;
+		long long journal_bytes;
+		bool need_checkpoint;
+		
+		// The game has ended, so nothing more is autosaved until the
+		// next game is started or loaded.
+		bool game_over;
+		
+		std::thread writer;
+		
+		void writer_loop();
+		
+		// Find a slot in a state, and of a kind unless any kind will do.
+		// Returns -1 if there isn't one. Called with slot_mutex held.
+		int find_slot(autosave_slot_state state, int kind);
+		
+		// Find the player's save to a save slot that's still waiting.
+		// Returns -1 if there isn't one. Called with slot_mutex held.
+		int find_waiting_save(int save_slot);
+		
+		// Mark a filled slot as waiting for the writer. Called with
+		// slot_mutex held.
+		void hand_over(int slot);
+		
+	public:
+		Autosave();
+		~Autosave();
+		
+		// Called on every pass of the mine loop. Every JOURNAL_BATCH_TURNS
+		// turns, hands the writer a journal batch or a new checkpoint, if
+		// it can without waiting. Returns true if it did.
+		bool update(MineData *mine, PlayerData *player);
+		
+		// The game has been started or loaded afresh: the next autosave
+		// has to be a checkpoint.
+		void restart();
+		
+		// The game has ended. Drops any autosave still waiting and
+		// removes the autosave and its journal, so loading can't go back
+		// to before the end. The player's own saves are kept.
+		void end_game();
+		
+		// Save to one of the player's save slots, replacing any save to
+		// the same slot still waiting. Only waits for the writer to take
+		// or hand back a slot.
+		void save(MineData *mine, PlayerData *player, int save_slot);
+		
+		// Wait until everything handed over has been written.
+		void finish();
+		
+		// Write what's waiting and stop the writer.
+		void stop();
+		
+		int get_checkpoints_written();
+		int get_batches_written();
+		long long get_bytes_written();
+		int get_saves_failed();
+};
+
+// The game's autosave.
+Autosave *get_autosave();
+
+#endif
@@ -33,10 +33,14 @@
 #include "sdl_functions.h"
 #include "classes.h"
 #include "bank_functions.h"
+#include "economy.h"
 #include "timer.h"
+#include "trace.h"
 
 void bank(PlayerData *player, SDL_Objects *sdl)
 {
+	Trace_Zone zone("bank", TRACE_SCREEN);
+
 	// Initialize the objects within the bank screen.
 	Bank_Objects bank_data;
 	
@@ -152,7 +156,7 @@ void bank(PlayerData *player, SDL_Objects *sdl)
 		if(update_screen)
 		{
 			bank_data.update_bank_graphics(sdl, player, &bank_selection);	
-			SDL_UpdateRect(sdl->return_screen(), 500, 0, 70, 380);
+			sdl->update_rect(500, 0, 70, 380);
 			sdl->display_hud(player);
 			SDL_Flip(sdl->return_screen());
 		}
@@ -163,23 +167,31 @@ void bank(PlayerData *player, SDL_Objects *sdl)
 
 Bank_Objects::Bank_Objects()
 {
-	bank_graphic = IMG_Load("./Graphics/bank/bank_screen.png");
-	bank_arrow_graphic = IMG_Load("./Graphics/bank/arrow.png");
+	bank_graphic = load_image("graphics/bank/bank_screen.png");
+	bank_arrow_graphic = load_image("graphics/bank/arrow.png");
+	
+	sell_coal_graphic = load_image("graphics/bank/sell_coal.png");
+	sell_silver_graphic = load_image("graphics/bank/sell_silver.png");
+	sell_gold_graphic = load_image("graphics/bank/sell_gold.png");
+	sell_platinum_graphic = load_image("graphics/bank/sell_platinum.png");
+	sell_all_graphic = load_image("graphics/bank/sell_all.png");
+	exit_graphic = load_image("graphics/bank/exit_bank.png");
+	
+	platinum_graphic = load_image("graphics/bank/platinum.png");
+	gold_graphic = load_image("graphics/bank/gold.png");
+	silver_graphic = load_image("graphics/bank/silver.png");
+	coal_graphic = load_image("graphics/bank/coal.png");
 	
-	sell_coal_graphic = IMG_Load("./Graphics/bank/sell_coal.png");
-	sell_silver_graphic = IMG_Load("./Graphics/bank/sell_silver.png");
-	sell_gold_graphic = IMG_Load("./Graphics/bank/sell_gold.png");
-	sell_platinum_graphic = IMG_Load("./Graphics/bank/sell_platinum.png");
-	sell_all_graphic = IMG_Load("./Graphics/bank/sell_all.png");
-	exit_graphic = IMG_Load("./Graphics/bank/exit_bank.png");
+	header_font = open_font("Fonts/DejaVuSans-Bold.ttf", 28);
+	display_font = open_font("Fonts/DejaVuSans-Bold.ttf", 20);
 	
-	platinum_graphic = IMG_Load("./Graphics/bank/platinum.png");
-	gold_graphic = IMG_Load("./Graphics/bank/gold.png");
-	silver_graphic = IMG_Load("./Graphics/bank/silver.png");
-	coal_graphic = IMG_Load("./Graphics/bank/coal.png");
+	for(int mineral = 0; mineral < MARKET_MINERALS; mineral++)
+	{
+		sparkline[mineral] = NULL;
+	}
 	
-	header_font = TTF_OpenFont("./Fonts/DejaVuSans-Bold.ttf", 28);
-	display_font = TTF_OpenFont("./Fonts/DejaVuSans-Bold.ttf", 20);
+	sparkline_changes = 0;
+	sparklines_drawn = false;
 }
 
 Bank_Objects::~Bank_Objects()
@@ -201,51 +213,136 @@ Bank_Objects::~Bank_Objects()
 	
 	TTF_CloseFont(header_font);
 	TTF_CloseFont(display_font);
+	
+	for(int mineral = 0; mineral < MARKET_MINERALS; mineral++)
+	{
+		SDL_FreeSurface(sparkline[mineral]);
+	}
 }
 
+// The sales themselves are in economy.cpp.
 void Bank_Objects::bank_sell_all(PlayerData *player)
 {
-	bank_sell_platinum(player);
-	bank_sell_gold(player);
-	bank_sell_silver(player);
-	bank_sell_coal(player);
+	sell_all_minerals(player);
 }
 
 void Bank_Objects::bank_sell_platinum(PlayerData *player)
 {
-	player->change_money(player->get_platinum() * player->get_platinum_value());
-	player->change_platinum(player->get_platinum() * -1);
+	sell_mineral(player, PLATINUM);
 }
 		
 void Bank_Objects::bank_sell_gold(PlayerData *player)
 {
-	player->change_money(player->get_gold() * player->get_gold_value());
-	player->change_gold(player->get_gold() * -1);
+	sell_mineral(player, GOLD);
 }
 
 void Bank_Objects::bank_sell_silver(PlayerData *player)
 {
-	player->change_money(player->get_silver() * player->get_silver_value());
-	player->change_silver(player->get_silver() * -1);
+	sell_mineral(player, SILVER);
 }
 	
 void Bank_Objects::bank_sell_coal(PlayerData *player)
 {
-	player->change_money(player->get_coal() * player->get_coal_value());
-	player->change_coal(player->get_coal() * -1);
+	sell_mineral(player, COAL);
 }
 
 void Bank_Objects::bank_randomize_values(PlayerData *player)
 {
-	if((player->get_turn_number() - player->get_previous_turn_number()) >= 10)
+	randomize_mineral_values(player);
+}
+
+// Draw one mineral's price history, newest on the right, scaled to
+// the lowest and highest its price can be.
+void Bank_Objects::draw_sparkline(SDL_Objects *sdl, Mineral_Market *market, market_mineral mineral)
+{
+	SDL_PixelFormat *format = sdl->return_screen()->format;
+	
+	if(sparkline[mineral] == NULL)
+	{
+		sparkline[mineral] = SDL_CreateRGBSurface(SDL_SWSURFACE, SPARKLINE_WIDTH, SPARKLINE_HEIGHT,
+												  format->BitsPerPixel, format->Rmask, format->Gmask,
+												  format->Bmask, format->Amask);
+		
+		if(sparkline[mineral] == NULL)
+		{
+			return;
+		}
+	}
+	
+	SDL_Surface *surface = sparkline[mineral];
+	
+	Uint32 line_colour = SDL_MapRGB(surface->format, 200, 200, 200);
+	Uint32 rise_colour = SDL_MapRGB(surface->format, 80, 200, 80);
+	Uint32 fall_colour = SDL_MapRGB(surface->format, 220, 70, 60);
+	
+	SDL_FillRect(surface, NULL, SDL_MapRGB(surface->format, 30, 30, 30));
+	
+	int low = market->get_low_price(mineral);
+	int high = market->get_high_price(mineral);
+	int count = market->get_history_count();
+	int previous_y = 0;
+	
+	for(int age = 0; age < count; age++)
 	{
-		player->randomize_coal_value();
-		player->randomize_silver_value();
-		player->randomize_gold_value();
-		player->randomize_platinum_value();
+		int price = market->get_history(mineral, age);
+		int x = (PRICE_HISTORY - count + age) * SPARKLINE_STEP;
+		int y = (SPARKLINE_HEIGHT - 3) - (price - low) * (SPARKLINE_HEIGHT - 3) / (high - low);
 		
-		player->set_previous_turn_number();
-	}	
+		Uint32 colour = line_colour;
+		
+		// The newest price shows which way it went.
+		if(age == count - 1 && age > 0)
+		{
+			if(price >= market->get_history(mineral, age - 1))
+			{
+				colour = rise_colour;
+			}
+			else
+			{
+				colour = fall_colour;
+			}
+		}
+		
+		// Join it to the price before.
+		if(age > 0)
+		{
+			SDL_Rect join;
+			join.x = x;
+			join.y = (y < previous_y) ? y : previous_y;
+			join.w = 2;
+			join.h = ((y < previous_y) ? previous_y - y : y - previous_y) + 3;
+			SDL_FillRect(surface, &join, line_colour);
+		}
+		
+		SDL_Rect point;
+		point.x = x;
+		point.y = y;
+		point.w = SPARKLINE_STEP;
+		point.h = 3;
+		SDL_FillRect(surface, &point, colour);
+		
+		previous_y = y;
+	}
+}
+
+// Draw the price histories again if the market has changed since they
+// were last drawn.
+void Bank_Objects::update_sparklines(SDL_Objects *sdl, PlayerData *player)
+{
+	Mineral_Market *market = player->get_market();
+	
+	if(sparklines_drawn && sparkline_changes == market->get_changes())
+	{
+		return;
+	}
+	
+	draw_sparkline(sdl, market, MARKET_COAL);
+	draw_sparkline(sdl, market, MARKET_SILVER);
+	draw_sparkline(sdl, market, MARKET_GOLD);
+	draw_sparkline(sdl, market, MARKET_PLATINUM);
+	
+	sparkline_changes = market->get_changes();
+	sparklines_drawn = true;
 }
 
 void Bank_Objects::update_bank_graphics(SDL_Objects *sdl, PlayerData *player, Selection_Arrow *bank_selection)
@@ -274,6 +371,9 @@ void Bank_Objects::display_bank_information(SDL_Objects *sdl, PlayerData *player
 	std::stringstream temp_stringstream;
 	int temp_money_value = 0;
 	
+	// Each mineral's recent prices go under its listing.
+	update_sparklines(sdl, player);
+	
 	// Display items on the sidebar
 	sdl->apply_surface(576, 0, sell_all_graphic, sdl->return_screen());
 	sdl->apply_surface(576, 64, sell_coal_graphic, sdl->return_screen());
@@ -289,6 +389,7 @@ void Bank_Objects::display_bank_information(SDL_Objects *sdl, PlayerData *player
     temp_string = temp_stringstream.str();
     sdl->apply_text(100, 80, temp_string, display_font, sdl->return_screen());
     temp_stringstream.str("");
+    sdl->apply_surface(100, 106, sparkline[MARKET_COAL], sdl->return_screen());
     
     temp_money_value = player->get_coal_value() * player->get_coal();
     temp_stringstream << temp_money_value;
@@ -302,6 +403,7 @@ void Bank_Objects::display_bank_information(SDL_Objects *sdl, PlayerData *player
     temp_string = temp_stringstream.str();
     sdl->apply_text(100, 145, temp_string, display_font, sdl->return_screen());
     temp_stringstream.str("");
+    sdl->apply_surface(100, 171, sparkline[MARKET_SILVER], sdl->return_screen());
     
     temp_money_value = player->get_silver_value() * player->get_silver();
     temp_stringstream << temp_money_value;
@@ -315,6 +417,7 @@ void Bank_Objects::display_bank_information(SDL_Objects *sdl, PlayerData *player
     temp_string = temp_stringstream.str();
     sdl->apply_text(100, 210, temp_string, display_font, sdl->return_screen());
     temp_stringstream.str("");
+    sdl->apply_surface(100, 236, sparkline[MARKET_GOLD], sdl->return_screen());
     
     temp_money_value = player->get_gold_value() * player->get_gold();
     temp_stringstream << temp_money_value;
@@ -328,6 +431,7 @@ void Bank_Objects::display_bank_information(SDL_Objects *sdl, PlayerData *player
     temp_string = temp_stringstream.str();
     sdl->apply_text(100, 275, temp_string, display_font, sdl->return_screen());
     temp_stringstream.str("");
+    sdl->apply_surface(100, 301, sparkline[MARKET_PLATINUM], sdl->return_screen());
     
     temp_money_value = player->get_platinum_value() * player->get_platinum();
     temp_stringstream << temp_money_value;
@@ -357,7 +461,7 @@ void Bank_Objects::animate_arrow_down(SDL_Objects *sdl, PlayerData *player, Sele
 		temp = temp + 16;
         display_bank_information(sdl, player);
 		sdl->apply_surface(selection->return_arrow_x(), temp, bank_arrow_graphic, sdl->return_screen());
-		SDL_UpdateRect(sdl->return_screen(), 500, 0, 70, 380);
+		sdl->update_rect(500, 0, 70, 380);
 		SDL_Delay(sdl->MENU_ANIMATION_WAIT);
 	}
 }
@@ -371,7 +475,7 @@ void Bank_Objects::animate_arrow_up(SDL_Objects *sdl, PlayerData *player, Select
 		temp = temp - 16;
         display_bank_information(sdl, player);
 		sdl->apply_surface(selection->return_arrow_x(), temp, bank_arrow_graphic, sdl->return_screen());
-		SDL_UpdateRect(sdl->return_screen(), 500, 0, 70, 380);
+		sdl->update_rect(500, 0, 70, 380);
 		SDL_Delay(sdl->MENU_ANIMATION_WAIT);
 	}
 }
@@ -30,8 +30,14 @@
 #include "SDL_ttf/SDL_ttf.h"
 
 #include "classes.h"
+#include "market.h"
 #include "sdl_functions.h"
 
+// Size of the price history drawn under each mineral's price.
+const int SPARKLINE_STEP = 10;		// Pixels between prices.
+const int SPARKLINE_WIDTH = PRICE_HISTORY * SPARKLINE_STEP;
+const int SPARKLINE_HEIGHT = 16;
+
 // Load the bank
 void bank(PlayerData *player, SDL_Objects *sdl);
 
@@ -56,6 +62,15 @@ class Bank_Objects
 		TTF_Font *header_font;
 		TTF_Font *display_font;
 		
+		// Each mineral's price history, drawn once and only drawn again
+		// when the market has changed (see Mineral_Market::get_changes).
+		SDL_Surface *sparkline[MARKET_MINERALS];
+		unsigned int sparkline_changes;
+		bool sparklines_drawn;
+		
+		void draw_sparkline(SDL_Objects *sdl, Mineral_Market *market, market_mineral mineral);
+		void update_sparklines(SDL_Objects *sdl, PlayerData *player);
+		
 	public:
 		Bank_Objects();
 		
@@ -24,18 +24,30 @@
  what has happened within the mine.
 */
 
-#include <ctime>		// Allows generation of psuedorandom numbers.
-#include <cstdlib>		// Allows for rand()
+#include <ctime>		// Seeds new games from the time.
+#include <cstdlib>		// For NULL.
+#include <cstring>		// For memset and memcpy.
 #include <iostream>		// For testing purposes... cout.
 
-#include "sdl_functions.h"
 #include "classes.h"
+#include "game_events.h"
+#include "trace.h"
+#include "game_recorder.h"
+#include "game_rules.h"
 
 // PlayerData constructor
 PlayerData::PlayerData()
 {
-	// Seed the random number generator.
-	srand( time(NULL) );
+	event_sink = NULL;
+	recorder = NULL;
+	
+	// Seed the random number generator from the time.
+	reset(time(NULL));
+}
+
+void PlayerData::reset(unsigned int seed)
+{
+	set_seed(seed);
 	
 	// Set money and health to default starting values.
 	money = 1500;
@@ -47,18 +59,13 @@ PlayerData::PlayerData()
 	gold = 0;
 	platinum = 0;
 	
-	coal_value = 15;
-	silver_value = 50;
-	gold_value = 100;
-	platinum_value = 250;
-
 	turn_number = 0;
 	previous_turn_number = 0;
 	insurance_turn_number = -100;
 	
 	has_axe = false;
 	has_bucket = false;
-	has_dynamite = false;
+	dynamite = 0;
 	has_flashlight = false;
 	has_hardhat = false;
 	has_shovel = false;
@@ -70,11 +77,32 @@ PlayerData::PlayerData()
 	previous_location_x = 0;
 	previous_location_y = 0;
 		
-	dynamite_x = 0;
-	dynamite_y = 0;
+	has_tip = false;
+	tip_x = 0;
+	tip_y = 0;
+	tip_width = 0;
+	tip_height = 0;
 	
-	dynamite_primed = false;
-	dynamite_timer = 0;
+	market.reset();
+	scheduler.clear(0);
+}
+
+// Restart the player's random numbers from a seed.
+// Kept apart from the mine's numbers, which may use the same seed.
+void PlayerData::set_seed(unsigned int seed)
+{
+	this->seed = seed;
+	random.seed(((unsigned long long)seed << 1) | 1);
+}
+
+unsigned int PlayerData::get_seed()
+{
+	return seed;
+}
+
+int PlayerData::random_int(int range)
+{
+	return random.next_int(range);
 }
 
 void PlayerData::change_money(int value)
@@ -107,44 +135,10 @@ void PlayerData::change_platinum(int value)
 	platinum += value;
 }
 
-void PlayerData::randomize_coal_value()
-{
-	coal_value = rand() % 25;
-
-	while(coal_value < 5 || coal_value > 25)
-	{
-		coal_value = rand() % 25;
-	}
-}
-
-void PlayerData::randomize_silver_value()
-{
-	silver_value = rand() % 60;
-
-	while(silver_value < 40 || silver_value > 60)
-	{
-		silver_value = rand() % 60;
-	}
-}
-
-void PlayerData::randomize_gold_value()
-{
-	gold_value = rand() % 125;
-
-	while(gold_value < 80 || gold_value > 125)
-	{
-		gold_value = rand() % 125;
-	}
-}
-
-void PlayerData::randomize_platinum_value()
+// Move the bank's prices on one change, with the player's random numbers.
+void PlayerData::change_prices()
 {
-	platinum_value = rand() % 275;
-
-	while(platinum_value < 225 || platinum_value > 275)
-	{
-		platinum_value = rand() % 275;
-	}
+	market.change_prices(random);
 }
 		
 int PlayerData::get_money()
@@ -179,22 +173,27 @@ int PlayerData::get_platinum()
 
 int PlayerData::get_coal_value()
 {
-	return coal_value;
+	return market.get_price(MARKET_COAL);
 }
 
 int PlayerData::get_silver_value()
 {
-	return silver_value;
+	return market.get_price(MARKET_SILVER);
 }
 
 int PlayerData::get_gold_value()
 {
-	return gold_value;
+	return market.get_price(MARKET_GOLD);
 }
 
 int PlayerData::get_platinum_value()
 {
-	return platinum_value;
+	return market.get_price(MARKET_PLATINUM);
+}
+
+Mineral_Market *PlayerData::get_market()
+{
+	return &market;
 }
 	
 void PlayerData::change_has_axe(bool value)
@@ -207,9 +206,9 @@ void PlayerData::change_has_bucket(bool value)
 	has_bucket = value;
 }
 
-void PlayerData::change_has_dynamite(bool value)
+void PlayerData::change_dynamite(int value)
 {
-	has_dynamite = value;
+	dynamite += value;
 }
 
 void PlayerData::change_has_flashlight(bool value)
@@ -237,27 +236,24 @@ void PlayerData::change_has_insurance(bool value)
 	has_insurance = value;
 }
 
-void PlayerData::dig_function()
+void PlayerData::dig_function(materials material)
 {
 	// Check to see if the player has the shovel. Adjust money accordingly.
-	if(get_has_shovel() == false)
-	{
-		change_money(-20);
-	}
-	else
+	int cost = DIG_COST;
+	
+	if(get_has_shovel() == true)
 	{
-		change_money(-15);
+		cost = SHOVEL_DIG_COST;
 	}
+	
+	change_money(-cost);
+	
+	send_event(Game_Event(EVENT_TILE_DUG, 0, 0, material, 0, cost));
 }
 
 void PlayerData::increment_turn_number()
 {
 	turn_number++;
-	
-	if((get_insurance_turn_number() + 50) < get_turn_number())
-	{
-		change_has_insurance(false);
-	}
 }
 
 void PlayerData::set_previous_turn_number()
@@ -273,6 +269,9 @@ void PlayerData::set_previous_turn_number(int number)
 void PlayerData::set_insurance_turn_number()
 {
 	insurance_turn_number = turn_number;
+	
+	// Have the insurance checked the first turn it's out of date.
+	scheduler.schedule(turn_number + INSURANCE_TURNS + 1, EFFECT_INSURANCE_EXPIRY, 0, 0);
 }
 
 void PlayerData::set_insurance_turn_number(int number)
@@ -312,7 +311,12 @@ bool PlayerData::get_has_bucket()
 
 bool PlayerData::get_has_dynamite()
 {
-	return has_dynamite;
+	return dynamite > 0;
+}
+
+int PlayerData::get_dynamite()
+{
+	return dynamite;
 }
 
 bool PlayerData::get_has_flashlight()
@@ -342,7 +346,7 @@ bool PlayerData::get_has_insurance()
 
 // Allows the player's health to be checked after each turn.
 // Return false if health is below 0.
-bool PlayerData::check_health(SDL_Objects *sdl)
+bool PlayerData::check_health()
 {
 	if(get_health() <= 0)
 		{
@@ -352,9 +356,11 @@ bool PlayerData::check_health(SDL_Objects *sdl)
 				// Kick the player out of the mine.
 				return false;
 			}
-			else if((get_insurance_turn_number() + 50) > get_turn_number()
+			else if((get_insurance_turn_number() + INSURANCE_TURNS) > get_turn_number()
 					&& get_has_insurance() == true)
 			{
+				Record_Scope record(this, ACTION_CHECK_HEALTH);
+				
 				// Give the player 25 health to help them out.
 				health = 35;
 				
@@ -362,7 +368,7 @@ bool PlayerData::check_health(SDL_Objects *sdl)
 				change_has_insurance(false);
 
 				// Update onscreen information with the player's status.
-				sdl->update_status_text("Thank goodness for insurance!");
+				send_event(Game_Event(EVENT_INSURANCE_CLAIMED));
 				
 				return true;
 			}
@@ -370,54 +376,27 @@ bool PlayerData::check_health(SDL_Objects *sdl)
 	return true;
 }
 
-// Primes the player's dynamite for explosion.
-void PlayerData::dynamite_prime(int x, int y, MineData *mine)
-{
-	mine->set_contents(x ,y, DYNAMITE);	// Change the tile to dynamite.
-	set_dynamite_location(x ,y, mine);	// Let the program know where the dynamite is.
-	dynamite_primed = true;				// convert this to a function.
-	change_has_dynamite(false);
-	dynamite_timer = 0;					// Set the timer for the dynamite.
-}
-
-bool PlayerData::dynamite_countdown(MineData *mine)
+// Lays a stick of dynamite and schedules its blast.
+bool PlayerData::dynamite_prime(int x, int y, MineData *mine)
 {
-	if(dynamite_primed == true && dynamite_timer < 1)
+	if(!scheduler.schedule(turn_number + DYNAMITE_FUSE_TURNS, EFFECT_DYNAMITE, x, y))
 	{
-		dynamite_timer++;
 		return false;
 	}
-	else if(dynamite_primed == true && dynamite_timer >= 1)
-	{	
-		// Check to see if the player is in the blast radius.
-		if(dynamite_radius())
-		{
-			// Blow up the dynamite.
-			dynamite_explode(get_dynamite_location_x(), get_dynamite_location_y(), mine);
-			set_dynamite_location(0, 0, mine);			// Clear the dynamite variables.
-			dynamite_primed = false;			
-			return true;
-		}
-		else
-		{
-			// Blow up the dynamite.
-			dynamite_explode(get_dynamite_location_x(), get_dynamite_location_y(), mine);
-			set_dynamite_location(0, 0, mine);			// Clear the dynamite variables.
-			dynamite_primed = false;
-			return false;
-		}
-	}
 	
-	return false;
+	mine->set_contents(x ,y, DYNAMITE);	// Change the tile to dynamite.
+	change_dynamite(-1);
+	
+	return true;
 }
 
-// Check to see if the player is within the blast ardius of the dynamite.
-bool PlayerData::dynamite_radius()
+// Check to see if the player is within the blast radius of dynamite at x, y.
+bool PlayerData::dynamite_radius(int x, int y)
 {
-	if(((get_location_x() < (get_dynamite_location_x() + 2))
-		&& (get_location_x() > (get_dynamite_location_x() - 2)))
-		&& ((get_location_y() < (get_dynamite_location_y() + 2))
-		&& (get_location_y() > (get_dynamite_location_y() - 2))))
+	if(((get_location_x() < (x + 2))
+		&& (get_location_x() > (x - 2)))
+		&& ((get_location_y() < (y + 2))
+		&& (get_location_y() > (y - 2))))
 	{
 		return true;
 	}
@@ -434,7 +413,7 @@ void PlayerData::dynamite_explode(int x, int y, MineData *mine)
 	{
 		for(int y_start = y - 2; y_start <= y + 2; y_start++)
 		{
-			if(x_start >= 0 && y_start >= 0)
+			if(mine->in_bounds(x_start, y_start))
 			{
 				// Set all tiles within blast to explored.
 				mine->set_explored(x_start, y_start, true);
@@ -453,8 +432,14 @@ void PlayerData::dynamite_explode(int x, int y, MineData *mine)
 	}
 }
 		
-void PlayerData::change_location(int x, int y, MineData *mine, SDL_Objects *sdl)
-{	
+void PlayerData::change_location(int x, int y, MineData *mine)
+{
+	Trace_Zone zone("change_location", TRACE_LOGIC);
+	Record_Scope record(this, move_action(location_x, location_y, x, y), x, y);
+	
+	// Whether the move takes a turn.
+	int turn_before = turn_number;
+	
 	// Below if statments ensure that the requested move is valid.
 	if((x >= 0 && x < mine->get_map_x()) && (y >= 0 && y < mine->get_map_y()))
 	{
@@ -478,7 +463,7 @@ void PlayerData::change_location(int x, int y, MineData *mine, SDL_Objects *sdl)
 			mine->set_explored(x,y, true);
 			
 			// Dig the area, subtract money.
-			dig_function();
+			dig_function(mine->get_contents(x,y));
 			
 			// Increment the number of moves the player has performed.
 			increment_turn_number();
@@ -492,7 +477,7 @@ void PlayerData::change_location(int x, int y, MineData *mine, SDL_Objects *sdl)
 			// Dig the area, subtract money.
 			if(mine->get_explored(x,y) == false)
 			{
-				dig_function();
+				dig_function(mine->get_contents(x,y));
 				
 				// Make the granite known
 				mine->set_explored(x,y, true);
@@ -503,7 +488,7 @@ void PlayerData::change_location(int x, int y, MineData *mine, SDL_Objects *sdl)
 			else if(get_has_axe())
 			{
 				// Charge the player a slightly higher rate for digging.
-				change_money(-30);
+				change_money(-GRANITE_DIG_COST);
 				
 				// Change the granite area to an explored area.
 				mine->set_contents(x,y, EXPLORED);
@@ -512,18 +497,18 @@ void PlayerData::change_location(int x, int y, MineData *mine, SDL_Objects *sdl)
 				increment_turn_number();
 				
 				// Update the HUD
-				sdl->update_status_text("You chip away at the granite!");
+				send_event(Game_Event(EVENT_GRANITE_CHIPPED, x, y, GRANITE, 0, GRANITE_DIG_COST));
 			}
 			else
 			{
 				// Update the HUD
-				sdl->update_status_text("You can't dig through granite!");
+				send_event(Game_Event(EVENT_GRANITE_BLOCKED, x, y, GRANITE));
 			}
 		}
 		else if(mine->get_contents(x,y) == SPRING)
 		{
 			// Dig the area, subtract money.
-			dig_function();
+			dig_function(mine->get_contents(x,y));
 			
 			// Make the spring known
 			mine->set_explored(x,y, true);
@@ -538,12 +523,12 @@ void PlayerData::change_location(int x, int y, MineData *mine, SDL_Objects *sdl)
 			mine->water_flow(x,y);
 			
 			// Update the HUD
-			sdl->update_status_text("Oh no, a spring!");
+			send_event(Game_Event(EVENT_SPRING_HIT, x, y, SPRING));
 		}
 		else if(mine->get_contents(x,y) == CAVE_IN)
 		{
 			// Dig the area, subtract money.
-			dig_function();
+			dig_function(mine->get_contents(x,y));
 			
 			// Make the cave-in known
 			mine->set_explored(x,y, true);
@@ -565,18 +550,19 @@ void PlayerData::change_location(int x, int y, MineData *mine, SDL_Objects *sdl)
 			mine->cave_in(x, y);
 			
 			// Update the HUD
-			sdl->update_status_text("Ow, a cave-in!");
+			send_event(Game_Event(EVENT_CAVE_IN, x, y, CAVE_IN));
 		}
 		else if(mine->get_contents(x,y) == COAL)
 		{
 			if(!mine->get_explored(x,y))
 			{
 				// Dig the area, subtract money.
-				dig_function();
+				dig_function(mine->get_contents(x,y));
 			}
 			
 			// Randomly adjust the amount of materials found.
-			change_coal((rand() % 4) + 1);
+			int found = random.next_int(4) + 1;
+			change_coal(found);
 			
 			// Increment the number of moves the player has performed.
 			increment_turn_number();
@@ -589,22 +575,20 @@ void PlayerData::change_location(int x, int y, MineData *mine, SDL_Objects *sdl)
 			location_x = x;
 			location_y = y;
 			
-			// Begin the animation of finding the item.
-			mine->add_recently_found(location_x, location_y, COAL);
-			
-			// Update the HUD
-			sdl->update_status_text("You found some coal!");			
+			// Tell the player what they found.
+			send_event(Game_Event(EVENT_MINERAL_FOUND, location_x, location_y, COAL, found));			
 		}
 		else if(mine->get_contents(x,y) == SILVER)
 		{
 			if(!mine->get_explored(x,y))
 			{
 				// Dig the area, subtract money.
-				dig_function();
+				dig_function(mine->get_contents(x,y));
 			}
 			
 			// Randomly adjust the amount of minerals found.
-			change_silver((rand() % 3) + 1);
+			int found = random.next_int(3) + 1;
+			change_silver(found);
 			
 			// Increment the number of moves the player has performed.
 			increment_turn_number();			
@@ -617,22 +601,20 @@ void PlayerData::change_location(int x, int y, MineData *mine, SDL_Objects *sdl)
 			location_x = x;
 			location_y = y;
 			
-			// Begin the animation of finding the item.
-			mine->add_recently_found(location_x, location_y, SILVER);
-
-			// Update the HUD
-			sdl->update_status_text("You found some silver!");
+			// Tell the player what they found.
+			send_event(Game_Event(EVENT_MINERAL_FOUND, location_x, location_y, SILVER, found));
 		}
 		else if(mine->get_contents(x,y) == GOLD)
 		{
 			if(!mine->get_explored(x,y))
 			{
 				// Dig the area, subtract money.
-				dig_function();
+				dig_function(mine->get_contents(x,y));
 			}
 			
 			// Randomly adjust the amount of minerals found.	
-			change_gold((rand() % 3) + 1);
+			int found = random.next_int(3) + 1;
+			change_gold(found);
 			
 			// Increment the number of moves the player has performed.
 			increment_turn_number();		
@@ -645,22 +627,20 @@ void PlayerData::change_location(int x, int y, MineData *mine, SDL_Objects *sdl)
 			location_x = x;
 			location_y = y;
 
-			// Begin the animation of finding the item.
-			mine->add_recently_found(location_x, location_y, GOLD);
-			
-			// Update the HUD
-			sdl->update_status_text("You found some gold!");
+			// Tell the player what they found.
+			send_event(Game_Event(EVENT_MINERAL_FOUND, location_x, location_y, GOLD, found));
 		}
 		else if(mine->get_contents(x,y) == PLATINUM)
 		{
 			if(!mine->get_explored(x,y))
 			{
 				// Dig the area, subtract money.
-				dig_function();
+				dig_function(mine->get_contents(x,y));
 			}
 			
 			// Randomly adjust the amount of minerals found.
-			change_platinum((rand() % 2) + 1);
+			int found = random.next_int(2) + 1;
+			change_platinum(found);
 			
 			// Make the area known
 			mine->set_explored(x,y, true);
@@ -673,11 +653,8 @@ void PlayerData::change_location(int x, int y, MineData *mine, SDL_Objects *sdl)
 			location_x = x;
 			location_y = y;
 
-			// Begin the animation of finding the item.
-			mine->add_recently_found(location_x, location_y, PLATINUM);
-			
-			// Update the HUD
-			sdl->update_status_text("You found some platinum!");			
+			// Tell the player what they found.
+			send_event(Game_Event(EVENT_MINERAL_FOUND, location_x, location_y, PLATINUM, found));			
 		}
 		// Deal with the character trying to enter a stream of water.
 		else if(mine->get_contents(x,y) == WATER)
@@ -691,13 +668,13 @@ void PlayerData::change_location(int x, int y, MineData *mine, SDL_Objects *sdl)
 				increment_turn_number();
 				
 				// Charge the character 40 dollars for clearing the stream.
-				change_money(-40);
+				change_money(-BUCKET_COST);
 
 				// Change the tile to plain ol' explored
 				mine->set_contents(x,y, EXPLORED);
 				
 				// Update the HUD
-				sdl->update_status_text("You use your bucket!");
+				send_event(Game_Event(EVENT_BUCKET_USED, x, y, WATER, 0, BUCKET_COST));
 			}
 			// Do not allow the player to enter the stream.
 			else
@@ -709,7 +686,7 @@ void PlayerData::change_location(int x, int y, MineData *mine, SDL_Objects *sdl)
 				change_health(-5);
 				
 				// Update the HUD
-				sdl->update_status_text("You start to drown!");
+				send_event(Game_Event(EVENT_DROWNING, x, y, WATER));
 			}
 		}
 		// Deal with the player finding the diamond in the mine.
@@ -718,7 +695,7 @@ void PlayerData::change_location(int x, int y, MineData *mine, SDL_Objects *sdl)
 			if(!mine->get_explored(x,y))
 			{
 				// Dig the area, subtract money.
-				dig_function();
+				dig_function(mine->get_contents(x,y));
 			}
 			
 			// Increment the number of moves the player has performed.
@@ -735,11 +712,8 @@ void PlayerData::change_location(int x, int y, MineData *mine, SDL_Objects *sdl)
 			location_x = x;
 			location_y = y;
 
-			// Begin the animation of finding the item.
-			mine->add_recently_found(location_x, location_y, DIAMOND);
-				
-			// Update the HUD
-			sdl->update_status_text("You found the diamond!");
+			// Tell the player what they found.
+			send_event(Game_Event(EVENT_MINERAL_FOUND, location_x, location_y, DIAMOND, 1));
 		}	
 		// Allow the character to move to previously searched location, except for mineshaft.
 		else if(mine->get_explored(x,y) == true
@@ -771,16 +745,25 @@ void PlayerData::change_location(int x, int y, MineData *mine, SDL_Objects *sdl)
 		location_x = x;
 		location_y = y;
 	}
-}
-
-void PlayerData::set_dynamite_location(int x, int y, MineData *mine)
-{
-	if((x >= 0 && x <= mine->get_map_x()) && (y >= 0 && y <= mine->get_map_y()))
+	
+	// Shine the flashlight around wherever the player ended up.
+	if(has_flashlight)
+	{
+		mine->update_hints(location_x, location_y, FLASHLIGHT_RADIUS, turn_number);
+	}
+	else
+	{
+		mine->update_hints(location_x, location_y, -1, turn_number);
+	}
+	
+	// Count down the dynamite and let the water flow, once for each
+	// turn taken.
+	if(turn_number != turn_before)
 	{
-		dynamite_x = x;
-		dynamite_y = y;
+		end_turn(this, mine);
 	}
 }
+
 		
 int PlayerData::get_location_x()
 {
@@ -802,50 +785,172 @@ int PlayerData::get_previous_location_y()
 	return previous_location_y;
 }
 
-int PlayerData::get_dynamite_location_x()
+Turn_Scheduler *PlayerData::get_scheduler()
+{
+	return &scheduler;
+}
+
+// Remember the area the last tavern tip pointed to.
+void PlayerData::set_tip_region(int x, int y, int width, int height)
+{
+	has_tip = true;
+	tip_x = x;
+	tip_y = y;
+	tip_width = width;
+	tip_height = height;
+}
+
+bool PlayerData::get_has_tip()
 {
-	return dynamite_x;
+	return has_tip;
 }
 
-int PlayerData::get_dynamite_location_y()
+int PlayerData::get_tip_x()
 {
-	return dynamite_y;
+	return tip_x;
+}
+
+int PlayerData::get_tip_y()
+{
+	return tip_y;
+}
+
+int PlayerData::get_tip_width()
+{
+	return tip_width;
+}
+
+int PlayerData::get_tip_height()
+{
+	return tip_height;
+}
+
+void PlayerData::set_event_sink(Game_Event_Sink *sink)
+{
+	event_sink = sink;
+}
+
+Game_Event_Sink *PlayerData::get_event_sink()
+{
+	return event_sink;
+}
+
+// Send an event to the event sink, if there is one.
+void PlayerData::send_event(const Game_Event &event)
+{
+	if(event_sink != NULL)
+	{
+		event_sink->handle_event(event);
+	}
+}
+
+void PlayerData::set_recorder(Game_Recorder *recorder)
+{
+	this->recorder = recorder;
+}
+
+Game_Recorder *PlayerData::get_recorder()
+{
+	return recorder;
 }
 
 // MineData constructor
 MineData::MineData()
 {
-	// Set the diamond location to zero.
-	diamond_x = 0;
-	diamond_y = 0;
-	
 	// State the dimensions of the map.
 	map_x = 191;
 	map_y = 191;
 	
-	// Clear out the recently found area.
-	recently_found_material = NOTHING;
-	recently_found_x = NULL;
-	recently_found_y = NULL;
-	recently_found_countdown = -1;
+	scratch = NULL;
+	owns_scratch = false;
+	
+	// Leave the mine empty until it's reset or loaded.
+	clear(time(NULL));
+}
+
+// Make the mine from a given seed. The same seed always gives the same mine.
+MineData::MineData(unsigned int seed)
+{
+	map_x = 191;
+	map_y = 191;
+	
+	scratch = NULL;
+	owns_scratch = false;
+	
+	reset(seed);
+}
+
+void MineData::reset(unsigned int seed)
+{
+	clear(seed);
 	
 	// Randomize the mine.
 	randomize_mine();
 }
 
+void MineData::clear(unsigned int seed)
+{
+	// Set the diamond location to zero.
+	diamond_x = 0;
+	diamond_y = 0;
+	
+	// Start with unexplored dirt everywhere, including the edge tiles
+	// randomize_mine doesn't fill.
+	memset(tiles, 0, sizeof(tiles));
+	tile_checksum = 0;
+	memset(water_level, 0, sizeof(water_level));
+	water_next.clear();
+	memset(chamber_parent, 0xFF, sizeof(chamber_parent));	// NO_CHAMBER everywhere.
+	chamber_pending.clear();
+	hint_x = 0;
+	hint_y = 0;
+	hint_radius = -1;
+	memset(changed_bits, 0, sizeof(changed_bits));
+	changed_tiles.clear();
+	
+	// Seed the random number generator.
+	this->seed = seed;
+	random.seed((unsigned long long)seed << 1);
+}
+
 // MineData deconstructor
 MineData::~MineData()
 {
+	if(owns_scratch)
+	{
+		delete scratch;
+	}
+}
+
+void MineData::set_scratch(Mine_Scratch *shared)
+{
+	if(owns_scratch)
+	{
+		delete scratch;
+	}
+	
+	scratch = shared;
+	owns_scratch = false;
+}
+
+Mine_Scratch *MineData::get_scratch()
+{
+	if(scratch == NULL)
+	{
+		scratch = new Mine_Scratch;
+		owns_scratch = true;
+	}
 	
+	return scratch;
 }
 
 void MineData::randomize_mine()
 {
+	Trace_Zone zone("randomize_mine", TRACE_LOGIC);
+
 	int tempValue = 0;
 	int testedValue = 0;
 
-	srand( time(NULL) );		// Seed the random number generator.
-
 	// Makes the mineshaft on the far left of the matrix.
 	for(int y = 0; y <= map_y; y++)
 	{
@@ -858,14 +963,14 @@ void MineData::randomize_mine()
 	{
 		for(int y = 0; y <= (map_y - 1); y++)
 		{
-			tempValue = rand() % 7;
+			tempValue = random.next_int(7);
 			
 			// Sets the mine to being unexplored.
 			set_explored(x, y, false);
 			
 			if(tempValue == 0)
 			{
-				testedValue = rand() % 1;
+				testedValue = random.next_int(1);
 
 				if(testedValue == 0)
 				{
@@ -878,7 +983,7 @@ void MineData::randomize_mine()
 			}
 			else if(tempValue == 1)
 			{
-				testedValue = rand() % 3;
+				testedValue = random.next_int(3);
 
 				if(testedValue == 0)
 				{
@@ -892,7 +997,7 @@ void MineData::randomize_mine()
 			}
 			else if(tempValue == 2)
 			{
-				testedValue = rand() % 5;
+				testedValue = random.next_int(5);
 
 				if(testedValue == 0)
 				{
@@ -905,7 +1010,7 @@ void MineData::randomize_mine()
 			}
 			else if(tempValue == 3)
 			{
-				testedValue = rand() % 7;
+				testedValue = random.next_int(7);
 
 				if(testedValue == 0)
 				{
@@ -918,7 +1023,7 @@ void MineData::randomize_mine()
 			}
 			else if(tempValue == 4)
 			{
-				testedValue = rand() % 5;
+				testedValue = random.next_int(5);
 
 				if(testedValue == 0)
 				{
@@ -931,7 +1036,7 @@ void MineData::randomize_mine()
 			}
 			else if(tempValue == 5)
 			{
-				testedValue = rand() % 5;
+				testedValue = random.next_int(5);
 
 				if(testedValue == 0)
 				{
@@ -944,7 +1049,7 @@ void MineData::randomize_mine()
 			}
 			else if(tempValue == 6)
 			{
-				testedValue = rand() % 2;
+				testedValue = random.next_int(2);
 
 				if(testedValue == 0)
 				{
@@ -959,8 +1064,8 @@ void MineData::randomize_mine()
 	}
 	
 	// Randomly place the diamond in one tile of the mine.
-	diamond_x = rand() % map_x + 1;
-	diamond_y = rand() % map_y + 1;
+	diamond_x = random.next_int(map_x) + 1;
+	diamond_y = random.next_int(map_y) + 1;
 	set_contents(diamond_x, diamond_y, DIAMOND);
 	
 	// Place the elevator at the 0, 0 area of the matrix.
@@ -970,169 +1075,657 @@ void MineData::randomize_mine()
 // Returns what is at a specified area in the mine.
 materials MineData::get_contents(int x, int y)
 {
-	return mine_contents[x][y];
+	return (materials)(tiles[get_index(x, y)] & TILE_MATERIAL_MASK);
 }
 
 // Returns whether an area has been explored or not.
 bool MineData::get_explored(int x, int y)
 {
-	return explored[x][y];
+	return (tiles[get_index(x, y)] & TILE_EXPLORED) != 0;
 }
 
-// Allows materials to be stored into mine_contents
+// Allows materials to be stored into the tiles.
 void MineData::set_contents(int x, int y, materials contents)
 {
-	mine_contents[x][y] = contents;
+	int index = get_index(x, y);
+	bool was_open = is_open(x, y);
+	
+	write_tile(index, (tiles[index] & ~TILE_MATERIAL_MASK) | (unsigned char)contents);
+	
+	// Keep the chambers up to date, as granite is chipped away and so on.
+	if(is_open(x, y) != was_open)
+	{
+		if(was_open)
+		{
+			tile_closed(x, y);
+		}
+		else
+		{
+			tile_opened(x, y);
+		}
+	}
 }
 
 // Allows the status of an explored area to be changed.
 void MineData::set_explored(int x, int y, bool status)
 {
-	explored[x][y] = status;
+	int index = get_index(x, y);
+	bool was_open = is_open(x, y);
+	
+	if(status)
+	{
+		// Newly dug tunnels let standing water flow on.
+		if(!(tiles[index] & TILE_EXPLORED))
+		{
+			write_tile(index, tiles[index] | TILE_EXPLORED);
+			wake_water(x, y);
+		}
+	}
+	else
+	{
+		write_tile(index, tiles[index] & ~TILE_EXPLORED);
+	}
+	
+	if(is_open(x, y) != was_open)
+	{
+		if(was_open)
+		{
+			tile_closed(x, y);
+		}
+		else
+		{
+			tile_opened(x, y);
+		}
+	}
 }
 
 // Simulates the mine caving in.
 void MineData::cave_in(int x, int y)
 {
-	int tempValue = 0;
-	int testedValue = 0;
-	
-	srand( time(NULL) );		// Seed the random number generator.
-	
-	// Randomizes the rest of the matrix. 
+	Trace_Zone zone("cave_in", TRACE_LOGIC);
+
+	// Fill in the tiles around the cave-in.
 	for(int x_start = x - 1; x_start <= x + 1; x_start++)
 	{
 		for(int y_start = y - 1; y_start <= y + 1; y_start++)
 		{
 			if((x != x_start || y != y_start) 
+				&& in_bounds(x_start, y_start)
 				&& get_contents(x_start, y_start) != ELEVATOR 
 				&& get_contents(x_start, y_start) != SHAFT
 				&& get_contents(x_start, y_start) != DIAMOND)
 			{
-				tempValue = rand() % 7;
-			
-				// Sets the mine to being unexplored.
-				set_explored(x_start, y_start, false);
-			
-				if(tempValue == 0)
-				{
-					testedValue = rand() % 1;
-
-					if(testedValue == 0)
-					{
-						set_contents(x_start, y_start, COAL);
-					}
-					else
-					{
-						set_contents(x_start, y_start, DIRT);
-					}
-				}
-				else if(tempValue == 1)
-				{
-					testedValue = rand() % 3;
-
-					if(testedValue == 0)
-					{
-						set_contents(x_start, y_start, SILVER);
-					}
-					else
-					{
-						set_contents(x_start, y_start, DIRT);
-					}
-
-				}
-				else if(tempValue == 2)
-				{
-					testedValue = rand() % 5;
-
-					if(testedValue == 0)
-					{
-						set_contents(x_start, y_start, GOLD);
-					}
-					else
-					{
-						set_contents(x_start, y_start, DIRT);
-					}
-				}
-				else if(tempValue == 3)
-				{
-					testedValue = rand() % 7;
-
-					if(testedValue == 0)
-					{
-						set_contents(x_start, y_start, PLATINUM);
-					}
-					else
-					{
-						set_contents(x_start, y_start, DIRT);
-					}
-				}
-				else if(tempValue == 4)
-				{
-					testedValue = rand() % 5;
-
-					if(testedValue == 0 && y_start != 1)
-					{
-						set_contents(x_start, y_start, CAVE_IN);
-					}
-					else
-					{
-						set_contents(x_start, y_start, DIRT);
-					}
-				}
-				else if(tempValue == 5)
-				{
-					testedValue = rand() % 5;
-
-					if(testedValue == 0 && y_start > 2)
-					{
-						set_contents(x_start, y_start, SPRING);
-					}
-					else
-					{
-						set_contents(x_start, y_start, DIRT);
-					}
-				}
-				else if(tempValue == 6)
-				{
-					testedValue = rand() % 2;
-
-					if(testedValue == 0)
-					{
-						set_contents(x_start, y_start, GRANITE);
-					}
-					else
-					{
-						set_contents(x_start, y_start, DIRT);
-					}
-				}
+				fill_with_rubble(x_start, y_start);
 			}
 		}
 	}
 }
 
-// Simulates the mine being flooded by a spring.
-void MineData::water_flow(int x, int y)
+// Turn a tile back into unexplored ground, with whatever might be in it.
+void MineData::fill_with_rubble(int x, int y)
 {
-	for(int x_start = x - 2; x_start <= x + 2; x_start++)
+	int tempValue = 0;
+	int testedValue = 0;
+	
+	tempValue = random.next_int(7);
+
+	// Sets the mine to being unexplored.
+	set_explored(x, y, false);
+
+	if(tempValue == 0)
 	{
-		for(int y_start = y - 1; y_start <= y + 1; y_start++)
+		testedValue = random.next_int(1);
+
+		if(testedValue == 0)
 		{
-			if((get_explored(x_start, y_start) == true)
-				&& (get_contents(x_start, y_start) != GRANITE)
-				&& (get_contents(x_start, y_start) != SPRING)
-				&& (get_contents(x_start, y_start) != ELEVATOR)
-				&& (get_contents(x_start, y_start) != SHAFT)
-				&& (get_contents(x_start, y_start) != DIAMOND))
-			{
-				// Stop the water from flowing the elevator over.
-				if(x_start > 2)
-				{
-					set_contents(x_start, y_start, WATER);
-				}
+			set_contents(x, y, COAL);
+		}
+		else
+		{
+			set_contents(x, y, DIRT);
+		}
+	}
+	else if(tempValue == 1)
+	{
+		testedValue = random.next_int(3);
+
+		if(testedValue == 0)
+		{
+			set_contents(x, y, SILVER);
+		}
+		else
+		{
+			set_contents(x, y, DIRT);
+		}
+
+	}
+	else if(tempValue == 2)
+	{
+		testedValue = random.next_int(5);
+
+		if(testedValue == 0)
+		{
+			set_contents(x, y, GOLD);
+		}
+		else
+		{
+			set_contents(x, y, DIRT);
+		}
+	}
+	else if(tempValue == 3)
+	{
+		testedValue = random.next_int(7);
+
+		if(testedValue == 0)
+		{
+			set_contents(x, y, PLATINUM);
+		}
+		else
+		{
+			set_contents(x, y, DIRT);
+		}
+	}
+	else if(tempValue == 4)
+	{
+		testedValue = random.next_int(5);
+
+		if(testedValue == 0 && y != 1)
+		{
+			set_contents(x, y, CAVE_IN);
+		}
+		else
+		{
+			set_contents(x, y, DIRT);
+		}
+	}
+	else if(tempValue == 5)
+	{
+		testedValue = random.next_int(5);
+
+		if(testedValue == 0 && y > 2)
+		{
+			set_contents(x, y, SPRING);
+		}
+		else
+		{
+			set_contents(x, y, DIRT);
+		}
+	}
+	else if(tempValue == 6)
+	{
+		testedValue = random.next_int(2);
+
+		if(testedValue == 0)
+		{
+			set_contents(x, y, GRANITE);
+		}
+		else
+		{
+			set_contents(x, y, DIRT);
+		}
+	}
+}
+
+// Returns true if a tile has been dug out. The shaft isn't counted;
+// it's shored up.
+bool MineData::is_open(int x, int y)
+{
+	if(x < 1 || !in_bounds(x, y))
+	{
+		return false;
+	}
+	
+	unsigned char tile = tiles[get_index(x, y)];
+	materials contents = (materials)(tile & TILE_MATERIAL_MASK);
+	
+	return (tile & TILE_EXPLORED)
+		&& contents != GRANITE
+		&& contents != SPRING
+		&& contents != CAVE_IN
+		&& contents != SHAFT
+		&& contents != ELEVATOR;
+}
+
+// Returns true if a tile and the one above it have been dug out, making
+// it part of a chamber.
+bool MineData::has_open_roof(int x, int y)
+{
+	return is_open(x, y) && is_open(x, y - 1);
+}
+
+// Find the root of a tile's chamber, halving the path on the way.
+int MineData::find_chamber(int index)
+{
+	while(chamber_parent[index] != index)
+	{
+		chamber_parent[index] = chamber_parent[chamber_parent[index]];
+		index = chamber_parent[index];
+	}
+	
+	return index;
+}
+
+void MineData::join_chambers(int a, int b)
+{
+	int root_a = find_chamber(a);
+	int root_b = find_chamber(b);
+	
+	if(root_a == root_b)
+	{
+		return;
+	}
+	
+	chamber_parent[root_b] = root_a;
+	
+	if(chamber_left[root_b] < chamber_left[root_a])
+	{
+		chamber_left[root_a] = chamber_left[root_b];
+	}
+	
+	if(chamber_right[root_b] > chamber_right[root_a])
+	{
+		chamber_right[root_a] = chamber_right[root_b];
+	}
+	
+	// Splice the two rings of tiles into one.
+	int next = chamber_next[root_a];
+	chamber_next[root_a] = chamber_next[root_b];
+	chamber_next[root_b] = next;
+}
+
+// Add a tile to the chambers, joining it to any chamber beside it.
+void MineData::add_to_chamber(int x, int y)
+{
+	link_to_chamber(x, y);
+	check_chamber_later(get_index(x, y), false);
+}
+
+// Join a tile to any chamber beside it, without checking the chamber.
+void MineData::link_to_chamber(int x, int y)
+{
+	int index = get_index(x, y);
+	
+	chamber_parent[index] = index;
+	chamber_next[index] = index;
+	chamber_left[index] = x;
+	chamber_right[index] = x;
+	
+	const int move_x[4] = { -1, 1, 0, 0 };
+	const int move_y[4] = { 0, 0, -1, 1 };
+	
+	for(int move = 0; move < 4; move++)
+	{
+		int next_x = x + move_x[move];
+		int next_y = y + move_y[move];
+		
+		if(in_bounds(next_x, next_y) && chamber_parent[get_index(next_x, next_y)] != NO_CHAMBER)
+		{
+			join_chambers(index, get_index(next_x, next_y));
+		}
+	}
+}
+
+// Check each chamber that tiles were put back into once, from its root.
+void MineData::check_relinked(const int *chamber_tiles, int count, bool shaken)
+{
+	for(int tile = 0; tile < count; tile++)
+	{
+		if(chamber_parent[chamber_tiles[tile]] == chamber_tiles[tile])
+		{
+			check_chamber_later(chamber_tiles[tile], shaken);
+		}
+	}
+}
+
+// A tile in the chamber has been filled in, which may have split it.
+// Take the chamber apart and put back the tiles still in one. Finding
+// where a chamber splits takes a walk of it, so this costs in
+// proportion to the chamber, which the turn's cave-ins keep to
+// CAVE_IN_SPAN tiles wide.
+void MineData::break_up_chamber(int index)
+{
+	int *chamber_scratch = get_scratch()->chamber_tiles;
+	int count = 0;
+	int member = index;
+	
+	do
+	{
+		chamber_scratch[count] = member;
+		count++;
+		member = chamber_next[member];
+	}
+	while(member != index);
+	
+	for(int tile = 0; tile < count; tile++)
+	{
+		chamber_parent[chamber_scratch[tile]] = NO_CHAMBER;
+	}
+	
+	for(int tile = 0; tile < count; tile++)
+	{
+		int x = chamber_scratch[tile] % MINE_WIDTH;
+		int y = chamber_scratch[tile] / MINE_WIDTH;
+		
+		if(has_open_roof(x, y))
+		{
+			link_to_chamber(x, y);
+		}
+	}
+	
+	check_relinked(chamber_scratch, count, false);
+}
+
+// A tile has been dug out. It, and the tile below it, may now have an open roof.
+void MineData::tile_opened(int x, int y)
+{
+	for(int below = 0; below <= 1; below++)
+	{
+		if(has_open_roof(x, y + below) && chamber_parent[get_index(x, y + below)] == NO_CHAMBER)
+		{
+			add_to_chamber(x, y + below);
+		}
+	}
+}
+
+// A tile has been filled in. It, and the tile below it, no longer have an open roof.
+void MineData::tile_closed(int x, int y)
+{
+	for(int below = 0; below <= 1; below++)
+	{
+		if(in_bounds(x, y + below) && chamber_parent[get_index(x, y + below)] != NO_CHAMBER)
+		{
+			break_up_chamber(get_index(x, y + below));
+		}
+	}
+}
+
+// Remember to check a chamber at the end of the turn, if it's too wide.
+void MineData::check_chamber_later(int index, bool shaken)
+{
+	int root = find_chamber(index);
+	int width = chamber_right[root] - chamber_left[root] + 1;
+	
+	if(chamber_pending.size() >= (unsigned int)MINE_TILES)
+	{
+		return;
+	}
+	
+	// Shaken chambers are stored negated.
+	if(shaken && width > CAVE_IN_CHAIN_SPAN)
+	{
+		chamber_pending.push_back(-(index + 1));
+	}
+	else if(width > CAVE_IN_SPAN)
+	{
+		chamber_pending.push_back(index);
+	}
+}
+
+// Fill in a chamber. Chambers within two tiles of it are shaken and
+// checked in turn.
+int MineData::collapse_chamber(int index, int player_x, int player_y, bool &player_hit)
+{
+	int *chamber_scratch = get_scratch()->chamber_tiles;
+	int count = 0;
+	int member = index;
+	
+	do
+	{
+		chamber_scratch[count] = member;
+		count++;
+		member = chamber_next[member];
+	}
+	while(member != index);
+	
+	// Take the chamber apart first, so filling it in finds nothing to update.
+	for(int tile = 0; tile < count; tile++)
+	{
+		chamber_parent[chamber_scratch[tile]] = NO_CHAMBER;
+	}
+	
+	int fallen = 0;
+	
+	for(int tile = 0; tile < count; tile++)
+	{
+		int x = chamber_scratch[tile] % MINE_WIDTH;
+		int y = chamber_scratch[tile] / MINE_WIDTH;
+		
+		if(abs(x - player_x) <= 1 && abs(y - player_y) <= 1)
+		{
+			player_hit = true;
+		}
+		
+		// The player keeps the tile they're standing on, and a blasted
+		// diamond isn't buried again.
+		if((x != player_x || y != player_y) && get_contents(x, y) != DIAMOND)
+		{
+			fill_with_rubble(x, y);
+			fallen++;
+		}
+	}
+	
+	// Tiles left standing may still have an open roof.
+	for(int tile = 0; tile < count; tile++)
+	{
+		int x = chamber_scratch[tile] % MINE_WIDTH;
+		int y = chamber_scratch[tile] / MINE_WIDTH;
+		
+		if(chamber_parent[chamber_scratch[tile]] == NO_CHAMBER && has_open_roof(x, y))
+		{
+			link_to_chamber(x, y);
+		}
+	}
+	
+	check_relinked(chamber_scratch, count, false);
+	
+	// Each chamber nearby is shaken once, however many of the fallen
+	// tiles it's near.
+	int shaken[CAVE_IN_SHAKEN_MAX];
+	int shaken_count = 0;
+	
+	for(int tile = 0; tile < count; tile++)
+	{
+		int x = chamber_scratch[tile] % MINE_WIDTH;
+		int y = chamber_scratch[tile] / MINE_WIDTH;
+		
+		for(int near_x = x - 2; near_x <= x + 2; near_x++)
+		{
+			for(int near_y = y - 2; near_y <= y + 2; near_y++)
+			{
+				if(!in_bounds(near_x, near_y) || chamber_parent[get_index(near_x, near_y)] == NO_CHAMBER)
+				{
+					continue;
+				}
+				
+				int root = find_chamber(get_index(near_x, near_y));
+				bool seen = false;
+				
+				for(int other = 0; other < shaken_count && !seen; other++)
+				{
+					seen = shaken[other] == root;
+				}
+				
+				if(!seen)
+				{
+					check_chamber_later(root, true);
+					
+					if(shaken_count < CAVE_IN_SHAKEN_MAX)
+					{
+						shaken[shaken_count++] = root;
+					}
+				}
 			}
 		}
 	}
+	
+	return fallen;
+}
+
+// Collapse any chamber that has been dug too wide.
+int MineData::check_supports(int player_x, int player_y, bool &player_hit)
+{
+	Trace_Zone zone("check_supports", TRACE_LOGIC);
+	
+	int fallen = 0;
+	
+	// Collapses add to the list as it's being worked through.
+	for(unsigned int pending = 0; pending < chamber_pending.size(); pending++)
+	{
+		int index = chamber_pending[pending];
+		int span = CAVE_IN_SPAN;
+		
+		if(index < 0)
+		{
+			index = -index - 1;
+			span = CAVE_IN_CHAIN_SPAN;
+		}
+		
+		// It may have collapsed or been filled in already.
+		if(chamber_parent[index] == NO_CHAMBER)
+		{
+			continue;
+		}
+		
+		int root = find_chamber(index);
+		
+		if(chamber_right[root] - chamber_left[root] + 1 > span)
+		{
+			fallen += collapse_chamber(root, player_x, player_y, player_hit);
+		}
+	}
+	
+	chamber_pending.clear();
+	
+	return fallen;
+}
+
+int MineData::get_chamber_width(int x, int y)
+{
+	if(!in_bounds(x, y) || chamber_parent[get_index(x, y)] == NO_CHAMBER)
+	{
+		return 0;
+	}
+	
+	int root = find_chamber(get_index(x, y));
+	
+	return chamber_right[root] - chamber_left[root] + 1;
+}
+
+// A spring has been hit. Its water spreads a little each turn from
+// then on (see water_turn).
+void MineData::water_flow(int x, int y)
+{
+	int index = get_index(x, y);
+	
+	water_level[index] = WATER_PRESSURE;
+	activate_water(index);
+}
+
+// Let the water spread for a turn.
+int MineData::water_turn()
+{
+	Trace_Zone zone("water_turn", TRACE_LOGIC);
+	
+	// The tiles flooded last turn are the ones that move this turn.
+	int *water_active = get_scratch()->water_active;
+	int water_active_count = water_next.size();
+	
+	if(water_active_count > 0)
+	{
+		memcpy(water_active, &water_next[0], water_active_count * sizeof(int));
+	}
+	
+	water_next.clear();
+	
+	// Down, left, right and up, and how much spreading each way costs.
+	const int move_x[4] = { 0, -1, 1, 0 };
+	const int move_y[4] = { 1, 0, 0, -1 };
+	const int move_cost[4] = { 0, 1, 1, 2 };
+	
+	for(int active = 0; active < water_active_count; active++)
+	{
+		int index = water_active[active];
+		
+		tiles[index] &= ~TILE_WATER_ACTIVE;
+		
+		// The player may have bailed it out since.
+		materials contents = (materials)(tiles[index] & TILE_MATERIAL_MASK);
+		
+		if(contents != WATER && contents != SPRING)
+		{
+			continue;
+		}
+		
+		int x = index % MINE_WIDTH;
+		int y = index / MINE_WIDTH;
+		
+		for(int move = 0; move < 4; move++)
+		{
+			int next_x = x + move_x[move];
+			int next_y = y + move_y[move];
+			
+			if(water_level[index] <= move_cost[move]
+				|| next_x < WATER_MIN_X || !in_bounds(next_x, next_y))
+			{
+				continue;
+			}
+			
+			int next = get_index(next_x, next_y);
+			
+			// Water only fills open tunnels.
+			if((tiles[next] & ~TILE_HINTED) != (TILE_EXPLORED | EXPLORED))
+			{
+				continue;
+			}
+			
+			write_tile(next, TILE_EXPLORED | WATER);
+			water_level[next] = water_level[index] - move_cost[move];
+			activate_water(next);
+		}
+	}
+	
+	return water_active_count;
+}
+
+int MineData::get_water_active()
+{
+	return water_next.size();
+}
+
+// Put a tile's water in the worklist for the next turn.
+void MineData::activate_water(int index)
+{
+	if(!(tiles[index] & TILE_WATER_ACTIVE))
+	{
+		tiles[index] |= TILE_WATER_ACTIVE;
+		water_next.push_back(index);
+	}
+}
+
+// Wake any water next to a tile that has just been opened up.
+void MineData::wake_water(int x, int y)
+{
+	const int move_x[4] = { 0, -1, 1, 0 };
+	const int move_y[4] = { -1, 0, 0, 1 };
+	
+	for(int move = 0; move < 4; move++)
+	{
+		int next_x = x + move_x[move];
+		int next_y = y + move_y[move];
+		
+		if(!in_bounds(next_x, next_y))
+		{
+			continue;
+		}
+		
+		int next = get_index(next_x, next_y);
+		materials contents = (materials)(tiles[next] & TILE_MATERIAL_MASK);
+		
+		if((contents == WATER || contents == SPRING) && water_level[next] > 0)
+		{
+			activate_water(next);
+		}
+	}
 }
 
 // Returns the location of the diamond
@@ -1146,62 +1739,204 @@ int MineData::get_diamond_y()
 	return diamond_y;
 }
 
-// Return the dimensions of the map
-int MineData::get_map_x()
+// Returns true if a tile is inside the mine.
+bool MineData::in_bounds(int x, int y)
 {
-	return map_x;
+	return x >= 0 && y >= 0 && x <= map_x && y <= map_y;
 }
 
-int MineData::get_map_y()
+// Where a tile is kept in the packed tiles.
+int MineData::get_index(int x, int y)
 {
-	return map_y;
+	return y * MINE_WIDTH + x;
 }
 
-// Allow a recently found item to be set.
-void MineData::add_recently_found(int x, int y, materials contents)
+const unsigned char *MineData::get_tiles()
 {
-	recently_found_material = contents;
-	recently_found_x = x;
-	recently_found_y = y;
-	recently_found_countdown = 24;	
+	return tiles;
 }
+
+// Scramble the bits of a number (splitmix64's finalizer).
+static unsigned long long mix_bits(unsigned long long hash)
+{
+	hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+	
+	return hash ^ (hash >> 31);
+}
+
+// A tile's part of the checksum. Unexplored dirt counts for nothing,
+// so a new mine's checksum is zero.
+static unsigned long long tile_hash(int index, unsigned char tile)
+{
+	tile &= TILE_MATERIAL_MASK | TILE_EXPLORED;
+	
+	if(tile == 0)
+	{
+		return 0;
+	}
+	
+	return mix_bits(((unsigned long long)index << 8) | tile);
+}
+
+// Change a tile's byte, keeping tile_checksum and the changed tiles up to date.
+void MineData::write_tile(int index, unsigned char tile)
+{
+	if((tiles[index] ^ tile) & (TILE_MATERIAL_MASK | TILE_EXPLORED))
+	{
+		tile_checksum ^= tile_hash(index, tiles[index]) ^ tile_hash(index, tile);
 		
-// Increment the counter for recently found.
-void MineData::count_recently_found()
+		if(!(changed_bits[index >> 5] & (1u << (index & 31))))
+		{
+			changed_bits[index >> 5] |= 1u << (index & 31);
+			changed_tiles.push_back(index);
+		}
+	}
+	
+	tiles[index] = tile;
+}
+
+unsigned long long MineData::get_tile_checksum()
+{
+	return tile_checksum;
+}
+
+int MineData::get_changed_count()
+{
+	return changed_tiles.size();
+}
+
+const int *MineData::get_changed_tiles()
+{
+	return changed_tiles.empty() ? NULL : &changed_tiles[0];
+}
+
+void MineData::forget_changes()
 {
-	if(recently_found_countdown > 0)
+	// Only the bits that were set need clearing.
+	for(unsigned int change = 0; change < changed_tiles.size(); change++)
 	{
-		recently_found_countdown--;
+		int index = changed_tiles[change];
+		changed_bits[index >> 5] &= ~(1u << (index & 31));
 	}
-	else
+	
+	changed_tiles.clear();
+}
+
+void MineData::load_tiles(const unsigned char *saved)
+{
+	memcpy(tiles, saved, MINE_TILES);
+	tile_checksum = 0;
+	
+	for(int index = 0; index < MINE_TILES; index++)
+	{
+		tiles[index] &= TILE_MATERIAL_MASK | TILE_EXPLORED;
+		tile_checksum ^= tile_hash(index, tiles[index]);
+	}
+	
+	// Find the chambers that were dug out.
+	for(int y = 0; y <= map_y; y++)
 	{
-		recently_found_material = NOTHING;
-		recently_found_x = NULL;
-		recently_found_y = NULL;
-		recently_found_countdown = -1;
+		for(int x = 1; x <= map_x; x++)
+		{
+			if(has_open_roof(x, y) && chamber_parent[get_index(x, y)] == NO_CHAMBER)
+			{
+				add_to_chamber(x, y);
+			}
+		}
+	}
+	
+	// Water that can still spread starts again on the next turn.
+	for(int index = 0; index < MINE_TILES; index++)
+	{
+		materials contents = (materials)(tiles[index] & TILE_MATERIAL_MASK);
+		
+		if(water_level[index] > 0 && (contents == WATER || contents == SPRING))
+		{
+			activate_water(index);
+		}
 	}
 }
 
+const unsigned char *MineData::get_water_levels()
+{
+	return water_level;
+}
 
-// Returns for all of the values that are associated with the recently founds.
-materials MineData::return_recently_found_material()
+void MineData::load_water_levels(const unsigned char *saved)
 {
-	return recently_found_material;
+	memcpy(water_level, saved, MINE_TILES);
 }
 
-int MineData::return_recently_found_x()
+// The materials the flashlight can catch in unexplored ground.
+const unsigned int HINTED_MATERIALS = (1 << GRANITE) | (1 << SPRING) | (1 << CAVE_IN) | (1 << COAL)
+	| (1 << SILVER) | (1 << GOLD) | (1 << PLATINUM) | (1 << DIAMOND);
+
+// Shine the flashlight from x, y out to radius tiles on this turn.
+void MineData::update_hints(int x, int y, int radius, int turn)
 {
-	return recently_found_x;
+	// Put out where it shone before.
+	for(int lit_y = hint_y - hint_radius; lit_y <= hint_y + hint_radius; lit_y++)
+	{
+		for(int lit_x = hint_x - hint_radius; lit_x <= hint_x + hint_radius; lit_x++)
+		{
+			if(in_bounds(lit_x, lit_y))
+			{
+				tiles[get_index(lit_x, lit_y)] &= ~TILE_HINTED;
+			}
+		}
+	}
+	
+	hint_x = x;
+	hint_y = y;
+	hint_radius = radius;
+	
+	for(int lit_y = y - radius; lit_y <= y + radius; lit_y++)
+	{
+		for(int lit_x = x - radius; lit_x <= x + radius; lit_x++)
+		{
+			if(!in_bounds(lit_x, lit_y))
+			{
+				continue;
+			}
+			
+			int index = get_index(lit_x, lit_y);
+			unsigned char tile = tiles[index];
+			
+			if((tile & TILE_EXPLORED) || !(HINTED_MATERIALS & (1 << (tile & TILE_MATERIAL_MASK))))
+			{
+				continue;
+			}
+			
+			// The same tile on the same turn always comes out the same.
+			if(mix_bits(((unsigned long long)turn << 32) | (unsigned int)index) % FLASHLIGHT_HINT_ODDS == 0)
+			{
+				tiles[index] = tile | TILE_HINTED;
+			}
+		}
+	}
 }
 
-int MineData::return_recently_found_y()
+bool MineData::get_hinted(int x, int y)
 {
-	return recently_found_y;
+	return (tiles[get_index(x, y)] & TILE_HINTED) != 0;
+}
+
+// Return the dimensions of the map
+int MineData::get_map_x()
+{
+	return map_x;
+}
+
+int MineData::get_map_y()
+{
+	return map_y;
 }
 
-int MineData::return_recently_found_countdown()
+// Returns the seed the mine was made from.
+unsigned int MineData::get_seed()
 {
-	return recently_found_countdown;
+	return seed;
 }
 
 // Used to set the location of the diamond for when the game is loaded.
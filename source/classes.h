@@ -22,17 +22,56 @@
  
  Both keep track of information about the player's status and
  what has happened within the mine.
+ 
+ Neither depends on SDL. Anything the player should be told about is
+ sent as a Game_Event to the player's event sink (see game_events.h).
  */
 
 
 #ifndef CLASSES
 #define CLASSES
 
-#include "SDL/SDL.h"
-#include "SDL_ttf/SDL_ttf.h"
+#include <vector>
+
+#include "game_random.h"
+#include "market.h"
+#include "turn_scheduler.h"
 
-class SDL_Objects;
 class MineData;
+class Game_Event_Sink;
+class Game_Recorder;
+struct Game_Event;
+
+// Costs and limits used by the rules. Kept together so they can be
+// tuned with the simulator (tools/simulator.cpp).
+const int DIG_COST = 20;			// Digging a tile without the shovel.
+const int SHOVEL_DIG_COST = 15;		// Digging a tile with the shovel.
+const int GRANITE_DIG_COST = 30;	// Chipping through granite with the pickaxe.
+const int BUCKET_COST = 40;			// Clearing water with the bucket.
+const int INSURANCE_TURNS = 50;		// How many turns insurance lasts.
+const int MAX_DYNAMITE = 3;			// Sticks of dynamite the player can carry.
+const int DYNAMITE_FUSE_TURNS = 2;	// Turns from lighting dynamite to the blast.
+									// Only moves that take a turn burn the fuse;
+									// walking through tunnels already dug doesn't.
+
+// Enumeration to keep track of what is located where in the mine.
+enum materials{
+	DIRT,		// ENUM 0 (used to show unexplored areas)
+	GRANITE,	// ENUM 1 (ued to show granite)
+	CAVE_IN,	// ENUM 2 (used to store cave in locations)
+	SPRING,		// ENUM 3 (used to store where springs are)
+	COAL,		// ENUM 4 (used to store coal locations)
+	SILVER,		// ENUM 5 (used to store silver locations)
+	GOLD,		// ENUM 6 (used to store where gold is)
+	PLATINUM,	// ENUM 7 (used to store where platinum is)
+	EXPLORED,	// ENUM 8 (used to store where a player has explored)
+	SHAFT,		// ENUM 9 (used to store the location of the elevator shaft)
+	ELEVATOR,	// ENUM 10 (used to store the location of the elevator)
+	WATER,		// ENUM 11 (used to store water from a spring)
+	DYNAMITE,	// ENUM 12 (used to store where dynamite has been placed)
+	DIAMOND,	// ENUM 13 (the diamond that mimi's been looking for!)
+	NOTHING		// ENUM 14 (used for when the user hasn't found anything there recently)
+};
 
 // Class to hold all data pertaining to the player
 class PlayerData
@@ -47,10 +86,8 @@ class PlayerData
 		int gold;
 		int platinum;
 		
-		int coal_value;
-		int silver_value;
-		int gold_value;
-		int platinum_value;
+		// The bank's prices.
+		Mineral_Market market;
 		
 		// Allows to keep track of how many turns have been taken.
 		// Used to randomize mineral values at the bank and when
@@ -63,30 +100,58 @@ class PlayerData
 		// Storage for the player's possessions
 		bool has_axe;
 		bool has_bucket;
-		bool has_dynamite;
+		int dynamite;				// Sticks carried.
 		bool has_flashlight;
 		bool has_hardhat;
 		bool has_shovel;
 		bool has_diamond;
 		bool has_insurance;
 		
-		// Variables concerned with dynamite usage.
-		bool dynamite_primed;
-		int dynamite_timer;
-		
 		// Storage for player's location in the mine
 		int location_x;
 		int location_y;
 		int previous_location_x;
 		int previous_location_y;
 		
-		// Store where the player has laid down dynamite
-		int dynamite_x;
-		int dynamite_y;
+		// Lit dynamite, and anything else set to happen on a later turn.
+		Turn_Scheduler scheduler;
+		
+		// The area of the mine the last tavern tip pointed to.
+		bool has_tip;
+		int tip_x;
+		int tip_y;
+		int tip_width;
+		int tip_height;
+		
+		// Where events are sent. NULL if nobody is listening.
+		Game_Event_Sink *event_sink;
+		
+		// Where the player's actions are recorded. NULL if they aren't.
+		Game_Recorder *recorder;
+		
+		// Used for the minerals found and their value at the bank.
+		unsigned int seed;
+		Game_Random random;
 		
 	public:
 		PlayerData();
 		
+		// Start the player again for a new game, as the constructor does,
+		// with their random numbers from a seed. Where events and actions
+		// are sent is kept. Nothing is allocated, so one player can be
+		// used for game after game.
+		void reset(unsigned int seed);
+		
+		// Restart the player's random numbers from a seed.
+		void set_seed(unsigned int seed);
+		
+		// Returns the seed the player's random numbers were last started from.
+		unsigned int get_seed();
+		
+		// A random number from 0 to range - 1, for rules kept outside
+		// this class (the tavern's tips).
+		int random_int(int range);
+		
 		// Change the player's general stats
 		void change_money(int value);
 		void change_health(int value);
@@ -94,10 +159,9 @@ class PlayerData
 		void change_silver(int value);
 		void change_gold(int value);
 		void change_platinum(int value);
-		void randomize_coal_value();
-		void randomize_silver_value();
-		void randomize_gold_value();
-		void randomize_platinum_value();
+		
+		// Move the bank's prices on one change.
+		void change_prices();
 		
 		// Retrieve the player's general stats
 		int get_money();
@@ -111,18 +175,22 @@ class PlayerData
 		int get_gold_value();
 		int get_platinum_value();
 		
+		// The bank's prices, their history and what has been sold.
+		Mineral_Market *get_market();
+		
 		// Change the player's possessions
 		void change_has_axe(bool value);
 		void change_has_bucket(bool value);
-		void change_has_dynamite(bool value);
+		void change_dynamite(int value);
 		void change_has_flashlight(bool value);
 		void change_has_hardhat(bool value);
 		void change_has_shovel(bool value);
 		void change_has_diamond(bool value);
 		void change_has_insurance(bool value);
 		
-		// Automatically effect stats according to inventory
-		void dig_function();
+		// Automatically effect stats according to inventory, digging
+		// into a tile of the material.
+		void dig_function(materials material);
 		
 		// Modify and access the player's number of turns.
 		void increment_turn_number();
@@ -139,6 +207,7 @@ class PlayerData
 		bool get_has_axe();
 		bool get_has_bucket();
 		bool get_has_dynamite();
+		int get_dynamite();
 		bool get_has_flashlight();
 		bool get_has_hardhat();
 		bool get_has_shovel();
@@ -146,70 +215,187 @@ class PlayerData
 		bool get_has_insurance();
 		
 		// Allows the player's health and money status to be checked each turn.
-		bool check_health(SDL_Objects *sdl);
+		bool check_health();
  		
-		// Primes the player's dynamite for explosion.
-		void dynamite_prime(int x, int y, MineData *mine);
+		// Lays a stick of dynamite and schedules its blast for
+		// DYNAMITE_FUSE_TURNS turns later. Returns false if it couldn't
+		// be lit.
+		bool dynamite_prime(int x, int y, MineData *mine);
 		
-		// Performs the countdown for the dynamite.
-		// Returns true if the dynamite explodes.
-		bool dynamite_countdown(MineData *mine);
+		// Check to see whether the player is inside the blast radius of
+		// dynamite at x, y.
+		bool dynamite_radius(int x, int y);
 		
-		// Check to see whether the player is inside the blast radius of the dynamite.
-		bool dynamite_radius();
-		
-		// Executed once the player's priming time is up.
+		// Executed once a charge's fuse has burnt down.
 		void dynamite_explode(int x, int y, MineData *mine);
 		
 		// Change the player's location in the mine.
-		void change_location(int x, int y, MineData *mine, SDL_Objects *sdl);
+		void change_location(int x, int y, MineData *mine);
 		
 		// Check to see if a player can move to a certain area.
 		bool valid_location(int x, int y, MineData *mine);
 		
-		// Sets the location of the dynamite.
-		void set_dynamite_location(int x, int y, MineData *mine);
-		
 		// Retrieve the x and y coords of the player.
 		int get_location_x();
 		int get_location_y();
 		int get_previous_location_x();
 		int get_previous_location_y();
 
-		// Get the location of the dynamite.
-		int get_dynamite_location_x();
-		int get_dynamite_location_y();
+		// Effects waiting for a later turn.
+		Turn_Scheduler *get_scheduler();
+		
+		// Remember the area the last tavern tip pointed to.
+		void set_tip_region(int x, int y, int width, int height);
+		bool get_has_tip();
+		int get_tip_x();
+		int get_tip_y();
+		int get_tip_width();
+		int get_tip_height();
+		
+		// Set where the player's events are sent.
+		void set_event_sink(Game_Event_Sink *sink);
+		Game_Event_Sink *get_event_sink();
+		
+		// Send an event to the event sink, if there is one.
+		void send_event(const Game_Event &event);
+		
+		// Set where the player's actions are recorded (see game_recorder.h).
+		void set_recorder(Game_Recorder *recorder);
+		Game_Recorder *get_recorder();
 };
 
-// Enumeration to keep track of what is located where in the mine.
-enum materials{
-	DIRT,		// ENUM 0 (used to show unexplored areas)
-	GRANITE,	// ENUM 1 (ued to show granite)
-	CAVE_IN,	// ENUM 2 (used to store cave in locations)
-	SPRING,		// ENUM 3 (used to store where springs are)
-	COAL,		// ENUM 4 (used to store coal locations)
-	SILVER,		// ENUM 5 (used to store silver locations)
-	GOLD,		// ENUM 6 (used to store where gold is)
-	PLATINUM,	// ENUM 7 (used to store where platinum is)
-	EXPLORED,	// ENUM 8 (used to store where a player has explored)
-	SHAFT,		// ENUM 9 (used to store the location of the elevator shaft)
-	ELEVATOR,	// ENUM 10 (used to store the location of the elevator)
-	WATER,		// ENUM 11 (used to store water from a spring)
-	DYNAMITE,	// ENUM 12 (used to store where dynamite has been placed)
-	DIAMOND,	// ENUM 13 (the diamond that mimi's been looking for!)
-	NOTHING		// ENUM 14 (used for when the user hasn't found anything there recently)
-};
 
+// Size of the storage for the mine, in tiles.
+const int MINE_WIDTH = 192;
+const int MINE_HEIGHT = 192;
+const int MINE_TILES = MINE_WIDTH * MINE_HEIGHT;
+
+// Each tile of the mine is packed into one byte: the material in the
+// low bits and whether it has been explored in the high bits.
+const unsigned char TILE_MATERIAL_MASK = 0x0F;
+const unsigned char TILE_EXPLORED = 0x10;
+const unsigned char TILE_WATER_ACTIVE = 0x20;	// In the water's worklist.
+const unsigned char TILE_HINTED = 0x40;			// The flashlight shows something here.
+
+// How far the flashlight reaches from the player, and the odds (one in
+// this many) of it catching something in each tile it reaches on a move.
+const int FLASHLIGHT_RADIUS = 1;
+const int FLASHLIGHT_HINT_ODDS = 6;
+
+// How far a spring's water spreads. Flowing down costs nothing, along
+// a tunnel costs 1 and up costs 2.
+const unsigned char WATER_PRESSURE = 6;
+
+// Water never comes closer to the elevator than this.
+const int WATER_MIN_X = 3;
+
+// A chamber is dug-out ground at least two tiles high. Wider than this
+// and its roof falls in.
+const int CAVE_IN_SPAN = 5;
+
+// How wide a chamber can stay when the ground beside it falls in.
+const int CAVE_IN_CHAIN_SPAN = 3;
+
+// Chambers a cave-in remembers having shaken. Any more are shaken again
+// for each fallen tile they're near, which costs time but not results.
+const int CAVE_IN_SHAKEN_MAX = 16;
+
+// A tile that isn't in a chamber. Chambers are kept by tile index, which
+// always fits below this.
+const unsigned short NO_CHAMBER = 0xFFFF;
+
+// Room a mine only needs while it's working through a turn: the water
+// moving this turn and the tiles of a chamber being taken apart. Mines
+// used one at a time, like a server shard's, can share one.
+struct Mine_Scratch
+{
+	int water_active[MINE_TILES];
+	int chamber_tiles[MINE_TILES];
+};
 
 // Class to hold all data pertaining to the mining field
 class MineData
 {
 	private:
-		// Refers to above enumeration.		
-		materials mine_contents[192][192];
-		
-		// Refers to whether the player has explored an area or not.
-		bool explored[192][192];
+		// The packed tiles, row by row (see get_index).
+		unsigned char tiles[MINE_TILES];
+		
+		// Each tile's material and explored bit hashed with its place,
+		// all XORed together. Kept up to date as tiles change, so the
+		// whole mine can be checked without reading it.
+		unsigned long long tile_checksum;
+		
+		// Change a tile's byte, keeping tile_checksum and the changed
+		// tiles up to date.
+		void write_tile(int index, unsigned char tile);
+		
+		// The tiles whose material or explored bit has changed since
+		// the changes were last forgotten, for the save journal (see
+		// save_load.h). Each is listed once.
+		unsigned int changed_bits[(MINE_TILES + 31) / 32];
+		std::vector<int> changed_tiles;
+		
+		// How much further the water in each tile can spread.
+		unsigned char water_level[MINE_TILES];
+		
+		// The water that moves on the next turn. This turn's is kept in
+		// the scratch while it moves.
+		std::vector<int> water_next;
+		
+		// Put a tile's water in the worklist for the next turn.
+		void activate_water(int index);
+		
+		// Wake any water next to a tile that has just been opened up.
+		void wake_water(int x, int y);
+		
+		// The chambers, as disjoint sets of the tiles whose roof is dug
+		// out too. Each set's tiles are also kept in a ring, so a set can
+		// be taken apart without looking at the rest of the mine.
+		unsigned short chamber_parent[MINE_TILES];	// NO_CHAMBER if not in a chamber.
+		unsigned short chamber_next[MINE_TILES];
+		unsigned char chamber_left[MINE_TILES];		// The chamber's extent, kept at its root.
+		unsigned char chamber_right[MINE_TILES];
+		
+		// Chambers to check at the end of the turn.
+		std::vector<int> chamber_pending;
+		
+		// The scratch, shared or the mine's own, made when first needed.
+		Mine_Scratch *scratch;
+		bool owns_scratch;
+		Mine_Scratch *get_scratch();
+		
+		// Can't be copied; the scratch would be freed twice.
+		MineData(const MineData &);
+		MineData &operator=(const MineData &);
+		
+		// Returns true if a tile has been dug out.
+		bool is_open(int x, int y);
+		
+		// Returns true if a tile and the one above it have been dug out.
+		bool has_open_roof(int x, int y);
+		
+		// Chamber bookkeeping, called as tiles are dug out or filled in.
+		int find_chamber(int index);
+		void join_chambers(int a, int b);
+		void add_to_chamber(int x, int y);
+		void link_to_chamber(int x, int y);
+		void check_relinked(const int *chamber_tiles, int count, bool shaken);
+		void break_up_chamber(int index);
+		void tile_opened(int x, int y);
+		void tile_closed(int x, int y);
+		void check_chamber_later(int index, bool shaken);
+		
+		// Fill in a chamber. Returns how many tiles fell in.
+		int collapse_chamber(int index, int player_x, int player_y, bool &player_hit);
+		
+		// Turn a tile back into unexplored ground, with whatever might be in it.
+		void fill_with_rubble(int x, int y);
+		
+		// The square the flashlight last shone on, so its hints can be
+		// cleared. hint_radius is -1 if it hasn't.
+		int hint_x;
+		int hint_y;
+		int hint_radius;
 		
 		// Stores where the diamond is located.
 		int diamond_x;
@@ -219,17 +405,35 @@ class MineData
 		int map_x;
 		int map_y;
 		
-		// Information for what has been recently found.
-		materials recently_found_material;
-		int recently_found_x;
-		int recently_found_y;
-		int recently_found_countdown;
+		// The seed the mine was made from, and the generator used for
+		// the mine and anything that later changes it (cave-ins).
+		unsigned int seed;
+		Game_Random random;
 		
 	public:
-		// Class initializer.
+		// Class initializer. Without a seed, the mine is left empty, as
+		// clear leaves it, for reset or a saved game to fill.
 		MineData();	
+		MineData(unsigned int seed);
 		~MineData();
 		
+		// Make a new mine from a seed in place of the old one. The same
+		// seed always gives the same mine. Nothing is allocated, so one
+		// mine can be used for game after game.
+		void reset(unsigned int seed);
+		
+		// Empty the mine and start its random numbers from a seed,
+		// without making a new mine: for a saved game to be loaded into,
+		// or randomize_mine to fill.
+		void clear(unsigned int seed);
+		
+		// Returns the seed the mine was made from.
+		unsigned int get_seed();
+		
+		// Use scratch shared with other mines, rather than the mine's
+		// own. Only one of them can be working through a turn at a time.
+		void set_scratch(Mine_Scratch *shared);
+		
 		// Randomize the mine.
 		void randomize_mine();
 		
@@ -250,9 +454,37 @@ class MineData
 		// Simulates the mine caving in.
 		void cave_in(int x, int y);
 		
-		// Simulates the mine being flooded by a spring.
+		// A spring has been hit: start its water flowing.
 		void water_flow(int x, int y);
 		
+		// Let the water spread for a turn. Called from end_turn once for
+		// each turn the player takes, so it spreads a tile per turn
+		// however the keys are held. Only tiles whose water can still
+		// move are looked at. Returns how many were.
+		int water_turn();
+		
+		// Returns how many tiles of water will move next turn.
+		int get_water_active();
+		
+		// Collapse any chamber dug too wide, and any chamber beside it
+		// that's too weak to stand the shock. Only chambers changed since
+		// the last check are looked at. player_hit is set if the player
+		// was next to the fall. Returns how many tiles fell in.
+		int check_supports(int player_x, int player_y, bool &player_hit);
+		
+		// Width of the chamber a tile is in, or 0 if it isn't in one.
+		int get_chamber_width(int x, int y);
+		
+		// Shine the flashlight from x, y out to radius tiles on this turn,
+		// clearing where it shone before. Which unexplored tiles with
+		// something in them it catches depends only on the tile and the
+		// turn, so it doesn't change between frames. A radius below zero
+		// only clears the hints.
+		void update_hints(int x, int y, int radius, int turn);
+		
+		// Returns true if the flashlight shows something in a tile.
+		bool get_hinted(int x, int y);
+		
 		// Gets where the diamond is located.
 		int get_diamond_x();
 		int get_diamond_y();
@@ -261,18 +493,37 @@ class MineData
 		int get_map_x();
 		int get_map_y();
 		
-		// Allow a recently found item to be set. (ANIMATION OF MINERALS)
-		void add_recently_found(int x, int y, materials contents);
+		// Returns true if a tile is inside the mine.
+		bool in_bounds(int x, int y);
+		
+		// Where a tile is kept in the packed tiles.
+		int get_index(int x, int y);
+		
+		// The packed tiles, for code that needs to scan the whole mine.
+		const unsigned char *get_tiles();
+		
+		// Put back every tile of a saved mine at once, MINE_TILES of
+		// them packed as get_tiles has them. Only the material and
+		// explored bits are kept. The mine should have been cleared.
+		void load_tiles(const unsigned char *saved);
+		
+		// How much further the water in each tile can spread, by index,
+		// for code that saves the whole mine.
+		const unsigned char *get_water_levels();
+		
+		// Put back the water's levels from a save. Call before
+		// load_tiles, which sets any water that can still spread
+		// flowing again.
+		void load_water_levels(const unsigned char *saved);
 		
-		// Increment the counter for recently found. (ANIMATION OF MINERALS)
-		void count_recently_found();
+		// A checksum of every tile's material and explored bit.
+		unsigned long long get_tile_checksum();
 		
-		// Returns for the values within the recently founds.
-		// Used for the animation of found minerals.
-		materials return_recently_found_material();
-		int return_recently_found_x();
-		int return_recently_found_y();
-		int return_recently_found_countdown();
+		// The tiles changed since the mine was cleared or the changes
+		// were last forgotten, by index.
+		int get_changed_count();
+		const int *get_changed_tiles();
+		void forget_changes();
 		
 		// Used to set the location of the diamond for when the game is loaded.
 		void set_diamond_location(int x, int y);
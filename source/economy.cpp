@@ -0,0 +1,355 @@
+/*
+ economy.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ The town's economy: selling minerals at the bank, buying from the
+ store, paying the hospital and buying tips at the tavern.
+*/
+
+#include "classes.h"
+#include "game_events.h"
+#include "economy.h"
+#include "game_recorder.h"
+
+// Sell all of one mineral at the current price.
+int sell_mineral(PlayerData *player, materials mineral)
+{
+	Record_Scope record(player, ACTION_SELL_MINERAL, mineral);
+
+	int amount = 0;
+	int value = 0;
+
+	if(mineral == COAL)
+	{
+		amount = player->get_coal();
+		value = amount * player->get_coal_value();
+		player->change_coal(-amount);
+		player->get_market()->record_sale(MARKET_COAL, amount);
+	}
+	else if(mineral == SILVER)
+	{
+		amount = player->get_silver();
+		value = amount * player->get_silver_value();
+		player->change_silver(-amount);
+		player->get_market()->record_sale(MARKET_SILVER, amount);
+	}
+	else if(mineral == GOLD)
+	{
+		amount = player->get_gold();
+		value = amount * player->get_gold_value();
+		player->change_gold(-amount);
+		player->get_market()->record_sale(MARKET_GOLD, amount);
+	}
+	else if(mineral == PLATINUM)
+	{
+		amount = player->get_platinum();
+		value = amount * player->get_platinum_value();
+		player->change_platinum(-amount);
+		player->get_market()->record_sale(MARKET_PLATINUM, amount);
+	}
+
+	if(amount > 0)
+	{
+		player->change_money(value);
+		player->send_event(Game_Event(EVENT_MINERAL_SOLD, 0, 0, mineral, amount, value));
+	}
+
+	return value;
+}
+
+// Sell every mineral the player is carrying.
+int sell_all_minerals(PlayerData *player)
+{
+	Record_Scope record(player, ACTION_SELL_ALL);
+
+	int value = 0;
+
+	value += sell_mineral(player, PLATINUM);
+	value += sell_mineral(player, GOLD);
+	value += sell_mineral(player, SILVER);
+	value += sell_mineral(player, COAL);
+
+	return value;
+}
+
+// Give the minerals new values if enough turns have passed.
+void randomize_mineral_values(PlayerData *player)
+{
+	Record_Scope record(player, ACTION_NEW_PRICES);
+
+	int price_changes = (player->get_turn_number() - player->get_previous_turn_number()) / PRICE_CHANGE_TURNS;
+
+	if(price_changes > 0)
+	{
+		// Catch up on every change missed while the player was away,
+		// as far back as the history goes.
+		if(price_changes > PRICE_HISTORY)
+		{
+			price_changes = PRICE_HISTORY;
+		}
+
+		for(int change = 0; change < price_changes; change++)
+		{
+			player->change_prices();
+		}
+
+		player->set_previous_turn_number();
+
+		player->send_event(Game_Event(EVENT_PRICES_CHANGED));
+	}
+}
+
+int get_item_price(store_item item)
+{
+	if(item == ITEM_SHOVEL)
+	{
+		return 250;
+	}
+	else if(item == ITEM_AXE)
+	{
+		return 200;
+	}
+	else if(item == ITEM_BUCKET)
+	{
+		return 250;
+	}
+	else if(item == ITEM_DYNAMITE)
+	{
+		return 500;
+	}
+	else if(item == ITEM_FLASHLIGHT)
+	{
+		return 300;
+	}
+	else
+	{
+		return 200;		// ITEM_HARDHAT
+	}
+}
+
+// Returns whether the player already has an item, or as much dynamite
+// as they can carry.
+static bool player_has_item(PlayerData *player, store_item item)
+{
+	if(item == ITEM_SHOVEL)
+	{
+		return player->get_has_shovel();
+	}
+	else if(item == ITEM_AXE)
+	{
+		return player->get_has_axe();
+	}
+	else if(item == ITEM_BUCKET)
+	{
+		return player->get_has_bucket();
+	}
+	else if(item == ITEM_DYNAMITE)
+	{
+		return player->get_dynamite() >= MAX_DYNAMITE;
+	}
+	else if(item == ITEM_FLASHLIGHT)
+	{
+		return player->get_has_flashlight();
+	}
+	else
+	{
+		return player->get_has_hardhat();
+	}
+}
+
+// Buy an item at the store.
+bool buy_item(PlayerData *player, store_item item)
+{
+	Record_Scope record(player, ACTION_BUY_ITEM, item);
+
+	int price = get_item_price(item);
+
+	if(player_has_item(player, item))
+	{
+		player->send_event(Game_Event(EVENT_ITEM_OWNED, 0, 0, NOTHING, item));
+		return false;
+	}
+
+	if(player->get_money() < price)
+	{
+		player->send_event(Game_Event(EVENT_ITEM_UNAFFORDABLE, 0, 0, NOTHING, item));
+		return false;
+	}
+
+	if(item == ITEM_SHOVEL)
+	{
+		player->change_has_shovel(true);
+	}
+	else if(item == ITEM_AXE)
+	{
+		player->change_has_axe(true);
+	}
+	else if(item == ITEM_BUCKET)
+	{
+		player->change_has_bucket(true);
+	}
+	else if(item == ITEM_DYNAMITE)
+	{
+		player->change_dynamite(1);
+	}
+	else if(item == ITEM_FLASHLIGHT)
+	{
+		player->change_has_flashlight(true);
+	}
+	else
+	{
+		player->change_has_hardhat(true);
+	}
+
+	player->change_money(-price);
+	player->send_event(Game_Event(EVENT_ITEM_BOUGHT, 0, 0, NOTHING, item, price));
+
+	return true;
+}
+
+void stay_one_day(PlayerData *player)
+{
+	Record_Scope record(player, ACTION_STAY_ONE_DAY);
+
+	if(player->get_health() <= 100 && player->get_money() >= 10)
+	{
+		player->change_health(10);
+		player->change_money(-HOSPITAL_DAY_PRICE);
+		player->send_event(Game_Event(EVENT_HEALED, 0, 0, NOTHING, 10, HOSPITAL_DAY_PRICE));
+	}
+}
+
+void full_heal(PlayerData *player)
+{
+	Record_Scope record(player, ACTION_FULL_HEAL);
+
+	int healed = 0;
+
+	while(player->get_health() < 100 && player->get_money() >= HOSPITAL_HEALTH_PRICE)
+	{
+		player->change_health(1);
+		player->change_money(-HOSPITAL_HEALTH_PRICE);
+		healed++;
+	}
+
+	if(healed > 0)
+	{
+		player->send_event(Game_Event(EVENT_HEALED, 0, 0, NOTHING, healed, healed * HOSPITAL_HEALTH_PRICE));
+	}
+}
+
+// Buy insurance at the hospital.
+bool buy_insurance(PlayerData *player)
+{
+	Record_Scope record(player, ACTION_BUY_INSURANCE);
+
+	if(player->get_money() >= INSURANCE_PRICE
+		&& (player->get_insurance_turn_number() + 25) < player->get_turn_number())
+	{
+		player->change_has_insurance(true);
+		player->set_insurance_turn_number();
+		player->change_money(-INSURANCE_PRICE);
+
+		player->send_event(Game_Event(EVENT_INSURANCE_BOUGHT, 0, 0, NOTHING, 0, INSURANCE_PRICE));
+
+		return true;
+	}
+	else if(player->get_money() < INSURANCE_PRICE)
+	{
+		player->send_event(Game_Event(EVENT_INSURANCE_UNAFFORDABLE));
+	}
+	else if(player->get_insurance_turn_number() == player->get_turn_number())
+	{
+		player->send_event(Game_Event(EVENT_INSURANCE_MAXED));
+	}
+
+	return false;
+}
+
+int get_tip_price(tip_amount tip)
+{
+	if(tip == CHEAP)
+	{
+		return 250;
+	}
+	else if(tip == GOOD)
+	{
+		return 750;
+	}
+	else
+	{
+		return 1500;
+	}
+}
+
+// Buy a tip at the tavern.
+bool buy_tip(PlayerData *player, tip_amount tip)
+{
+	Record_Scope record(player, ACTION_BUY_TIP, tip);
+
+	int price = get_tip_price(tip);
+
+	if(player->get_money() < price)
+	{
+		player->send_event(Game_Event(EVENT_TIP_UNAFFORDABLE, 0, 0, NOTHING, tip));
+		return false;
+	}
+
+	player->change_money(-price);
+	player->send_event(Game_Event(EVENT_TIP_BOUGHT, 0, 0, NOTHING, tip, price));
+
+	return true;
+}
+
+// Work out the area of the mine a tip points to.
+void make_tip_region(PlayerData *player, MineData *mine, tip_amount tip)
+{
+	Record_Scope record(player, ACTION_TIP_REGION, tip);
+
+	int diamond_x = mine->get_diamond_x();
+	int diamond_y = mine->get_diamond_y();
+	
+	if(tip == CHEAP)
+	{
+		// The quarter of the mine the diamond is in.
+		int quarter_x = 0;
+		int quarter_y = 0;
+		
+		if(diamond_x > 96)
+		{
+			quarter_x = 96;
+		}
+		
+		if(diamond_y > 96)
+		{
+			quarter_y = 96;
+		}
+		
+		player->set_tip_region(quarter_x, quarter_y, 96, 96);
+	}
+	else if(tip == GOOD)
+	{
+		// A 24 tile square somewhere around the diamond.
+		player->set_tip_region(diamond_x - player->random_int(12), diamond_y - player->random_int(24), 24, 24);
+	}
+	else
+	{
+		// A 6 tile square centred on the diamond.
+		player->set_tip_region(diamond_x - 2, diamond_y - 2, 6, 6);
+	}
+}
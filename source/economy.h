@@ -0,0 +1,89 @@
+/*
+ economy.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ The town's economy: selling minerals at the bank, buying from the
+ store, paying the hospital and buying tips at the tavern.
+
+ The town screens only draw and take input; every transaction goes
+ through here, so it can be run without SDL. Refusals (can't afford,
+ already owned) are reported through the player's event sink.
+*/
+
+#ifndef ECONOMY
+#define ECONOMY
+
+#include "classes.h"
+
+// Items for sale at the store.
+enum store_item
+{
+	ITEM_SHOVEL,
+	ITEM_AXE,
+	ITEM_BUCKET,
+	ITEM_DYNAMITE,
+	ITEM_FLASHLIGHT,
+	ITEM_HARDHAT
+};
+
+// Enumerations for the amount of tip chosen.
+enum tip_amount
+{
+	CHEAP,
+	GOOD,
+	BEST
+};
+
+// Prices in town.
+const int INSURANCE_PRICE = 250;
+const int HOSPITAL_DAY_PRICE = 100;
+const int HOSPITAL_HEALTH_PRICE = 10;	// Per point of health when fully healing.
+
+// Number of turns between changes in the bank's prices.
+const int PRICE_CHANGE_TURNS = 10;
+
+// Sell all of one mineral at the current price. Returns the money made.
+int sell_mineral(PlayerData *player, materials mineral);
+
+// Sell every mineral the player is carrying. Returns the money made.
+int sell_all_minerals(PlayerData *player);
+
+// Give the minerals new values if enough turns have passed: one change
+// in the market (see market.h) for every PRICE_CHANGE_TURNS.
+void randomize_mineral_values(PlayerData *player);
+
+// Buy an item at the store. Returns true if it was bought.
+int get_item_price(store_item item);
+bool buy_item(PlayerData *player, store_item item);
+
+// Hospital stays.
+void stay_one_day(PlayerData *player);
+void full_heal(PlayerData *player);
+
+// Buy insurance at the hospital. Returns true if it was bought.
+bool buy_insurance(PlayerData *player);
+
+// Buy a tip at the tavern. Returns true if it was bought.
+int get_tip_price(tip_amount tip);
+bool buy_tip(PlayerData *player, tip_amount tip);
+
+// Work out the area of the mine a tip points to and give it to the
+// player, who can then head there (see autopilot.h).
+void make_tip_region(PlayerData *player, MineData *mine, tip_amount tip);
+
+#endif
@@ -31,12 +31,19 @@
 #include "sdl_functions.h"
 #include "classes.h"
 #include "timer.h"
+#include "trace.h"
 
 #include "endgame_screens.h"
+#include "game_statistics.h"
 
 // Call the ending.
-void display_ending(SDL_Objects *sdl, PlayerData *player, MineData *mine)
+void display_ending(SDL_Objects *sdl, PlayerData *player)
 {
+	Trace_Zone zone("display_ending", TRACE_SCREEN);
+	
+	// Clear the mine's view from around the screen.
+	sdl->clear_screen();
+
 	// Create the endgame data.
 	Endgame_Screen_Data endgame_data;
 	
@@ -51,11 +58,11 @@ void display_ending(SDL_Objects *sdl, PlayerData *player, MineData *mine)
 	// Display the proper screen according to the player's wealth.
 	if(player->get_money() < 5000)
 	{
-		endgame_data.display_bad_ending_screen(sdl, player, mine);
+		endgame_data.display_bad_ending_screen(sdl, player);
 	}
 	else
 	{
-		endgame_data.display_good_ending_screen(sdl, player, mine);
+		endgame_data.display_good_ending_screen(sdl, player);
 	}
 	
 	// Update the screen.
@@ -83,12 +90,12 @@ void display_ending(SDL_Objects *sdl, PlayerData *player, MineData *mine)
 // Initialize the objects
 Endgame_Screen_Data::Endgame_Screen_Data()
 {
-	good_background = IMG_Load("./Graphics/ending_screen/good_ending.png");
-	bad_background = IMG_Load("./Graphics/ending_screen/bad_ending.png");
+	good_background = load_image("graphics/ending_screen/good_ending.png");
+	bad_background = load_image("graphics/ending_screen/bad_ending.png");
 	
-	big_header_font = TTF_OpenFont("./Fonts/DejaVuSans-Bold.ttf", 36);
-	header_font = TTF_OpenFont("./Fonts/DejaVuSans-Bold.ttf", 28);
-	standard_font = TTF_OpenFont("./Fonts/DejaVuSans-Bold.ttf", 20);
+	big_header_font = open_font("Fonts/DejaVuSans-Bold.ttf", 36);
+	header_font = open_font("Fonts/DejaVuSans-Bold.ttf", 28);
+	standard_font = open_font("Fonts/DejaVuSans-Bold.ttf", 20);
 }
 
 // Take the objects out of memory.
@@ -103,7 +110,7 @@ Endgame_Screen_Data::~Endgame_Screen_Data()
 }
 
 // Refresh the good ending screen.
-void Endgame_Screen_Data::display_good_ending_screen(SDL_Objects *sdl, PlayerData *player, MineData *mine)
+void Endgame_Screen_Data::display_good_ending_screen(SDL_Objects *sdl, PlayerData *player)
 {
 	// Apply the background image.
 	sdl->apply_surface(0, 0, good_background, sdl->return_screen());
@@ -120,61 +127,12 @@ void Endgame_Screen_Data::display_good_ending_screen(SDL_Objects *sdl, PlayerDat
 	// Apply the header for the statistics.
 	sdl->apply_text(495, 250, "STATS", big_header_font, sdl->return_screen());
 	
-	// Stats to list: total gold, % of mine explored, # of turns
-	sdl->apply_text(445, 300, "Total Gold:", standard_font, sdl->return_screen());
-	sdl->apply_text(445, 325, "% Explored:", standard_font, sdl->return_screen());
-	sdl->apply_text(445, 350, "# of Turns:", standard_font, sdl->return_screen());
-	sdl->apply_text(445, 375, "Health:", standard_font, sdl->return_screen());
-	
-	// Stores the temporary values for strings being posted on the screen.
-	std::string temp_string;
-	std::stringstream temp_stringstream;	
-	int temp_int = 0;
-	
-	temp_int = player->get_money();
-	temp_stringstream << temp_int;
-	temp_string = temp_stringstream.str();
-	sdl->apply_text(610, 300, temp_string, standard_font, sdl->return_screen());
-	temp_stringstream.str("");
-	
-	// Compute the amount of the mine that has been explored
-	temp_int = 0;
-	for(int x = 1; x < mine->get_map_x(); x++)
-	{
-		for(int y = 0; y < mine->get_map_y(); y++)
-		{
-			if(mine->get_explored(x, y))
-			{
-				temp_int++;
-			}
-		}
-	}
-	
-	// Calculate the percentage of the mine that has been explored.
-	temp_int = ((double)temp_int / 36864) * 100;
-	temp_stringstream << temp_int << "%";
-	temp_string = temp_stringstream.str();
-	sdl->apply_text(610, 325, temp_string, standard_font, sdl->return_screen());
-	temp_stringstream.str("");	
-	
-	// State the number of turns taken.
-	temp_int = player->get_turn_number();
-	temp_stringstream << temp_int;
-	temp_string = temp_stringstream.str();
-	sdl->apply_text(610, 350, temp_string, standard_font, sdl->return_screen());
-	temp_stringstream.str("");
-	
-	// Display the player's ending health
-	temp_int = player->get_health();
-	temp_stringstream << temp_int;
-	temp_string = temp_stringstream.str();
-	sdl->apply_text(610, 375, temp_string, standard_font, sdl->return_screen());
-	temp_stringstream.str("");
-	
+	// The game's statistics, as counted while it was played.
+	display_stats(sdl, player);
 }
 
 // Refresh the bad ending screen.
-void Endgame_Screen_Data::display_bad_ending_screen(SDL_Objects *sdl, PlayerData *player, MineData *mine)
+void Endgame_Screen_Data::display_bad_ending_screen(SDL_Objects *sdl, PlayerData *player)
 {
 	// Apply the background image.
 	sdl->apply_surface(0, 0, bad_background, sdl->return_screen());
@@ -193,55 +151,49 @@ void Endgame_Screen_Data::display_bad_ending_screen(SDL_Objects *sdl, PlayerData
 	// Apply the header for the statistics.
 	sdl->apply_text(495, 250, "STATS", big_header_font, sdl->return_screen());
 	
-	// Stats to list: total gold, % of mine explored, # of turns
-	sdl->apply_text(445, 300, "Total Gold:", standard_font, sdl->return_screen());
-	sdl->apply_text(445, 325, "% Explored:", standard_font, sdl->return_screen());
-	sdl->apply_text(445, 350, "# of Turns:", standard_font, sdl->return_screen());
-	sdl->apply_text(445, 375, "Health:", standard_font, sdl->return_screen());
-	
-	// Stores the temporary values for strings being posted on the screen.
-	std::string temp_string;
-	std::stringstream temp_stringstream;	
-	int temp_int = 0;
-	
-	temp_int = player->get_money();
-	temp_stringstream << temp_int;
-	temp_string = temp_stringstream.str();
-	sdl->apply_text(610, 300, temp_string, standard_font, sdl->return_screen());
-	temp_stringstream.str("");
-	
-	// Compute the amount of the mine that has been explored
-	temp_int = 0;
-	for(int x = 1; x < mine->get_map_x(); x++)
+	// The game's statistics, as counted while it was played.
+	display_stats(sdl, player);
+}
+
+// List the game's statistics, and the lifetime totals, under the STATS
+// header. They're all counters already; nothing is worked out here.
+void Endgame_Screen_Data::display_stats(SDL_Objects *sdl, PlayerData *player)
+{
+	Game_Statistics *statistics = get_game_statistics();
+	
+	const char *labels[] = { "Total Gold:", "# of Turns:", "Health:", "Tiles Dug:", "Minerals:", "Hazards:", "Spent:",
+							 "All Games:" };
+	
+	long long values[8];
+	values[0] = player->get_money();
+	values[1] = player->get_turn_number();
+	values[2] = player->get_health();
+	values[3] = statistics->get_game(STAT_TILES_DUG);
+	values[4] = statistics->get_game(STAT_FOUND_COAL) + statistics->get_game(STAT_FOUND_SILVER) +
+				statistics->get_game(STAT_FOUND_GOLD) + statistics->get_game(STAT_FOUND_PLATINUM);
+	values[5] = statistics->get_game(STAT_SPRINGS_HIT) + statistics->get_game(STAT_CAVE_INS) +
+				statistics->get_game(STAT_COLLAPSES) + statistics->get_game(STAT_DROWNINGS) +
+				statistics->get_game(STAT_BLAST_INJURIES);
+	values[6] = statistics->get_game(STAT_SPENT_DIGGING) + statistics->get_game(STAT_SPENT_ELEVATOR) +
+				statistics->get_game(STAT_SPENT_HOSPITAL) + statistics->get_game(STAT_SPENT_STORE) +
+				statistics->get_game(STAT_SPENT_TAVERN);
+	values[7] = statistics->get_lifetime(STAT_GAMES);
+	
+	std::stringstream temp_stringstream;
+	
+	for(int line = 0; line < 8; line++)
 	{
-		for(int y = 0; y < mine->get_map_y(); y++)
+		sdl->apply_text(445, 295 + line * 22, labels[line], standard_font, sdl->return_screen());
+		
+		temp_stringstream.str("");
+		temp_stringstream << values[line];
+		
+		// Lifetime wins go with the games.
+		if(line == 7)
 		{
-			if(mine->get_explored(x, y))
-			{
-				temp_int++;
-			}
+			temp_stringstream << " (" << statistics->get_lifetime(STAT_WINS) << " won)";
 		}
+		
+		sdl->apply_text(610, 295 + line * 22, temp_stringstream.str(), standard_font, sdl->return_screen());
 	}
-	
-	// Calculate the percentage of the mine that has been explored.
-	temp_int = ((double)temp_int / 36864) * 100;
-	temp_stringstream << temp_int << "%";
-	temp_string = temp_stringstream.str();
-	sdl->apply_text(610, 325, temp_string, standard_font, sdl->return_screen());
-	temp_stringstream.str("");	
-	
-	// State the number of turns taken.
-	temp_int = player->get_turn_number();
-	temp_stringstream << temp_int;
-	temp_string = temp_stringstream.str();
-	sdl->apply_text(610, 350, temp_string, standard_font, sdl->return_screen());
-	temp_stringstream.str("");
-	
-	// Display the player's ending health
-	temp_int = player->get_health();
-	temp_stringstream << temp_int;
-	temp_string = temp_stringstream.str();
-	sdl->apply_text(610, 375, temp_string, standard_font, sdl->return_screen());
-	temp_stringstream.str("");
-
 }
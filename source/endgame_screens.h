@@ -27,7 +27,7 @@
 #include "classes.h"
 
 // Call the ending.
-void display_ending(SDL_Objects *sdl, PlayerData *player, MineData *mine);
+void display_ending(SDL_Objects *sdl, PlayerData *player);
 
 class Endgame_Screen_Data
 {
@@ -44,10 +44,13 @@ class Endgame_Screen_Data
 		~Endgame_Screen_Data();
 		
 		// Refresh the good ending screen.
-		void display_good_ending_screen(SDL_Objects *sdl, PlayerData *player, MineData *mine);
+		void display_good_ending_screen(SDL_Objects *sdl, PlayerData *player);
 		
 		// Refresh the bad ending screen.
-		void display_bad_ending_screen(SDL_Objects *sdl, PlayerData *player, MineData *mine);
+		void display_bad_ending_screen(SDL_Objects *sdl, PlayerData *player);
+		
+		// List the game's statistics and the lifetime totals.
+		void display_stats(SDL_Objects *sdl, PlayerData *player);
 };
 
 #endif
@@ -0,0 +1,83 @@
+/*
+ game_events.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Events sent out by the game's rules.
+*/
+
+#include "game_events.h"
+
+Game_Event::Game_Event(game_event_type type, int x, int y, materials material, int amount, int value)
+{
+	this->type = type;
+	this->x = x;
+	this->y = y;
+	this->material = material;
+	this->amount = amount;
+	this->value = value;
+}
+
+Game_Event_Sink::~Game_Event_Sink()
+{
+
+}
+
+Game_Event_Dispatcher::Game_Event_Dispatcher()
+{
+	sink_count = 0;
+}
+
+// Add a sink to the end of the list.
+bool Game_Event_Dispatcher::subscribe(Game_Event_Sink *sink)
+{
+	if(sink_count >= MAX_EVENT_SINKS)
+	{
+		return false;
+	}
+
+	sinks[sink_count] = sink;
+	sink_count++;
+
+	return true;
+}
+
+// Remove a sink, keeping the others in order.
+void Game_Event_Dispatcher::unsubscribe(Game_Event_Sink *sink)
+{
+	for(int i = 0; i < sink_count; i++)
+	{
+		if(sinks[i] == sink)
+		{
+			for(int j = i; j < sink_count - 1; j++)
+			{
+				sinks[j] = sinks[j + 1];
+			}
+
+			sink_count--;
+			return;
+		}
+	}
+}
+
+void Game_Event_Dispatcher::handle_event(const Game_Event &event)
+{
+	for(int i = 0; i < sink_count; i++)
+	{
+		sinks[i]->handle_event(event);
+	}
+}
@@ -0,0 +1,120 @@
+/*
+ game_events.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Events sent out by the game's rules.
+
+ The rules (PlayerData, MineData, elevator, dynamite and the town's
+ economy) don't know about the screen. Whenever something happens
+ that the player should hear about, they hand a Game_Event to the
+ player's event sink. The SDL layer turns these into status text and
+ animations; bots, servers and benchmarks can ignore them or count them.
+*/
+
+#ifndef GAME_EVENTS
+#define GAME_EVENTS
+
+#include "classes.h"
+
+// Maximum number of sinks a dispatcher can pass events on to.
+const int MAX_EVENT_SINKS = 8;
+
+// Everything the rules can report.
+enum game_event_type
+{
+	// In the mine.
+	EVENT_TILE_DUG,				// material: what was dug into, value: cost of digging
+	EVENT_GRANITE_CHIPPED,		// Dug through granite with the pickaxe. value: cost
+	EVENT_GRANITE_BLOCKED,		// Tried granite without the pickaxe.
+	EVENT_SPRING_HIT,
+	EVENT_CAVE_IN,
+	EVENT_COLLAPSE,				// A chamber fell in away from the player. amount: tiles
+	EVENT_MINERAL_FOUND,		// material, amount: how many were found
+	EVENT_BUCKET_USED,			// value: cost
+	EVENT_DROWNING,
+	EVENT_INSURANCE_CLAIMED,
+	EVENT_INSURANCE_EXPIRED,
+	EVENT_ELEVATOR_TO_BOTTOM,	// y: level reached, value: fare
+	EVENT_ELEVATOR_TO_TOP,
+	EVENT_ELEVATOR_REFUSED,
+	EVENT_DYNAMITE_LIT,
+	EVENT_NO_DYNAMITE,
+	EVENT_DYNAMITE_EXPLODED,	// x, y: where it went off
+	EVENT_BLAST_INJURY,			// amount: health lost
+	EVENT_AUTOPILOT_ROUTE,		// x, y: target, amount: steps, value: cost in dollars
+	EVENT_AUTOPILOT_NO_ROUTE,	// x, y: target
+	EVENT_AUTOPILOT_NO_TIP,
+	EVENT_AUTOPILOT_ARRIVED,
+	EVENT_AUTOPILOT_STOPPED,	// Couldn't keep moving along the route.
+
+	// In town.
+	EVENT_MINERAL_SOLD,			// material, amount: how many, value: money made
+	EVENT_PRICES_CHANGED,
+	EVENT_ITEM_BOUGHT,			// amount: store_item, value: price
+	EVENT_ITEM_OWNED,			// amount: store_item
+	EVENT_ITEM_UNAFFORDABLE,	// amount: store_item
+	EVENT_HEALED,				// amount: health gained, value: cost
+	EVENT_INSURANCE_BOUGHT,		// value: price
+	EVENT_INSURANCE_UNAFFORDABLE,
+	EVENT_INSURANCE_MAXED,
+	EVENT_TIP_BOUGHT,			// amount: tip_amount, value: price
+	EVENT_TIP_UNAFFORDABLE		// amount: tip_amount
+};
+
+// A single event. Fields not used by an event type are left at zero.
+struct Game_Event
+{
+	game_event_type type;
+
+	int x;
+	int y;
+	materials material;
+	int amount;
+	int value;
+
+	Game_Event(game_event_type type, int x = 0, int y = 0, materials material = NOTHING,
+			   int amount = 0, int value = 0);
+};
+
+// Anything that wants to hear about the game's events.
+class Game_Event_Sink
+{
+	public:
+		virtual ~Game_Event_Sink();
+
+		virtual void handle_event(const Game_Event &event) = 0;
+};
+
+// Passes each event on to every subscribed sink, in the order they subscribed.
+class Game_Event_Dispatcher : public Game_Event_Sink
+{
+	private:
+		Game_Event_Sink *sinks[MAX_EVENT_SINKS];
+		int sink_count;
+
+	public:
+		Game_Event_Dispatcher();
+
+		// Returns false if there is no room for another sink.
+		bool subscribe(Game_Event_Sink *sink);
+		void unsubscribe(Game_Event_Sink *sink);
+
+		void handle_event(const Game_Event &event);
+};
+
+#endif
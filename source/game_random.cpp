@@ -0,0 +1,67 @@
+/*
+ game_random.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Random numbers for a single game.
+
+ Uses the splitmix64 generator: small, fast, and any seed (including
+ neighbouring ones) gives an unrelated sequence.
+*/
+
+#include "game_random.h"
+
+Game_Random::Game_Random()
+{
+	seed(0);
+}
+
+Game_Random::Game_Random(unsigned long long seed)
+{
+	this->seed(seed);
+}
+
+// Restart the sequence from a seed.
+void Game_Random::seed(unsigned long long seed)
+{
+	state = seed;
+}
+
+// Returns the next 32 random bits.
+unsigned int Game_Random::next()
+{
+	state += 0x9E3779B97F4A7C15ULL;
+
+	unsigned long long z = state;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	z = z ^ (z >> 31);
+
+	return (unsigned int)(z >> 32);
+}
+
+// Returns a number from 0 to range - 1.
+int Game_Random::next_int(int range)
+{
+	if(range <= 1)
+	{
+		return 0;
+	}
+
+	// Scale rather than take the remainder, which favours small numbers.
+	return (int)(((unsigned long long)next() * (unsigned int)range) >> 32);
+}
@@ -0,0 +1,49 @@
+/*
+ game_random.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Random numbers for a single game.
+
+ Each PlayerData and MineData keeps its own generator, so a game can
+ be repeated from its seed and several games can be played at once on
+ different threads. rand() shares one hidden state between them all.
+*/
+
+#ifndef GAME_RANDOM
+#define GAME_RANDOM
+
+class Game_Random
+{
+	private:
+		unsigned long long state;
+
+	public:
+		Game_Random();
+		Game_Random(unsigned long long seed);
+
+		// Restart the sequence from a seed.
+		void seed(unsigned long long seed);
+
+		// Returns the next 32 random bits.
+		unsigned int next();
+
+		// Returns a number from 0 to range - 1, like rand() % range.
+		int next_int(int range);
+};
+
+#endif
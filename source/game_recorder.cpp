@@ -0,0 +1,557 @@
+/*
+ game_recorder.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Records a game as its seeds and the player's actions, and plays a
+ recording back without SDL.
+*/
+
+#include <cstdio>
+
+#include "classes.h"
+#include "economy.h"
+#include "game_recorder.h"
+#include "game_rules.h"
+#include "trace.h"
+
+// Marks the start of a recording.
+static const char RECORD_MAGIC[4] = { 'M', 'R', 'E', 'C' };
+
+Game_Recorder::Game_Recorder()
+{
+	recording = false;
+	depth = 0;
+	turns_since_checksum = 0;
+}
+
+// Start a new recording of a game made from these seeds.
+void Game_Recorder::start(unsigned int player_seed, unsigned int mine_seed)
+{
+	data.clear();
+
+	for(int index = 0; index < 4; index++)
+	{
+		write_byte(RECORD_MAGIC[index]);
+	}
+
+	write_byte(RECORD_VERSION);
+	write_uint32(player_seed);
+	write_uint32(mine_seed);
+
+	recording = true;
+	depth = 0;
+	turns_since_checksum = 0;
+}
+
+void Game_Recorder::stop()
+{
+	recording = false;
+}
+
+bool Game_Recorder::is_recording()
+{
+	return recording;
+}
+
+void Game_Recorder::write_byte(unsigned char value)
+{
+	data.push_back(value);
+}
+
+void Game_Recorder::write_int16(int value)
+{
+	write_byte(value & 0xFF);
+	write_byte((value >> 8) & 0xFF);
+}
+
+void Game_Recorder::write_uint32(unsigned int value)
+{
+	for(int shift = 0; shift < 32; shift += 8)
+	{
+		write_byte((value >> shift) & 0xFF);
+	}
+}
+
+void Game_Recorder::write_uint64(unsigned long long value)
+{
+	for(int shift = 0; shift < 64; shift += 8)
+	{
+		write_byte((value >> shift) & 0xFF);
+	}
+}
+
+// Record a rule being carried out.
+void Game_Recorder::begin_action(record_action action, int operand_x, int operand_y)
+{
+	if(recording && depth == 0)
+	{
+		write_byte(action);
+
+		if(action == ACTION_MOVE_TO)
+		{
+			write_int16(operand_x);
+			write_int16(operand_y);
+		}
+		else if(action == ACTION_SELL_MINERAL || action == ACTION_BUY_ITEM
+				|| action == ACTION_BUY_TIP || action == ACTION_TIP_REGION)
+		{
+			write_byte(operand_x);
+		}
+	}
+
+	depth++;
+}
+
+// Record that a rule has finished.
+void Game_Recorder::end_action()
+{
+	depth--;
+}
+
+// After a turn has ended. Records a checksum of the game if one is due.
+void Game_Recorder::turn_ended(PlayerData *player, MineData *mine)
+{
+	if(!recording)
+	{
+		return;
+	}
+
+	turns_since_checksum++;
+
+	if(turns_since_checksum >= RECORD_CHECKSUM_TURNS)
+	{
+		write_byte(ACTION_CHECKSUM);
+		write_uint64(game_checksum(player, mine));
+		turns_since_checksum = 0;
+	}
+}
+
+// Write the recording to a file.
+bool Game_Recorder::save(const char *path)
+{
+	FILE *file = fopen(path, "wb");
+
+	if(file == NULL)
+	{
+		return false;
+	}
+
+	bool written = data.empty() || fwrite(&data[0], 1, data.size(), file) == data.size();
+
+	return fclose(file) == 0 && written;
+}
+
+const std::vector<unsigned char> &Game_Recorder::get_data()
+{
+	return data;
+}
+
+Record_Scope::Record_Scope(PlayerData *player, record_action action, int operand_x, int operand_y)
+{
+	recorder = player->get_recorder();
+
+	if(recorder != NULL)
+	{
+		recorder->begin_action(action, operand_x, operand_y);
+	}
+}
+
+Record_Scope::~Record_Scope()
+{
+	if(recorder != NULL)
+	{
+		recorder->end_action();
+	}
+}
+
+// The action for moving the player from one tile to another.
+record_action move_action(int from_x, int from_y, int to_x, int to_y)
+{
+	if(to_x == from_x && to_y == from_y - 1)
+	{
+		return ACTION_MOVE_UP;
+	}
+	else if(to_x == from_x && to_y == from_y + 1)
+	{
+		return ACTION_MOVE_DOWN;
+	}
+	else if(to_x == from_x - 1 && to_y == from_y)
+	{
+		return ACTION_MOVE_LEFT;
+	}
+	else if(to_x == from_x + 1 && to_y == from_y)
+	{
+		return ACTION_MOVE_RIGHT;
+	}
+	else
+	{
+		return ACTION_MOVE_TO;
+	}
+}
+
+// Fold a value into a checksum.
+static unsigned long long checksum_mix(unsigned long long checksum, unsigned long long value)
+{
+	checksum ^= value;
+	checksum *= 0x9E3779B97F4A7C15ULL;
+	checksum ^= checksum >> 29;
+
+	return checksum;
+}
+
+// A checksum of everything about the game that the rules can change.
+unsigned long long game_checksum(PlayerData *player, MineData *mine)
+{
+	unsigned long long checksum = 0;
+
+	checksum = checksum_mix(checksum, player->get_money());
+	checksum = checksum_mix(checksum, player->get_health());
+	checksum = checksum_mix(checksum, player->get_coal());
+	checksum = checksum_mix(checksum, player->get_silver());
+	checksum = checksum_mix(checksum, player->get_gold());
+	checksum = checksum_mix(checksum, player->get_platinum());
+	checksum = checksum_mix(checksum, player->get_coal_value());
+	checksum = checksum_mix(checksum, player->get_silver_value());
+	checksum = checksum_mix(checksum, player->get_gold_value());
+	checksum = checksum_mix(checksum, player->get_platinum_value());
+	checksum = checksum_mix(checksum, player->get_turn_number());
+	checksum = checksum_mix(checksum, player->get_previous_turn_number());
+	checksum = checksum_mix(checksum, player->get_insurance_turn_number());
+	checksum = checksum_mix(checksum, player->get_dynamite());
+	checksum = checksum_mix(checksum, player->get_location_x());
+	checksum = checksum_mix(checksum, player->get_location_y());
+	checksum = checksum_mix(checksum, player->get_scheduler()->get_pending());
+
+	unsigned long long possessions = player->get_has_axe()
+		| (player->get_has_bucket() << 1)
+		| (player->get_has_flashlight() << 2)
+		| (player->get_has_hardhat() << 3)
+		| (player->get_has_shovel() << 4)
+		| (player->get_has_diamond() << 5)
+		| (player->get_has_insurance() << 6)
+		| (player->get_has_tip() << 7);
+
+	checksum = checksum_mix(checksum, possessions);
+	checksum = checksum_mix(checksum, player->get_tip_x());
+	checksum = checksum_mix(checksum, player->get_tip_y());
+	checksum = checksum_mix(checksum, player->get_tip_width());
+	checksum = checksum_mix(checksum, player->get_tip_height());
+
+	// The mine keeps its own checksum of the tiles up to date.
+	checksum = checksum_mix(checksum, mine->get_tile_checksum());
+	checksum = checksum_mix(checksum, mine->get_diamond_x());
+	checksum = checksum_mix(checksum, mine->get_diamond_y());
+
+	return checksum;
+}
+
+Game_Replayer::Game_Replayer()
+{
+	position = 0;
+	player_seed = 0;
+	mine_seed = 0;
+
+	actions = 0;
+	turns = 0;
+	checksums = 0;
+	diverged_turn = -1;
+}
+
+// Read a recording's header.
+bool read_record_header(const unsigned char *data, int size, unsigned int &player_seed, unsigned int &mine_seed)
+{
+	if(size < RECORD_HEADER_SIZE)
+	{
+		return false;
+	}
+
+	for(int index = 0; index < 4; index++)
+	{
+		if(data[index] != (unsigned char)RECORD_MAGIC[index])
+		{
+			return false;
+		}
+	}
+
+	if(data[4] != RECORD_VERSION)
+	{
+		return false;
+	}
+
+	player_seed = 0;
+	mine_seed = 0;
+
+	for(int byte = 0; byte < 4; byte++)
+	{
+		player_seed |= (unsigned int)data[5 + byte] << (byte * 8);
+		mine_seed |= (unsigned int)data[9 + byte] << (byte * 8);
+	}
+
+	return true;
+}
+
+// Use a recording from memory.
+bool Game_Replayer::set_data(const std::vector<unsigned char> &recording)
+{
+	data = recording;
+	position = 0;
+
+	return read_record_header(data.data(), data.size(), player_seed, mine_seed);
+}
+
+// Use a recording from a file.
+bool Game_Replayer::load(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+
+	if(file == NULL)
+	{
+		return false;
+	}
+
+	std::vector<unsigned char> recording;
+	unsigned char buffer[4096];
+	size_t read = 0;
+
+	while((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		recording.insert(recording.end(), buffer, buffer + read);
+	}
+
+	fclose(file);
+
+	return set_data(recording);
+}
+
+unsigned int Game_Replayer::get_player_seed()
+{
+	return player_seed;
+}
+
+unsigned int Game_Replayer::get_mine_seed()
+{
+	return mine_seed;
+}
+
+// Little-endian operands of an action.
+static int read_int16(const unsigned char *data)
+{
+	// Sign extend from sixteen bits.
+	return (short)(data[0] | (data[1] << 8));
+}
+
+static unsigned long long read_uint64(const unsigned char *data)
+{
+	unsigned long long value = 0;
+
+	for(int byte = 0; byte < 8; byte++)
+	{
+		value |= (unsigned long long)data[byte] << (byte * 8);
+	}
+
+	return value;
+}
+
+// Bytes an action takes, including its own.
+int get_action_length(unsigned char action)
+{
+	if(action >= ACTION_COUNT)
+	{
+		return 0;
+	}
+	else if(action == ACTION_MOVE_TO)
+	{
+		return 5;
+	}
+	else if(action == ACTION_SELL_MINERAL || action == ACTION_BUY_ITEM
+			|| action == ACTION_BUY_TIP || action == ACTION_TIP_REGION)
+	{
+		return 2;
+	}
+	else if(action == ACTION_CHECKSUM)
+	{
+		return 9;
+	}
+
+	return 1;
+}
+
+// Carry out the action at the start of data.
+perform_result perform_action(PlayerData *player, MineData *mine, const unsigned char *data, int size, int &length)
+{
+	length = 0;
+
+	if(size < 1)
+	{
+		return PERFORM_CUT_SHORT;
+	}
+
+	unsigned char action = data[0];
+
+	if(get_action_length(action) == 0)
+	{
+		return PERFORM_UNKNOWN;
+	}
+
+	if(size < get_action_length(action))
+	{
+		return PERFORM_CUT_SHORT;
+	}
+
+	int x = player->get_location_x();
+	int y = player->get_location_y();
+
+	switch(action)
+	{
+		case ACTION_MOVE_UP:
+			player->change_location(x, y - 1, mine);
+			break;
+		case ACTION_MOVE_DOWN:
+			player->change_location(x, y + 1, mine);
+			break;
+		case ACTION_MOVE_LEFT:
+			player->change_location(x - 1, y, mine);
+			break;
+		case ACTION_MOVE_RIGHT:
+			player->change_location(x + 1, y, mine);
+			break;
+		case ACTION_MOVE_TO:
+			player->change_location(read_int16(data + 1), read_int16(data + 3), mine);
+			break;
+		case ACTION_END_TURN:
+			end_turn(player, mine);
+			break;
+		case ACTION_CHECK_HEALTH:
+			player->check_health();
+			break;
+		case ACTION_LIGHT_DYNAMITE:
+			light_dynamite(player, mine);
+			break;
+		case ACTION_ELEVATOR_BOTTOM:
+			move_elevator_to_bottom(mine, player);
+			break;
+		case ACTION_ELEVATOR_TOP:
+			move_elevator_to_top(mine, player);
+			break;
+		case ACTION_SELL_MINERAL:
+			sell_mineral(player, (materials)data[1]);
+			break;
+		case ACTION_SELL_ALL:
+			sell_all_minerals(player);
+			break;
+		case ACTION_NEW_PRICES:
+			randomize_mineral_values(player);
+			break;
+		case ACTION_BUY_ITEM:
+			buy_item(player, (store_item)data[1]);
+			break;
+		case ACTION_STAY_ONE_DAY:
+			stay_one_day(player);
+			break;
+		case ACTION_FULL_HEAL:
+			full_heal(player);
+			break;
+		case ACTION_BUY_INSURANCE:
+			buy_insurance(player);
+			break;
+		case ACTION_BUY_TIP:
+			buy_tip(player, (tip_amount)data[1]);
+			break;
+		case ACTION_TIP_REGION:
+			make_tip_region(player, mine, (tip_amount)data[1]);
+			break;
+		default:
+			// ACTION_CHECKSUM changes nothing.
+			break;
+	}
+
+	length = get_action_length(action);
+
+	return PERFORM_OK;
+}
+
+// Play the recording through on a new player and mine.
+replay_result Game_Replayer::run(PlayerData *player, MineData *mine)
+{
+	Trace_Zone zone("replay", TRACE_LOGIC);
+
+	actions = 0;
+	turns = 0;
+	checksums = 0;
+	diverged_turn = -1;
+
+	if(data.size() < (unsigned int)RECORD_HEADER_SIZE || mine->get_seed() != mine_seed)
+	{
+		return REPLAY_BAD_FILE;
+	}
+
+	// Start after the header.
+	position = RECORD_HEADER_SIZE;
+
+	player->set_seed(player_seed);
+	player->set_recorder(NULL);
+
+	while(position < data.size())
+	{
+		const unsigned char *action = &data[position];
+		int length = 0;
+
+		if(perform_action(player, mine, action, data.size() - position, length) != PERFORM_OK)
+		{
+			return REPLAY_BAD_FILE;
+		}
+
+		turns = player->get_turn_number();
+
+		if(action[0] == ACTION_CHECKSUM)
+		{
+			checksums++;
+
+			if(read_uint64(action + 1) != game_checksum(player, mine))
+			{
+				diverged_turn = turns;
+				return REPLAY_DIVERGED;
+			}
+		}
+
+		position += length;
+		actions++;
+	}
+
+	return REPLAY_OK;
+}
+
+int Game_Replayer::get_actions()
+{
+	return actions;
+}
+
+int Game_Replayer::get_turns()
+{
+	return turns;
+}
+
+int Game_Replayer::get_checksums()
+{
+	return checksums;
+}
+
+int Game_Replayer::get_diverged_turn()
+{
+	return diverged_turn;
+}
@@ -0,0 +1,207 @@
+/*
+ game_recorder.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Records a game as its seeds and the player's actions, and plays a
+ recording back without SDL.
+
+ Every rule that changes the game state (the player's moves, dynamite,
+ the elevator and every town transaction) records itself through the
+ player's recorder with a Record_Scope. Only the outermost rule is
+ recorded: the elevator moves the player with change_location, and a
+ move that takes a turn ends it, but replaying them does that again.
+
+ Since the player and the mine each keep their own seeded generator,
+ doing the same actions from the same seeds gives the same game. A
+ checksum of the game is recorded every RECORD_CHECKSUM_TURNS turns
+ so the replay can tell where it stopped matching.
+
+ The recording is a byte stream: a header with the seeds, then one
+ byte per action followed by any operands, little-endian. Moves to a
+ neighbouring tile take one byte each.
+
+ A recording has to start from a new game; a loaded game isn't
+ recorded.
+*/
+
+#ifndef GAME_RECORDER
+#define GAME_RECORDER
+
+#include <vector>
+
+#include "classes.h"
+
+const unsigned char RECORD_VERSION = 3;
+
+// Bytes in a recording's header: the magic, the version and the two seeds.
+const int RECORD_HEADER_SIZE = 13;
+
+// Where the game keeps the recording of the last game played.
+const char RECORDING_FILE[] = "last_game.replay";
+
+// Turns between checksums of the game.
+const int RECORD_CHECKSUM_TURNS = 64;
+
+enum record_action
+{
+	ACTION_MOVE_UP,				// One tile from where the player is.
+	ACTION_MOVE_DOWN,
+	ACTION_MOVE_LEFT,
+	ACTION_MOVE_RIGHT,
+	ACTION_MOVE_TO,				// int16 x, int16 y
+	ACTION_END_TURN,			// A turn without a move. Moves end their own.
+	ACTION_CHECK_HEALTH,		// Only recorded when it claimed the insurance.
+	ACTION_LIGHT_DYNAMITE,
+	ACTION_ELEVATOR_BOTTOM,
+	ACTION_ELEVATOR_TOP,
+	ACTION_SELL_MINERAL,		// uint8 materials
+	ACTION_SELL_ALL,
+	ACTION_NEW_PRICES,
+	ACTION_BUY_ITEM,			// uint8 store_item
+	ACTION_STAY_ONE_DAY,
+	ACTION_FULL_HEAL,
+	ACTION_BUY_INSURANCE,
+	ACTION_BUY_TIP,				// uint8 tip_amount
+	ACTION_TIP_REGION,			// uint8 tip_amount
+	ACTION_CHECKSUM,			// uint64 game_checksum
+	ACTION_COUNT
+};
+
+class Game_Recorder
+{
+	private:
+		std::vector<unsigned char> data;
+		bool recording;
+
+		// How many rules are being carried out inside one another.
+		// Only the outermost is recorded.
+		int depth;
+
+		int turns_since_checksum;
+
+		void write_byte(unsigned char value);
+		void write_int16(int value);
+		void write_uint32(unsigned int value);
+		void write_uint64(unsigned long long value);
+
+	public:
+		Game_Recorder();
+
+		// Start a new recording of a game made from these seeds.
+		void start(unsigned int player_seed, unsigned int mine_seed);
+		void stop();
+		bool is_recording();
+
+		// Record a rule being carried out, and that it has finished.
+		// operand_x and operand_y are used by ACTION_MOVE_TO; the other
+		// actions with an operand use operand_x.
+		void begin_action(record_action action, int operand_x, int operand_y);
+		void end_action();
+
+		// After a turn has ended. Records a checksum of the game if one
+		// is due.
+		void turn_ended(PlayerData *player, MineData *mine);
+
+		// Write the recording to a file. Returns false if it couldn't be.
+		bool save(const char *path);
+
+		const std::vector<unsigned char> &get_data();
+};
+
+// Records a rule for as long as it's in scope, if the player has a recorder.
+class Record_Scope
+{
+	private:
+		Game_Recorder *recorder;
+
+	public:
+		Record_Scope(PlayerData *player, record_action action, int operand_x = 0, int operand_y = 0);
+		~Record_Scope();
+};
+
+// The action for moving the player from one tile to another.
+record_action move_action(int from_x, int from_y, int to_x, int to_y);
+
+// A checksum of everything about the game that the rules can change.
+unsigned long long game_checksum(PlayerData *player, MineData *mine);
+
+// Read the seeds from a recording's header. Returns false if it isn't
+// the header of a recording this version can play.
+bool read_record_header(const unsigned char *data, int size, unsigned int &player_seed, unsigned int &mine_seed);
+
+// Bytes an action takes with its operands, or 0 if it isn't an action.
+int get_action_length(unsigned char action);
+
+enum perform_result
+{
+	PERFORM_OK,
+	PERFORM_CUT_SHORT,		// The action's operands haven't all arrived.
+	PERFORM_UNKNOWN			// Not an action.
+};
+
+// Carry out the action at the start of data, in the recording's
+// format, on a game. length is set to the bytes it took. A checksum is
+// skipped over without being checked. Used by the replayer and by
+// anything else that takes actions as bytes (tools/server.cpp).
+perform_result perform_action(PlayerData *player, MineData *mine, const unsigned char *data, int size, int &length);
+
+enum replay_result
+{
+	REPLAY_OK,
+	REPLAY_BAD_FILE,		// Not a recording, or cut short.
+	REPLAY_DIVERGED			// A checksum didn't match.
+};
+
+class Game_Replayer
+{
+	private:
+		std::vector<unsigned char> data;
+		unsigned int position;
+
+		unsigned int player_seed;
+		unsigned int mine_seed;
+
+		// What the last run got through.
+		int actions;
+		int turns;
+		int checksums;
+		int diverged_turn;		// First turn a checksum didn't match, or -1.
+
+	public:
+		Game_Replayer();
+
+		// Use a recording from memory or a file.
+		// Returns false if it isn't a recording.
+		bool set_data(const std::vector<unsigned char> &recording);
+		bool load(const char *path);
+
+		// The seeds the recorded game was made from.
+		unsigned int get_player_seed();
+		unsigned int get_mine_seed();
+
+		// Play the recording through on a new player and a mine made
+		// from get_mine_seed(). They are left as the recording left them.
+		replay_result run(PlayerData *player, MineData *mine);
+
+		int get_actions();
+		int get_turns();
+		int get_checksums();
+		int get_diverged_turn();
+};
+
+#endif
@@ -0,0 +1,271 @@
+/*
+ game_rules.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Rules for the player's actions in the mine that aren't a plain move:
+ the elevator shortcuts and the dynamite, and the end of each turn.
+*/
+
+#include "classes.h"
+#include "game_events.h"
+#include "game_recorder.h"
+#include "game_rules.h"
+#include "trace.h"
+
+// Most charges one blast can set off in a chain.
+const int MAX_CHAIN = 64;
+
+// Move the elevator to the lowest level explored if the player is within
+// the elevator.
+bool move_elevator_to_bottom(MineData *mine, PlayerData *player)
+{
+	Record_Scope record(player, ACTION_ELEVATOR_BOTTOM);
+
+	// Check to see if the player is in the elevator.
+	if(player->get_location_x() == 0)
+	{
+		// Variable to keep track of the lowest area the player has explored
+		// adjacent to the elevator.
+		int lowest_explored = 0;
+
+		for(int y = 0; y <= mine->get_map_y(); y++)
+		{
+			if(mine->get_explored(1, y))
+			{
+				lowest_explored = y;
+			}
+		}
+
+		if(lowest_explored <= player->get_money()
+			&& player->get_location_y() < lowest_explored)
+		{
+			// Charge the player for the elevator usage.
+			int fare = lowest_explored - player->get_location_y();
+			player->change_money(-fare);
+
+			player->change_location(0, lowest_explored, mine);
+
+			player->send_event(Game_Event(EVENT_ELEVATOR_TO_BOTTOM, 0, lowest_explored, ELEVATOR, 0, fare));
+
+			// Say that the player can indeed move down.
+			return true;
+		}
+	}
+
+	player->send_event(Game_Event(EVENT_ELEVATOR_REFUSED));
+
+	return false;
+}
+
+// Move the elevator to the very top level provided the player is within
+// the elevator.
+bool move_elevator_to_top(MineData *mine, PlayerData *player)
+{
+	Record_Scope record(player, ACTION_ELEVATOR_TOP);
+
+	// Check to see if the player is in the elevator
+	if(player->get_location_x() == 0 && player->get_location_y() != 0)
+	{
+		player->change_location(0, 0, mine);
+
+		player->send_event(Game_Event(EVENT_ELEVATOR_TO_TOP, 0, 0, ELEVATOR));
+
+		return true;
+	}
+
+	player->send_event(Game_Event(EVENT_ELEVATOR_REFUSED));
+
+	return false;
+}
+
+// Light the player's dynamite where they are standing.
+bool light_dynamite(PlayerData *player, MineData *mine)
+{
+	Record_Scope record(player, ACTION_LIGHT_DYNAMITE);
+
+	if(!player->get_has_dynamite())
+	{
+		player->send_event(Game_Event(EVENT_NO_DYNAMITE));
+		return false;
+	}
+
+	// Dynamite can't be left in the elevator, or on top of another stick.
+	if(mine->get_contents(player->get_location_x(), player->get_location_y()) == ELEVATOR
+	   || mine->get_contents(player->get_location_x(), player->get_location_y()) == DYNAMITE)
+	{
+		return false;
+	}
+
+	if(!player->dynamite_prime(player->get_location_x(), player->get_location_y(), mine))
+	{
+		return false;
+	}
+
+	player->send_event(Game_Event(EVENT_DYNAMITE_LIT, player->get_location_x(), player->get_location_y(), DYNAMITE));
+
+	return true;
+}
+
+// Blow up the charge at x, y and any others caught in the blast.
+static void detonate(PlayerData *player, MineData *mine, int x, int y)
+{
+	int chain_x[MAX_CHAIN];
+	int chain_y[MAX_CHAIN];
+	int chain_length = 1;
+
+	chain_x[0] = x;
+	chain_y[0] = y;
+
+	for(int blast = 0; blast < chain_length; blast++)
+	{
+		int blast_x = chain_x[blast];
+		int blast_y = chain_y[blast];
+
+		player->send_event(Game_Event(EVENT_DYNAMITE_EXPLODED, blast_x, blast_y));
+
+		// Check to see if the player is in the blast radius.
+		if(player->dynamite_radius(blast_x, blast_y))
+		{
+			player->change_health(-DYNAMITE_BLAST_DAMAGE);
+			player->send_event(Game_Event(EVENT_BLAST_INJURY, player->get_location_x(), player->get_location_y(),
+										  DYNAMITE, DYNAMITE_BLAST_DAMAGE));
+		}
+
+		// Other charges in the blast go off with it rather than when
+		// their own fuses burn down. The blast clears their tiles, so
+		// none is found twice.
+		for(int other_x = blast_x - 2; other_x <= blast_x + 2; other_x++)
+		{
+			for(int other_y = blast_y - 2; other_y <= blast_y + 2; other_y++)
+			{
+				if((other_x != blast_x || other_y != blast_y)
+				   && mine->in_bounds(other_x, other_y)
+				   && mine->get_contents(other_x, other_y) == DYNAMITE
+				   && chain_length < MAX_CHAIN)
+				{
+					player->get_scheduler()->cancel(EFFECT_DYNAMITE, other_x, other_y);
+
+					chain_x[chain_length] = other_x;
+					chain_y[chain_length] = other_y;
+					chain_length++;
+				}
+			}
+		}
+
+		player->dynamite_explode(blast_x, blast_y, mine);
+	}
+}
+
+// Carry out whatever was scheduled for this turn or earlier.
+void scheduled_turn(PlayerData *player, MineData *mine)
+{
+	Trace_Zone zone("scheduled_turn", TRACE_LOGIC);
+
+	Scheduled_Effect effect;
+
+	while(player->get_scheduler()->next_due(player->get_turn_number(), effect))
+	{
+		if(effect.type == EFFECT_DYNAMITE)
+		{
+			// The charge may have been buried by a collapse since it was lit.
+			if(mine->get_contents(effect.x, effect.y) == DYNAMITE)
+			{
+				detonate(player, mine, effect.x, effect.y);
+			}
+		}
+		else if(effect.type == EFFECT_INSURANCE_EXPIRY)
+		{
+			// Insurance bought again since this was scheduled has its own expiry.
+			if(player->get_has_insurance()
+			   && (player->get_insurance_turn_number() + INSURANCE_TURNS) < player->get_turn_number())
+			{
+				player->change_has_insurance(false);
+				player->send_event(Game_Event(EVENT_INSURANCE_EXPIRED));
+			}
+		}
+	}
+}
+
+// Schedule again what a loaded game had waiting.
+void restart_scheduled_effects(PlayerData *player, MineData *mine)
+{
+	Turn_Scheduler *scheduler = player->get_scheduler();
+
+	scheduler->clear(player->get_turn_number());
+
+	if(player->get_has_insurance())
+	{
+		scheduler->schedule(player->get_insurance_turn_number() + INSURANCE_TURNS + 1, EFFECT_INSURANCE_EXPIRY, 0, 0);
+	}
+
+	// Saves don't keep how long fuses had left, so any dynamite left
+	// lit starts a fresh one.
+	for(int y = 0; y <= mine->get_map_y(); y++)
+	{
+		for(int x = 0; x <= mine->get_map_x(); x++)
+		{
+			if(mine->get_contents(x, y) == DYNAMITE)
+			{
+				scheduler->schedule(player->get_turn_number() + DYNAMITE_FUSE_TURNS, EFFECT_DYNAMITE, x, y);
+			}
+		}
+	}
+}
+
+// Everything in the mine that happens by itself between the player's moves.
+void end_turn(PlayerData *player, MineData *mine)
+{
+	Record_Scope record(player, ACTION_END_TURN);
+
+	scheduled_turn(player, mine);
+	mine->water_turn();
+	
+	// Chambers dug or blasted too wide fall in.
+	bool player_hit = false;
+	int fallen = mine->check_supports(player->get_location_x(), player->get_location_y(), player_hit);
+	
+	if(player_hit)
+	{
+		if(player->get_has_hardhat())
+		{
+			player->change_health(-CHAMBER_HARDHAT_DAMAGE);
+		}
+		else
+		{
+			player->change_health(-CHAMBER_DAMAGE);
+		}
+		
+		player->send_event(Game_Event(EVENT_CAVE_IN, player->get_location_x(), player->get_location_y(), CAVE_IN));
+	}
+	else if(fallen > 0)
+	{
+		player->send_event(Game_Event(EVENT_COLLAPSE, 0, 0, CAVE_IN, fallen));
+	}
+	
+	// Let the recorder check the game every so often.
+	if(player->get_recorder() != NULL)
+	{
+		player->get_recorder()->turn_ended(player, mine);
+	}
+}
+
+// Returns true if the player has what it takes to win the game at the tavern.
+bool can_win_game(PlayerData *player)
+{
+	return player->get_has_diamond() && player->get_money() >= MIMI_MONEY;
+}
@@ -0,0 +1,75 @@
+/*
+ game_rules.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Rules for the player's actions in the mine that aren't a plain move:
+ the elevator shortcuts and the dynamite, and the end of each turn,
+ including whatever was scheduled for it (see turn_scheduler.h).
+
+ Like PlayerData and MineData, nothing here uses SDL. Results are
+ reported through the player's event sink.
+*/
+
+#ifndef GAME_RULES
+#define GAME_RULES
+
+class PlayerData;
+class MineData;
+
+// Health lost when the player is caught in their own blast.
+const int DYNAMITE_BLAST_DAMAGE = 50;
+
+// Health lost when a chamber falls in next to the player, as for a cave-in.
+const int CHAMBER_DAMAGE = 10;
+const int CHAMBER_HARDHAT_DAMAGE = 5;
+
+// Money Mimi wants to see, along with the diamond, before she'll marry the player.
+const int MIMI_MONEY = 2500;
+
+// Move the elevator to the lowest level explored if the player is within
+// the elevator.
+bool move_elevator_to_bottom(MineData *mine, PlayerData *player);
+
+// Move the elevator to the very top level provided the player is within
+// the elevator.
+bool move_elevator_to_top(MineData *mine, PlayerData *player);
+
+// Light the player's dynamite where they are standing.
+// Returns true if the dynamite was lit.
+bool light_dynamite(PlayerData *player, MineData *mine);
+
+// Carry out the effects scheduled for this turn or earlier: blow up
+// dynamite whose fuse has burnt down, setting off any other charges in
+// the blast and hurting the player if they are too close, and let
+// insurance run out.
+void scheduled_turn(PlayerData *player, MineData *mine);
+
+// Schedule again what a loaded game had waiting: the insurance expiry
+// and any dynamite left lit in the mine.
+void restart_scheduled_effects(PlayerData *player, MineData *mine);
+
+// Everything in the mine that happens by itself between the player's
+// moves: scheduled effects, the water and chambers falling in. Called
+// by change_location after each move that takes a turn; scheduled
+// effects go by the player's turn number.
+void end_turn(PlayerData *player, MineData *mine);
+
+// Returns true if the player has what it takes to win the game at the tavern.
+bool can_win_game(PlayerData *player);
+
+#endif
@@ -0,0 +1,360 @@
+/*
+ game_statistics.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ What happened during play, counted from the game's events.
+*/
+
+#include <cstdio>
+#include <cstring>
+
+#include <unistd.h>
+
+#include "game_statistics.h"
+#include "mapped_file.h"
+#include "trace.h"
+
+static void write_le(unsigned char *data, unsigned long long value, int bytes)
+{
+	for(int byte = 0; byte < bytes; byte++)
+	{
+		data[byte] = (unsigned char)(value >> (byte * 8));
+	}
+}
+
+static unsigned long long read_le(const unsigned char *data, int bytes)
+{
+	unsigned long long value = 0;
+	
+	for(int byte = 0; byte < bytes; byte++)
+	{
+		value |= (unsigned long long)data[byte] << (byte * 8);
+	}
+	
+	return value;
+}
+
+// FNV-1a, as the saves use.
+static unsigned long long record_checksum(const unsigned char *data, int size)
+{
+	unsigned long long hash = 0xCBF29CE484222325ULL;
+	
+	for(int index = 0; index < size; index++)
+	{
+		hash = (hash ^ data[index]) * 0x100000001B3ULL;
+	}
+	
+	return hash;
+}
+
+// The counter for a tile dug into.
+static game_statistic dug_statistic(materials material)
+{
+	if(material == GRANITE)
+	{
+		return STAT_DUG_GRANITE;
+	}
+	else if(material == SPRING)
+	{
+		return STAT_DUG_SPRING;
+	}
+	else if(material == CAVE_IN)
+	{
+		return STAT_DUG_CAVE_IN;
+	}
+	else if(material == COAL)
+	{
+		return STAT_DUG_COAL;
+	}
+	else if(material == SILVER)
+	{
+		return STAT_DUG_SILVER;
+	}
+	else if(material == GOLD)
+	{
+		return STAT_DUG_GOLD;
+	}
+	else if(material == PLATINUM)
+	{
+		return STAT_DUG_PLATINUM;
+	}
+	else if(material == DIAMOND)
+	{
+		return STAT_DUG_DIAMOND;
+	}
+	
+	return STAT_DUG_DIRT;
+}
+
+Game_Statistics::Game_Statistics()
+{
+	memset(lifetime, 0, sizeof(lifetime));
+	lifetime_loaded = false;
+	
+	start_game();
+}
+
+void Game_Statistics::start_game()
+{
+	memset(game, 0, sizeof(game));
+	game_finished = false;
+}
+
+void Game_Statistics::resume_game(const unsigned int saved[STATISTIC_COUNT])
+{
+	memcpy(game, saved, sizeof(game));
+	game_finished = false;
+}
+
+void Game_Statistics::handle_event(const Game_Event &event)
+{
+	switch(event.type)
+	{
+		case EVENT_TILE_DUG:
+			game[STAT_TILES_DUG]++;
+			game[dug_statistic(event.material)]++;
+			game[STAT_SPENT_DIGGING] += event.value;
+			break;
+		case EVENT_GRANITE_CHIPPED:
+			game[STAT_GRANITE_CHIPPED]++;
+			game[STAT_SPENT_DIGGING] += event.value;
+			break;
+		case EVENT_BUCKET_USED:
+			game[STAT_SPENT_DIGGING] += event.value;
+			break;
+		case EVENT_MINERAL_FOUND:
+			if(event.material == COAL)
+			{
+				game[STAT_FOUND_COAL] += event.amount;
+			}
+			else if(event.material == SILVER)
+			{
+				game[STAT_FOUND_SILVER] += event.amount;
+			}
+			else if(event.material == GOLD)
+			{
+				game[STAT_FOUND_GOLD] += event.amount;
+			}
+			else if(event.material == PLATINUM)
+			{
+				game[STAT_FOUND_PLATINUM] += event.amount;
+			}
+			break;
+		case EVENT_SPRING_HIT:
+			game[STAT_SPRINGS_HIT]++;
+			break;
+		case EVENT_CAVE_IN:
+			game[STAT_CAVE_INS]++;
+			break;
+		case EVENT_COLLAPSE:
+			game[STAT_COLLAPSES]++;
+			break;
+		case EVENT_DROWNING:
+			game[STAT_DROWNINGS]++;
+			break;
+		case EVENT_BLAST_INJURY:
+			game[STAT_BLAST_INJURIES]++;
+			break;
+		case EVENT_INSURANCE_CLAIMED:
+			game[STAT_INSURANCE_CLAIMS]++;
+			break;
+		case EVENT_ELEVATOR_TO_BOTTOM:
+			game[STAT_SPENT_ELEVATOR] += event.value;
+			break;
+		case EVENT_HEALED:
+		case EVENT_INSURANCE_BOUGHT:
+			game[STAT_SPENT_HOSPITAL] += event.value;
+			break;
+		case EVENT_ITEM_BOUGHT:
+			game[STAT_SPENT_STORE] += event.value;
+			break;
+		case EVENT_TIP_BOUGHT:
+			game[STAT_SPENT_TAVERN] += event.value;
+			break;
+		case EVENT_MINERAL_SOLD:
+			game[STAT_EARNED_SELLING] += event.value;
+			break;
+		default:
+			break;
+	}
+}
+
+bool Game_Statistics::finish_game(PlayerData *player, game_outcome outcome, const char *path)
+{
+	Trace_Zone zone("finish_game_statistics", TRACE_IO);
+
+	if(game_finished)
+	{
+		return true;
+	}
+	
+	game_finished = true;
+	
+	if(!lifetime_loaded)
+	{
+		load_lifetime(path);
+	}
+	
+	game[STAT_GAMES] = 1;
+	game[STAT_TURNS] = player->get_turn_number();
+	
+	if(outcome == GAME_WON)
+	{
+		game[STAT_WINS] = 1;
+	}
+	else if(outcome == GAME_DIED)
+	{
+		game[STAT_DEATHS] = 1;
+	}
+	else if(outcome == GAME_WENT_BROKE)
+	{
+		game[STAT_BROKE] = 1;
+	}
+	
+	unsigned char record[STATISTICS_HEADER_SIZE + STATISTICS_RECORD_SIZE];
+	unsigned char *counters = record + STATISTICS_HEADER_SIZE;
+	
+	for(int statistic = 0; statistic < STATISTIC_COUNT; statistic++)
+	{
+		lifetime[statistic] += game[statistic];
+		
+		write_le(counters + statistic * 4, game[statistic], 4);
+		write_le(counters + STATISTIC_COUNT * 4 + statistic * 8, lifetime[statistic], 8);
+	}
+	
+	write_le(counters + STATISTIC_COUNT * 12, record_checksum(counters, STATISTIC_COUNT * 12), 8);
+	
+	memcpy(record, STATISTICS_MAGIC, 4);
+	write_le(record + 4, STATISTICS_VERSION, 2);
+	write_le(record + 6, STATISTIC_COUNT, 2);
+	
+	// Check what's there already: a ledger this version can't read is
+	// started again, and a record cut short is cut off, so the record
+	// appended lines up with those before it.
+	long size = 0;
+	bool readable = false;
+	FILE *file = fopen(path, "rb");
+	
+	if(file != NULL)
+	{
+		unsigned char header[STATISTICS_HEADER_SIZE];
+		
+		readable = fread(header, 1, STATISTICS_HEADER_SIZE, file) == (size_t)STATISTICS_HEADER_SIZE &&
+				   memcmp(header, record, STATISTICS_HEADER_SIZE) == 0;
+		
+		fseek(file, 0, SEEK_END);
+		size = ftell(file);
+		fclose(file);
+	}
+	
+	long whole = 0;
+	
+	if(readable)
+	{
+		whole = STATISTICS_HEADER_SIZE + (size - STATISTICS_HEADER_SIZE) / STATISTICS_RECORD_SIZE * STATISTICS_RECORD_SIZE;
+	}
+	
+	if(whole != size && truncate(path, whole) != 0)
+	{
+		return false;
+	}
+	
+	file = fopen(path, "ab");
+	
+	if(file == NULL)
+	{
+		return false;
+	}
+	
+	// A new ledger starts with its header.
+	int start = STATISTICS_HEADER_SIZE;
+	
+	if(whole == 0)
+	{
+		start = 0;
+	}
+	
+	int length = sizeof(record) - start;
+	bool written = (int)fwrite(record + start, 1, length, file) == length && fflush(file) == 0 &&
+				   fsync(fileno(file)) == 0;
+	
+	return fclose(file) == 0 && written;
+}
+
+bool Game_Statistics::load_lifetime(const char *path)
+{
+	Trace_Zone zone("load_lifetime_statistics", TRACE_IO);
+
+	memset(lifetime, 0, sizeof(lifetime));
+	lifetime_loaded = true;
+	
+	Mapped_File file;
+	
+	if(!file.open(path) || file.get_size() < STATISTICS_HEADER_SIZE)
+	{
+		return false;
+	}
+	
+	const unsigned char *ledger = file.get_data();
+	
+	if(memcmp(ledger, STATISTICS_MAGIC, 4) != 0 || read_le(ledger + 4, 2) != STATISTICS_VERSION ||
+	   read_le(ledger + 6, 2) != STATISTIC_COUNT)
+	{
+		return false;
+	}
+	
+	// The last record that's whole and undamaged.
+	for(long long record = (file.get_size() - STATISTICS_HEADER_SIZE) / STATISTICS_RECORD_SIZE - 1; record >= 0; record--)
+	{
+		const unsigned char *counters = ledger + STATISTICS_HEADER_SIZE + record * STATISTICS_RECORD_SIZE;
+		
+		if(read_le(counters + STATISTIC_COUNT * 12, 8) == record_checksum(counters, STATISTIC_COUNT * 12))
+		{
+			for(int statistic = 0; statistic < STATISTIC_COUNT; statistic++)
+			{
+				lifetime[statistic] = read_le(counters + STATISTIC_COUNT * 4 + statistic * 8, 8);
+			}
+			
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+unsigned int Game_Statistics::get_game(game_statistic statistic)
+{
+	return game[statistic];
+}
+
+unsigned long long Game_Statistics::get_lifetime(game_statistic statistic)
+{
+	if(!lifetime_loaded)
+	{
+		load_lifetime();
+	}
+	
+	return lifetime[statistic];
+}
+
+Game_Statistics *get_game_statistics()
+{
+	static Game_Statistics statistics;
+	
+	return &statistics;
+}
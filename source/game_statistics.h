@@ -0,0 +1,151 @@
+/*
+ game_statistics.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ What happened during play, counted from the game's events.
+
+ Each game is counted in a fixed set of counters, zeroed when a game
+ starts and saved with it. When it ends they're added to the lifetime
+ totals, and both are appended to the ledger as one record, so the
+ totals are never added up again: loading the ledger reads only its
+ last record.
+*/
+
+#ifndef GAME_STATISTICS
+#define GAME_STATISTICS
+
+#include "classes.h"
+#include "game_events.h"
+
+const char STATISTICS_LEDGER_FILE[] = "statistics_ledger";
+
+// Everything counted.
+enum game_statistic
+{
+	// Tiles dug into, in all and by what was in them.
+	STAT_TILES_DUG,
+	STAT_DUG_DIRT,
+	STAT_DUG_GRANITE,
+	STAT_DUG_SPRING,
+	STAT_DUG_CAVE_IN,
+	STAT_DUG_COAL,
+	STAT_DUG_SILVER,
+	STAT_DUG_GOLD,
+	STAT_DUG_PLATINUM,
+	STAT_DUG_DIAMOND,
+	STAT_GRANITE_CHIPPED,
+	
+	// Minerals found.
+	STAT_FOUND_COAL,
+	STAT_FOUND_SILVER,
+	STAT_FOUND_GOLD,
+	STAT_FOUND_PLATINUM,
+	
+	// Hazards hit.
+	STAT_SPRINGS_HIT,
+	STAT_CAVE_INS,
+	STAT_COLLAPSES,
+	STAT_DROWNINGS,
+	STAT_BLAST_INJURIES,
+	STAT_INSURANCE_CLAIMS,
+	
+	// Dollars spent, by what on. Digging includes chipping granite and
+	// bailing water; the hospital includes insurance.
+	STAT_SPENT_DIGGING,
+	STAT_SPENT_ELEVATOR,
+	STAT_SPENT_HOSPITAL,
+	STAT_SPENT_STORE,
+	STAT_SPENT_TAVERN,
+	
+	// Dollars made selling minerals.
+	STAT_EARNED_SELLING,
+	
+	// Counted when the game ends.
+	STAT_GAMES,
+	STAT_TURNS,
+	STAT_WINS,
+	STAT_DEATHS,
+	STAT_BROKE,
+	
+	STATISTIC_COUNT
+};
+
+// How a game ended.
+enum game_outcome
+{
+	GAME_WON,
+	GAME_DIED,
+	GAME_WENT_BROKE
+};
+
+// The ledger. All little-endian:
+//	"MSTL"
+//	uint16 version, uint16 STATISTIC_COUNT
+// then a record for each game finished:
+//	STATISTIC_COUNT uint32s, the game's counters
+//	STATISTIC_COUNT uint64s, the lifetime totals after it
+//	uint64 checksum of the record before it
+// A record cut short or damaged at the end, by a crash while it was
+// being appended, is ignored, and the totals are the record's before.
+const char STATISTICS_MAGIC[4] = { 'M', 'S', 'T', 'L' };
+const int STATISTICS_VERSION = 1;
+const int STATISTICS_HEADER_SIZE = 8;
+const int STATISTICS_RECORD_SIZE = STATISTIC_COUNT * 12 + 8;
+
+class Game_Statistics : public Game_Event_Sink
+{
+	private:
+		unsigned int game[STATISTIC_COUNT];
+		unsigned long long lifetime[STATISTIC_COUNT];
+		
+		// Whether the lifetime totals have been read from the ledger.
+		bool lifetime_loaded;
+		
+		// Whether the game's counters have gone into the totals already.
+		bool game_finished;
+		
+	public:
+		Game_Statistics();
+		
+		// Count an event.
+		void handle_event(const Game_Event &event);
+		
+		// Zero the game's counters for a new game.
+		void start_game();
+		
+		// Put back the game's counters from a save, for a game just
+		// loaded.
+		void resume_game(const unsigned int saved[STATISTIC_COUNT]);
+		
+		// The game is over: count how it ended, add it to the lifetime
+		// totals and append both to the ledger. A game is only finished
+		// once. Returns false if the ledger couldn't be written.
+		bool finish_game(PlayerData *player, game_outcome outcome, const char *path = STATISTICS_LEDGER_FILE);
+		
+		// Read the lifetime totals from the ledger's last record. Leaves
+		// them at zero, and returns false, if there are none.
+		bool load_lifetime(const char *path = STATISTICS_LEDGER_FILE);
+		
+		unsigned int get_game(game_statistic statistic);
+		unsigned long long get_lifetime(game_statistic statistic);
+};
+
+// The statistics of the game being played.
+Game_Statistics *get_game_statistics();
+
+#endif
@@ -19,7 +19,7 @@
  ---------------------------------------
  Functions that deal with the display and writing of high scores.
 
- All information will be saved in filename "high_scores"
+ Every game scored is kept in the leaderboard (see leaderboard.h).
 */
 
 // Used for access to string libraries, etc.
@@ -37,52 +37,55 @@
 #include "high_scores.h"
 #include "sdl_functions.h"
 #include "classes.h"
+#include "trace.h"
 
 // Initial function to load up the high scores and to display them.
 void display_high_scores(SDL_Objects *sdl, PlayerData *player, bool high_score_entry)
 {
+	Trace_Zone zone("display_high_scores", TRACE_SCREEN);
+	
+	// Clear the mine's view from around the screen.
+	sdl->clear_screen();
+
 	High_Score_Objects high_score_screen;
 
 	high_score_screen.load_high_scores();				// Load the high scores from the file.	
 	
 	if(high_score_entry)
 	{
-		if(high_score_screen.check_high_score(player))		// Check to see if the player's new score fits into the high scores.
+		// Every game is scored, but only one good enough to be shown
+		// is asked for a name.
+		if(high_score_screen.check_high_score(player))
 		{
 			high_score_screen.name_entry_for_high_score(sdl, player);		
-			high_score_screen.rearrange_high_scores();		// Rearrange the high scores if a new one has been added.
 		}
+		
+		high_score_screen.add_high_score(player);
 	}
 		
 	high_score_screen.update_high_score_graphics(sdl);		// Update the graphics.
 
 	high_score_screen.wait_for_keypress(sdl);
-	
-	high_score_screen.write_high_scores();
 }
 
 High_Score_Objects::High_Score_Objects()
 {
-	background = IMG_Load("./Graphics/high_score/background.png");
-	name_entry = IMG_Load("./Graphics/high_score/name_entry.png");
-	diamond_graphic = IMG_Load("./Graphics/high_score/diamond.png");
-	mimi_happy_graphic = IMG_Load("./Graphics/high_score/mimi_happy.png");
-	mimi_sad_graphic = IMG_Load("./Graphics/high_score/mimi_sad.png");
-	headstone_graphic = IMG_Load("./Graphics/high_score/headstone.png");
+	background = load_image("graphics/high_score/background.png");
+	name_entry = load_image("graphics/high_score/name_entry.png");
+	diamond_graphic = load_image("graphics/high_score/diamond.png");
+	mimi_happy_graphic = load_image("graphics/high_score/mimi_happy.png");
+	mimi_sad_graphic = load_image("graphics/high_score/mimi_sad.png");
+	headstone_graphic = load_image("graphics/high_score/headstone.png");
 	
-	header_font = TTF_OpenFont("./Fonts/DejaVuSans-Bold.ttf", 36);
-	standard_font = TTF_OpenFont("./Fonts/DejaVuSans-Bold.ttf", 28);
+	header_font = open_font("Fonts/DejaVuSans-Bold.ttf", 36);
+	standard_font = open_font("Fonts/DejaVuSans-Bold.ttf", 28);
+	small_font = open_font("Fonts/DejaVuSans-Bold.ttf", 20);
 	
 	high_score_name = "";
 	
-	// Set all variables to nothing.
-	for(int x = 0; x <= 4; x++)
-	{
-		player_name[x] = "blank";			
-		player_money[x] = 0;
-		had_diamond[x] = false;
-		player_dead[x] = false;
-	}
+	placed_all_time = 0;
+	placed_today = 0;
+	placed_on_seed = 0;
 }
 
 High_Score_Objects::~High_Score_Objects()
@@ -95,47 +98,56 @@ High_Score_Objects::~High_Score_Objects()
 	
 	TTF_CloseFont(header_font);
 	TTF_CloseFont(standard_font);
+	TTF_CloseFont(small_font);
 }
 
 void High_Score_Objects::update_high_score_graphics(SDL_Objects *sdl)
 {
-	std::string temp_string;				// Used as a buffer for numerical values (int)
-	std::stringstream temp_stringstream;	// Used to convert the int to health string
+	std::stringstream temp_stringstream;	// Used to convert numbers to text.
 	
 	sdl->apply_surface(0, 0, background, sdl->return_screen());
 	sdl->apply_colored_text(245, 10, 198, 15, 15, "HIGH SCORES", header_font, sdl->return_screen());
 	
 	// Display the players' scores, etc.
-	for(int x = 0; x <= 4; x++)
+	for(unsigned int x = 0; x < top_scores.size(); x++)
 	{
-		temp_stringstream << player_money[x];
-		temp_string = temp_stringstream.str();
+		const Score_Entry &score = scores.get_entry(top_scores[x]);
+		
+		temp_stringstream.str("");
+		temp_stringstream << score.money;
 		
-		sdl->apply_text(50, 75 + (x * 80), temp_string.c_str(), standard_font, sdl->return_screen());
-		sdl->apply_text(200, 75 + (x * 80), player_name[x].c_str(), standard_font, sdl->return_screen());
+		sdl->apply_text(50, 75 + (x * 80), temp_stringstream.str(), standard_font, sdl->return_screen());
+		sdl->apply_text(200, 75 + (x * 80), score.name, standard_font, sdl->return_screen());
 		
-		if(had_diamond[x])
+		if(score.flags & SCORE_HAD_DIAMOND)
 		{
 			sdl->apply_surface(705, 60 + (x * 80), diamond_graphic, sdl->return_screen());
 		}
 		
-		if(player_dead[x])
+		if(score.flags & SCORE_DEAD)
 		{
 			sdl->apply_surface(655, 60 + (x * 80), headstone_graphic, sdl->return_screen());
 		}
 		
-		if(player_money[x] < 5000)
+		if(score.money < 5000)
 		{
 			sdl->apply_surface(605, 60 + (x * 80), mimi_sad_graphic, sdl->return_screen());
 		}
-		else if(player_money[x] >= 5000)
+		else if(score.money >= 5000)
 		{
 			sdl->apply_surface(605, 60 + (x * 80), mimi_happy_graphic, sdl->return_screen());
 		}
-
-		temp_stringstream.str("");
 	}
+	
+	// Where the game just scored placed.
+	if(placed_all_time > 0)
+	{
+		temp_stringstream.str("");
+		temp_stringstream << "This game: #" << placed_all_time << " of " << scores.get_count() << ", #"
+						  << placed_today << " today, #" << placed_on_seed << " in this mine";
 		
+		sdl->apply_text(30, 445, temp_stringstream.str(), small_font, sdl->return_screen());
+	}
 	
 	SDL_Flip(sdl->return_screen());
 }
@@ -153,7 +165,7 @@ void High_Score_Objects::name_entry_for_high_score(SDL_Objects *sdl, PlayerData
 	bool update_screen = false;
 	
 	// Clear the string where we're putting the Player's name
-	player_name[4] = "";
+	high_score_name = "";
 	
 	// Update the graphics initially
 	sdl->apply_surface(0, 0, background, sdl->return_screen());		
@@ -191,31 +203,37 @@ void High_Score_Objects::name_entry_for_high_score(SDL_Objects *sdl, PlayerData
 				}
 				else if(keystate[ SDLK_BACKSPACE ])
 				{
-						if(player_name[4].size() > 0)
+						if(high_score_name.size() > 0)
 						{
-							player_name[4].erase(player_name[4].size() - 1, 1);
+							high_score_name.erase(high_score_name.size() - 1, 1);
 						}
 				}
 				
-				if(player_name[4].size() < 14)
+				if((int)high_score_name.size() < LEADERBOARD_NAME_LENGTH)
 				{
 					//If the key is a number
 					if( ( user_input.key.keysym.unicode >= (Uint16)'0' ) && ( user_input.key.keysym.unicode <= (Uint16)'9' ) )
 					{
 						//Append the character
-						player_name[4] += (char)user_input.key.keysym.unicode;
+						high_score_name += (char)user_input.key.keysym.unicode;
 					}
 					//If the key is a uppercase letter
 					else if( ( user_input.key.keysym.unicode >= (Uint16)'A' ) && ( user_input.key.keysym.unicode <= (Uint16)'Z' ) )
 					{
 						//Append the character
-						player_name[4] += (char)user_input.key.keysym.unicode;
+						high_score_name += (char)user_input.key.keysym.unicode;
 					}
 					//If the key is a lowercase letter
 					else if( ( user_input.key.keysym.unicode >= (Uint16)'a' ) && ( user_input.key.keysym.unicode <= (Uint16)'z' ) )
 					{
 						//Append the character
-						player_name[4] += (char)user_input.key.keysym.unicode;
+						high_score_name += (char)user_input.key.keysym.unicode;
+					}
+					//If the key is a space between words
+					else if( user_input.key.keysym.unicode == (Uint16)' ' && high_score_name.size() > 0 )
+					{
+						//Append the character
+						high_score_name += ' ';
 					}		
 					
 					update_screen = true;						
@@ -229,7 +247,7 @@ void High_Score_Objects::name_entry_for_high_score(SDL_Objects *sdl, PlayerData
 			sdl->apply_surface(64, 140, name_entry, sdl->return_screen());
 			sdl->apply_text(160, 170, "You got a high score!", header_font, sdl->return_screen());
 			sdl->apply_text(180, 210, "Please enter your name!", standard_font, sdl->return_screen());
-			sdl->apply_text(100, 260, player_name[4].c_str(), header_font, sdl->return_screen());
+			sdl->apply_text(100, 260, high_score_name.c_str(), header_font, sdl->return_screen());
 			
 			SDL_Flip(sdl->return_screen());
 			update_screen = false;
@@ -238,127 +256,96 @@ void High_Score_Objects::name_entry_for_high_score(SDL_Objects *sdl, PlayerData
 		SDL_Delay(sdl->SDL_WAIT);
 	}
 	
-	// Prevent the player from having no name, otherwise the scoreboard gets messed up.
-	if(player_name[4] == "")
-	{
-		player_name[4] = "Unnamed";
-	}
-	
 	SDL_EnableUNICODE(0);
 	SDL_EnableKeyRepeat(NULL, NULL);
 }
 
 
-// Save the information to the high score file.
-void High_Score_Objects::write_high_scores()
-{
-	std::ofstream high_score_out("high_scores", std::ios::binary);
-	
-	for(int x = 0; x <= 4; x++)
-	{
-		high_score_out << player_name[x] << std::endl;	
-		high_score_out << player_money[x] << std::endl;
-		high_score_out << had_diamond[x] << std::endl;
-		high_score_out << player_dead[x] << std::endl;
-	}
-	
-	
-	high_score_out.close();
-}
-
-// Load the information from the high score file
+// Load the high scores, moving the old file's five into a new
+// leaderboard if there isn't one.
 void High_Score_Objects::load_high_scores()
 {
-	std::ifstream high_score_in("high_scores", std::ios::binary);
-	
-	for(int x = 0; x <= 4; x++)
-	{
-		high_score_in >> player_name[x];
-		high_score_in >> player_money[x];
-		high_score_in >> had_diamond[x];
-		high_score_in >> player_dead[x];
-	}
-	
-	high_score_in.close();
-}
+	Trace_Zone zone("load_high_scores", TRACE_IO);
 
-// Check to see if a high score can be entered into the current set.
-bool High_Score_Objects::check_high_score(PlayerData *player)
-{
-	for(int x = 0; x <= 4; x++)
+	if(!scores.load(LEADERBOARD_FILE))
 	{
-		// If it is a high score, then move the data into the lowest
-		// slot. Another function will rearrange.
-		if(player->get_money() > player_money[x])
+		std::ifstream high_score_in(OLD_HIGH_SCORE_FILE, std::ios::binary);
+		
+		for(int x = 0; x <= 4 && high_score_in; x++)
 		{
-			player_money[4] = player->get_money();
-			had_diamond[4] = player->get_has_diamond();
+			std::string name;
+			Score_Entry score;
+			bool had_diamond = false;
+			bool player_dead = false;
 			
-			if(player->get_health() <= 0)
-			{
-				player_dead[4] = true;
-			}
-			else
+			score.money = 0;
+			high_score_in >> name >> score.money >> had_diamond >> player_dead;
+			
+			// Scores never set were left as "blank".
+			if(!high_score_in || name == "blank")
 			{
-				player_dead[4] = false;
+				break;
 			}
 			
-			return true;
+			memset(score.name, 0, sizeof(score.name));
+			strncpy(score.name, name.c_str(), LEADERBOARD_NAME_LENGTH);
+			score.seed = 0;
+			score.day = 0;
+			score.flags = (had_diamond ? SCORE_HAD_DIAMOND : 0) | (player_dead ? SCORE_DEAD : 0);
+			
+			scores.add(score);
 		}
+		
+		high_score_in.close();
+		
+		// Replaces a leaderboard that couldn't be read, too.
+		scores.write(LEADERBOARD_FILE);
 	}
 	
-	return false;
+	scores.get_page(BOARD_ALL_TIME, 0, 0, HIGH_SCORES_SHOWN, top_scores);
 }
-		
-// Rearrange the high scores once one has been entered.
-void High_Score_Objects::rearrange_high_scores()
+
+// Check to see if the player's score would be one of those shown.
+bool High_Score_Objects::check_high_score(PlayerData *player)
 {
-	int player_money_temp;
-	std::string player_name_temp;
-	bool had_diamond_temp;
-	bool player_dead_temp;
+	return scores.get_rank(BOARD_ALL_TIME, 0, player->get_money()) <= HIGH_SCORES_SHOWN;
+}
+
+// Score the player's game, and add it to the leaderboard's file.
+void High_Score_Objects::add_high_score(PlayerData *player)
+{
+	Score_Entry score;
 	
-	bool in_order = false;
+	// Prevent the player from having no name, otherwise the scoreboard gets messed up.
+	if(high_score_name == "")
+	{
+		high_score_name = "Unnamed";
+	}
 	
-	while(!in_order)
+	memset(score.name, 0, sizeof(score.name));
+	strncpy(score.name, high_score_name.c_str(), LEADERBOARD_NAME_LENGTH);
+	score.money = player->get_money();
+	score.seed = player->get_seed();
+	score.day = get_score_day();
+	score.flags = 0;
+	
+	if(player->get_has_diamond())
 	{
-		// Quit if all of the scores are in proper order...
-		if(player_money[0] >= player_money[1]
-		&& player_money[1] >= player_money[2]
-		&& player_money[2] >= player_money[3]
-		&& player_money[3] >= player_money[4])
-		{
-			in_order = true;
-		}
-		// ... if not, then rearrange till they are.
-		else
-		{
-			for(int y = 0; y <= 4; y++)
-			{
-				for(int x = 0; x <= 4; x++)
-				{
-					if(player_money[y] < player_money[x]
-						&& y < x)
-					{
-						player_money_temp = player_money[y];
-						player_name_temp = player_name[y];
-						had_diamond_temp = had_diamond[y];
-						player_dead_temp = player_dead[y];
-						
-						player_money[y] = player_money[x];
-						player_name[y] = player_name[x];
-						had_diamond[y] = had_diamond[x];
-						player_dead[y] = player_dead[x];
-						
-						player_money[x] = player_money_temp;
-						player_name[x] = player_name_temp;
-						had_diamond[x] = had_diamond_temp;
-						player_dead[x] = player_dead_temp;
-					}
-				}
-			}
-		}
+		score.flags |= SCORE_HAD_DIAMOND;
+	}
+	
+	if(player->get_health() <= 0)
+	{
+		score.flags |= SCORE_DEAD;
 	}
+	
+	placed_all_time = scores.get_rank(BOARD_ALL_TIME, 0, score.money);
+	placed_today = scores.get_rank(BOARD_DAY, score.day, score.money);
+	placed_on_seed = scores.get_rank(BOARD_SEED, score.seed, score.money);
+	
+	scores.add_to_file(LEADERBOARD_FILE, score);
+	
+	scores.get_page(BOARD_ALL_TIME, 0, 0, HIGH_SCORES_SHOWN, top_scores);
 }
 
 // Wait for a user keypress to exit the high score screen.
@@ -19,7 +19,7 @@
  ---------------------------------------
  Functions that deal with the display and writing of high scores.
  
- All information will be saved in filename "high_scores"
+ Every game scored is kept in the leaderboard (see leaderboard.h).
 */
 
 #ifndef HIGH_SCORES
@@ -28,6 +28,7 @@
 // Used for access to string libraries, etc.
 #include <string>
 #include <sstream>
+#include <vector>
 
 // Used for the writing/accessing of files on the drive.
 #include <iostream>
@@ -38,8 +39,19 @@
 #include "SDL_ttf/SDL_ttf.h"
 
 #include "classes.h"
+#include "leaderboard.h"
 
-// Display the high scores.
+class SDL_Objects;
+
+// How many of the best scores the screen shows.
+const int HIGH_SCORES_SHOWN = 5;
+
+// Where the five high scores were kept before the leaderboard. They're
+// moved into it the first time there's no leaderboard to load.
+const char OLD_HIGH_SCORE_FILE[] = "high_scores";
+
+// Display the high scores. With high_score_entry, the player's game is
+// scored first, asking for their name if it's one of those shown.
 void display_high_scores(SDL_Objects *sdl, PlayerData *player, bool high_score_entry);
 
 class High_Score_Objects
@@ -55,13 +67,20 @@ class High_Score_Objects
 		
 		TTF_Font *header_font;
 		TTF_Font *standard_font;
+		TTF_Font *small_font;
 		
-		// Variables used for storage of items from the high score file.
-		std::string player_name[5];
+		// Every game scored, and the best of them all time.
+		Leaderboard scores;
+		std::vector<int> top_scores;
+		
+		// The name being entered.
 		std::string high_score_name;
-		int player_money[5];
-		bool had_diamond[5];
-		bool player_dead[5];
+		
+		// Where the game just scored placed all time, that day and on its
+		// seed, or 0 if no game was scored.
+		int placed_all_time;
+		int placed_today;
+		int placed_on_seed;
 		
 	public:
 		// Initializer etc.
@@ -74,17 +93,15 @@ class High_Score_Objects
 		// Allow the user to enter name for entry into scoreboard
 		void name_entry_for_high_score(SDL_Objects *sdl, PlayerData *player);
 		
-		// Update high score information
-		void write_high_scores();
-		
 		// Load the high scores.
 		void load_high_scores();
 		
-		// Check to see if a high score can be entered into the current set.
+		// Check to see if the player's score is one of those shown.
 		bool check_high_score(PlayerData *player);
 		
-		// Rearrange the high scores once one has been entered.
-		void rearrange_high_scores();		
+		// Score the player's game under the name entered, and add it to
+		// the leaderboard's file.
+		void add_high_score(PlayerData *player);
 
 		// Wait for a user keypress to exit the high score screen.
 		void wait_for_keypress(SDL_Objects *sdl);
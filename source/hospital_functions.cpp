@@ -33,11 +33,15 @@
 #include "sdl_functions.h"
 #include "classes.h"
 #include "hospital_functions.h"
+#include "economy.h"
 #include "popup_menu.h"
 #include "timer.h"
+#include "trace.h"
 
 void hospital(PlayerData *player, SDL_Objects *sdl)
 {
+	Trace_Zone zone("hospital", TRACE_SCREEN);
+
 	// Initialize object to store hospital's data in.
 	Hospital_Objects hospital_data;
 
@@ -125,19 +129,7 @@ void hospital(PlayerData *player, SDL_Objects *sdl)
 			else if(hospital_selection.return_vert() == 2)
 			{
 				// Allow the player to purchase insurance.
-				if(player->get_money() >= 250
-					&& (player->get_insurance_turn_number() + 25) < player->get_turn_number())
-				{
-					hospital_data.insurance(player);
-				}
-				else if(player->get_money() < 250)
-				{
-					sdl->update_status_text("You can't afford insurance!");
-				}
-				else if(player->get_insurance_turn_number() == player->get_turn_number())
-				{
-					sdl->update_status_text("You already have insurance for max turns!");
-				}
+				hospital_data.insurance(player);
 
 				SDL_Delay(sdl->KEYPRESS_WAIT);			
 				update_screen = true;
@@ -173,15 +165,15 @@ void hospital(PlayerData *player, SDL_Objects *sdl)
 
 Hospital_Objects::Hospital_Objects()
 {
-	hospital_graphic = IMG_Load("./Graphics/hospital/hospital.png");
-	hospital_arrow_graphic = IMG_Load("./Graphics/hospital/arrow.png");
-	one_day_button = IMG_Load("./Graphics/hospital/one_day.png");
-	full_heal_button = IMG_Load("./Graphics/hospital/refill_health.png");
-	insurance_button = IMG_Load("./Graphics/hospital/insurance.png");
-	exit_button = IMG_Load("./Graphics/hospital/exit_hospital.png");
+	hospital_graphic = load_image("graphics/hospital/hospital.png");
+	hospital_arrow_graphic = load_image("graphics/hospital/arrow.png");
+	one_day_button = load_image("graphics/hospital/one_day.png");
+	full_heal_button = load_image("graphics/hospital/refill_health.png");
+	insurance_button = load_image("graphics/hospital/insurance.png");
+	exit_button = load_image("graphics/hospital/exit_hospital.png");
 	
-	header_font = TTF_OpenFont("./Fonts/DejaVuSans-Bold.ttf", 28);
-	display_font = TTF_OpenFont("./Fonts/DejaVuSans-Bold.ttf", 20);
+	header_font = open_font("Fonts/DejaVuSans-Bold.ttf", 28);
+	display_font = open_font("Fonts/DejaVuSans-Bold.ttf", 20);
 }
 
 Hospital_Objects::~Hospital_Objects()
@@ -266,29 +258,20 @@ void Hospital_Objects::update_hospital_graphics(SDL_Objects *sdl, PlayerData *pl
 	}
 }
 
+// The charges themselves are in economy.cpp.
 void Hospital_Objects::stay_one_day(PlayerData *player)
 {
-	if(player->get_health() <= 100 && player->get_money() >= 10)
-	{
-		player->change_health(10);
-		player->change_money(-100);
-	}
+	::stay_one_day(player);
 }
 
 void Hospital_Objects::full_heal(PlayerData *player)
 {
-	while(player->get_health() < 100 && player->get_money() >= 10)
-	{
-		player->change_health(1);
-		player->change_money(-10);
-	}
+	::full_heal(player);
 }
 
 void Hospital_Objects::insurance(PlayerData *player)
 {
-	player->change_has_insurance(true);
-	player->set_insurance_turn_number();
-	player->change_money(-250);
+	buy_insurance(player);
 }
 
 // Animate movement of the arrow.
@@ -316,7 +299,7 @@ void Hospital_Objects::animate_arrow_down(SDL_Objects *sdl, Selection_Arrow *sel
         // Update the header for the hospital.
         sdl->apply_text(75, 10, "RUSTY'S RESTORATION", header_font, sdl->return_screen());
         
-		SDL_UpdateRect(sdl->return_screen(), 505, 0, 70, 380);
+		sdl->update_rect(505, 0, 70, 380);
 		SDL_Delay(sdl->MENU_ANIMATION_WAIT);
 	}
 }
@@ -345,7 +328,7 @@ void Hospital_Objects::animate_arrow_up(SDL_Objects *sdl, Selection_Arrow *selec
         // Update the header for the hospital.
         sdl->apply_text(75, 10, "RUSTY'S RESTORATION", header_font, sdl->return_screen());
 		
-        SDL_UpdateRect(sdl->return_screen(), 505, 0, 70, 380);
+        sdl->update_rect(505, 0, 70, 380);
 		SDL_Delay(sdl->MENU_ANIMATION_WAIT);
 	}
 }
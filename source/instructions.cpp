@@ -29,10 +29,13 @@
 
 // Functions to access graphical stuff.
 #include "sdl_functions.h"
+#include "trace.h"
 
 // General function to bring up the instructions.
 void display_instructions(SDL_Objects *sdl)
 {
+    Trace_Zone zone("display_instructions", TRACE_SCREEN);
+
     Instructions_Objects instructions_screen;
     
     instructions_screen.update_instructions_graphic(sdl);
@@ -42,7 +45,7 @@ void display_instructions(SDL_Objects *sdl)
 
 Instructions_Objects::Instructions_Objects()
 {
-    instructions_graphic = IMG_Load("./Graphics/instructions/instructions.png");
+    instructions_graphic = load_image("graphics/instructions/instructions.png");
 }
 
 Instructions_Objects::~Instructions_Objects()
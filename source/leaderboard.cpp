@@ -0,0 +1,591 @@
+/*
+ leaderboard.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ The high scores: every game that has been scored, ranked all time,
+ by the seed it was played from, and by the day it was played.
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <algorithm>
+
+#include <unistd.h>
+
+#include "leaderboard.h"
+#include "mapped_file.h"
+#include "trace.h"
+
+static void write_le(unsigned char *data, unsigned long long value, int bytes)
+{
+	for(int byte = 0; byte < bytes; byte++)
+	{
+		data[byte] = (unsigned char)(value >> (byte * 8));
+	}
+}
+
+static unsigned long long read_le(const unsigned char *data, int bytes)
+{
+	unsigned long long value = 0;
+	
+	for(int byte = 0; byte < bytes; byte++)
+	{
+		value |= (unsigned long long)data[byte] << (byte * 8);
+	}
+	
+	return value;
+}
+
+// A node's priority, mixed from its number so the same scores always
+// make the same trees.
+static unsigned int node_priority(unsigned int node)
+{
+	node ^= node >> 16;
+	node *= 0x7feb352d;
+	node ^= node >> 15;
+	node *= 0x846ca68b;
+	node ^= node >> 16;
+	
+	return node;
+}
+
+static void write_entry(unsigned char *data, const Score_Entry &entry)
+{
+	memset(data, 0, LEADERBOARD_ENTRY_SIZE);
+	memcpy(data, entry.name, strlen(entry.name));
+	write_le(data + LEADERBOARD_NAME_SIZE, (unsigned int)entry.money, 4);
+	write_le(data + LEADERBOARD_NAME_SIZE + 4, entry.seed, 4);
+	write_le(data + LEADERBOARD_NAME_SIZE + 8, entry.day, 2);
+	data[LEADERBOARD_NAME_SIZE + 10] = (unsigned char)entry.flags;
+}
+
+static void write_header(unsigned char *data)
+{
+	memcpy(data, LEADERBOARD_MAGIC, 4);
+	write_le(data + 4, LEADERBOARD_VERSION, 2);
+	write_le(data + 6, LEADERBOARD_ENTRY_SIZE, 2);
+}
+
+// Write bytes to the end of a file and make sure they're on the disk.
+static bool write_file(FILE *file, const unsigned char *data, int size)
+{
+	return (int)fwrite(data, 1, size, file) == size && fflush(file) == 0 && fsync(fileno(file)) == 0;
+}
+
+Leaderboard::Leaderboard()
+{
+	all_time_root = -1;
+}
+
+void Leaderboard::clear()
+{
+	entries.clear();
+	nodes.clear();
+	
+	all_time_root = -1;
+	seed_roots.clear();
+	day_roots.clear();
+}
+
+bool Leaderboard::ranks_above(int node, int other)
+{
+	if(nodes[node].money != nodes[other].money)
+	{
+		return nodes[node].money > nodes[other].money;
+	}
+	
+	return nodes[node].entry < nodes[other].entry;
+}
+
+int Leaderboard::node_size(int node)
+{
+	if(node == -1)
+	{
+		return 0;
+	}
+	
+	return nodes[node].size;
+}
+
+void Leaderboard::update_size(int node)
+{
+	nodes[node].size = node_size(nodes[node].left) + node_size(nodes[node].right) + 1;
+}
+
+void Leaderboard::split(int tree, int node, int &above, int &below)
+{
+	if(tree == -1)
+	{
+		above = -1;
+		below = -1;
+		return;
+	}
+	
+	if(ranks_above(tree, node))
+	{
+		split(nodes[tree].right, node, nodes[tree].right, below);
+		above = tree;
+	}
+	else
+	{
+		split(nodes[tree].left, node, above, nodes[tree].left);
+		below = tree;
+	}
+	
+	update_size(tree);
+}
+
+int Leaderboard::insert_node(int tree, int node)
+{
+	if(tree == -1)
+	{
+		return node;
+	}
+	
+	// A node with a higher priority than the tree's root becomes the
+	// root, with the tree split either side of it.
+	if(nodes[node].priority > nodes[tree].priority)
+	{
+		split(tree, node, nodes[node].left, nodes[node].right);
+		update_size(node);
+		return node;
+	}
+	
+	if(ranks_above(node, tree))
+	{
+		nodes[tree].left = insert_node(nodes[tree].left, node);
+	}
+	else
+	{
+		nodes[tree].right = insert_node(nodes[tree].right, node);
+	}
+	
+	update_size(tree);
+	
+	return tree;
+}
+
+int Leaderboard::find_root(leaderboard_board board, unsigned int key)
+{
+	if(board == BOARD_SEED)
+	{
+		std::map<unsigned int, int>::iterator root = seed_roots.find(key);
+		
+		if(root != seed_roots.end())
+		{
+			return root->second;
+		}
+	}
+	else if(board == BOARD_DAY)
+	{
+		std::map<int, int>::iterator root = day_roots.find((int)key);
+		
+		if(root != day_roots.end())
+		{
+			return root->second;
+		}
+	}
+	else
+	{
+		return all_time_root;
+	}
+	
+	return -1;
+}
+
+void Leaderboard::make_nodes(int entry)
+{
+	for(int node = entry * 3; node < entry * 3 + 3; node++)
+	{
+		nodes[node].entry = entry;
+		nodes[node].money = entries[entry].money;
+		nodes[node].left = -1;
+		nodes[node].right = -1;
+		nodes[node].size = 1;
+		nodes[node].priority = node_priority(node);
+	}
+}
+
+void Leaderboard::rank_entry(int entry)
+{
+	int first_node = entry * 3;
+	
+	nodes.resize(first_node + 3);
+	make_nodes(entry);
+	
+	all_time_root = insert_node(all_time_root, first_node);
+	
+	std::map<unsigned int, int>::iterator seed_root = seed_roots.find(entries[entry].seed);
+	
+	if(seed_root == seed_roots.end())
+	{
+		seed_root = seed_roots.insert(std::make_pair(entries[entry].seed, -1)).first;
+	}
+	
+	seed_root->second = insert_node(seed_root->second, first_node + 1);
+	
+	std::map<int, int>::iterator day_root = day_roots.find(entries[entry].day);
+	
+	if(day_root == day_roots.end())
+	{
+		day_root = day_roots.insert(std::make_pair(entries[entry].day, -1)).first;
+	}
+	
+	day_root->second = insert_node(day_root->second, first_node + 2);
+}
+
+// An entry's place when sorting a board's nodes: by the board's key,
+// and then in rank order.
+struct Board_Key
+{
+	unsigned int key;
+	int money;
+	int entry;
+};
+
+static bool board_key_before(const Board_Key &one, const Board_Key &other)
+{
+	if(one.key != other.key)
+	{
+		return one.key < other.key;
+	}
+	
+	if(one.money != other.money)
+	{
+		return one.money > other.money;
+	}
+	
+	return one.entry < other.entry;
+}
+
+int Leaderboard::build_tree(const std::vector<int> &ranked)
+{
+	// The tree's right edge. Each node in turn goes down it to below the
+	// first node with a higher priority, taking the nodes it passes as
+	// its left subtree. A node taken off the edge has no more nodes to
+	// come under it, so its size is known.
+	std::vector<int> edge;
+	
+	for(unsigned int place = 0; place < ranked.size(); place++)
+	{
+		int node = ranked[place];
+		int passed = -1;
+		
+		while(!edge.empty() && nodes[edge.back()].priority < nodes[node].priority)
+		{
+			passed = edge.back();
+			edge.pop_back();
+			update_size(passed);
+		}
+		
+		nodes[node].left = passed;
+		
+		if(!edge.empty())
+		{
+			nodes[edge.back()].right = node;
+		}
+		
+		edge.push_back(node);
+	}
+	
+	if(edge.empty())
+	{
+		return -1;
+	}
+	
+	for(int node = edge.size() - 1; node >= 0; node--)
+	{
+		update_size(edge[node]);
+	}
+	
+	return edge[0];
+}
+
+void Leaderboard::build_boards()
+{
+	int count = entries.size();
+	std::vector<Board_Key> keys(count);
+	std::vector<int> ranked;
+	
+	for(int board = BOARD_ALL_TIME; board <= BOARD_DAY; board++)
+	{
+		for(int entry = 0; entry < count; entry++)
+		{
+			keys[entry].key = 0;
+			keys[entry].money = entries[entry].money;
+			keys[entry].entry = entry;
+			
+			if(board == BOARD_SEED)
+			{
+				keys[entry].key = entries[entry].seed;
+			}
+			else if(board == BOARD_DAY)
+			{
+				keys[entry].key = entries[entry].day;
+			}
+		}
+		
+		std::sort(keys.begin(), keys.end(), board_key_before);
+		
+		// Each run of the same key is a board.
+		int end = 0;
+		
+		for(int start = 0; start < count; start = end)
+		{
+			ranked.clear();
+			
+			for(end = start; end < count && keys[end].key == keys[start].key; end++)
+			{
+				ranked.push_back(keys[end].entry * 3 + board);
+			}
+			
+			int root = build_tree(ranked);
+			
+			if(board == BOARD_SEED)
+			{
+				seed_roots[keys[start].key] = root;
+			}
+			else if(board == BOARD_DAY)
+			{
+				day_roots[keys[start].key] = root;
+			}
+			else
+			{
+				all_time_root = root;
+			}
+		}
+	}
+}
+
+bool Leaderboard::load(const char *path)
+{
+	Trace_Zone zone("load_leaderboard", TRACE_IO);
+
+	clear();
+	
+	Mapped_File file;
+	
+	if(!file.open(path) || file.get_size() < LEADERBOARD_HEADER_SIZE)
+	{
+		return false;
+	}
+	
+	const unsigned char *data = file.get_data();
+	
+	if(memcmp(data, LEADERBOARD_MAGIC, 4) != 0 || read_le(data + 4, 2) != LEADERBOARD_VERSION ||
+	   read_le(data + 6, 2) != LEADERBOARD_ENTRY_SIZE)
+	{
+		return false;
+	}
+	
+	int count = (file.get_size() - LEADERBOARD_HEADER_SIZE) / LEADERBOARD_ENTRY_SIZE;
+	
+	entries.resize(count);
+	nodes.resize(count * 3);
+	
+	for(int entry = 0; entry < count; entry++)
+	{
+		const unsigned char *saved = data + LEADERBOARD_HEADER_SIZE + entry * LEADERBOARD_ENTRY_SIZE;
+		Score_Entry &score = entries[entry];
+		
+		memcpy(score.name, saved, LEADERBOARD_NAME_SIZE);
+		score.name[LEADERBOARD_NAME_LENGTH] = '\0';
+		score.money = (int)read_le(saved + LEADERBOARD_NAME_SIZE, 4);
+		score.seed = (unsigned int)read_le(saved + LEADERBOARD_NAME_SIZE + 4, 4);
+		score.day = (int)read_le(saved + LEADERBOARD_NAME_SIZE + 8, 2);
+		score.flags = saved[LEADERBOARD_NAME_SIZE + 10];
+		
+		make_nodes(entry);
+	}
+	
+	build_boards();
+	
+	return true;
+}
+
+bool Leaderboard::write(const char *path)
+{
+	Trace_Zone zone("write_leaderboard", TRACE_IO);
+
+	std::vector<unsigned char> data(LEADERBOARD_HEADER_SIZE + entries.size() * LEADERBOARD_ENTRY_SIZE);
+	
+	write_header(&data[0]);
+	
+	for(unsigned int entry = 0; entry < entries.size(); entry++)
+	{
+		write_entry(&data[LEADERBOARD_HEADER_SIZE + entry * LEADERBOARD_ENTRY_SIZE], entries[entry]);
+	}
+	
+	// Written to a temporary file that then replaces it, so a crash
+	// leaves either the old leaderboard or the new one.
+	std::string temporary_path = std::string(path) + ".tmp";
+	FILE *file = fopen(temporary_path.c_str(), "wb");
+	
+	if(file == NULL)
+	{
+		return false;
+	}
+	
+	bool written = write_file(file, &data[0], data.size());
+	
+	if(fclose(file) != 0 || !written || rename(temporary_path.c_str(), path) != 0)
+	{
+		remove(temporary_path.c_str());
+		return false;
+	}
+	
+	return true;
+}
+
+int Leaderboard::add(const Score_Entry &entry)
+{
+	int number = entries.size();
+	
+	entries.push_back(entry);
+	entries[number].name[LEADERBOARD_NAME_LENGTH] = '\0';
+	
+	rank_entry(number);
+	
+	return number;
+}
+
+bool Leaderboard::add_to_file(const char *path, const Score_Entry &entry)
+{
+	Trace_Zone zone("add_to_leaderboard", TRACE_IO);
+
+	int number = add(entry);
+	
+	FILE *file = fopen(path, "ab");
+	
+	if(file == NULL)
+	{
+		return false;
+	}
+	
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	
+	// An entry cut short would put every entry after it out of line, so
+	// the file is written again without it.
+	if(size != 0 && (size < LEADERBOARD_HEADER_SIZE || (size - LEADERBOARD_HEADER_SIZE) % LEADERBOARD_ENTRY_SIZE != 0))
+	{
+		fclose(file);
+		return write(path);
+	}
+	
+	unsigned char data[LEADERBOARD_HEADER_SIZE + LEADERBOARD_ENTRY_SIZE];
+	int start = LEADERBOARD_HEADER_SIZE;
+	
+	if(size == 0)
+	{
+		write_header(data);
+		start = 0;
+	}
+	
+	write_entry(data + LEADERBOARD_HEADER_SIZE, entries[number]);
+	
+	bool written = write_file(file, data + start, sizeof(data) - start);
+	
+	return fclose(file) == 0 && written;
+}
+
+int Leaderboard::get_count()
+{
+	return entries.size();
+}
+
+const Score_Entry &Leaderboard::get_entry(int entry)
+{
+	return entries[entry];
+}
+
+int Leaderboard::get_board_count(leaderboard_board board, unsigned int key)
+{
+	return node_size(find_root(board, key));
+}
+
+int Leaderboard::get_rank(leaderboard_board board, unsigned int key, int money)
+{
+	int rank = 1;
+	int node = find_root(board, key);
+	
+	// Count the entries with at least as much money.
+	while(node != -1)
+	{
+		if(nodes[node].money >= money)
+		{
+			rank += node_size(nodes[node].left) + 1;
+			node = nodes[node].right;
+		}
+		else
+		{
+			node = nodes[node].left;
+		}
+	}
+	
+	return rank;
+}
+
+int Leaderboard::get_page(leaderboard_board board, unsigned int key, int first, int count, std::vector<int> &page)
+{
+	page.clear();
+	
+	int root = find_root(board, key);
+	int last = first + count;
+	
+	if(first < 0)
+	{
+		first = 0;
+	}
+	
+	if(last > node_size(root))
+	{
+		last = node_size(root);
+	}
+	
+	for(int rank = first; rank < last; rank++)
+	{
+		// Walk down to the entry with rank entries above it.
+		int node = root;
+		int above = rank;
+		
+		while(above != node_size(nodes[node].left))
+		{
+			if(above < node_size(nodes[node].left))
+			{
+				node = nodes[node].left;
+			}
+			else
+			{
+				above -= node_size(nodes[node].left) + 1;
+				node = nodes[node].right;
+			}
+		}
+		
+		page.push_back(nodes[node].entry);
+	}
+	
+	return page.size();
+}
+
+int get_score_day()
+{
+	return (int)(time(NULL) / (24 * 60 * 60));
+}
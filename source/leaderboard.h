@@ -0,0 +1,184 @@
+/*
+ leaderboard.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ The high scores: every game that has been scored, ranked all time,
+ by the seed it was played from, and by the day it was played.
+
+ Each board is a treap (a binary search tree kept balanced by random
+ priorities) of entry numbers, best first, with each node counting the
+ nodes under it. A score is put in its place, a rank is looked up, and
+ the entry at a rank is found in O(log n), however many there are.
+ The nodes of every board share one pool, and refer to each other and
+ to the entries by number, so a board costs no allocations of its own.
+ A loaded leaderboard's boards are sorted and built in one go, giving
+ the same trees as ranking the entries one at a time would.
+
+ The file is a header followed by the entries in the order they were
+ scored, so a new score is appended to it rather than the file being
+ written again.
+*/
+
+#ifndef LEADERBOARD
+#define LEADERBOARD
+
+#include <vector>
+#include <map>
+
+const char LEADERBOARD_FILE[] = "leaderboard";
+
+// The file. All little-endian:
+//	"MLDB"
+//	uint16 version, uint16 size of an entry
+// then each entry:
+//	the name, padded with zeros to LEADERBOARD_NAME_SIZE bytes
+//	int32 money
+//	uint32 the seed the game was played from
+//	uint16 the day it was played, in days since 1970
+//	uint8 flags (score_flag)
+//	uint8 unused
+// An entry cut short at the end of the file, by a crash while it was
+// being appended, is ignored.
+const char LEADERBOARD_MAGIC[4] = { 'M', 'L', 'D', 'B' };
+const int LEADERBOARD_VERSION = 1;
+const int LEADERBOARD_HEADER_SIZE = 8;
+const int LEADERBOARD_NAME_SIZE = 16;
+const int LEADERBOARD_ENTRY_SIZE = LEADERBOARD_NAME_SIZE + 12;
+
+// Longest name that fits, leaving room for the zero after it.
+const int LEADERBOARD_NAME_LENGTH = LEADERBOARD_NAME_SIZE - 1;
+
+enum score_flag
+{
+	SCORE_HAD_DIAMOND = 1,
+	SCORE_DEAD = 2
+};
+
+struct Score_Entry
+{
+	char name[LEADERBOARD_NAME_SIZE];
+	int money;
+	unsigned int seed;
+	int day;
+	int flags;
+};
+
+// Which board to look at. The seed and day boards are picked by a key:
+// the seed, or the day.
+enum leaderboard_board
+{
+	BOARD_ALL_TIME,
+	BOARD_SEED,
+	BOARD_DAY
+};
+
+class Leaderboard
+{
+	private:
+		// Each entry has a node on each board, numbered entry * 3 + the
+		// board. The node keeps the entry's money, so the tree can be
+		// walked without looking at the entries.
+		struct Board_Node
+		{
+			int entry;
+			int money;
+			int left;			// -1 if there is none.
+			int right;
+			int size;			// Nodes in this one's tree, itself included.
+			unsigned int priority;
+		};
+		
+		std::vector<Score_Entry> entries;
+		std::vector<Board_Node> nodes;
+		
+		int all_time_root;
+		std::map<unsigned int, int> seed_roots;
+		std::map<int, int> day_roots;
+		
+		// Whether one node ranks above another: more money, or the same
+		// and scored first.
+		bool ranks_above(int node, int other);
+		
+		int node_size(int node);
+		void update_size(int node);
+		
+		// Split a tree into the nodes that rank above a node and those
+		// that don't.
+		void split(int tree, int node, int &above, int &below);
+		
+		// Put a node in a tree, returning the tree's new root.
+		int insert_node(int tree, int node);
+		
+		// A board's root, or -1 if it has no entries.
+		int find_root(leaderboard_board board, unsigned int key);
+		
+		// Set up an entry's nodes, on no board yet.
+		void make_nodes(int entry);
+		
+		// Put an entry on all its boards.
+		void rank_entry(int entry);
+		
+		// Make a tree of nodes already in rank order, in O(n).
+		int build_tree(const std::vector<int> &ranked);
+		
+		// Make every board from scratch, sorting rather than putting
+		// the entries on one at a time.
+		void build_boards();
+		
+	public:
+		Leaderboard();
+		
+		// Forget every entry.
+		void clear();
+		
+		// Replace the entries with those in a file. Returns false, with
+		// no entries, if there's no file or it isn't a leaderboard.
+		bool load(const char *path);
+		
+		// Write every entry to a file, replacing it.
+		bool write(const char *path);
+		
+		// Rank an entry, returning its number. The name is cut short if
+		// it's too long.
+		int add(const Score_Entry &entry);
+		
+		// Rank an entry and append it to a file, starting the file if it
+		// isn't there. Returns false if it couldn't be written; it's
+		// ranked either way.
+		bool add_to_file(const char *path, const Score_Entry &entry);
+		
+		// Every entry scored, on all boards.
+		int get_count();
+		const Score_Entry &get_entry(int entry);
+		
+		// How many entries a board has.
+		int get_board_count(leaderboard_board board, unsigned int key);
+		
+		// The rank (1 for the best) a score of money would take on a
+		// board if it were added now, after any the same already there.
+		int get_rank(leaderboard_board board, unsigned int key, int money);
+		
+		// Fill page with up to count entry numbers, best first, starting
+		// at rank first + 1. Returns how many there were.
+		int get_page(leaderboard_board board, unsigned int key, int first, int count, std::vector<int> &page);
+};
+
+// The day it is now, in days since 1970, for the day boards.
+int get_score_day();
+
+#endif
@@ -23,13 +23,24 @@
 #include "SDL/SDL.h"
 
 #include "classes.h"
+#include "game_events.h"
+#include "game_recorder.h"
 #include "sdl_functions.h"
 
 #include "town_functions.h"
 #include "startup_screen.h"
 #include "change_working_directory.h"
+#include "trace.h"
+#include "autosave.h"
+#include "game_statistics.h"
+#include "asset_archive.h"
+#include "asset_preloader.h"
 
 #include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
 
 int main(int argc, char* args[])
 {
@@ -38,23 +49,96 @@ int main(int argc, char* args[])
     change_directory_macos();
 #endif
     
+	// Record a session trace if asked to with --trace <file>.
+	for(int arg = 1; arg < argc - 1; arg++)
+	{
+		if(strcmp(args[arg], "--trace") == 0)
+		{
+			if(!get_trace_recorder()->start(args[arg + 1]))
+			{
+				std::cerr << "Unable to open trace file " << args[arg + 1] << std::endl;
+			}
+		}
+	}
+	
+	// The window's size, with --resolution <width>x<height>, and the size
+	// of a mine tile in it, with --tile <pixels>.
+	Display_Settings display;
+		display.width = LAYOUT_WIDTH;
+		display.height = LAYOUT_HEIGHT;
+		display.tile_size = DEFAULT_TILE_SIZE;
+	
+	for(int arg = 1; arg < argc - 1; arg++)
+	{
+		if(strcmp(args[arg], "--resolution") == 0)
+		{
+			int width = 0;
+			int height = 0;
+			
+			if(sscanf(args[arg + 1], "%dx%d", &width, &height) == 2
+				&& width >= LAYOUT_WIDTH && height >= LAYOUT_HEIGHT)
+			{
+				display.width = width;
+				display.height = height;
+			}
+			else
+			{
+				std::cerr << "Resolution " << args[arg + 1] << " is smaller than "
+					<< LAYOUT_WIDTH << "x" << LAYOUT_HEIGHT << ", using that instead" << std::endl;
+			}
+		}
+		else if(strcmp(args[arg], "--tile") == 0)
+		{
+			int tile_size = atoi(args[arg + 1]);
+			
+			if(tile_size >= MIN_TILE_SIZE && tile_size <= MAX_TILE_SIZE)
+			{
+				display.tile_size = tile_size;
+			}
+			else
+			{
+				std::cerr << "Tile size " << args[arg + 1] << " isn't between "
+					<< MIN_TILE_SIZE << " and " << MAX_TILE_SIZE << ", using "
+					<< DEFAULT_TILE_SIZE << " instead" << std::endl;
+			}
+		}
+	}
+	
 	// Initialize SDL
 	if( SDL_Init(SDL_INIT_EVERYTHING) == -1)
 	{
 		return -1;
 	}
 	
+	// Map the packed graphics and font, if they've been packed (see
+	// tools/pack_assets.cpp). If not, each is loaded from its own file.
+	get_asset_archive()->open(ASSET_ARCHIVE_FILE);
+	
 	// Initialize the SDL_Objects object.
 	// This will also generate the program window via the class
 	// constructor.
-	SDL_Objects sdl;
+	SDL_Objects sdl(display);
 	
 	// Set the window's caption.
 	SDL_WM_SetCaption("Miner SDL", NULL);
 	
-	// Make the player's and mine's objects.
+	// Everything that listens to the game's events.
+	// The SDL layer shows them as status text and animations, and the
+	// statistics count them.
+	Game_Event_Dispatcher game_events;
+	game_events.subscribe(&sdl);
+	game_events.subscribe(get_game_statistics());
+	
+	// Records each new game so it can be played back (see tools/replay.cpp).
+	Game_Recorder recorder;
+	
+	// Make the player's and mine's objects. They're used for every game
+	// from here on; the mine is only made once it's known whether a new
+	// game is being started or a saved one loaded.
 	PlayerData *player = new PlayerData;
 	MineData *mine = new MineData;
+	player->set_event_sink(&game_events);
+	player->set_recorder(&recorder);
 	
 	// Load the welcoming screen.
 	// Take control from main();
@@ -62,16 +146,26 @@ int main(int argc, char* args[])
 	{
 		if(sdl.return_quit_to_menu())
 		{		
-			// Clear out the old player and mine instances.
-			delete player;
-			delete mine;
+			// Keep the recording of the game just finished.
+			if(recorder.is_recording())
+			{
+				recorder.save(RECORDING_FILE);
+			}
 			
 			// Clear out the status information log.
 			sdl.clear_status_text();
 			
-			// Start a new player and mine instance.
-			player = new PlayerData;
-			mine = new MineData;
+			// Start the player afresh and empty the mine. The startup
+			// screen fills the mine, from its seed or from a save.
+			unsigned int seed = time(NULL);
+			player->reset(seed);
+			mine->clear(seed);
+			
+			// The autosave's journal can't carry on into a new game.
+			get_autosave()->restart();
+			get_game_statistics()->start_game();
+			
+			recorder.start(player->get_seed(), mine->get_seed());
 			
 			startup_screen(player, mine, &sdl);
 		}
@@ -81,5 +175,18 @@ int main(int argc, char* args[])
 		}
 	}
 	
+	get_trace_recorder()->stop();
+	
+	// Don't leave the preloader loading images as the game closes.
+	get_asset_preloader()->stop();
+	
+	// Let the last save finish writing.
+	get_autosave()->stop();
+	
+	if(recorder.is_recording())
+	{
+		recorder.save(RECORDING_FILE);
+	}
+	
 	return 0;
 }
@@ -0,0 +1,148 @@
+/*
+ mapped_file.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Read-only access to a whole file, mapped into memory.
+*/
+
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mapped_file.h"
+
+Mapped_File::Mapped_File()
+{
+	data = NULL;
+	size = 0;
+	mapped = false;
+	writable = false;
+}
+
+Mapped_File::~Mapped_File()
+{
+	close();
+}
+
+bool Mapped_File::open(const char *path, bool copy_on_write)
+{
+	close();
+	
+	int fd = ::open(path, O_RDONLY);
+	
+	if(fd < 0)
+	{
+		return false;
+	}
+	
+	struct stat status;
+	
+	if(fstat(fd, &status) != 0)
+	{
+		::close(fd);
+		return false;
+	}
+	
+	size = status.st_size;
+	
+	// An empty file can't be mapped, but there's nothing to read either.
+	if(size == 0)
+	{
+		::close(fd);
+		data = (const unsigned char *)"";
+		return true;
+	}
+	
+	int protection = copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ;
+	void *mapping = mmap(NULL, size, protection, MAP_PRIVATE, fd, 0);
+	
+	if(mapping != MAP_FAILED)
+	{
+		data = (const unsigned char *)mapping;
+		mapped = true;
+		writable = copy_on_write;
+		::close(fd);
+		return true;
+	}
+	
+	// Read it in instead.
+	buffer.resize(size);
+	long long done = 0;
+	
+	while(done < size)
+	{
+		ssize_t count = read(fd, &buffer[done], size - done);
+		
+		if(count <= 0)
+		{
+			break;
+		}
+		
+		done += count;
+	}
+	
+	::close(fd);
+	
+	if(done < size)
+	{
+		buffer.clear();
+		size = 0;
+		return false;
+	}
+	
+	data = &buffer[0];
+	writable = copy_on_write;
+	return true;
+}
+
+void Mapped_File::close()
+{
+	if(mapped)
+	{
+		munmap((void *)data, size);
+	}
+	
+	data = NULL;
+	size = 0;
+	mapped = false;
+	writable = false;
+	buffer.clear();
+}
+
+bool Mapped_File::is_open()
+{
+	return data != NULL;
+}
+
+const unsigned char *Mapped_File::get_data()
+{
+	return data;
+}
+
+long long Mapped_File::get_size()
+{
+	return size;
+}
+
+unsigned char *Mapped_File::get_writable_data()
+{
+	return writable ? (unsigned char *)data : NULL;
+}
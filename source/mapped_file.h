@@ -0,0 +1,73 @@
+/*
+ mapped_file.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Read-only access to a whole file, mapped into memory.
+
+ The file is mapped rather than read, so nothing is copied until it's
+ used and the pages are shared with the operating system's cache. If a
+ file can't be mapped it's read into memory instead, so the caller
+ sees the same thing either way.
+
+ A file can also be mapped copy-on-write, for a caller that hands the
+ data to something that wants it writable. Anything written goes to a
+ private copy of the page, never to the file.
+*/
+
+#ifndef MAPPED_FILE
+#define MAPPED_FILE
+
+#include <vector>
+
+class Mapped_File
+{
+	private:
+		const unsigned char *data;
+		long long size;
+		
+		// True if data is mapped, rather than pointing into buffer.
+		bool mapped;
+		bool writable;
+		std::vector<unsigned char> buffer;
+		
+		// Can't be copied; the mapping would be released twice.
+		Mapped_File(const Mapped_File &);
+		Mapped_File &operator=(const Mapped_File &);
+		
+	public:
+		Mapped_File();
+		~Mapped_File();
+		
+		// Map a file, closing any file already mapped. Returns false
+		// if it can't be opened.
+		bool open(const char *path, bool copy_on_write = false);
+		
+		// Release the file.
+		void close();
+		
+		bool is_open();
+		
+		// The file's contents, or NULL if none is open.
+		const unsigned char *get_data();
+		long long get_size();
+		
+		// The contents, if the file was opened copy-on-write; else NULL.
+		unsigned char *get_writable_data();
+};
+
+#endif
@@ -0,0 +1,230 @@
+/*
+ market.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ The bank's prices for minerals.
+*/
+
+#include "market.h"
+
+// How each mineral's price behaves. The ranges are the ones the bank
+// has always used.
+struct Mineral_Terms
+{
+	int usual;			// The price it heads back towards.
+	int low;
+	int high;
+	int noise;			// Most it can move by chance in one change.
+	int glut;			// Units sold that halve the gap from usual to low.
+};
+
+static const Mineral_Terms terms[MARKET_MINERALS] =
+{
+	{ 15, 5, 24, 3, 40 },		// Coal
+	{ 50, 40, 59, 3, 20 },		// Silver
+	{ 100, 80, 124, 6, 10 },	// Gold
+	{ 250, 225, 274, 8, 4 }		// Platinum
+};
+
+// Each change closes this fraction of the gap to where the price is heading.
+const int REVERSION_DIVISOR = 3;
+
+Mineral_Market::Mineral_Market()
+{
+	reset();
+}
+
+void Mineral_Market::reset()
+{
+	for(int mineral = 0; mineral < MARKET_MINERALS; mineral++)
+	{
+		price[mineral] = terms[mineral].usual;
+		supply[mineral] = 0;
+	}
+
+	history_start = 0;
+	history_count = 0;
+	changes = 0;
+
+	record_prices();
+}
+
+void Mineral_Market::save_values(int values[MARKET_SAVE_VALUES])
+{
+	for(int mineral = 0; mineral < MARKET_MINERALS; mineral++)
+	{
+		values[mineral] = price[mineral];
+		values[MARKET_MINERALS + mineral] = supply[mineral];
+
+		// Past the history's end, there's nothing to save.
+		for(int age = 0; age < PRICE_HISTORY; age++)
+		{
+			int saved = 0;
+
+			if(age < history_count)
+			{
+				saved = get_history((market_mineral)mineral, age);
+			}
+
+			values[MARKET_MINERALS * 2 + 1 + mineral * PRICE_HISTORY + age] = saved;
+		}
+	}
+
+	values[MARKET_MINERALS * 2] = history_count;
+}
+
+// A price kept to a mineral's range.
+static int keep_in_range(const Mineral_Terms &mineral_terms, int value)
+{
+	if(value < mineral_terms.low)
+	{
+		return mineral_terms.low;
+	}
+	else if(value > mineral_terms.high)
+	{
+		return mineral_terms.high;
+	}
+
+	return value;
+}
+
+// Prices out of range, from a damaged save, are kept to the range.
+void Mineral_Market::load_values(const int values[MARKET_SAVE_VALUES])
+{
+	history_start = 0;
+	history_count = values[MARKET_MINERALS * 2];
+
+	if(history_count < 1 || history_count > PRICE_HISTORY)
+	{
+		history_count = 1;
+	}
+
+	for(int mineral = 0; mineral < MARKET_MINERALS; mineral++)
+	{
+		const Mineral_Terms &mineral_terms = terms[mineral];
+
+		price[mineral] = values[mineral];
+		supply[mineral] = values[MARKET_MINERALS + mineral];
+
+		if(supply[mineral] < 0)
+		{
+			supply[mineral] = 0;
+		}
+
+		for(int age = 0; age < PRICE_HISTORY; age++)
+		{
+			history[mineral][age] = keep_in_range(mineral_terms,
+				values[MARKET_MINERALS * 2 + 1 + mineral * PRICE_HISTORY + age]);
+		}
+
+		price[mineral] = keep_in_range(mineral_terms, price[mineral]);
+	}
+
+	// Drawings of the old history are out of date.
+	changes++;
+}
+
+// Add the current prices to the history, dropping the oldest if it's full.
+void Mineral_Market::record_prices()
+{
+	int slot = (history_start + history_count) % PRICE_HISTORY;
+
+	if(history_count < PRICE_HISTORY)
+	{
+		history_count++;
+	}
+	else
+	{
+		history_start = (history_start + 1) % PRICE_HISTORY;
+	}
+
+	for(int mineral = 0; mineral < MARKET_MINERALS; mineral++)
+	{
+		history[mineral][slot] = price[mineral];
+	}
+
+	changes++;
+}
+
+// Move every price one step.
+void Mineral_Market::change_prices(Game_Random &random)
+{
+	for(int mineral = 0; mineral < MARKET_MINERALS; mineral++)
+	{
+		const Mineral_Terms &mineral_terms = terms[mineral];
+
+		// Where the price is heading: the usual price, less however much
+		// the player has flooded the market with.
+		int target = mineral_terms.usual
+			- (mineral_terms.usual - mineral_terms.low) * supply[mineral] / (supply[mineral] + mineral_terms.glut);
+
+		int next = price[mineral] + (target - price[mineral]) / REVERSION_DIVISOR
+			+ random.next_int(2 * mineral_terms.noise + 1) - mineral_terms.noise;
+
+		if(next < mineral_terms.low)
+		{
+			next = mineral_terms.low;
+		}
+		else if(next > mineral_terms.high)
+		{
+			next = mineral_terms.high;
+		}
+
+		price[mineral] = next;
+		supply[mineral] /= 2;
+	}
+
+	record_prices();
+}
+
+// The player has sold some of a mineral.
+void Mineral_Market::record_sale(market_mineral mineral, int amount)
+{
+	supply[mineral] += amount;
+}
+
+int Mineral_Market::get_price(market_mineral mineral)
+{
+	return price[mineral];
+}
+
+int Mineral_Market::get_low_price(market_mineral mineral)
+{
+	return terms[mineral].low;
+}
+
+int Mineral_Market::get_high_price(market_mineral mineral)
+{
+	return terms[mineral].high;
+}
+
+int Mineral_Market::get_history_count()
+{
+	return history_count;
+}
+
+// A price in the history, from 0 (oldest) to get_history_count() - 1.
+int Mineral_Market::get_history(market_mineral mineral, int age)
+{
+	return history[mineral][(history_start + age) % PRICE_HISTORY];
+}
+
+unsigned int Mineral_Market::get_changes()
+{
+	return changes;
+}
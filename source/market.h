@@ -0,0 +1,105 @@
+/*
+ market.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ The bank's prices for minerals.
+
+ Each change in prices moves every mineral a step back towards its
+ usual price, plus a little noise, so prices wander but don't run
+ away. Selling a mineral floods the market: the more the player has
+ sold lately, the lower the price it heads back towards. What was
+ sold wears off by half each change.
+
+ The last PRICE_HISTORY prices of each mineral are kept in a ring
+ buffer for the bank's sparklines. All of it is saved with the game,
+ so what was sold still weighs on prices after a load. Nothing here
+ uses SDL.
+*/
+
+#ifndef MARKET
+#define MARKET
+
+#include "game_random.h"
+
+// Minerals the bank buys.
+enum market_mineral
+{
+	MARKET_COAL,
+	MARKET_SILVER,
+	MARKET_GOLD,
+	MARKET_PLATINUM,
+	MARKET_MINERALS
+};
+
+// Price changes kept for each mineral.
+const int PRICE_HISTORY = 32;
+
+// Ints the market is saved as: each mineral's price and supply, how
+// many prices are in the history, and each mineral's history, oldest
+// first.
+const int MARKET_SAVE_VALUES = MARKET_MINERALS * 2 + 1 + MARKET_MINERALS * PRICE_HISTORY;
+
+class Mineral_Market
+{
+	private:
+		int price[MARKET_MINERALS];
+		int supply[MARKET_MINERALS];	// Units sold, wearing off each change.
+
+		// history[mineral][(history_start + age) % PRICE_HISTORY],
+		// oldest first.
+		int history[MARKET_MINERALS][PRICE_HISTORY];
+		int history_start;
+		int history_count;
+
+		// Counts every change to the history, so drawings of it can
+		// tell when they are out of date.
+		unsigned int changes;
+
+		void record_prices();
+
+	public:
+		Mineral_Market();
+
+		// Back to the usual prices, with no history.
+		void reset();
+
+		// Copy the market out for a save, and back in from one.
+		void save_values(int values[MARKET_SAVE_VALUES]);
+		void load_values(const int values[MARKET_SAVE_VALUES]);
+
+		// Move every price one step.
+		void change_prices(Game_Random &random);
+
+		// The player has sold some of a mineral.
+		void record_sale(market_mineral mineral, int amount);
+
+		int get_price(market_mineral mineral);
+
+		// The lowest and highest a mineral's price can be.
+		int get_low_price(market_mineral mineral);
+		int get_high_price(market_mineral mineral);
+
+		// Prices in the history, oldest first, from 0 to
+		// get_history_count() - 1.
+		int get_history_count();
+		int get_history(market_mineral mineral, int age);
+
+		unsigned int get_changes();
+};
+
+#endif
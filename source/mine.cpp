@@ -34,12 +34,19 @@
 #include "sdl_functions.h"
 #include "classes.h"
 #include "mine.h"
+#include "game_rules.h"
+#include "autopilot.h"
 #include "timer.h"
+#include "trace.h"
+#include "autosave.h"
+#include "game_statistics.h"
 #include "popup_menu.h"
 #include "high_scores.h"
 
 void mine_function(PlayerData *player, SDL_Objects *sdl, MineData *mine)
 {
+	Trace_Zone zone("mine_function", TRACE_SCREEN);
+
 	// To catch the user's input.
 	SDL_Event user_input;
 	
@@ -53,12 +60,23 @@ void mine_function(PlayerData *player, SDL_Objects *sdl, MineData *mine)
 	sdl->update_status_text("You descend into the mine...");
 	
 	// Restore the player to the origin of the mine
-	player->change_location(0, 0, mine, sdl);
+	player->change_location(0, 0, mine);
+	
+	// Walks the player to a target when asked.
+	Autopilot *autopilot = get_autopilot();
+	autopilot->stop();
+	
+	// Don't let anything drawn in town count towards the first frame.
+	sdl->return_profiler()->begin_frame();
 	
 	// Update the graphics for the first refresh.
 	sdl->update_mine_graphics(player, mine, player_direction);
 	sdl->display_hud(player);
-	SDL_Flip(sdl->return_screen());
+	sdl->flip_screen();
+	
+	// Time each pass of the loop, for the trace.
+	Timer loop_timer;
+	loop_timer.begin_timer();
 	
 	// Testing stuff...
 	bool exit = false;
@@ -83,13 +101,21 @@ void mine_function(PlayerData *player, SDL_Objects *sdl, MineData *mine)
 			}
 			else if(user_input.type == SDL_KEYUP)
 			{
-				// Check to see if dynamite is counting down.
-				if(player->dynamite_countdown(mine))
+				// Toggle the frame profiler's overlay.
+				if(user_input.key.keysym.sym == SDLK_F3)
+				{
+					sdl->return_profiler()->toggle_overlay();
+					update_screen = true;
+				}
+				// Dump the frame profiler's data.
+				else if(user_input.key.keysym.sym == SDLK_F4)
 				{
-					// Above returns true if player was too close to the blast.
-					sdl->update_status_text("You were too close to the blast!");
-					player->change_health(-50);
-				}					
+					if(sdl->return_profiler()->dump_csv("frame_profile.csv"))
+					{
+						sdl->update_status_text("Frame profile saved!");
+					}
+					update_screen = true;
+				}
 			}
         }	
         
@@ -99,44 +125,45 @@ void mine_function(PlayerData *player, SDL_Objects *sdl, MineData *mine)
 			exit = true;
 		}
 		
+		// Any of the player's own moves take over from the autopilot.
+		if(keystate[ SDLK_DOWN ] || keystate[ SDLK_UP ] || keystate[ SDLK_LEFT ] || keystate[ SDLK_RIGHT ]
+		   || keystate[ SDLK_d ] || keystate[ SDLK_b ] || keystate[ SDLK_t ]
+		   || keystate[ SDLK_ESCAPE ] || keystate[ SDLK_BACKSPACE ])
+		{
+			autopilot->stop();
+		}
+		
 		if(keystate[ SDLK_DOWN ])
 		{
-			player->change_location((player->get_location_x()), (player->get_location_y() + 1), mine, sdl);
+			player->change_location((player->get_location_x()), (player->get_location_y() + 1), mine);
 			update_screen = true;
             player_direction = DOWN;
 		}
 		else if(keystate[ SDLK_UP ])
 		{
-			player->change_location((player->get_location_x()), (player->get_location_y() - 1), mine, sdl);
+			player->change_location((player->get_location_x()), (player->get_location_y() - 1), mine);
 			update_screen = true;
             player_direction = UP;
 		}
 		else if(keystate[ SDLK_LEFT ])
 		{			
-			player->change_location((player->get_location_x() - 1), player->get_location_y(), mine, sdl);
+			player->change_location((player->get_location_x() - 1), player->get_location_y(), mine);
 			update_screen = true;
             player_direction = LEFT;
 		}
 		else if(keystate[ SDLK_RIGHT ])
 		{			
-			player->change_location((player->get_location_x() + 1), player->get_location_y(), mine, sdl);
+			player->change_location((player->get_location_x() + 1), player->get_location_y(), mine);
 			update_screen = true;
             player_direction = RIGHT;
 		}	
 		// Activate the dynamite, if the player has any.					
 		else if(keystate[ SDLK_d ])
 		{
-			if(player->get_has_dynamite()
-				&& mine->get_contents(player->get_location_x(), player->get_location_y()) != ELEVATOR)
+			if(light_dynamite(player, mine))
 			{
-				player->dynamite_prime(player->get_location_x(), player->get_location_y(), mine);
-				sdl->update_status_text("You light the dynamite. RUN!");
 				SDL_Delay(125);
 			}
-			else if(!player->get_has_dynamite())
-			{
-				sdl->update_status_text("You don't have any dynamite!");
-			}
 			
 			update_screen = true;
 		}
@@ -148,20 +175,21 @@ void mine_function(PlayerData *player, SDL_Objects *sdl, MineData *mine)
 			
 			update_screen = true;
 		}
+		// Let the player look back through the status log.
+		else if(keystate[ SDLK_l ])
+		{
+			SDL_Delay(sdl->KEYPRESS_WAIT);
+			mine_show_log(sdl, player);
+			
+			update_screen = true;
+		}
 		// Allow the player to instantly travel to the lowest level accessible
 		// to the elevator
 		else if(keystate[ SDLK_b ])
 		{
 			SDL_Delay(sdl->KEYPRESS_WAIT);
 						
-			if(move_elevator_to_bottom(sdl, mine, player))
-			{
-				sdl->update_status_text("To the depths!");
-			}
-			else
-			{
-				sdl->update_status_text("You can't do that now!");
-			}
+			move_elevator_to_bottom(mine, player);
 			
 			update_screen = true;
 		}
@@ -169,13 +197,51 @@ void mine_function(PlayerData *player, SDL_Objects *sdl, MineData *mine)
 		{
 			SDL_Delay(sdl->KEYPRESS_WAIT);
 			
-			if(move_elevator_to_top(sdl, mine, player))
+			move_elevator_to_top(mine, player);
+			
+			update_screen = true;
+		}
+		// Let the autopilot take the player to where the tavern's tip pointed.
+		else if(keystate[ SDLK_a ])
+		{
+			SDL_Delay(sdl->KEYPRESS_WAIT);
+			
+			autopilot->head_for_tip(player, mine);
+			
+			update_screen = true;
+		}
+		// Let the autopilot take the player back to the elevator.
+		else if(keystate[ SDLK_e ])
+		{
+			SDL_Delay(sdl->KEYPRESS_WAIT);
+			
+			autopilot->head_for_elevator(player, mine);
+			
+			update_screen = true;
+		}
+		// Take the next step along the autopilot's route.
+		else if(autopilot->is_active())
+		{
+			int old_x = player->get_location_x();
+			int old_y = player->get_location_y();
+			
+			autopilot->step(player, mine);
+			
+			if(player->get_location_y() > old_y)
 			{
-				sdl->update_status_text("Daylight!");
+				player_direction = DOWN;
 			}
-			else
+			else if(player->get_location_y() < old_y)
 			{
-				sdl->update_status_text("You can't do that now!");
+				player_direction = UP;
+			}
+			else if(player->get_location_x() < old_x)
+			{
+				player_direction = LEFT;
+			}
+			else if(player->get_location_x() > old_x)
+			{
+				player_direction = RIGHT;
 			}
 			
 			update_screen = true;
@@ -187,11 +253,11 @@ void mine_function(PlayerData *player, SDL_Objects *sdl, MineData *mine)
 			update_screen = true;
 		}
 		
-        // Countdown for the recently found minerals
-		if(mine->return_recently_found_countdown() >= 0)
+        // Keep found minerals, debris and splashes moving.
+		if(sdl->particles_active())
 		{
 			update_screen = true;
-			mine->count_recently_found();
+			sdl->step_particles();
 		}
 		
 		// Apply the graphics on screen and update them.
@@ -199,34 +265,37 @@ void mine_function(PlayerData *player, SDL_Objects *sdl, MineData *mine)
 		{
 			sdl->update_mine_graphics(player, mine, player_direction);
 			sdl->display_hud(player);
-			SDL_Flip(sdl->return_screen());
+			sdl->flip_screen();
             SDL_Delay(sdl->MINE_ANIMATION_WAIT);
             
             // Animate 'between' still frames.
             if(player_direction != NONE)
             {
-                if(mine->return_recently_found_countdown() >= 0)
+                if(sdl->particles_active())
                 {
                     update_screen = true;
-                    mine->count_recently_found();
+                    sdl->step_particles();
                 }                
                 
                 sdl->update_mine_graphics(player, mine, NONE);
                 player_direction = NONE;
                 
                 sdl->display_hud(player);
-                SDL_Flip(sdl->return_screen());
+                sdl->flip_screen();
                 SDL_Delay(sdl->MINE_ANIMATION_WAIT);
             }
 		}
 		
 		// Check to see if the player's health has fallen below 0.
-		if(!player->check_health(sdl))
+		if(!player->check_health())
 		{
 			// Show the death screen, then go to the main menu.
+			get_game_statistics()->finish_game(player, GAME_DIED);
+			get_autosave()->end_game();
 			display_dead_message(sdl);
 			display_high_scores(sdl, player, true);			
 			sdl->set_quit_to_menu(true);
+			get_trace_recorder()->add_histogram("mine_loop", TRACE_SCREEN, loop_timer.return_histogram());
 			return;
 		}	
 		
@@ -234,25 +303,40 @@ void mine_function(PlayerData *player, SDL_Objects *sdl, MineData *mine)
 		if(player->get_money() < 0)
 		{
 			// Show the broke screen, then go to the main menu.
+			get_game_statistics()->finish_game(player, GAME_WENT_BROKE);
+			get_autosave()->end_game();
 			display_broke_message(sdl);
 			sdl->set_quit_to_menu(true);
+			get_trace_recorder()->add_histogram("mine_loop", TRACE_SCREEN, loop_timer.return_histogram());
 			return;
 		}	        
+		
+		// Every so often, hand a copy of the game to the autosave's thread.
+		get_autosave()->update(mine, player);
         	
+		loop_timer.record_lap();
+		
 		SDL_Delay(sdl->SDL_WAIT);	// Delay the loop so the CPU isn't maxed out.
+		
+		// Leave the delay out of the next lap.
+		loop_timer.begin_lap();
 	}
+	
+	get_trace_recorder()->add_histogram("mine_loop", TRACE_SCREEN, loop_timer.return_histogram());
 }
 
 // Show the player the map of where the diamond is.
 void mine_show_map(MineData *mine, SDL_Objects *sdl, PlayerData *player)
 {
+	Trace_Zone zone("mine_show_map", TRACE_SCREEN);
+
 	SDL_Surface *minimap;
 	SDL_Surface *minimap_explored_area;
 	SDL_Surface *player_location;
 	
-	minimap = IMG_Load("./Graphics/mine/map/cheat_map.png");
-	minimap_explored_area = IMG_Load("./Graphics/mine/map/explored_pixel.png");
-	player_location = IMG_Load("./Graphics/mine/map/player_indicator.png");
+	minimap = load_image("graphics/mine/map/cheat_map.png");
+	minimap_explored_area = load_image("graphics/mine/map/explored_pixel.png");
+	player_location = load_image("graphics/mine/map/player_indicator.png");
 	
 	// Display the map on screen.
 	sdl->apply_surface(0, 0, minimap, sdl->return_screen());
@@ -291,6 +375,82 @@ void mine_show_map(MineData *mine, SDL_Objects *sdl, PlayerData *player)
 
 
 
+// Page through everything the player has been told this session.
+// Up and down move a line, page up and page down a page; any other
+// key goes back to the mine.
+void mine_show_log(SDL_Objects *sdl, PlayerData *player)
+{
+	Trace_Zone zone("mine_show_log", TRACE_SCREEN);
+	
+	SDL_Event user_input;
+	
+	int lines_back = 0;
+	int furthest_back = sdl->display_status_log(lines_back);
+	bool exit = false;
+	
+	sdl->display_hud(player);
+	SDL_Flip(sdl->return_screen());
+	
+	while(!exit)
+	{
+		int next_lines_back = lines_back;
+		
+		while(SDL_PollEvent(&user_input))
+		{
+			// Quit if the user chooses to close the window.
+			if(user_input.type == SDL_QUIT)
+			{
+				sdl->set_quitSDL();
+				exit = true;
+			}
+			else if(user_input.type == SDL_KEYDOWN)
+			{
+				if(user_input.key.keysym.sym == SDLK_UP)
+				{
+					next_lines_back++;
+				}
+				else if(user_input.key.keysym.sym == SDLK_DOWN)
+				{
+					next_lines_back--;
+				}
+				else if(user_input.key.keysym.sym == SDLK_PAGEUP)
+				{
+					next_lines_back += STATUS_PAGE_LINES;
+				}
+				else if(user_input.key.keysym.sym == SDLK_PAGEDOWN)
+				{
+					next_lines_back -= STATUS_PAGE_LINES;
+				}
+				else
+				{
+					exit = true;
+				}
+			}
+		}
+		
+		if(next_lines_back > furthest_back)
+		{
+			next_lines_back = furthest_back;
+		}
+		else if(next_lines_back < 0)
+		{
+			next_lines_back = 0;
+		}
+		
+		// Only draw the page again if it has moved.
+		if(!exit && next_lines_back != lines_back)
+		{
+			lines_back = next_lines_back;
+			sdl->display_status_log(lines_back);
+			SDL_UpdateRect(sdl->return_screen(), 0, 0, sdl->return_screen()->w, sdl->get_view_height());
+		}
+		
+		SDL_Delay(sdl->SDL_WAIT);
+	}
+	
+	SDL_Delay(sdl->ENTER_WAIT);
+}
+
 // Wait for a user keypress to exit the map screen.
 void wait_for_keypress(SDL_Objects *sdl)
 {
@@ -328,64 +488,3 @@ void wait_for_keypress(SDL_Objects *sdl)
 	
 	SDL_Delay(sdl->ENTER_WAIT);
 }
-
-// Move the elevator to the lowest level explored if the player is within
-// the elevator.
-bool move_elevator_to_bottom(SDL_Objects *sdl, MineData *mine, PlayerData *player)
-{
-	// Check to see if the player is in the elevator.
-	if(player->get_location_x() == 0)
-	{
-		// Variable to keep track of the lowest area the player has explored
-		// adjacent to the elevator.
-		int lowest_explored = 0;
-		
-		for(int y = 0; y <= mine->get_map_y(); y++)
-		{
-			if(mine->get_explored(1, y))
-			{
-				lowest_explored = y;
-			}
-		}
-		
-		if(lowest_explored <= player->get_money()
-			&& player->get_location_y() < lowest_explored)
-		{
-			if(player->get_location_y() < lowest_explored)
-			{
-				// Charge the player for the elevator usage.
-				player->change_money(-1 * (lowest_explored - player->get_location_y()));
-			}
-			
-			player->change_location(0, lowest_explored, mine, sdl);
-			
-			// Say that the player can indeed move down.
-			return true;
-		}
-		else
-		{
-			return false;
-		}
-	}
-	else
-	{
-		return false;
-	}
-}
-
-// Move the elevator to the very top level provided the player is within
-// the elevator.
-bool move_elevator_to_top(SDL_Objects *sdl, MineData *mine, PlayerData *player)
-{
-	// Check to see if the player is in the elevator
-	if(player->get_location_x() == 0 && player->get_location_y() != 0)
-	{
-		player->change_location(0, 0, mine, sdl);
-		
-		return true;
-	}
-	else
-	{
-		return false;
-	}
-}
@@ -38,15 +38,12 @@ void mine_function(PlayerData *player, SDL_Objects *sdl, MineData *mine);
 // Display the map and where the player has explored.
 void mine_show_map(MineData *mine, SDL_Objects *sdl, PlayerData *player);
 
+// Page through everything the player has been told this session.
+void mine_show_log(SDL_Objects *sdl, PlayerData *player);
+
 // Function that waits for user keypress
 void wait_for_keypress(SDL_Objects *sdl);
 
-// Move the elevator to the lowest level explored if the player is within
-// the elevator.
-bool move_elevator_to_bottom(SDL_Objects *sdl, MineData *mine, PlayerData *player);
-
-// Move the elevator to the very top level provided the player is within
-// the elevator.
-bool move_elevator_to_top(SDL_Objects *sdl, MineData *mine, PlayerData *player);
+// The elevator shortcuts and the dynamite are in "game_rules".
 
 #endif
@@ -0,0 +1,163 @@
+/*
+ particles.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Short animations in the mine, kept in a fixed pool.
+*/
+
+#include "particles.h"
+
+Particle_Pool::Particle_Pool()
+{
+	// Only the look of the debris depends on this.
+	random.seed(1);
+
+	clear();
+}
+
+void Particle_Pool::clear()
+{
+	count = 0;
+
+	for(int kind = 0; kind < PARTICLE_KINDS; kind++)
+	{
+		kind_count[kind] = 0;
+	}
+}
+
+// Add a particle. Returns false if the pool is full.
+bool Particle_Pool::spawn(particle_kind kind, materials material, int x, int y, int velocity_x, int velocity_y,
+						  int gravity, int size, int life)
+{
+	if(count >= PARTICLE_CAPACITY
+	   || (kind != PARTICLE_PICKUP && count >= PARTICLE_CAPACITY - PICKUP_RESERVE))
+	{
+		return false;
+	}
+
+	Particle &particle = particles[count];
+
+	particle.kind = kind;
+	particle.material = material;
+	particle.x = x;
+	particle.y = y;
+	particle.velocity_x = velocity_x;
+	particle.velocity_y = velocity_y;
+	particle.gravity = gravity;
+	particle.size = size;
+	particle.life = life;
+
+	count++;
+	kind_count[kind]++;
+
+	return true;
+}
+
+// Start a mineral rising out of the tile it was found in.
+bool Particle_Pool::spawn_pickup(int tile_x, int tile_y, materials material)
+{
+	// Rises two tiles over its life, as the old single animation did.
+	return spawn(PARTICLE_PICKUP, material, tile_x * PARTICLE_TILE_SIZE, tile_y * PARTICLE_TILE_SIZE,
+				 0, -(2 * PARTICLE_TILE_SIZE) / PICKUP_FRAMES, 0, PARTICLE_TILE_SIZE, PICKUP_FRAMES);
+}
+
+// Throw rock out from the middle of a tile.
+int Particle_Pool::spawn_debris(int tile_x, int tile_y, int pieces)
+{
+	int centre_x = tile_x * PARTICLE_TILE_SIZE + PARTICLE_TILE_SIZE / 2;
+	int centre_y = tile_y * PARTICLE_TILE_SIZE + PARTICLE_TILE_SIZE / 2;
+	int spawned = 0;
+
+	for(int piece = 0; piece < pieces; piece++)
+	{
+		if(!spawn(PARTICLE_DEBRIS, NOTHING, centre_x, centre_y,
+				  random.next_int(13) - 6, -2 - random.next_int(11), 1, 4 + random.next_int(5), 16 + random.next_int(8)))
+		{
+			break;
+		}
+
+		spawned++;
+	}
+
+	return spawned;
+}
+
+// Splash water up from the middle of a tile.
+int Particle_Pool::spawn_splash(int tile_x, int tile_y, int drops)
+{
+	int centre_x = tile_x * PARTICLE_TILE_SIZE + PARTICLE_TILE_SIZE / 2;
+	int centre_y = tile_y * PARTICLE_TILE_SIZE + PARTICLE_TILE_SIZE / 2;
+	int spawned = 0;
+
+	for(int drop = 0; drop < drops; drop++)
+	{
+		if(!spawn(PARTICLE_SPLASH, WATER, centre_x, centre_y,
+				  random.next_int(7) - 3, -2 - random.next_int(7), 1, 4, 10 + random.next_int(6)))
+		{
+			break;
+		}
+
+		spawned++;
+	}
+
+	return spawned;
+}
+
+// Move every particle on a frame, removing the ones that are done.
+void Particle_Pool::step()
+{
+	int index = 0;
+
+	while(index < count)
+	{
+		Particle &particle = particles[index];
+
+		if(particle.life <= 0)
+		{
+			// Fill the gap with the last live particle, which hasn't been
+			// moved yet.
+			kind_count[particle.kind]--;
+			count--;
+			particles[index] = particles[count];
+			continue;
+		}
+
+		particle.x += particle.velocity_x;
+		particle.y += particle.velocity_y;
+		particle.velocity_y += particle.gravity;
+		particle.life--;
+
+		index++;
+	}
+}
+
+int Particle_Pool::get_count()
+{
+	return count;
+}
+
+int Particle_Pool::get_count(particle_kind kind)
+{
+	return kind_count[kind];
+}
+
+// A live particle, from 0 to get_count() - 1.
+const Particle &Particle_Pool::get_particle(int index)
+{
+	return particles[index];
+}
@@ -0,0 +1,115 @@
+/*
+ particles.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Short animations in the mine: minerals rising out of the tile they
+ were found in, debris thrown by blasts and cave-ins, and splashes
+ of water.
+
+ Particles are kept in a fixed pool, with the live ones packed at
+ the front, so spawning and moving them never allocates and drawing
+ only visits the ones that are alive. Positions are in pixels from
+ the top left of the mine, so they can be drawn wherever the view
+ happens to be. Nothing here uses SDL; see SDL_Objects::display_particles.
+*/
+
+#ifndef PARTICLES
+#define PARTICLES
+
+#include "classes.h"
+#include "game_random.h"
+
+// Most particles alive at once. Any more are dropped.
+const int PARTICLE_CAPACITY = 512;
+
+// Room kept for found minerals, so a big blast can't hide them.
+const int PICKUP_RESERVE = 32;
+
+// Size of a mine tile in the pixels particles move in. They are scaled
+// to the tile size they are drawn at.
+const int PARTICLE_TILE_SIZE = 48;
+
+// Frames a found mineral takes to rise out of its tile.
+const int PICKUP_FRAMES = 24;
+
+enum particle_kind
+{
+	PARTICLE_PICKUP,	// A found mineral's graphic floating up.
+	PARTICLE_DEBRIS,	// Rock thrown out by a blast or cave-in.
+	PARTICLE_SPLASH,	// A drop of water.
+	PARTICLE_KINDS
+};
+
+struct Particle
+{
+	particle_kind kind;
+	materials material;		// For pickups, which graphic to draw.
+
+	// Pixels from the top left of the mine, and pixels per frame.
+	int x;
+	int y;
+	int velocity_x;
+	int velocity_y;
+	int gravity;
+
+	int size;				// Width and height of debris and drops.
+	int life;				// Frames left after this one.
+};
+
+class Particle_Pool
+{
+	private:
+		// Live particles are particles[0] to particles[count - 1].
+		Particle particles[PARTICLE_CAPACITY];
+		int count;
+		int kind_count[PARTICLE_KINDS];
+
+		Game_Random random;
+
+		// Add a particle. Returns false if the pool is full.
+		bool spawn(particle_kind kind, materials material, int x, int y, int velocity_x, int velocity_y,
+				   int gravity, int size, int life);
+
+	public:
+		Particle_Pool();
+
+		// Start a mineral rising out of the tile it was found in.
+		bool spawn_pickup(int tile_x, int tile_y, materials material);
+
+		// Throw rock out from the middle of a tile.
+		// Returns how many pieces there was room for.
+		int spawn_debris(int tile_x, int tile_y, int pieces);
+
+		// Splash water up from the middle of a tile.
+		// Returns how many drops there was room for.
+		int spawn_splash(int tile_x, int tile_y, int drops);
+
+		// Move every particle on a frame, removing the ones that are done.
+		void step();
+
+		void clear();
+
+		// Particles alive, in all or of one kind.
+		int get_count();
+		int get_count(particle_kind kind);
+
+		// A live particle, from 0 to get_count() - 1.
+		const Particle &get_particle(int index);
+};
+
+#endif
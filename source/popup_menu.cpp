@@ -32,11 +32,15 @@
 #include "classes.h"
 #include "popup_menu.h"
 #include "save_load.h"
+#include "save_slot_menu.h"
 #include "instructions.h"
+#include "trace.h"
 
 // Display the general options menu for the town screen.
 void display_popup_menu(SDL_Objects *sdl, MineData *mine, PlayerData *player)
 {
+	Trace_Zone zone("display_popup_menu", TRACE_SCREEN);
+
 	// Initialize the objects for the popup menu.
 	Popup_Menu menu;
 	
@@ -104,19 +108,42 @@ void display_popup_menu(SDL_Objects *sdl, MineData *mine, PlayerData *player)
 			}
 			else if(selection.return_vert() == 1)
 			{
-				// Save game.
+				// Save game, to the slot the player picks.
 				SDL_Delay(sdl->KEYPRESS_WAIT);
-				save_game(mine, player);
-				sdl->update_status_text("Game saved!");
+				int slot = choose_save_slot(sdl, true);
+				
+				if(slot != SLOT_CHOICE_NONE)
+				{
+					save_game(mine, player, slot);
+					sdl->update_status_text("Game saved!");
+				}
 				update_screen = true;
 			}
 			else if(selection.return_vert() == 2)
 			{
-				// Load game.
+				// Load game, from the slot the player picks.
 				SDL_Delay(sdl->KEYPRESS_WAIT);
-				load_game(mine, player);
-				sdl->clear_status_text();
-				sdl->update_status_text("Game loaded!");
+				int slot = choose_save_slot(sdl, false);
+				bool loaded = false;
+				
+				if(slot == SLOT_CHOICE_AUTOSAVE)
+				{
+					loaded = load_game(mine, player);
+				}
+				else if(slot != SLOT_CHOICE_NONE)
+				{
+					loaded = load_game(mine, player, slot);
+				}
+				
+				if(loaded)
+				{
+					sdl->clear_status_text();
+					sdl->update_status_text("Game loaded!");
+				}
+				else if(slot != SLOT_CHOICE_NONE)
+				{
+					sdl->update_status_text("There's no saved game to load.");
+				}
 				update_screen = true;
 			}
             else if(selection.return_vert() == 3)
@@ -365,18 +392,18 @@ bool display_confirm_spend(SDL_Objects *sdl)
 
 Popup_Menu::Popup_Menu()
 {
-	menu_backdrop = IMG_Load("./Graphics/popup_menu/popup_menu.png");
-    background = IMG_Load("./Graphics/start_screen/background.png");
+	menu_backdrop = load_image("graphics/popup_menu/popup_menu.png");
+    background = load_image("graphics/start_screen/background.png");
 
-	confirmation_menu = IMG_Load("./Graphics/popup_menu/confirmation_menu.png");
+	confirmation_menu = load_image("graphics/popup_menu/confirmation_menu.png");
 	
-	menu_arrow = IMG_Load("./Graphics/popup_menu/arrow.png");
+	menu_arrow = load_image("graphics/popup_menu/arrow.png");
 	
-	headstone_graphic = IMG_Load("./Graphics/popup_menu/headstone.png");
-	broke_graphic = IMG_Load("./Graphics/popup_menu/broke.png");
+	headstone_graphic = load_image("graphics/popup_menu/headstone.png");
+	broke_graphic = load_image("graphics/popup_menu/broke.png");
 	
-	font = TTF_OpenFont("./Fonts/DejaVuSans-Bold.ttf", 28);
-	small_font = TTF_OpenFont("./Fonts/DejaVuSans-Bold.ttf", 20);
+	font = open_font("Fonts/DejaVuSans-Bold.ttf", 28);
+	small_font = open_font("Fonts/DejaVuSans-Bold.ttf", 20);
 }
 
 Popup_Menu::~Popup_Menu()
@@ -491,7 +518,7 @@ void Popup_Menu::animate_arrow_up(SDL_Objects *sdl, Selection_Arrow *selection)
         sdl->apply_text(300, 256, "QUIT TO OS", font, sdl->return_screen());   
         
 		sdl->apply_surface(selection->return_arrow_x(), temp, menu_arrow, sdl->return_screen());
-		SDL_UpdateRect(sdl->return_screen(), 234, 40, 60, 270);
+		sdl->update_rect(234, 40, 60, 270);
 		SDL_Delay(sdl->MENU_ANIMATION_WAIT * 2);
 	}		
 }
@@ -513,7 +540,7 @@ void Popup_Menu::animate_arrow_down(SDL_Objects *sdl, Selection_Arrow *selection
         sdl->apply_text(300, 256, "QUIT TO OS", font, sdl->return_screen());
         
 		sdl->apply_surface(selection->return_arrow_x(), temp, menu_arrow, sdl->return_screen());
-		SDL_UpdateRect(sdl->return_screen(), 234, 40, 60, 270);
+		sdl->update_rect(234, 40, 60, 270);
 		SDL_Delay(sdl->MENU_ANIMATION_WAIT * 2);
 	}
 }
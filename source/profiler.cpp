@@ -0,0 +1,268 @@
+/*
+ profiler.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Frame profiler for the mine screen.
+
+ Keeps a rolling window of how long each drawing phase took per frame,
+ along with the number of blits and text renders per frame. The data
+ can be shown as an on-screen overlay or dumped to a CSV file.
+*/
+
+#include <algorithm>	// For std::nth_element
+#include <fstream>
+
+#include "profiler.h"
+#include "timer.h"
+#include "trace.h"
+
+Frame_Profiler::Frame_Profiler()
+{
+	for(int phase = 0; phase < PHASE_COUNT; phase++)
+	{
+		phase_time[phase] = 0;
+
+		for(int frame = 0; frame < PROFILE_HISTORY; frame++)
+		{
+			phase_history[phase][frame] = 0;
+		}
+	}
+
+	for(int frame = 0; frame < PROFILE_HISTORY; frame++)
+	{
+		blit_history[frame] = 0;
+		text_history[frame] = 0;
+	}
+
+	history_position = 0;
+	history_count = 0;
+
+	blit_count = 0;
+	text_count = 0;
+
+	frame_start = Timer::get_ticks_ns();
+
+	counting = true;
+	overlay_visible = false;
+}
+
+// Start a new frame, discarding anything counted so far.
+void Frame_Profiler::begin_frame()
+{
+	for(int phase = 0; phase < PHASE_COUNT; phase++)
+	{
+		phase_time[phase] = 0;
+	}
+
+	blit_count = 0;
+	text_count = 0;
+
+	frame_start = Timer::get_ticks_ns();
+}
+
+// Store the current frame in the rolling window and start the next.
+void Frame_Profiler::end_frame()
+{
+	phase_time[PHASE_FRAME] = Timer::get_ticks_ns() - frame_start;
+
+	for(int phase = 0; phase < PHASE_COUNT; phase++)
+	{
+		phase_history[phase][history_position] = phase_time[phase];
+	}
+
+	blit_history[history_position] = blit_count;
+	text_history[history_position] = text_count;
+
+	history_position = (history_position + 1) % PROFILE_HISTORY;
+
+	if(history_count < PROFILE_HISTORY)
+	{
+		history_count++;
+	}
+
+	begin_frame();
+}
+
+// Add time to a phase of the current frame.
+void Frame_Profiler::add_phase_time(profile_phase phase, long long nanoseconds)
+{
+	if(counting)
+	{
+		phase_time[phase] += nanoseconds;
+	}
+}
+
+void Frame_Profiler::count_blit()
+{
+	if(counting)
+	{
+		blit_count++;
+	}
+}
+
+void Frame_Profiler::count_text()
+{
+	if(counting)
+	{
+		text_count++;
+	}
+}
+
+void Frame_Profiler::set_counting(bool value)
+{
+	counting = value;
+}
+
+// Returns the given percentile (0-100) of a phase over the window, in nanoseconds.
+long long Frame_Profiler::get_percentile(profile_phase phase, int percentile)
+{
+	if(history_count == 0)
+	{
+		return 0;
+	}
+
+	// Work on a copy so the window itself stays in frame order.
+	long long sorted[PROFILE_HISTORY];
+
+	for(int frame = 0; frame < history_count; frame++)
+	{
+		sorted[frame] = phase_history[phase][frame];
+	}
+
+	int rank = (percentile * (history_count - 1)) / 100;
+	std::nth_element(sorted, sorted + rank, sorted + history_count);
+
+	return sorted[rank];
+}
+
+// Returns the average blits per frame over the window.
+int Frame_Profiler::get_average_blits()
+{
+	if(history_count == 0)
+	{
+		return 0;
+	}
+
+	int total = 0;
+
+	for(int frame = 0; frame < history_count; frame++)
+	{
+		total += blit_history[frame];
+	}
+
+	return total / history_count;
+}
+
+// Returns the average text renders per frame over the window.
+int Frame_Profiler::get_average_text()
+{
+	if(history_count == 0)
+	{
+		return 0;
+	}
+
+	int total = 0;
+
+	for(int frame = 0; frame < history_count; frame++)
+	{
+		total += text_history[frame];
+	}
+
+	return total / history_count;
+}
+
+int Frame_Profiler::get_frame_count()
+{
+	return history_count;
+}
+
+void Frame_Profiler::toggle_overlay()
+{
+	overlay_visible = !overlay_visible;
+}
+
+bool Frame_Profiler::is_overlay_visible()
+{
+	return overlay_visible;
+}
+
+// Write every frame in the window to a CSV file, oldest first.
+bool Frame_Profiler::dump_csv(const char *filename)
+{
+	Trace_Zone zone("dump_csv", TRACE_IO);
+
+	std::ofstream csv_out(filename);
+
+	if(!csv_out)
+	{
+		return false;
+	}
+
+	csv_out << "frame";
+	for(int phase = 0; phase < PHASE_COUNT; phase++)
+	{
+		csv_out << "," << get_phase_name((profile_phase)phase) << "_us";
+	}
+	csv_out << ",blits,text_renders\n";
+
+	// The oldest frame sits at history_position once the window is full.
+	int start = (history_count < PROFILE_HISTORY) ? 0 : history_position;
+
+	for(int frame = 0; frame < history_count; frame++)
+	{
+		int index = (start + frame) % PROFILE_HISTORY;
+
+		csv_out << frame;
+		for(int phase = 0; phase < PHASE_COUNT; phase++)
+		{
+			csv_out << "," << (phase_history[phase][index] / 1000);
+		}
+		csv_out << "," << blit_history[index] << "," << text_history[index] << "\n";
+	}
+
+	csv_out.close();
+
+	return true;
+}
+
+const char *Frame_Profiler::get_phase_name(profile_phase phase)
+{
+	switch(phase)
+	{
+		case PHASE_BACKGROUND:		return "background";
+		case PHASE_SPRITES:			return "sprites";
+		case PHASE_PARTICLES:		return "particles";
+		case PHASE_HUD:				return "hud";
+		case PHASE_TEXT:			return "text";
+		case PHASE_FLIP:			return "flip";
+		case PHASE_FRAME:			return "frame";
+		default:					return "unknown";
+	}
+}
+
+Profile_Scope::Profile_Scope(Frame_Profiler *profiler, profile_phase phase)
+{
+	this->profiler = profiler;
+	this->phase = phase;
+	start_time = Timer::get_ticks_ns();
+}
+
+Profile_Scope::~Profile_Scope()
+{
+	profiler->add_phase_time(phase, Timer::get_ticks_ns() - start_time);
+}
@@ -0,0 +1,124 @@
+/*
+ profiler.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Frame profiler for the mine screen.
+
+ Keeps a rolling window of how long each drawing phase took per frame,
+ along with the number of blits and text renders per frame. The data
+ can be shown as an on-screen overlay or dumped to a CSV file.
+*/
+
+#ifndef FRAME_PROFILER
+#define FRAME_PROFILER
+
+// The drawing phases that are timed within a frame.
+enum profile_phase
+{
+	PHASE_BACKGROUND,		// display_background_layer (or the static tile pass)
+	PHASE_SPRITES,			// display_sprite_layer
+	PHASE_PARTICLES,		// display_particles
+	PHASE_HUD,				// display_hud
+	PHASE_TEXT,				// apply_text / apply_colored_text
+	PHASE_FLIP,				// SDL_Flip
+	PHASE_FRAME,			// Whole frame, flip to flip
+	PHASE_COUNT
+};
+
+// Number of frames kept in the rolling window.
+const int PROFILE_HISTORY = 120;
+
+class Frame_Profiler
+{
+	private:
+		// Time spent in each phase during the current frame.
+		long long phase_time[PHASE_COUNT];
+
+		// Rolling window of previous frames.
+		long long phase_history[PHASE_COUNT][PROFILE_HISTORY];
+		int blit_history[PROFILE_HISTORY];
+		int text_history[PROFILE_HISTORY];
+		int history_position;
+		int history_count;
+
+		// Counters for the current frame.
+		int blit_count;
+		int text_count;
+
+		// When the current frame was started.
+		long long frame_start;
+
+		// Whether phase times, blits and text renders are being counted.
+		// Switched off while the overlay itself is being drawn.
+		bool counting;
+
+		bool overlay_visible;
+
+	public:
+		Frame_Profiler();
+
+		// Start a new frame, discarding anything counted so far.
+		void begin_frame();
+
+		// Store the current frame in the rolling window and start the next.
+		void end_frame();
+
+		// Add time to a phase of the current frame.
+		void add_phase_time(profile_phase phase, long long nanoseconds);
+
+		// Count a blit or a text render in the current frame.
+		void count_blit();
+		void count_text();
+		void set_counting(bool value);
+
+		// Returns the given percentile (0-100) of a phase over the window, in nanoseconds.
+		long long get_percentile(profile_phase phase, int percentile);
+
+		// Returns the average blits and text renders per frame over the window.
+		int get_average_blits();
+		int get_average_text();
+
+		// Returns the number of frames held in the window.
+		int get_frame_count();
+
+		// Show or hide the overlay.
+		void toggle_overlay();
+		bool is_overlay_visible();
+
+		// Write every frame in the window to a CSV file.
+		// Returns false if the file could not be opened.
+		bool dump_csv(const char *filename);
+
+		// Returns the printable name of a phase.
+		static const char *get_phase_name(profile_phase phase);
+};
+
+// Times the enclosing scope and adds it to a phase of the profiler.
+class Profile_Scope
+{
+	private:
+		Frame_Profiler *profiler;
+		profile_phase phase;
+		long long start_time;
+
+	public:
+		Profile_Scope(Frame_Profiler *profiler, profile_phase phase);
+		~Profile_Scope();
+};
+
+#endif
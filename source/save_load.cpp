@@ -27,141 +27,1041 @@
 
 #include <iostream>
 #include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "classes.h"
+#include "save_load.h"
+#include "autosave.h"
+#include "game_rules.h"
+#include "game_recorder.h"
+#include "mapped_file.h"
+#include "trace.h"
+
+// Bytes of a save's values and diamond.
+const int SAVE_VALUES_SIZE = SAVE_VALUES * 4 + 8;
+
+// The player's values, in the order they're saved.
+static void collect_player(PlayerData *player, int values[SAVE_PLAYER_VALUES])
+{
+	values[SAVE_HEALTH] = player->get_health();
+	values[SAVE_MONEY] = player->get_money();
+	values[SAVE_COAL] = player->get_coal();
+	values[SAVE_SILVER] = player->get_silver();
+	values[SAVE_GOLD] = player->get_gold();
+	values[SAVE_PLATINUM] = player->get_platinum();
+	values[SAVE_TURN] = player->get_turn_number();
+	values[SAVE_INSURANCE_TURN] = player->get_insurance_turn_number();
+	values[SAVE_PREVIOUS_TURN] = player->get_previous_turn_number();
+	values[SAVE_HAS_AXE] = player->get_has_axe();
+	values[SAVE_HAS_BUCKET] = player->get_has_bucket();
+	values[SAVE_HAS_DIAMOND] = player->get_has_diamond();
+	values[SAVE_DYNAMITE] = player->get_dynamite();
+	values[SAVE_HAS_FLASHLIGHT] = player->get_has_flashlight();
+	values[SAVE_HAS_HARDHAT] = player->get_has_hardhat();
+	values[SAVE_HAS_INSURANCE] = player->get_has_insurance();
+	values[SAVE_HAS_SHOVEL] = player->get_has_shovel();
+}
 
-void save_game(MineData *mine, PlayerData *player)
+// The game's statistics and the market, after the player's values.
+static void collect_game(PlayerData *player, int values[SAVE_VALUES])
 {
-	// Save the player's information to the player file.
-	std::ofstream player_out("player_save", std::ios::binary);
+	for(int statistic = 0; statistic < STATISTIC_COUNT; statistic++)
+	{
+		values[SAVE_STATISTICS_START + statistic] = get_game_statistics()->get_game((game_statistic)statistic);
+	}
 	
-		player_out << player->get_health() << std::endl;
-		player_out << player->get_money() << std::endl;
+	player->get_market()->save_values(values + SAVE_MARKET_START);
+}
+
+// Put back the player's values from a save, and the rest of the game
+// that goes with them, once the mine's tiles are back. Without the
+// market's values, the market starts afresh.
+static void restore_game(MineData *mine, PlayerData *player, const int values[SAVE_VALUES],
+						 bool has_market, int diamond_x, int diamond_y)
+{
+	player->change_health(values[SAVE_HEALTH] - player->get_health());
+	player->change_money(values[SAVE_MONEY] - player->get_money());
+	player->change_coal(values[SAVE_COAL] - player->get_coal());
+	player->change_silver(values[SAVE_SILVER] - player->get_silver());
+	player->change_gold(values[SAVE_GOLD] - player->get_gold());
+	player->change_platinum(values[SAVE_PLATINUM] - player->get_platinum());
 	
-		player_out << player->get_coal() << std::endl;
-		player_out << player->get_silver() << std::endl;
-		player_out << player->get_gold() << std::endl;
-		player_out << player->get_platinum() << std::endl;
+	player->set_turn_number(values[SAVE_TURN]);
+	player->set_insurance_turn_number(values[SAVE_INSURANCE_TURN]);
+	player->set_previous_turn_number(values[SAVE_PREVIOUS_TURN]);
 	
-		player_out << player->get_turn_number() << std::endl;
-		player_out << player->get_insurance_turn_number() << std::endl;
-		player_out << player->get_previous_turn_number() << std::endl;
+	player->change_has_axe(values[SAVE_HAS_AXE] != 0);
+	player->change_has_bucket(values[SAVE_HAS_BUCKET] != 0);
+	player->change_has_diamond(values[SAVE_HAS_DIAMOND] != 0);
 	
-		player_out << player->get_has_axe() << std::endl;
-		player_out << player->get_has_bucket() << std::endl;
-		player_out << player->get_has_diamond() << std::endl;
-		player_out << player->get_has_dynamite() << std::endl;
-		player_out << player->get_has_flashlight() << std::endl;
-		player_out << player->get_has_hardhat() << std::endl;
-		player_out << player->get_has_insurance() << std::endl;
-		player_out << player->get_has_shovel() << std::endl;
+	// Older saves only have whether there was any dynamite, which
+	// reads the same as a count.
+	player->change_dynamite(values[SAVE_DYNAMITE] - player->get_dynamite());
 	
-	player_out.close();
+	player->change_has_flashlight(values[SAVE_HAS_FLASHLIGHT] != 0);
+	player->change_has_hardhat(values[SAVE_HAS_HARDHAT] != 0);
+	player->change_has_insurance(values[SAVE_HAS_INSURANCE] != 0);
+	player->change_has_shovel(values[SAVE_HAS_SHOVEL] != 0);
 	
-	std::ofstream mine_out("mine_save", std::ios::binary);
+	if(has_market)
+	{
+		player->get_market()->load_values(values + SAVE_MARKET_START);
+	}
+	else
+	{
+		// Older saves have no market; start it afresh with one change.
+		player->get_market()->reset();
+		player->change_prices();
+	}
 	
-		// Dump the mine contents to the file.
-		for(int x = 0; x <= (mine->get_map_x() - 1); x++)
+	// Set the location of the diamond (for the hint screen)
+	mine->set_diamond_location(diamond_x, diamond_y);
+	
+	// Pick up the insurance expiry and any lit dynamite from the turn
+	// the game was saved on.
+	restart_scheduled_effects(player, mine);
+	
+	// Carry on counting from where the game was saved.
+	unsigned int statistics[STATISTIC_COUNT];
+	
+	for(int statistic = 0; statistic < STATISTIC_COUNT; statistic++)
+	{
+		statistics[statistic] = (unsigned int)values[SAVE_STATISTICS_START + statistic];
+	}
+	
+	get_game_statistics()->resume_game(statistics);
+}
+
+static void write_le(unsigned char *data, unsigned long long value, int bytes)
+{
+	for(int byte = 0; byte < bytes; byte++)
+	{
+		data[byte] = (unsigned char)(value >> (byte * 8));
+	}
+}
+
+static unsigned long long read_le(const unsigned char *data, int bytes)
+{
+	unsigned long long value = 0;
+	
+	for(int byte = 0; byte < bytes; byte++)
+	{
+		value |= (unsigned long long)data[byte] << (byte * 8);
+	}
+	
+	return value;
+}
+
+// 64-bit FNV-1a, to tell a damaged save from a good one.
+static unsigned long long save_checksum(const unsigned char *data, int size)
+{
+	unsigned long long hash = 0xCBF29CE484222325ULL;
+	
+	for(int index = 0; index < size; index++)
+	{
+		hash = (hash ^ data[index]) * 0x100000001B3ULL;
+	}
+	
+	return hash;
+}
+
+// When a file was last written, or -1 if it isn't there.
+static long long modified_time(const char *path)
+{
+	struct stat status;
+	
+	if(stat(path, &status) != 0)
+	{
+		return -1;
+	}
+	
+	return status.st_mtime;
+}
+
+// After a game has been loaded.
+static void finish_loading(PlayerData *player)
+{
+	// The journal only follows the autosave it started from.
+	get_autosave()->restart();
+	
+	// A recording has to start from a new game's seeds, so a
+	// loaded game isn't recorded.
+	if(player->get_recorder() != NULL)
+	{
+		player->get_recorder()->stop();
+	}
+}
+
+void save_game(MineData *mine, PlayerData *player, int slot)
+{
+	get_autosave()->save(mine, player, slot);
+}
+
+bool load_game(MineData *mine, PlayerData *player, int slot)
+{
+	Trace_Zone zone("load_game_slot", TRACE_IO);
+
+	// A save to the slot may still be on its way to the disk.
+	get_autosave()->finish();
+	
+	if(slot < 0 || slot >= SAVE_SLOTS || !read_save(SAVE_SLOT_FILES[slot], mine, player))
+	{
+		return false;
+	}
+	
+	finish_loading(player);
+	
+	return true;
+}
+
+bool load_game(MineData *mine, PlayerData *player)
+{
+	Trace_Zone zone("load_game", TRACE_IO);
+
+	// Anything still being saved has to be on the disk first.
+	get_autosave()->finish();
+	
+	// Try the last saved first. The player's own save wins a tie. The
+	// autosave was last saved when its journal was.
+	long long autosave_time = modified_time(AUTOSAVE_FILE);
+	
+	if(modified_time(JOURNAL_FILE) > autosave_time)
+	{
+		autosave_time = modified_time(JOURNAL_FILE);
+	}
+	
+	bool loaded = false;
+	
+	if(autosave_time > modified_time(SAVE_FILE))
+	{
+		loaded = read_save(AUTOSAVE_FILE, mine, player, JOURNAL_FILE) || read_save(SAVE_FILE, mine, player);
+	}
+	else
+	{
+		loaded = read_save(SAVE_FILE, mine, player) || read_save(AUTOSAVE_FILE, mine, player, JOURNAL_FILE);
+	}
+	
+	loaded = loaded || read_text_save(TEXT_PLAYER_FILE, TEXT_MINE_FILE, mine, player);
+	
+	if(loaded)
+	{
+		finish_loading(player);
+	}
+	
+	return loaded;
+}
+
+void pack_explored(const unsigned char *tiles, unsigned char *packed)
+{
+	memset(packed, 0, SAVE_EXPLORED_SIZE);
+	
+	for(int index = 0; index < MINE_TILES; index++)
+	{
+		if(tiles[index] & TILE_EXPLORED)
 		{
-			for(int y = 0; y <= (mine->get_map_y() - 1); y++)
+			packed[index >> 3] |= 1 << (index & 7);
+		}
+	}
+}
+
+void unpack_explored(const unsigned char *packed, unsigned char *tiles)
+{
+	for(int index = 0; index < MINE_TILES; index++)
+	{
+		if(packed[index >> 3] & (1 << (index & 7)))
+		{
+			tiles[index] |= TILE_EXPLORED;
+		}
+	}
+}
+
+void pack_materials(const unsigned char *tiles, std::vector<unsigned char> &packed)
+{
+	packed.clear();
+	
+	unsigned char run_material = DIRT;
+	int index = 0;
+	
+	while(index < MINE_TILES)
+	{
+		int run = 0;
+		
+		while(index + run < MINE_TILES && (tiles[index + run] & TILE_MATERIAL_MASK) == run_material)
+		{
+			run++;
+		}
+		
+		index += run;
+		
+		unsigned char after = 0;
+		
+		if(index < MINE_TILES)
+		{
+			after = tiles[index] & TILE_MATERIAL_MASK;
+		}
+		
+		packed.push_back((run < 15 ? run : 15) << 4 | after);
+		
+		if(run >= 15)
+		{
+			for(run -= 15; run >= 255; run -= 255)
 			{
-				mine_out << mine->get_contents(x, y) << std::endl;
+				packed.push_back(255);
 			}
+			
+			packed.push_back(run);
 		}
 		
-		for(int x = 0; x <= (mine->get_map_x() - 1); x++)
+		if(index < MINE_TILES)
 		{
-			for(int y = 0; y <= (mine->get_map_y() - 1); y++)
+			index++;
+			
+			if(after == DIRT || after == EXPLORED)
 			{
-				mine_out << mine->get_explored(x, y) << std::endl;
+				run_material = after;
 			}
 		}
+	}
+}
+
+bool unpack_materials(const unsigned char *packed, int size, unsigned char *tiles)
+{
+	unsigned char run_material = DIRT;
+	int position = 0;
+	int index = 0;
+	
+	while(index < MINE_TILES)
+	{
+		if(position >= size)
+		{
+			return false;
+		}
 		
-		// Get the location of the diamond (for the hint screen)
-		mine_out << mine->get_diamond_x() << std::endl;
-		mine_out << mine->get_diamond_y() << std::endl;
+		unsigned char token = packed[position++];
+		int run = token >> 4;
+		
+		if(run == 15)
+		{
+			unsigned char more = 255;
+			
+			while(more == 255)
+			{
+				if(position >= size)
+				{
+					return false;
+				}
+				
+				more = packed[position++];
+				run += more;
+			}
+		}
+		
+		if(run > MINE_TILES - index)
+		{
+			return false;
+		}
+		
+		memset(tiles + index, run_material, run);
+		index += run;
+		
+		if(index < MINE_TILES)
+		{
+			unsigned char after = token & TILE_MATERIAL_MASK;
+			
+			tiles[index++] = after;
+			
+			if(after == DIRT || after == EXPLORED)
+			{
+				run_material = after;
+			}
+		}
+	}
 	
-	mine_out.close();
+	return position == size;
 }
 
-void load_game(MineData *mine, PlayerData *player)
+// For a save from before the water's levels were kept: any spring that
+// has been hit flows again at full pressure.
+static void restart_springs(const unsigned char *tiles, unsigned char *levels)
 {
-	int temp_int = 0;
-	bool temp_bool = false;
-	int temp_x = 0;
-	int temp_y = 0;
+	for(int index = 0; index < MINE_TILES; index++)
+	{
+		if((tiles[index] & (TILE_MATERIAL_MASK | TILE_EXPLORED)) == (TILE_EXPLORED | SPRING) && levels[index] == 0)
+		{
+			levels[index] = WATER_PRESSURE;
+		}
+	}
+}
+
+// Whether a tile has water that can still spread.
+static bool has_water_level(const unsigned char *tiles, const unsigned char *levels, int index)
+{
+	unsigned char contents = tiles[index] & TILE_MATERIAL_MASK;
 	
-	// Load the player's information from the player file
-	std::ifstream player_in("player_save", std::ios::binary);
+	return levels[index] > 0 && (contents == WATER || contents == SPRING);
+}
+
+// Write a file to a temporary file, make sure it's on the disk, and
+// then put it in place of the file. A crash leaves either the old file
+// or the new one, never half of one.
+static bool replace_file(const char *path, const unsigned char *data, int size)
+{
+	std::string temporary_path = std::string(path) + ".tmp";
+	FILE *file = fopen(temporary_path.c_str(), "wb");
+	
+	if(file == NULL)
+	{
+		return false;
+	}
+	
+	bool written = (int)fwrite(data, 1, size, file) == size && fflush(file) == 0 && fsync(fileno(file)) == 0;
+	
+	if(fclose(file) != 0 || !written || rename(temporary_path.c_str(), path) != 0)
+	{
+		remove(temporary_path.c_str());
+		return false;
+	}
+	
+	return true;
+}
+
+void take_snapshot(MineData *mine, PlayerData *player, Save_Snapshot &snapshot)
+{
+	collect_player(player, snapshot.values);
+	collect_game(player, snapshot.values);
+	snapshot.diamond_x = mine->get_diamond_x();
+	snapshot.diamond_y = mine->get_diamond_y();
+	snapshot.mine_seed = mine->get_seed();
+	memcpy(snapshot.tiles, mine->get_tiles(), MINE_TILES);
+	memcpy(snapshot.water_levels, mine->get_water_levels(), MINE_TILES);
+}
+
+bool write_snapshot(const char *path, const Save_Snapshot &snapshot, unsigned long long *checksum)
+{
+	Trace_Zone zone("write_snapshot", TRACE_IO);
+
+	std::vector<unsigned char> materials;
+	pack_materials(snapshot.tiles, materials);
+	
+	int water_count = 0;
+	
+	for(int index = 0; index < MINE_TILES; index++)
+	{
+		if(has_water_level(snapshot.tiles, snapshot.water_levels, index))
+		{
+			water_count++;
+		}
+	}
+	
+	// The whole save is put together first, so it's written in one go.
+	int body_size = SAVE_VALUES_SIZE + SAVE_EXPLORED_SIZE + 4 + materials.size() + 4 + water_count * 3;
+	std::vector<unsigned char> save(SAVE_HEADER_SIZE + body_size);
+	unsigned char *body = &save[SAVE_HEADER_SIZE];
+	
+	for(int value = 0; value < SAVE_VALUES; value++)
+	{
+		write_le(body + value * 4, (unsigned int)snapshot.values[value], 4);
+	}
+	
+	write_le(body + SAVE_VALUES * 4, (unsigned int)snapshot.diamond_x, 4);
+	write_le(body + SAVE_VALUES * 4 + 4, (unsigned int)snapshot.diamond_y, 4);
+	
+	unsigned char *tiles = body + SAVE_VALUES_SIZE;
+	pack_explored(snapshot.tiles, tiles);
+	write_le(tiles + SAVE_EXPLORED_SIZE, materials.size(), 4);
+	memcpy(tiles + SAVE_EXPLORED_SIZE + 4, &materials[0], materials.size());
+	
+	unsigned char *water = tiles + SAVE_EXPLORED_SIZE + 4 + materials.size();
+	write_le(water, water_count, 4);
+	water += 4;
+	
+	for(int index = 0; index < MINE_TILES; index++)
+	{
+		if(has_water_level(snapshot.tiles, snapshot.water_levels, index))
+		{
+			write_le(water, index, 2);
+			water[2] = snapshot.water_levels[index];
+			water += 3;
+		}
+	}
+	
+	memcpy(&save[0], SAVE_MAGIC, 4);
+	write_le(&save[4], SAVE_VERSION, 2);
+	write_le(&save[6], SAVE_HEADER_SIZE, 2);
+	write_le(&save[8], MINE_WIDTH, 2);
+	write_le(&save[10], MINE_HEIGHT, 2);
+	write_le(&save[12], snapshot.mine_seed, 4);
+	write_le(&save[16], SAVE_VALUES, 4);
+	write_le(&save[20], SAVE_PACKED_TILES | SAVE_WATER_LEVELS | SAVE_MARKET, 4);
+	write_le(&save[24], save_checksum(body, body_size), 8);
+	
+	if(checksum != NULL)
+	{
+		*checksum = read_le(&save[24], 8);
+	}
+	
+	return replace_file(path, &save[0], save.size());
+}
+
+void take_journal_batch(MineData *mine, PlayerData *player, Journal_Batch &batch)
+{
+	int count = mine->get_changed_count();
+	const int *changed = mine->get_changed_tiles();
+	const unsigned char *tiles = mine->get_tiles();
+	const unsigned char *levels = mine->get_water_levels();
+	
+	int size = SAVE_VALUES * 4 + 4 + count * 3;
+	batch.data.resize(4 + size + 8);
+	unsigned char *data = &batch.data[0];
+	
+	write_le(data, size, 4);
+	
+	int values[SAVE_VALUES];
+	collect_player(player, values);
+	collect_game(player, values);
+	
+	for(int value = 0; value < SAVE_VALUES; value++)
+	{
+		write_le(data + 4 + value * 4, (unsigned int)values[value], 4);
+	}
 	
-		player_in >> temp_int;
-		player->change_health(temp_int - player->get_health());
+	unsigned char *tile_data = data + 4 + SAVE_VALUES * 4;
+	write_le(tile_data, count, 4);
+	tile_data += 4;
 	
-		player_in >> temp_int;
-		player->change_money(temp_int - player->get_money());
+	for(int change = 0; change < count; change++)
+	{
+		write_le(tile_data + change * 3, changed[change], 2);
+		tile_data[change * 3 + 2] = tiles[changed[change]] & (TILE_MATERIAL_MASK | TILE_EXPLORED);
+		
+		if(has_water_level(tiles, levels, changed[change]))
+		{
+			tile_data[change * 3 + 2] |= levels[changed[change]] << JOURNAL_LEVEL_SHIFT;
+		}
+	}
+	
+	write_le(data + 4 + size, save_checksum(data, 4 + size), 8);
+	
+	mine->forget_changes();
+}
+
+bool start_journal(const char *path, unsigned long long checksum)
+{
+	unsigned char header[JOURNAL_HEADER_SIZE];
+	
+	memcpy(header, JOURNAL_MAGIC, 4);
+	write_le(header + 4, JOURNAL_VERSION, 4);
+	write_le(header + 8, checksum, 8);
+	
+	return replace_file(path, header, JOURNAL_HEADER_SIZE);
+}
+
+bool append_journal(const char *path, const Journal_Batch &batch)
+{
+	Trace_Zone zone("append_journal", TRACE_IO);
+
+	FILE *file = fopen(path, "ab");
+	
+	if(file == NULL)
+	{
+		return false;
+	}
+	
+	bool written = fwrite(&batch.data[0], 1, batch.data.size(), file) == batch.data.size()
+		&& fflush(file) == 0 && fsync(fileno(file)) == 0;
+	
+	return fclose(file) == 0 && written;
+}
+
+// Put the batches of a journal back into tiles, the water's levels and
+// the save's values. Stops at the first batch cut short or damaged.
+// Returns how many were put back, or -1 if the journal doesn't follow
+// the save.
+static int replay_journal(const char *path, unsigned long long checksum, unsigned char *tiles,
+						  unsigned char *levels, int values[SAVE_VALUES])
+{
+	Mapped_File file;
+	
+	if(!file.open(path) || file.get_size() < JOURNAL_HEADER_SIZE)
+	{
+		return -1;
+	}
+	
+	const unsigned char *journal = file.get_data();
+	long long size = file.get_size();
+	
+	if(memcmp(journal, JOURNAL_MAGIC, 4) != 0 || read_le(journal + 4, 4) > (unsigned int)JOURNAL_VERSION
+	   || read_le(journal + 8, 8) != checksum)
+	{
+		return -1;
+	}
+	
+	// Batches from before version 3 have only the player's values, and
+	// from version 3 the statistics too.
+	int value_count = SAVE_VALUES;
+	
+	if(read_le(journal + 4, 4) < 3)
+	{
+		value_count = SAVE_PLAYER_VALUES;
+	}
+	else if(read_le(journal + 4, 4) < 4)
+	{
+		value_count = SAVE_MARKET_START;
+	}
+	
+	long long position = JOURNAL_HEADER_SIZE;
+	int batches = 0;
+	
+	while(position + 4 <= size)
+	{
+		const unsigned char *batch = journal + position;
+		long long batch_size = read_le(batch, 4);
+		
+		if(batch_size < value_count * 4 + 4 || position + 4 + batch_size + 8 > size
+		   || save_checksum(batch, 4 + batch_size) != read_le(batch + 4 + batch_size, 8))
+		{
+			break;
+		}
+		
+		const unsigned char *tile_data = batch + 4 + value_count * 4;
+		long long count = read_le(tile_data, 4);
+		
+		if(value_count * 4 + 4 + count * 3 != batch_size)
+		{
+			break;
+		}
+		
+		for(int value = 0; value < value_count; value++)
+		{
+			values[value] = (int)read_le(batch + 4 + value * 4, 4);
+		}
+		
+		tile_data += 4;
+		
+		for(long long change = 0; change < count; change++)
+		{
+			int index = read_le(tile_data + change * 3, 2);
+			
+			if(index < MINE_TILES)
+			{
+				unsigned char tile = tile_data[change * 3 + 2];
+				
+				tiles[index] = tile & (TILE_MATERIAL_MASK | TILE_EXPLORED);
+				levels[index] = tile >> JOURNAL_LEVEL_SHIFT;
+			}
+		}
+		
+		position += 4 + batch_size + 8;
+		batches++;
+	}
+	
+	return batches;
+}
+
+void make_thumbnail(const unsigned char *tiles, unsigned char *thumbnail)
+{
+	memset(thumbnail, 0, SAVE_THUMBNAIL_BYTES);
+	
+	for(int y = 0; y < SAVE_THUMBNAIL_HEIGHT * SAVE_THUMBNAIL_SCALE; y++)
+	{
+		const unsigned char *row = tiles + y * MINE_WIDTH;
+		int pixel_row = (y / SAVE_THUMBNAIL_SCALE) * SAVE_THUMBNAIL_WIDTH;
+		
+		for(int x = 0; x < SAVE_THUMBNAIL_WIDTH * SAVE_THUMBNAIL_SCALE; x++)
+		{
+			if(row[x] & TILE_EXPLORED)
+			{
+				int pixel = pixel_row + x / SAVE_THUMBNAIL_SCALE;
+				thumbnail[pixel / 8] |= 1 << (pixel % 8);
+			}
+		}
+	}
+}
+
+bool read_save_index(Save_Slot_Info slots[SAVE_SLOTS])
+{
+	Trace_Zone zone("read_save_index", TRACE_IO);
+
+	for(int slot = 0; slot < SAVE_SLOTS; slot++)
+	{
+		memset(&slots[slot], 0, sizeof(Save_Slot_Info));
+	}
+	
+	Mapped_File file;
+	
+	if(!file.open(SAVE_INDEX_FILE) || file.get_size() != SAVE_INDEX_HEADER_SIZE + SAVE_SLOTS * SAVE_INDEX_ENTRY_SIZE)
+	{
+		return false;
+	}
+	
+	const unsigned char *index = file.get_data();
+	
+	if(memcmp(index, SAVE_INDEX_MAGIC, 4) != 0 || read_le(index + 4, 2) != SAVE_INDEX_VERSION ||
+	   read_le(index + 6, 2) != SAVE_SLOTS ||
+	   read_le(index + 8, 8) != save_checksum(index + SAVE_INDEX_HEADER_SIZE, SAVE_SLOTS * SAVE_INDEX_ENTRY_SIZE))
+	{
+		return false;
+	}
+	
+	for(int slot = 0; slot < SAVE_SLOTS; slot++)
+	{
+		const unsigned char *entry = index + SAVE_INDEX_HEADER_SIZE + slot * SAVE_INDEX_ENTRY_SIZE;
+		
+		slots[slot].used = entry[0] != 0;
+		slots[slot].has_diamond = entry[1] != 0;
+		slots[slot].turn = (int)read_le(entry + 4, 4);
+		slots[slot].money = (int)read_le(entry + 8, 4);
+		slots[slot].health = (int)read_le(entry + 12, 4);
+		slots[slot].time_saved = (long long)read_le(entry + 16, 8);
+		memcpy(slots[slot].thumbnail, entry + 24, SAVE_THUMBNAIL_BYTES);
+	}
+	
+	return true;
+}
+
+// Rebuild a slot's entry in the index from its save, for when the
+// index has been lost. Returns false, with the entry empty, if there's
+// no good save in the slot.
+static bool read_slot_info(int slot, Save_Slot_Info &info)
+{
+	memset(&info, 0, sizeof(Save_Slot_Info));
+	
+	Mapped_File file;
+	
+	if(!file.open(SAVE_SLOT_FILES[slot]) || file.get_size() < SAVE_HEADER_SIZE)
+	{
+		return false;
+	}
+	
+	const unsigned char *save = file.get_data();
+	int header_size = read_le(&save[6], 2);
+	int value_count = read_le(&save[16], 4);
+	unsigned int flags = read_le(&save[20], 4);
+	long long tiles_size = (flags & SAVE_PACKED_TILES) ? SAVE_EXPLORED_SIZE : MINE_TILES;
+	
+	if(memcmp(save, SAVE_MAGIC, 4) != 0 || read_le(&save[4], 2) > (unsigned int)SAVE_VERSION
+	   || header_size < SAVE_HEADER_SIZE || read_le(&save[8], 2) != (unsigned int)MINE_WIDTH
+	   || read_le(&save[10], 2) != (unsigned int)MINE_HEIGHT
+	   || value_count < SAVE_PLAYER_VALUES || value_count > (1 << 20)
+	   || file.get_size() < header_size + (long long)value_count * 4 + 8 + tiles_size)
+	{
+		return false;
+	}
+	
+	// A good save's checksum covers everything after the header.
+	const unsigned char *body = save + header_size;
+	
+	if(save_checksum(body, file.get_size() - header_size) != read_le(&save[24], 8))
+	{
+		return false;
+	}
+	
+	const unsigned char *tiles = body + value_count * 4 + 8;
+	std::vector<unsigned char> explored(MINE_TILES, 0);
+	
+	if(flags & SAVE_PACKED_TILES)
+	{
+		unpack_explored(tiles, &explored[0]);
+	}
+	else
+	{
+		memcpy(&explored[0], tiles, MINE_TILES);
+	}
 	
-		player_in >> temp_int;
-		player->change_coal(temp_int - player->get_coal());
+	info.used = true;
+	info.has_diamond = read_le(body + SAVE_HAS_DIAMOND * 4, 4) != 0;
+	info.turn = (int)read_le(body + SAVE_TURN * 4, 4);
+	info.money = (int)read_le(body + SAVE_MONEY * 4, 4);
+	info.health = (int)read_le(body + SAVE_HEALTH * 4, 4);
+	info.time_saved = modified_time(SAVE_SLOT_FILES[slot]);
+	make_thumbnail(&explored[0], info.thumbnail);
 	
-		player_in >> temp_int;
-		player->change_silver(temp_int - player->get_silver());
+	return true;
+}
+
+void read_save_slots(Save_Slot_Info slots[SAVE_SLOTS])
+{
+	if(!read_save_index(slots))
+	{
+		for(int slot = 0; slot < SAVE_SLOTS; slot++)
+		{
+			read_slot_info(slot, slots[slot]);
+		}
+	}
+}
+
+bool write_save_slot(int slot, const Save_Snapshot &snapshot, time_t time_saved)
+{
+	Trace_Zone zone("write_save_slot", TRACE_IO);
+
+	if(slot < 0 || slot >= SAVE_SLOTS || !write_snapshot(SAVE_SLOT_FILES[slot], snapshot))
+	{
+		return false;
+	}
+	
+	// The other slots' entries are kept as they were, or rebuilt from
+	// their saves if the index has been lost or damaged.
+	Save_Slot_Info slots[SAVE_SLOTS];
+	read_save_slots(slots);
+	
+	slots[slot].used = true;
+	slots[slot].has_diamond = snapshot.values[SAVE_HAS_DIAMOND] != 0;
+	slots[slot].turn = snapshot.values[SAVE_TURN];
+	slots[slot].money = snapshot.values[SAVE_MONEY];
+	slots[slot].health = snapshot.values[SAVE_HEALTH];
+	slots[slot].time_saved = time_saved;
+	make_thumbnail(snapshot.tiles, slots[slot].thumbnail);
+	
+	unsigned char index[SAVE_INDEX_HEADER_SIZE + SAVE_SLOTS * SAVE_INDEX_ENTRY_SIZE];
+	memset(index, 0, sizeof(index));
+	
+	for(int entry_slot = 0; entry_slot < SAVE_SLOTS; entry_slot++)
+	{
+		unsigned char *entry = index + SAVE_INDEX_HEADER_SIZE + entry_slot * SAVE_INDEX_ENTRY_SIZE;
+		
+		entry[0] = slots[entry_slot].used;
+		entry[1] = slots[entry_slot].has_diamond;
+		write_le(entry + 4, (unsigned int)slots[entry_slot].turn, 4);
+		write_le(entry + 8, (unsigned int)slots[entry_slot].money, 4);
+		write_le(entry + 12, (unsigned int)slots[entry_slot].health, 4);
+		write_le(entry + 16, (unsigned long long)slots[entry_slot].time_saved, 8);
+		memcpy(entry + 24, slots[entry_slot].thumbnail, SAVE_THUMBNAIL_BYTES);
+	}
+	
+	memcpy(index, SAVE_INDEX_MAGIC, 4);
+	write_le(index + 4, SAVE_INDEX_VERSION, 2);
+	write_le(index + 6, SAVE_SLOTS, 2);
+	write_le(index + 8, save_checksum(index + SAVE_INDEX_HEADER_SIZE, SAVE_SLOTS * SAVE_INDEX_ENTRY_SIZE), 8);
+	
+	return replace_file(SAVE_INDEX_FILE, index, sizeof(index));
+}
+
+bool write_save(const char *path, MineData *mine, PlayerData *player)
+{
+	Trace_Zone zone("save_game", TRACE_IO);
+
+	// Too big for the stack to hold comfortably.
+	Save_Snapshot *snapshot = new Save_Snapshot;
+	take_snapshot(mine, player, *snapshot);
+	
+	bool written = write_snapshot(path, *snapshot);
+	
+	delete snapshot;
+	
+	return written;
+}
+
+bool read_save(const char *path, MineData *mine, PlayerData *player, const char *journal_path)
+{
+	Trace_Zone zone("read_save", TRACE_IO);
+
+	Mapped_File file;
+	
+	if(!file.open(path) || file.get_size() < SAVE_HEADER_SIZE)
+	{
+		return false;
+	}
+	
+	const unsigned char *save = file.get_data();
+	
+	if(memcmp(save, SAVE_MAGIC, 4) != 0)
+	{
+		return false;
+	}
+	
+	int version = read_le(&save[4], 2);
+	int header_size = read_le(&save[6], 2);
+	int width = read_le(&save[8], 2);
+	int height = read_le(&save[10], 2);
+	unsigned int mine_seed = read_le(&save[12], 4);
+	int value_count = read_le(&save[16], 4);
+	unsigned int flags = read_le(&save[20], 4);
+	
+	// Later versions may add to the header or the player's values, but
+	// the mine has to be the size this game plays in.
+	if(version > SAVE_VERSION || header_size < SAVE_HEADER_SIZE || width != MINE_WIDTH || height != MINE_HEIGHT
+	   || value_count < SAVE_PLAYER_VALUES || value_count > (1 << 20))
+	{
+		return false;
+	}
+	
+	const unsigned char *body = save + header_size;
+	const unsigned char *tiles = body + value_count * 4 + 8;
+	long long body_size = (long long)value_count * 4 + 8;
+	long long materials_size = 0;
+	
+	if(flags & SAVE_PACKED_TILES)
+	{
+		body_size += SAVE_EXPLORED_SIZE + 4;
+		
+		if(file.get_size() < header_size + body_size)
+		{
+			return false;
+		}
+		
+		materials_size = read_le(tiles + SAVE_EXPLORED_SIZE, 4);
+		body_size += materials_size;
+	}
+	else
+	{
+		body_size += MINE_TILES;
+	}
 	
-		player_in >> temp_int;
-		player->change_gold(temp_int - player->get_gold());
+	const unsigned char *water = body + body_size;
+	long long water_count = 0;
 	
-		player_in >> temp_int;
-		player->change_platinum(temp_int - player->get_platinum());
+	if(flags & SAVE_WATER_LEVELS)
+	{
+		if(file.get_size() < header_size + body_size + 4)
+		{
+			return false;
+		}
+		
+		water_count = read_le(water, 4);
+		water += 4;
+		body_size += 4 + water_count * 3;
+	}
 	
-		player_in >> temp_int;
-		player->set_turn_number(temp_int);
+	if(file.get_size() != header_size + body_size)
+	{
+		return false;
+	}
 	
-		player_in >> temp_int;
-		player->set_insurance_turn_number(temp_int);
+	unsigned long long checksum = read_le(&save[24], 8);
 	
-		player_in >> temp_int;
-		player->set_previous_turn_number(temp_int);
+	if(save_checksum(body, body_size) != checksum)
+	{
+		return false;
+	}
 	
-		player_in >> temp_bool;
-		player->change_has_axe(temp_bool);
+	// The tiles are decoded to one side first, so a save that turns out
+	// to be bad leaves the game as it was.
+	std::vector<unsigned char> loaded_tiles(MINE_TILES);
+	unsigned char *mine_tiles = &loaded_tiles[0];
 	
-		player_in >> temp_bool;
-		player->change_has_bucket(temp_bool);
+	if(flags & SAVE_PACKED_TILES)
+	{
+		// The checksum matched, so only a save written wrongly gets here.
+		if(!unpack_materials(tiles + SAVE_EXPLORED_SIZE + 4, materials_size, mine_tiles))
+		{
+			return false;
+		}
+		
+		unpack_explored(tiles, mine_tiles);
+	}
+	else
+	{
+		memcpy(mine_tiles, tiles, MINE_TILES);
+	}
 	
-		player_in >> temp_bool;
-		player->change_has_diamond(temp_bool);
+	std::vector<unsigned char> loaded_levels(MINE_TILES, 0);
+	unsigned char *water_levels = &loaded_levels[0];
 	
-		player_in >> temp_bool;
-		player->change_has_dynamite(temp_bool);
+	for(long long tile = 0; tile < water_count; tile++)
+	{
+		int index = read_le(water + tile * 3, 2);
+		
+		if(index >= MINE_TILES || water[tile * 3 + 2] > WATER_PRESSURE)
+		{
+			return false;
+		}
+		
+		water_levels[index] = water[tile * 3 + 2];
+	}
 	
-		player_in >> temp_bool;
-		player->change_has_flashlight(temp_bool);
+	// The statistics are zero in a save from before they were kept.
+	int values[SAVE_VALUES];
+	memset(values, 0, sizeof(values));
+	
+	for(int value = 0; value < SAVE_VALUES && value < value_count; value++)
+	{
+		values[value] = (int)read_le(body + value * 4, 4);
+	}
+	
+	// Then what changed after it was saved.
+	if(journal_path != NULL)
+	{
+		replay_journal(journal_path, checksum, mine_tiles, water_levels, values);
+	}
+	
+	if(!(flags & SAVE_WATER_LEVELS))
+	{
+		restart_springs(mine_tiles, water_levels);
+	}
+	
+	// Everything has been read; only now is the game replaced.
+	mine->clear(mine_seed);
+	mine->load_water_levels(water_levels);
+	mine->load_tiles(mine_tiles);
+	
+	int diamond_x = (int)read_le(body + value_count * 4, 4);
+	int diamond_y = (int)read_le(body + value_count * 4 + 4, 4);
+	
+	bool has_market = (flags & SAVE_MARKET) && value_count >= SAVE_VALUES;
+	
+	restore_game(mine, player, values, has_market, diamond_x, diamond_y);
+	
+	return true;
+}
+
+bool read_text_save(const char *player_path, const char *mine_path, MineData *mine, PlayerData *player)
+{
+	Trace_Zone zone("read_text_save", TRACE_IO);
+
+	int temp_int = 0;
+	bool temp_bool = false;
+	int temp_x = 0;
+	int temp_y = 0;
 	
-		player_in >> temp_bool;
-		player->change_has_hardhat(temp_bool);
+	// Load the player's information from the player file
+	std::ifstream player_in(player_path, std::ios::binary);
 	
-		player_in >> temp_bool;
-		player->change_has_insurance(temp_bool);
+	if(!player_in)
+	{
+		return false;
+	}
 	
-		player_in >> temp_bool;
-		player->change_has_shovel(temp_bool);
+	// The text format has no statistics, so they start at zero.
+	int values[SAVE_VALUES];
+	memset(values, 0, sizeof(values));
 	
-		// Randomize the mineral values.
-		player->randomize_coal_value();
-		player->randomize_silver_value();
-		player->randomize_gold_value();
-		player->randomize_platinum_value();
+		for(int value = 0; value < SAVE_PLAYER_VALUES; value++)
+		{
+			player_in >> values[value];
+		}
 	
+	bool complete = !player_in.fail();
 	player_in.close();
 	
-	std::ifstream mine_in("mine_save", std::ios::binary);
+	// The text format left out the last row and column, so they're
+	// as a new mine has them: the shaft, and unexplored dirt.
+	std::vector<unsigned char> tiles(MINE_TILES, 0);
 	
-		// Load the mine information into the game.
+	for(int y = 0; y <= mine->get_map_y(); y++)
+	{
+		tiles[mine->get_index(0, y)] = SHAFT | TILE_EXPLORED;
+	}
+	
+	std::ifstream mine_in(mine_path, std::ios::binary);
+	
+	if(!mine_in)
+	{
+		return false;
+	}
+	
+		// Load the mine information.
 		for(int x = 0; x <= (mine->get_map_x() - 1); x++)
 		{
 			for(int y = 0; y <= (mine->get_map_y() - 1); y++)
 			{
 				mine_in >> temp_int;
-				mine->set_contents(x, y, (materials)temp_int);
+				tiles[mine->get_index(x, y)] = (unsigned char)temp_int & TILE_MATERIAL_MASK;
 			}
 		}
 		
@@ -170,13 +1070,35 @@ void load_game(MineData *mine, PlayerData *player)
 			for(int y = 0; y <= (mine->get_map_y() - 1); y++)
 			{
 				mine_in >> temp_bool;
-				mine->set_explored(x, y, temp_bool);
+				
+				if(temp_bool)
+				{
+					tiles[mine->get_index(x, y)] |= TILE_EXPLORED;
+				}
 			}
 		}
 	
-		// Set the location of the diamond (for the hint screen)
+		// Get the location of the diamond (for the hint screen)
 		mine_in >> temp_x >> temp_y;
-		mine->set_diamond_location(temp_x, temp_y);
 	
+	complete = complete && !mine_in.fail();
 	mine_in.close();
+	
+	// Nothing is changed unless the whole save was there.
+	if(!complete)
+	{
+		return false;
+	}
+	
+	// The text format didn't keep the water's levels.
+	std::vector<unsigned char> levels(MINE_TILES, 0);
+	restart_springs(&tiles[0], &levels[0]);
+	
+	mine->clear(mine->get_seed());
+	mine->load_water_levels(&levels[0]);
+	mine->load_tiles(&tiles[0]);
+	
+	restore_game(mine, player, values, false, temp_x, temp_y);
+	
+	return true;
 }
@@ -30,11 +30,253 @@
 
 #include <iostream>
 #include <fstream>
+#include <vector>
+#include <ctime>
 
 #include "classes.h"
+#include "game_statistics.h"
 
-void save_game(MineData *mine, PlayerData *player);
+// Where the game saves itself every so often (see autosave.h).
+const char AUTOSAVE_FILE[] = "autosave";
 
-void load_game(MineData *mine, PlayerData *player);
+// Where the player's saves go: one file for each slot, and an index of
+// what is in each, so the load menu can show them without opening any.
+const int SAVE_SLOTS = 4;
+const char SAVE_INDEX_FILE[] = "save_index";
+const char *const SAVE_SLOT_FILES[SAVE_SLOTS] = { "save_slot_1", "save_slot_2", "save_slot_3", "save_slot_4" };
+
+// Where the player's one save went before there were slots. It's still
+// loaded along with the autosave.
+const char SAVE_FILE[] = "game_save";
+
+// The changes made since AUTOSAVE_FILE was written.
+const char JOURNAL_FILE[] = "autosave_journal";
+
+// Where the text format kept the player and the mine. Saves in it are
+// still loaded, if there isn't a newer save.
+const char TEXT_PLAYER_FILE[] = "player_save";
+const char TEXT_MINE_FILE[] = "mine_save";
+
+// The save format. All little-endian:
+//	"MSAV"
+//	uint16 version, uint16 header size
+//	uint16 mine width, uint16 mine height (in tiles)
+//	uint32 the mine's seed
+//	uint32 how many of the player's values follow the header
+//	uint32 flags (save_flag)
+//	uint64 checksum of everything after the header
+// then the player's values as int32s, and the diamond's x and y as
+// int32s. Then the mine, row by row: either every tile as a byte with
+// its material and explored bits (see classes.h), or, with
+// SAVE_PACKED_TILES, the explored bits packed eight tiles a byte
+// (lowest bit first), a uint32 count of bytes, and that many bytes of
+// materials packed by pack_materials. Then, with SAVE_WATER_LEVELS, a
+// uint32 count of tiles of water that can still spread, and for each
+// a uint16 index and a uint8 level. Without it, any spring that has
+// been hit starts again at full pressure. With SAVE_MARKET the values
+// end with the market's; without it the market starts afresh.
+const char SAVE_MAGIC[4] = { 'M', 'S', 'A', 'V' };
+const int SAVE_VERSION = 4;
+const int SAVE_HEADER_SIZE = 32;
+
+enum save_flag
+{
+	SAVE_PACKED_TILES = 1,	// From version 2.
+	SAVE_WATER_LEVELS = 2,	// From version 3.
+	SAVE_MARKET = 4			// From version 4.
+};
+
+// Bytes the explored bits take when packed.
+const int SAVE_EXPLORED_SIZE = (MINE_TILES + 7) / 8;
+
+// The player's values, in the order they're saved in both formats.
+enum save_player_value
+{
+	SAVE_HEALTH,
+	SAVE_MONEY,
+	SAVE_COAL,
+	SAVE_SILVER,
+	SAVE_GOLD,
+	SAVE_PLATINUM,
+	SAVE_TURN,
+	SAVE_INSURANCE_TURN,
+	SAVE_PREVIOUS_TURN,
+	SAVE_HAS_AXE,
+	SAVE_HAS_BUCKET,
+	SAVE_HAS_DIAMOND,
+	SAVE_DYNAMITE,
+	SAVE_HAS_FLASHLIGHT,
+	SAVE_HAS_HARDHAT,
+	SAVE_HAS_INSURANCE,
+	SAVE_HAS_SHOVEL,
+	SAVE_PLAYER_VALUES
+};
+
+// The game's statistics (see game_statistics.h) are saved after the
+// player's values, as more values, and then the market (see market.h).
+// A save with only the player's values starts the statistics at zero.
+const int SAVE_STATISTICS_START = SAVE_PLAYER_VALUES;
+const int SAVE_MARKET_START = SAVE_STATISTICS_START + STATISTIC_COUNT;
+const int SAVE_VALUES = SAVE_MARKET_START + MARKET_SAVE_VALUES;
+
+// The journal of changes since a save. All little-endian:
+//	"MJNL"
+//	uint32 version
+//	uint64 the checksum from the header of the save it follows
+// then batches, each:
+//	uint32 size of the batch, not counting this or its checksum
+//	the player's values as int32s, after the batch, and from version 3
+//	the game's statistics after them, and from version 4 the market's
+//	uint32 count of tiles changed
+//	for each, uint16 index and uint8 tile (material and explored bits,
+//	and from version 2 the water's level above them)
+//	uint64 checksum of the batch, from its size on
+// A batch cut short or damaged, and anything after it, is ignored.
+const char JOURNAL_MAGIC[4] = { 'M', 'J', 'N', 'L' };
+const int JOURNAL_VERSION = 4;
+const int JOURNAL_LEVEL_SHIFT = 5;
+const int JOURNAL_HEADER_SIZE = 16;
+
+// The index of the save slots. All little-endian:
+//	"MIDX"
+//	uint16 version, uint16 number of slots
+//	uint64 checksum of everything after the header
+// then for each slot:
+//	uint8 whether it's used, uint8 whether the player has the diamond
+//	uint16 unused
+//	int32 turn, int32 money, int32 health
+//	int64 when it was saved, in seconds since 1970
+//	the thumbnail, SAVE_THUMBNAIL_BYTES bytes
+// A damaged index reads as every slot empty. The slots' saves are
+// still there: read_save_slots rebuilds the entries from them for the
+// menu, and the next save to a slot writes them back.
+const char SAVE_INDEX_MAGIC[4] = { 'M', 'I', 'D', 'X' };
+const int SAVE_INDEX_VERSION = 1;
+const int SAVE_INDEX_HEADER_SIZE = 16;
+
+// A thumbnail of the map: a pixel for each SAVE_THUMBNAIL_SCALE tiles
+// square, set if any of them has been explored, packed eight pixels a
+// byte (lowest bit first) row by row.
+const int SAVE_THUMBNAIL_SCALE = 3;
+const int SAVE_THUMBNAIL_WIDTH = MINE_WIDTH / SAVE_THUMBNAIL_SCALE;
+const int SAVE_THUMBNAIL_HEIGHT = MINE_HEIGHT / SAVE_THUMBNAIL_SCALE;
+const int SAVE_THUMBNAIL_BYTES = (SAVE_THUMBNAIL_WIDTH * SAVE_THUMBNAIL_HEIGHT + 7) / 8;
+
+const int SAVE_INDEX_ENTRY_SIZE = 24 + SAVE_THUMBNAIL_BYTES;
+
+// What the index says about a slot.
+struct Save_Slot_Info
+{
+	bool used;
+	bool has_diamond;
+	int turn;
+	int money;
+	int health;
+	long long time_saved;
+	unsigned char thumbnail[SAVE_THUMBNAIL_BYTES];
+};
+
+// Everything that goes in a save, copied out of the game so it can be
+// written while the game goes on.
+struct Save_Snapshot
+{
+	int values[SAVE_VALUES];
+	int diamond_x;
+	int diamond_y;
+	unsigned int mine_seed;
+	unsigned char tiles[MINE_TILES];
+	unsigned char water_levels[MINE_TILES];
+};
+
+// The changes to the game since the mine's changes were last
+// forgotten, as a journal batch, ready to be appended.
+struct Journal_Batch
+{
+	std::vector<unsigned char> data;
+};
+
+// Save to a slot. The writing, and the index after it, are done by the
+// autosave's thread, so the game doesn't wait for the disk.
+void save_game(MineData *mine, PlayerData *player, int slot);
+
+// Load a slot's save. Only the slot's file is read. Returns false,
+// leaving the game as it was, if there's no save in it to load.
+bool load_game(MineData *mine, PlayerData *player, int slot);
+
+// Load whichever of AUTOSAVE_FILE and SAVE_FILE was saved last, or the
+// text format's files if neither is there. Returns false, leaving the
+// game as it was, if there's no save to load.
+bool load_game(MineData *mine, PlayerData *player);
+
+// Read the index into slots. Returns false, with every slot empty, if
+// there's no index or it has been damaged. Only the index is read.
+bool read_save_index(Save_Slot_Info slots[SAVE_SLOTS]);
+
+// Read the index into slots, or if it has been lost or damaged, rebuild
+// it from the slots' saves. The rebuilt index is only written with the
+// next save to a slot, so only the writer ever writes it.
+void read_save_slots(Save_Slot_Info slots[SAVE_SLOTS]);
+
+// Write a snapshot to a slot's file, and then its entry in the index.
+// Only one thread may write slots at a time. Returns false if either
+// couldn't be written.
+bool write_save_slot(int slot, const Save_Snapshot &snapshot, time_t time_saved);
+
+// Make a thumbnail of the explored tiles.
+void make_thumbnail(const unsigned char *tiles, unsigned char *thumbnail);
+
+// Copy the game into a snapshot.
+void take_snapshot(MineData *mine, PlayerData *player, Save_Snapshot &snapshot);
+
+// Write a snapshot to a file. It's written to a temporary file that
+// then replaces the file, so a save is never left half written.
+// checksum, if given, is set to the checksum in the save's header.
+// Returns false if it couldn't be written.
+bool write_snapshot(const char *path, const Save_Snapshot &snapshot, unsigned long long *checksum = NULL);
+
+// Copy the mine's changed tiles and the player into a batch, and
+// forget the mine's changes. Takes time in proportion to the changes.
+void take_journal_batch(MineData *mine, PlayerData *player, Journal_Batch &batch);
+
+// Start a journal for the save with the given checksum, replacing any
+// journal there was, the same way write_snapshot replaces a save.
+bool start_journal(const char *path, unsigned long long checksum);
+
+// Append a batch to a journal, and make sure it's on the disk.
+bool append_journal(const char *path, const Journal_Batch &batch);
+
+// Write a save to a file, now. Returns false if it couldn't be written.
+bool write_save(const char *path, MineData *mine, PlayerData *player);
+
+// Load a save from a file. Returns false, leaving the game as it was,
+// if it isn't a save this version can read or it has been damaged.
+// Nothing in the game is changed until the whole save has been read.
+// With a journal_path, the batches in the journal that follows the
+// save are put back too.
+bool read_save(const char *path, MineData *mine, PlayerData *player, const char *journal_path = NULL);
+
+// Pack the tiles' explored bits into SAVE_EXPLORED_SIZE bytes, and
+// set the bits in tiles that are set in the packed bits.
+void pack_explored(const unsigned char *tiles, unsigned char *packed);
+void unpack_explored(const unsigned char *packed, unsigned char *tiles);
+
+// Pack the tiles' materials. Most of a mine is runs of unexplored dirt,
+// with the odd mineral in them, and runs of tunnels. Each byte has a
+// run of the current run material in its high four bits and the tile
+// after the run in its low four. A run of 15 or more has 15 there and
+// the rest in the bytes that follow: 255 in each until less than 255
+// is left, then what's left. The run material starts as DIRT, and
+// becomes DIRT or EXPLORED whenever one of them is the tile after a
+// run. A run to the end of the mine has nothing after it, so its low
+// four bits are 0.
+void pack_materials(const unsigned char *tiles, std::vector<unsigned char> &packed);
+
+// Unpack materials into MINE_TILES tiles, overwriting them. Returns
+// false if the packed bytes aren't exactly a mine's worth.
+bool unpack_materials(const unsigned char *packed, int size, unsigned char *tiles);
+
+// Load a save in the text format. Only the tiles above and to the left
+// of the last row and column were kept in it.
+bool read_text_save(const char *player_path, const char *mine_path, MineData *mine, PlayerData *player);
 
 #endif
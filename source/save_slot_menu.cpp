@@ -0,0 +1,275 @@
+/*
+ save_slot_menu.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ The screen where the player picks a save slot to save to or load.
+*/
+
+#include <sstream>
+#include <ctime>
+
+// General SDL includes.
+#include "SDL/SDL.h"
+#include "SDL_image/SDL_image.h"
+#include "SDL_ttf/SDL_ttf.h"
+
+#include "sdl_functions.h"
+#include "save_slot_menu.h"
+#include "trace.h"
+
+// Where the rows of the menu are.
+const int SLOT_MENU_TOP = 60;
+const int SLOT_MENU_ROW = 82;
+
+int choose_save_slot(SDL_Objects *sdl, bool saving)
+{
+	Trace_Zone zone("choose_save_slot", TRACE_SCREEN);
+
+	Save_Slot_Objects menu(sdl, saving);
+	
+	// Initialize the selection arrow
+	Selection_Arrow selection(1, menu.get_choices(), 0, SLOT_MENU_ROW);
+	selection.set_arrow_initial(20, SLOT_MENU_TOP + 20);
+	
+	// Initialize an event to track the user's input
+	SDL_Event user_input;
+	
+	bool exit = false;		// Keeps track of whether to exit main loop.
+	bool update_screen = false;	// Keeps track of when to update the screen.
+	int choice = SLOT_CHOICE_NONE;
+	
+	// Apply the graphics on the screen
+	menu.update_save_slot_menu(sdl, &selection);
+	SDL_Flip(sdl->return_screen());
+	
+	while(!exit)
+	{
+		update_screen = false;
+		Uint8 *keystate = SDL_GetKeyState(NULL);	// Captures keyboard input.
+		
+		while(SDL_PollEvent( &user_input ))
+		{	
+			// Quit if the user chooses to close the window.
+			if(user_input.type == SDL_QUIT)
+			{
+				sdl->set_quitSDL();
+				exit = true;
+			}
+		}
+		
+		// Respond to the user's key presses
+		if(keystate[SDLK_DOWN])
+		{
+			selection.move_down();
+			update_screen = true;
+			SDL_Delay(sdl->KEYPRESS_WAIT);
+		}
+		else if(keystate[SDLK_UP])
+		{
+			selection.move_up();
+			update_screen = true;
+			SDL_Delay(sdl->KEYPRESS_WAIT);
+		}
+		else if(keystate[SDLK_ESCAPE] || keystate[SDLK_BACKSPACE])
+		{
+			// Back out without picking a slot.
+			exit = true;
+			SDL_Delay(sdl->KEYPRESS_WAIT);
+		}		
+		else if(keystate[SDLK_RETURN] || keystate[SDLK_KP_ENTER])
+		{
+			int picked = selection.return_vert();
+			
+			// An empty slot has nothing to load.
+			if(saving || picked == SLOT_CHOICE_AUTOSAVE || menu.is_used(picked))
+			{
+				choice = picked;
+				exit = true;
+			}
+			
+			SDL_Delay(sdl->KEYPRESS_WAIT);
+		}
+		
+		if(update_screen)
+		{
+			menu.update_save_slot_menu(sdl, &selection);
+			SDL_Flip(sdl->return_screen());
+		}
+		
+		SDL_Delay(sdl->SDL_WAIT);
+	}
+	
+	return choice;
+}
+
+Save_Slot_Objects::Save_Slot_Objects(SDL_Objects *sdl, bool saving)
+{
+	background = load_image("graphics/start_screen/background.png");
+	menu_arrow = load_image("graphics/popup_menu/arrow.png");
+	diamond_graphic = load_image("graphics/high_score/diamond.png");
+	
+	header_font = open_font("Fonts/DejaVuSans-Bold.ttf", 36);
+	font = open_font("Fonts/DejaVuSans-Bold.ttf", 28);
+	small_font = open_font("Fonts/DejaVuSans-Bold.ttf", 20);
+	
+	this->saving = saving;
+	
+	// Everything shown comes from the index. The saves are only opened
+	// if it has been lost or damaged.
+	read_save_slots(slots);
+	
+	for(int slot = 0; slot < SAVE_SLOTS; slot++)
+	{
+		thumbnails[slot] = NULL;
+		
+		if(slots[slot].used)
+		{
+			thumbnails[slot] = make_thumbnail_surface(sdl, slots[slot]);
+		}
+	}
+}
+
+Save_Slot_Objects::~Save_Slot_Objects()
+{
+	SDL_FreeSurface(background);
+	SDL_FreeSurface(menu_arrow);
+	SDL_FreeSurface(diamond_graphic);
+	
+	for(int slot = 0; slot < SAVE_SLOTS; slot++)
+	{
+		if(thumbnails[slot] != NULL)
+		{
+			SDL_FreeSurface(thumbnails[slot]);
+		}
+	}
+	
+	TTF_CloseFont(header_font);
+	TTF_CloseFont(font);
+	TTF_CloseFont(small_font);
+}
+
+SDL_Surface *Save_Slot_Objects::make_thumbnail_surface(SDL_Objects *sdl, const Save_Slot_Info &slot)
+{
+	SDL_PixelFormat *format = sdl->return_screen()->format;
+	SDL_Surface *surface = SDL_CreateRGBSurface(SDL_SWSURFACE, SAVE_THUMBNAIL_WIDTH, SAVE_THUMBNAIL_HEIGHT,
+												format->BitsPerPixel, format->Rmask, format->Gmask,
+												format->Bmask, format->Amask);
+	
+	if(surface == NULL)
+	{
+		return NULL;
+	}
+	
+	Uint32 explored_colour = SDL_MapRGB(surface->format, 200, 170, 110);
+	
+	SDL_FillRect(surface, NULL, SDL_MapRGB(surface->format, 30, 30, 30));
+	
+	for(int pixel = 0; pixel < SAVE_THUMBNAIL_WIDTH * SAVE_THUMBNAIL_HEIGHT; pixel++)
+	{
+		if(slot.thumbnail[pixel / 8] & (1 << (pixel % 8)))
+		{
+			SDL_Rect point;
+			point.x = pixel % SAVE_THUMBNAIL_WIDTH;
+			point.y = pixel / SAVE_THUMBNAIL_WIDTH;
+			point.w = 1;
+			point.h = 1;
+			SDL_FillRect(surface, &point, explored_colour);
+		}
+	}
+	
+	return surface;
+}
+
+int Save_Slot_Objects::get_choices()
+{
+	if(saving)
+	{
+		return SAVE_SLOTS;
+	}
+	
+	return SAVE_SLOTS + 1;
+}
+
+bool Save_Slot_Objects::is_used(int slot)
+{
+	return slot >= 0 && slot < SAVE_SLOTS && slots[slot].used;
+}
+
+void Save_Slot_Objects::update_save_slot_menu(SDL_Objects *sdl, Selection_Arrow *selection)
+{
+	std::stringstream text;
+	
+	sdl->apply_surface(0, 0, background, sdl->return_screen());
+	
+	if(saving)
+	{
+		sdl->apply_colored_text(265, 10, 198, 15, 15, "SAVE GAME", header_font, sdl->return_screen());
+	}
+	else
+	{
+		sdl->apply_colored_text(265, 10, 198, 15, 15, "LOAD GAME", header_font, sdl->return_screen());
+	}
+	
+	for(int slot = 0; slot < SAVE_SLOTS; slot++)
+	{
+		int y = SLOT_MENU_TOP + slot * SLOT_MENU_ROW;
+		
+		text.str("");
+		text << "SLOT " << slot + 1;
+		sdl->apply_text(150, y, text.str(), font, sdl->return_screen());
+		
+		if(!slots[slot].used)
+		{
+			sdl->apply_text(150, y + 36, "Empty", small_font, sdl->return_screen());
+			continue;
+		}
+		
+		if(thumbnails[slot] != NULL)
+		{
+			sdl->apply_surface(70, y, thumbnails[slot], sdl->return_screen());
+		}
+		
+		// When it was saved.
+		char saved_at[32] = "";
+		time_t time_saved = (time_t)slots[slot].time_saved;
+		struct tm *local = localtime(&time_saved);
+		
+		if(local != NULL)
+		{
+			strftime(saved_at, sizeof(saved_at), "%b %d, %H:%M", local);
+		}
+		
+		sdl->apply_text(300, y + 6, saved_at, small_font, sdl->return_screen());
+		
+		text.str("");
+		text << "Turn " << slots[slot].turn << "    $" << slots[slot].money << "    Health " << slots[slot].health;
+		sdl->apply_text(150, y + 36, text.str(), small_font, sdl->return_screen());
+		
+		if(slots[slot].has_diamond)
+		{
+			sdl->apply_surface(680, y + 4, diamond_graphic, sdl->return_screen());
+		}
+	}
+	
+	if(!saving)
+	{
+		sdl->apply_text(150, SLOT_MENU_TOP + SAVE_SLOTS * SLOT_MENU_ROW, "LATEST AUTOSAVE", font, sdl->return_screen());
+	}
+	
+	sdl->apply_surface(selection->return_arrow_x(), selection->return_arrow_y(), menu_arrow, sdl->return_screen());
+}
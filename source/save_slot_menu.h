@@ -0,0 +1,79 @@
+/*
+ save_slot_menu.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ The screen where the player picks a save slot to save to or load.
+
+ It only reads the save index (see save_load.h), so listing the slots
+ doesn't open any of their saves.
+*/
+
+#ifndef SAVE_SLOT_MENU
+#define SAVE_SLOT_MENU
+
+// General SDL Includes.
+#include "SDL/SDL.h"
+#include "SDL_image/SDL_image.h"
+#include "SDL_ttf/SDL_ttf.h"
+
+#include "sdl_functions.h"
+#include "save_load.h"
+
+// What choose_save_slot returns besides a slot.
+const int SLOT_CHOICE_NONE = -1;				// The player backed out.
+const int SLOT_CHOICE_AUTOSAVE = SAVE_SLOTS;	// The latest autosave, when loading.
+
+// Let the player pick a slot to save to, or to load (with the latest
+// autosave below the slots). Returns the slot, or one of the choices above.
+int choose_save_slot(SDL_Objects *sdl, bool saving);
+
+class Save_Slot_Objects
+{
+	private:
+		SDL_Surface *background;
+		SDL_Surface *menu_arrow;
+		SDL_Surface *diamond_graphic;
+		
+		// Each used slot's thumbnail, drawn once when the menu opens.
+		SDL_Surface *thumbnails[SAVE_SLOTS];
+		
+		TTF_Font *header_font;
+		TTF_Font *font;
+		TTF_Font *small_font;
+		
+		Save_Slot_Info slots[SAVE_SLOTS];
+		bool saving;
+		
+		// Draw a slot's thumbnail from the index.
+		SDL_Surface *make_thumbnail_surface(SDL_Objects *sdl, const Save_Slot_Info &slot);
+		
+	public:
+		Save_Slot_Objects(SDL_Objects *sdl, bool saving);
+		~Save_Slot_Objects();
+		
+		// How many choices there are: the slots, and the autosave when loading.
+		int get_choices();
+		
+		// Whether a slot has a save in it.
+		bool is_used(int slot);
+		
+		// Display the slots, with the arrow at the selection.
+		void update_save_slot_menu(SDL_Objects *sdl, Selection_Arrow *selection);
+};
+
+#endif
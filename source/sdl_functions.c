@@ -29,6 +29,7 @@
 #include <string>
 #include <sstream> 		// Allows for easy conversion of int into string for HUD.
 #include <iostream>
+#include <iomanip>		// Allows the profiler overlay to show fixed decimals.
 
 #include "SDL/SDL.h"
 #include "SDL_image/SDL_image.h"
@@ -36,61 +37,57 @@
 
 #include "sdl_functions.h"
 #include "classes.h"
+#include "economy.h"
 #include "timer.h"
+#include "trace.h"
 
 // Initialize SDL_Objects
-SDL_Objects::SDL_Objects()
+SDL_Objects::SDL_Objects(const Display_Settings &settings)
 {	
+	Trace_Zone zone("start_sdl", TRACE_IO);
+	
 	// Initialize display screen.
-	// Currently resolution is restricted to 768x480. 16:10
-	screen = SDL_SetVideoMode(768, 480, 32, SDL_HWSURFACE);
+	// At least 768x480 (16:10), which the town's screens are drawn at.
+	screen = SDL_SetVideoMode(settings.width, settings.height, 32, SDL_HWSURFACE);
 	
-	// Initialize TTF_Font for display of TrueType fonts.
-	TTF_Init();
+	origin_x = (settings.width - LAYOUT_WIDTH) / 2;
+	origin_y = (settings.height - LAYOUT_HEIGHT) / 2;
 	
-	// Load the HUD, as it will be needed by most screens.
-	hud_graphic = IMG_Load("./Graphics/hud/hud.png");
-
-	// Load the inventory graphics used by the HUD, as this is needed as well.
-	hud_shovel = IMG_Load("./Graphics/hud/shovel.png");
-	hud_pickaxe = IMG_Load("./Graphics/hud/pickaxe.png");
-	hud_bucket = IMG_Load("./Graphics/hud/bucket.png");
-	hud_dynamite = IMG_Load("./Graphics/hud/tnt.png");
-	hud_flashlight = IMG_Load("./Graphics/hud/flashlight.png");
-	hud_hardhat = IMG_Load("./Graphics/hud/hardhat.png");
-	hud_insurance = IMG_Load("./Graphics/hud/red_cross.png");
+	// The mine's view fills the window above the HUD.
+	tile_size = settings.tile_size;
+	view_height = settings.height - HUD_HEIGHT;
+	view_columns = (settings.width + tile_size - 1) / tile_size;
+	view_rows = (view_height + tile_size - 1) / tile_size;
 	
-	// Load the graphics to be used in the mine.
-	dirt_graphic = IMG_Load("./Graphics/mine/dirt.png");
-	elevator_graphic = IMG_Load("./Graphics/mine/elevator.png");	
-	mineshaft_graphic = IMG_Load("./Graphics/mine/shaft.png");
+	// Initialize TTF_Font for display of TrueType fonts.
+	TTF_Init();
 	
-	miner_graphic = IMG_Load("./Graphics/mine/miner.png");
-	miner_down_graphic_1 = IMG_Load("./Graphics/mine/miner-down-1.png");
-	miner_down_graphic_2 = IMG_Load("./Graphics/mine/miner-down-2.png");
+	// The HUD and the mine's graphics aren't wanted until the start
+	// screen is done with, and neither is the town, so they're loaded
+	// while it's shown. See load_graphics().
+	graphics_loaded = false;
+	miner_animate = false;
 	
-	miner_move_graphic = IMG_Load("./Graphics/mine/minermove.png");
+	get_asset_preloader()->preload_directory("graphics/hud/", PRELOAD_NEXT);
+	get_asset_preloader()->preload_directory("graphics/mine/", PRELOAD_NEXT);
+	get_asset_preloader()->preload_directory("graphics/town/", PRELOAD_NEXT);
 	
-	miner_animate = false;
+	// Load the fonts for the HUD.
+	status_font = open_font("Fonts/DejaVuSans-Bold.ttf", 28);
+	news_font = open_font("Fonts/DejaVuSans-Bold.ttf", 12);
 	
-	granite_graphic = IMG_Load("./Graphics/mine/granite.png");
-	explored_graphic = IMG_Load("./Graphics/mine/explored.png");
-	hint_graphic = IMG_Load("./Graphics/mine/hint.png");
-	dynamite_graphic = IMG_Load("./Graphics/mine/dynamite.png");
-	diamond_graphic = IMG_Load("./Graphics/mine/diamond.png");
+	// Nothing has been said yet.
+	status_first = 0;
 	
-	platinum_graphic = IMG_Load("./Graphics/mine/platinum.png");
-	gold_graphic = IMG_Load("./Graphics/mine/gold.png");
-	silver_graphic = IMG_Load("./Graphics/mine/silver.png");
-	coal_graphic = IMG_Load("./Graphics/mine/coal.png");
+	for(int line = 0; line < STATUS_LINE_CACHE; line++)
+	{
+		status_lines[line] = NULL;
+		status_line_sequence[line] = 0;
+	}
 	
-	spring_graphic = IMG_Load("./Graphics/mine/spring.png");
-	water_graphic = IMG_Load("./Graphics/mine/water.png");
-	cave_in_graphic = IMG_Load("./Graphics/mine/cave-in.png");
-
-	// Load the fonts for the above graphic.
-	status_font = TTF_OpenFont("./Fonts/DejaVuSans-Bold.ttf", 28);
-	news_font = TTF_OpenFont("./Fonts/DejaVuSans-Bold.ttf", 12);
+	status_panel = NULL;
+	status_panel_end = 0;
+	status_panel_first = 0;
 	
 	// Set quitSDL to false.
 	quitSDL = false;
@@ -103,45 +100,117 @@ SDL_Objects::SDL_Objects()
 	MENU_ANIMATION_WAIT = 20;	
 }
 
+void SDL_Objects::load_graphics()
+{
+	if(graphics_loaded)
+	{
+		return;
+	}
+	
+	Trace_Zone zone("load_graphics", TRACE_IO);
+	
+	// Load the HUD, as it will be needed by most screens.
+	hud_graphic = load_image("graphics/hud/hud.png");
+
+	// Load the inventory graphics used by the HUD, as this is needed as well.
+	hud_shovel = load_image("graphics/hud/shovel.png");
+	hud_pickaxe = load_image("graphics/hud/pickaxe.png");
+	hud_bucket = load_image("graphics/hud/bucket.png");
+	hud_dynamite = load_image("graphics/hud/tnt.png");
+	hud_flashlight = load_image("graphics/hud/flashlight.png");
+	hud_hardhat = load_image("graphics/hud/hardhat.png");
+	hud_insurance = load_image("graphics/hud/red_cross.png");
+	
+	// Load the graphics to be used in the mine.
+	dirt_graphic = load_image("graphics/mine/dirt.png");
+	elevator_graphic = load_image("graphics/mine/elevator.png");	
+	mineshaft_graphic = load_image("graphics/mine/shaft.png");
+	
+	miner_graphic = load_image("graphics/mine/miner.png");
+	miner_down_graphic_1 = load_image("graphics/mine/miner-down-1.png");
+	miner_down_graphic_2 = load_image("graphics/mine/miner-down-2.png");
+	
+	miner_move_graphic = load_image("graphics/mine/minermove.png");
+	
+	granite_graphic = load_image("graphics/mine/granite.png");
+	explored_graphic = load_image("graphics/mine/explored.png");
+	hint_graphic = load_image("graphics/mine/hint.png");
+	dynamite_graphic = load_image("graphics/mine/dynamite.png");
+	diamond_graphic = load_image("graphics/mine/diamond.png");
+	
+	platinum_graphic = load_image("graphics/mine/platinum.png");
+	gold_graphic = load_image("graphics/mine/gold.png");
+	silver_graphic = load_image("graphics/mine/silver.png");
+	coal_graphic = load_image("graphics/mine/coal.png");
+	
+	spring_graphic = load_image("graphics/mine/spring.png");
+	water_graphic = load_image("graphics/mine/water.png");
+	cave_in_graphic = load_image("graphics/mine/cave-in.png");
+	
+	// Scaled once to the tile size, in mine_tile order.
+	SDL_Surface *tiles[GRAPHIC_COUNT] =
+	{
+		dirt_graphic, explored_graphic, hint_graphic, elevator_graphic, mineshaft_graphic,
+		granite_graphic, cave_in_graphic, spring_graphic, water_graphic,
+		coal_graphic, silver_graphic, gold_graphic, platinum_graphic, dynamite_graphic, diamond_graphic,
+		miner_graphic, miner_down_graphic_1, miner_down_graphic_2, miner_move_graphic
+	};
+	
+	tile_atlas.build(tiles, tile_size);
+	
+	graphics_loaded = true;
+}
+
 SDL_Objects::~SDL_Objects()
 {
 	SDL_FreeSurface(screen);
 	
-	// Free the HUD graphics.
-	SDL_FreeSurface(hud_graphic);
-	SDL_FreeSurface(hud_shovel);
-	SDL_FreeSurface(hud_pickaxe);
-	SDL_FreeSurface(hud_bucket);
-	SDL_FreeSurface(hud_dynamite);
-	SDL_FreeSurface(hud_flashlight);
-	SDL_FreeSurface(hud_hardhat);
-	SDL_FreeSurface(hud_insurance);
-	
-	// Free the graphics used in the mine.
-	SDL_FreeSurface(dirt_graphic);
-	
-	SDL_FreeSurface(elevator_graphic);
-	SDL_FreeSurface(mineshaft_graphic);	
-	
-	SDL_FreeSurface(miner_graphic);
-	SDL_FreeSurface(miner_down_graphic_1);
-	SDL_FreeSurface(miner_down_graphic_2);
-	SDL_FreeSurface(miner_move_graphic);
-	
-	SDL_FreeSurface(granite_graphic);
-	SDL_FreeSurface(explored_graphic);
-	SDL_FreeSurface(hint_graphic);
-	SDL_FreeSurface(dynamite_graphic);
-	SDL_FreeSurface(diamond_graphic);
-	
-	SDL_FreeSurface(platinum_graphic);
-	SDL_FreeSurface(gold_graphic);
-	SDL_FreeSurface(silver_graphic);
-	SDL_FreeSurface(coal_graphic);
-	
-	SDL_FreeSurface(spring_graphic);
-	SDL_FreeSurface(water_graphic);
-	SDL_FreeSurface(cave_in_graphic);
+	if(graphics_loaded)
+	{
+		// Free the HUD graphics.
+		SDL_FreeSurface(hud_graphic);
+		SDL_FreeSurface(hud_shovel);
+		SDL_FreeSurface(hud_pickaxe);
+		SDL_FreeSurface(hud_bucket);
+		SDL_FreeSurface(hud_dynamite);
+		SDL_FreeSurface(hud_flashlight);
+		SDL_FreeSurface(hud_hardhat);
+		SDL_FreeSurface(hud_insurance);
+		
+		// Free the graphics used in the mine.
+		SDL_FreeSurface(dirt_graphic);
+		
+		SDL_FreeSurface(elevator_graphic);
+		SDL_FreeSurface(mineshaft_graphic);	
+		
+		SDL_FreeSurface(miner_graphic);
+		SDL_FreeSurface(miner_down_graphic_1);
+		SDL_FreeSurface(miner_down_graphic_2);
+		SDL_FreeSurface(miner_move_graphic);
+		
+		SDL_FreeSurface(granite_graphic);
+		SDL_FreeSurface(explored_graphic);
+		SDL_FreeSurface(hint_graphic);
+		SDL_FreeSurface(dynamite_graphic);
+		SDL_FreeSurface(diamond_graphic);
+		
+		SDL_FreeSurface(platinum_graphic);
+		SDL_FreeSurface(gold_graphic);
+		SDL_FreeSurface(silver_graphic);
+		SDL_FreeSurface(coal_graphic);
+		
+		SDL_FreeSurface(spring_graphic);
+		SDL_FreeSurface(water_graphic);
+		SDL_FreeSurface(cave_in_graphic);
+	}
+		
+	// Free the rendered status lines.
+	for(int line = 0; line < STATUS_LINE_CACHE; line++)
+	{
+		SDL_FreeSurface(status_lines[line]);
+	}
+	
+	SDL_FreeSurface(status_panel);
 	
 	// Close out the fonts used in the HUD
 	TTF_CloseFont(status_font);
@@ -152,20 +221,34 @@ SDL_Objects::~SDL_Objects()
 // Displays the HUD
 void SDL_Objects::display_hud(PlayerData *player)
 {
+	Profile_Scope hud_scope(&profiler, PHASE_HUD);
+	
 	std::string temp_string;	// Used as a buffer for numerical values (int)
 	std::stringstream temp_stringstream;	// Used to convert the int to health string
 	
 	SDL_Rect hud_location;		// Stores where on the screen the HUD will be located.
 		hud_location.x = 0;
-		hud_location.y = 384;
+		hud_location.y = return_screen()->h - HUD_HEIGHT - origin_y;
 		hud_location.w = 720;
 		hud_location.h = 72;
 	
 	SDL_Rect hud_text;
 		hud_text.x = 250;
-		hud_text.y = 408;
+		hud_text.y = hud_location.y + 24;
 		hud_text.w = 550;
 		hud_text.h = 72;
+	
+	// The HUD sits at the bottom of the window, with black either side.
+	if(origin_x > 0)
+	{
+		SDL_Rect side;
+			side.x = 0;
+			side.y = view_height;
+			side.w = return_screen()->w;
+			side.h = HUD_HEIGHT;
+		
+		SDL_FillRect(return_screen(), &side, SDL_MapRGB(return_screen()->format, 0, 0, 0));
+	}
 		
 	apply_surface(hud_location.x, hud_location.y, hud_graphic, return_screen());
 
@@ -223,12 +306,9 @@ void SDL_Objects::display_hud(PlayerData *player)
 	apply_text((hud_location.x + 206), (hud_location.y + 80), temp_string.c_str(), news_font, return_screen());
 	temp_stringstream.str("");
 	
-	// Display the text buffer for the update screen.
-	for(int x = 0; x < 7; x++)
-	{
-		temp_string = return_status_text(x);
-		apply_text((hud_location.x + 250), (hud_location.y + (x * 15)), temp_string.c_str(), news_font, return_screen());
-	}
+	// Display the newsfeed, drawn again only if a line has been added.
+	update_status_panel();
+	apply_surface((hud_location.x + 250), hud_location.y, status_panel, return_screen());
 	
 	// Display whether the player has insurance or not.
 	if(player->get_has_insurance())
@@ -267,6 +347,61 @@ void SDL_Objects::display_hud(PlayerData *player)
 	}
 }
 
+// Whether x, y is a tile of the mine. A view bigger than the mine shows
+// dirt beyond it.
+static bool in_mine(int x, int y)
+{
+	return x >= 0 && y >= 0 && x < MINE_WIDTH && y < MINE_HEIGHT;
+}
+
+// The column at the left of the view. It keeps the player just left of
+// the centre until the right edge of the mine is in view. A view as
+// wide as the mine, or wider, stays put with the mine in its middle.
+int SDL_Objects::get_view_x(PlayerData *player, MineData *mine, bool &following)
+{
+	int half = view_columns / 2;
+	int player_x = player->get_location_x();
+	
+	if(view_columns >= mine->get_map_x() + 1)
+	{
+		return -(view_columns - (mine->get_map_x() + 1)) / 2;
+	}
+	else if(player_x > half && player_x < mine->get_map_x() - (half + 2))
+	{
+		following = true;
+		return player_x - (half - 1);
+	}
+	else if(player_x >= mine->get_map_x() - (half + 2))
+	{
+		return mine->get_map_x() - view_columns;
+	}
+	
+	return 0;
+}
+
+// The row at the top of the view, as get_view_x.
+int SDL_Objects::get_view_y(PlayerData *player, MineData *mine, bool &following)
+{
+	int half = view_rows / 2;
+	int player_y = player->get_location_y();
+	
+	if(view_rows >= mine->get_map_y() + 1)
+	{
+		return -(view_rows - (mine->get_map_y() + 1)) / 2;
+	}
+	else if(player_y > half + 1 && player_y < mine->get_map_y() - half)
+	{
+		following = true;
+		return player_y - half;
+	}
+	else if(player_y >= mine->get_map_y() - half)
+	{
+		return mine->get_map_y() - view_rows;
+	}
+	
+	return 0;
+}
+
 // Function to update the screen when in the mine.
 void SDL_Objects::update_mine_graphics(PlayerData *player, MineData *mine, direction way)
 {
@@ -276,78 +411,52 @@ void SDL_Objects::update_mine_graphics(PlayerData *player, MineData *mine, direc
     }
     else
     {
-        // Variables used for temporary storage of where the centre of the screen
-        // should be.
-        int mine_x = 0;
-        int mine_y = 0;
-	
-        // Determine if the playing area should be focused on the player or not.
-        if(player->get_location_x() > 8 && player->get_location_x() < (mine->get_map_x() - 10))
-        {
-            mine_x = player->get_location_x() - 7;
-        }
-        else if(player->get_location_x() >= (mine->get_map_x() - 10))
-        {
-		mine_x = (mine->get_map_x() - 16);
-        }
-	
-        if(player->get_location_y() > 5 && player->get_location_y() < (mine->get_map_y() - 4))
-        {
-            mine_y = player->get_location_y() - 4;
-        }
-        else if(player->get_location_y() >= (mine->get_map_y() - 4))
-        {
-            mine_y = (mine->get_map_y() - 8);
-        }
+        // Where the view is, following the player away from the edges.
+        bool following = false;
+        int mine_x = get_view_x(player, mine, following);
+        int mine_y = get_view_y(player, mine, following);
 		
         // Show the area of the screen that is to be shown.
-        // Below variables store position on the 48x48 grid.
+        // Below variables store position on the grid of tiles.
         int y_tile_position = 0;
         int x_tile_position = 0;
+        
+        // Tiles cut off at the bottom of the view stay out of the HUD.
+        SDL_Rect view;
+            view.x = 0;
+            view.y = 0;
+            view.w = return_screen()->w;
+            view.h = view_height;
+        
+        SDL_SetClipRect(return_screen(), &view);
+        
+        Profile_Scope background_scope(&profiler, PHASE_BACKGROUND);
 	
-        for(int y = mine_y; y < (mine_y + 8); y++)
+        for(int y = mine_y; y < (mine_y + view_rows); y++)
         {
-            for(int x = mine_x; x < (mine_x + 16); x++)
+            for(int x = mine_x; x < (mine_x + view_columns); x++)
             {
                 // Apply the appropriate graphic for the location.
-                if(mine->get_explored(x,y) == false)
+                if(!in_mine(x, y))
+                {
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_DIRT);
+                }
+                else if(mine->get_explored(x,y) == false)
                 {
                     // Apply everything as dirt if the player has no flashlight.
-                    if(player->get_has_flashlight() == false || mine->return_recently_found_countdown() > 0)
+                    if(player->get_has_flashlight() == false || particles.get_count(PARTICLE_PICKUP) > 0)
+                    {
+                        draw_tile(x_tile_position, y_tile_position, GRAPHIC_DIRT);
+                    }
+                    // Otherwise show where the flashlight caught something
+                    // (see MineData::update_hints).
+                    else if(mine->get_hinted(x,y))
                     {
-                        apply_surface(x_tile_position, y_tile_position, dirt_graphic, return_screen());
+                        draw_tile(x_tile_position, y_tile_position, GRAPHIC_HINT);
                     }
-                    // Otherwise occasionally hint where minerals are to the player.
                     else
                     {
-                        if((y + 2 > player->get_location_y()) && (y - 2 < player->get_location_y())
-                           && ((x + 2 > player->get_location_x()) && (x -2 < player->get_location_x()))
-                           && mine->return_recently_found_material() == NOTHING
-                           && ((mine->get_contents(x,y) == GRANITE)
-                               || (mine->get_contents(x,y) == SPRING)
-                               || (mine->get_contents(x,y) == CAVE_IN)
-                               || (mine->get_contents(x,y) == COAL)
-                               || (mine->get_contents(x,y) == SILVER)
-                               || (mine->get_contents(x,y) == GOLD)
-                               || (mine->get_contents(x,y) == PLATINUM
-                                   || (mine->get_contents(x,y) == DIAMOND))))
-                        {
-                            int random_number = 0;
-						
-                            random_number = rand() % 6;
-                            if(random_number == 5)
-                            {
-                                apply_surface(x_tile_position, y_tile_position, hint_graphic, return_screen());
-                            }
-                            else
-                            {
-                                apply_surface(x_tile_position, y_tile_position, dirt_graphic, return_screen());
-                            }
-                        }
-                        else
-                        {
-                            apply_surface(x_tile_position, y_tile_position, dirt_graphic, return_screen());
-                        }
+                        draw_tile(x_tile_position, y_tile_position, GRAPHIC_DIRT);
                     }
                 }
                 else if(mine->get_explored(x,y) == true
@@ -364,219 +473,157 @@ void SDL_Objects::update_mine_graphics(PlayerData *player, MineData *mine, direc
                         && mine->get_contents(x,y) != DYNAMITE
                         && mine->get_contents(x,y) != DIAMOND)
                 {
-                    apply_surface(x_tile_position, y_tile_position, explored_graphic, return_screen());
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_EXPLORED);
                 }		
                 else if(mine->get_explored(x,y) == true
                         && mine->get_contents(x,y) == ELEVATOR)
                 {
-                    apply_surface(x_tile_position, y_tile_position, elevator_graphic, return_screen());
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_ELEVATOR);
                 }
                 else if(mine->get_explored(x,y) == true
                         && mine->get_contents(x,y) == SHAFT)
                 {
-                    apply_surface(x_tile_position, y_tile_position, mineshaft_graphic, return_screen());
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_SHAFT);
                 }
                 else if(mine->get_explored(x,y) == true
                         && mine->get_contents(x,y) == GRANITE)
                 {
-                    apply_surface(x_tile_position, y_tile_position, granite_graphic, return_screen());
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_GRANITE);
                 }
                 else if(mine->get_explored(x,y) == true
                         && mine->get_contents(x,y) == CAVE_IN)
                 {
-                    apply_surface(x_tile_position, y_tile_position, cave_in_graphic, return_screen());
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_CAVE_IN);
                 }
                 else if(mine->get_explored(x,y) == true
                         && mine->get_contents(x,y) == SPRING)
                 {
-                    apply_surface(x_tile_position, y_tile_position, spring_graphic, return_screen());
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_SPRING);
                 }
                 else if(mine->get_explored(x,y) == true
                         && mine->get_contents(x,y) == WATER)
                 {
-                    apply_surface(x_tile_position, y_tile_position, water_graphic, return_screen());
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_WATER);
                 }
                 // The below else ifs come into effect if dynamite has uncovered minerals.
                 else if(mine->get_explored(x,y) == true
                         && mine->get_contents(x,y) == COAL)
                 {
-                    apply_surface(x_tile_position, y_tile_position, explored_graphic, return_screen());
-                    apply_surface(x_tile_position, y_tile_position, coal_graphic, return_screen());
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_EXPLORED);
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_COAL);
                 }
                 else if(mine->get_explored(x,y) == true
                         && mine->get_contents(x,y) == SILVER)
                 {
-                    apply_surface(x_tile_position, y_tile_position, explored_graphic, return_screen());
-                    apply_surface(x_tile_position, y_tile_position, silver_graphic, return_screen());
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_EXPLORED);
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_SILVER);
                 }
                 else if(mine->get_explored(x,y) == true
                         && mine->get_contents(x,y) == GOLD)
                 {
-                    apply_surface(x_tile_position, y_tile_position, explored_graphic, return_screen());
-                    apply_surface(x_tile_position, y_tile_position, gold_graphic, return_screen());
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_EXPLORED);
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_GOLD);
                 }
                 else if(mine->get_explored(x,y) == true
                         && mine->get_contents(x,y) == PLATINUM)
                 {
-                    apply_surface(x_tile_position, y_tile_position, explored_graphic, return_screen());
-                    apply_surface(x_tile_position, y_tile_position, platinum_graphic, return_screen());
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_EXPLORED);
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_PLATINUM);
                 }
                 else if(mine->get_explored(x,y) == true
                         && mine->get_contents(x,y) == DYNAMITE)
                 {
-                    apply_surface(x_tile_position, y_tile_position, explored_graphic, return_screen());
-                    apply_surface(x_tile_position, y_tile_position, dynamite_graphic, return_screen());				
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_EXPLORED);
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_DYNAMITE);				
                 }
                 else if(mine->get_explored(x,y) == true
                         && mine->get_contents(x,y) == DIAMOND)
                 {
-                    apply_surface(x_tile_position, y_tile_position, explored_graphic, return_screen());
-                    apply_surface(x_tile_position, y_tile_position, diamond_graphic, return_screen());						
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_EXPLORED);
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_DIAMOND);						
                 }
 			
                 // Applies the little miner dude on the screen.
                 if(x == player->get_location_x() && y == player->get_location_y())
                 {
-                    apply_surface(x_tile_position, y_tile_position, miner_graphic, return_screen());
+                    draw_tile(x_tile_position, y_tile_position, GRAPHIC_MINER);
                 }
 			
-                x_tile_position = x_tile_position + 48;
+                x_tile_position = x_tile_position + tile_size;
             }
             x_tile_position = 0;
-            y_tile_position = y_tile_position + 48;
+            y_tile_position = y_tile_position + tile_size;
         }
         
-        // Only display found minerals if the timer is higher than zero.
-        if(mine->return_recently_found_material() != NOTHING)
+        // Found minerals, debris and splashes go over the tiles.
+        if(particles.get_count() > 0)
         {
-            display_found_minerals(player, mine);
+            display_particles(mine_x * tile_size, mine_y * tile_size);
         }
         
+        SDL_SetClipRect(return_screen(), NULL);
     }
 }
 
-// Displays found minerals when the screen is stationary.
-void SDL_Objects::display_found_minerals(PlayerData *player, MineData *mine)
-{
-	// Variables used for temporary storage of where the centre of the screen
-	// should be.
-	int mine_x = 0;
-	int mine_y = 0;
-	
-	// Determine if the playing area should be focused on the player or not.
-	if(player->get_location_x() > 8 && player->get_location_x() < (mine->get_map_x() - 10))
-	{
-		mine_x = player->get_location_x() - 7;
-	}
-	else if(player->get_location_x() >= (mine->get_map_x() - 10))
-	{
-		mine_x = (mine->get_map_x() - 16);
-	}
-	
-	if(player->get_location_y() > 5 && player->get_location_y() < (mine->get_map_y() - 4))
-	{
-		mine_y = player->get_location_y() - 4;
-	}
-	else if(player->get_location_y() >= (mine->get_map_y() - 4))
-	{
-		mine_y = (mine->get_map_y() - 8);
-	}
-		
-	// Show the area of the screen that is to be shown.
-	// Below variables store position on the 48x48 grid.
-	int y_tile_position = 0;
-	int x_tile_position = 0;	
-
-	for(int y = mine_y; y < (mine_y + 11); y++)
-	{
-		for(int x = mine_x; x < (mine_x + 17); x++)
-		{	
-			if(x == mine->return_recently_found_x() && y == mine->return_recently_found_y())
-			{
-				if(mine->return_recently_found_material() == COAL)
-				{
-					apply_surface(x_tile_position,
-						y_tile_position - 96 + (mine->return_recently_found_countdown() * 4), coal_graphic, return_screen());
-				}
-				else if(mine->return_recently_found_material() == SILVER)
-				{
-					apply_surface(x_tile_position,
-						y_tile_position - 96 + (mine->return_recently_found_countdown() * 4), silver_graphic, return_screen());
-				}
-				else if(mine->return_recently_found_material() == GOLD)
-				{
-					apply_surface(x_tile_position,
-						y_tile_position - 96 + (mine->return_recently_found_countdown() * 4), gold_graphic, return_screen());
-				}
-				else if(mine->return_recently_found_material() == PLATINUM)
-				{
-					apply_surface(x_tile_position,
-						y_tile_position - 96 + (mine->return_recently_found_countdown() * 4), platinum_graphic, return_screen());
-				}
-				else if(mine->return_recently_found_material() == DIAMOND)
-				{
-					apply_surface(x_tile_position,
-						y_tile_position - 96 + (mine->return_recently_found_countdown() * 4), diamond_graphic, return_screen());
-				}				
-			}
-			x_tile_position += 48;
-		}
-	
-		x_tile_position = 0;
-		y_tile_position += 48;
-	}
-}	
-
 // Following four functions allow for tile to tile animation to occur within the mine.
 void SDL_Objects::animate_mine_graphics(PlayerData *player, MineData *mine, direction way)
 {
 	// Determine whether the graphics will be animated.
-	// Determine if the playing area should be focused on the player or not.
-	int mine_x = 0;
-	int mine_y = 0;
+	// The view only scrolls with the player while it's following them.
+	bool following_x = false;
+	bool following_y = false;
+	int mine_x = get_view_x(player, mine, following_x);
+	int mine_y = get_view_y(player, mine, following_y);
 	
 	// Booleans to determine whether movement should be animated.
-	bool animate_vert = false;
-	bool animate_horiz = false;
+	bool animate_vert = following_y && (way == UP || way == DOWN);
+	bool animate_horiz = following_x && (way == RIGHT || way == LEFT);
 	
-	if((player->get_location_x() >= 9 && player->get_location_x() < (mine->get_map_x() - 10)))
-	{
-		mine_x = player->get_location_x() - 7;
-		if((way == RIGHT || way == LEFT))
-		{
-			animate_horiz = true;
-		}
-	}
-	else if(player->get_location_x() >= (mine->get_map_x() - 10))
-	{
-		mine_x = (mine->get_map_x() - 16);
-	}
+	// Tiles cut off at the bottom of the view stay out of the HUD.
+	SDL_Rect view;
+		view.x = 0;
+		view.y = 0;
+		view.w = return_screen()->w;
+		view.h = view_height;
 	
-	if((player->get_location_y() > 5 && player->get_location_y() < (mine->get_map_y() - 4)))
-	{
-		mine_y = player->get_location_y() - 4;
-		if((way == UP || way == DOWN))
-		{
-			animate_vert = true;
-		}
-	}
-	else if(player->get_location_y() >= (mine->get_map_y() - 4))
-	{
-		mine_y = (mine->get_map_y() - 8);
-	}
+	SDL_SetClipRect(return_screen(), &view);
 		
 	// Blit the graphics.
 	display_background_layer(player, mine, way, animate_vert, animate_horiz, mine_x, mine_y);
 	display_sprite_layer(player, mine, way, animate_vert, animate_horiz, mine_x, mine_y);
-	if(mine->return_recently_found_material() != NOTHING)
+	if(particles.get_count() > 0)
 	{
-		display_found_minerals_animated(player, mine, way, animate_vert, animate_horiz, mine_x, mine_y);
-//		mine->count_recently_found();
+		// The layers are drawn half a tile along from mine_x, mine_y
+		// towards where the player came from.
+		int origin_x = mine_x * tile_size;
+		int origin_y = mine_y * tile_size;
+		
+		if(animate_horiz == true && way == LEFT)
+		{
+			origin_x += tile_size / 2;
+		}
+		else if(animate_horiz == true && way == RIGHT)
+		{
+			origin_x -= tile_size / 2;
+		}
+		
+		if(animate_vert == true && way == UP)
+		{
+			origin_y += tile_size / 2;
+		}
+		else if(animate_vert == true && way == DOWN)
+		{
+			origin_y -= tile_size / 2;
+		}
+		
+		display_particles(origin_x, origin_y);
 	}
+	
+	SDL_SetClipRect(return_screen(), NULL);
 
 	// Display the graphics.
 	display_hud(player);
-	SDL_Flip(return_screen());
+	flip_screen();
 	
 //	SDL_Delay(MINE_ANIMATION_WAIT);
 }
@@ -584,40 +631,46 @@ void SDL_Objects::animate_mine_graphics(PlayerData *player, MineData *mine, dire
 void SDL_Objects::display_background_layer(PlayerData *player, MineData *mine, direction way, bool animate_vert, bool animate_horiz,
 											int mine_x, int mine_y)
 {
+	Profile_Scope background_scope(&profiler, PHASE_BACKGROUND);
+	
 	int x_tile_position = 0;
 	int y_tile_position = 0;
 		
 	// Show the area of the screen that is to be shown.
-	// Below variables store position on the 48x48 grid.
+	// Below variables store position on the grid of tiles.
 	if(animate_vert == true && way == UP)
 	{	
-		y_tile_position = -24;
+		y_tile_position = -(tile_size / 2);
 	}
 	else if(animate_vert == true && way == DOWN)
 	{
-		y_tile_position = -24;
+		y_tile_position = -(tile_size / 2);
 		mine_y = mine_y - 1;
 	}
 	
 	if(animate_horiz == true && way == LEFT)
 	{		
-		x_tile_position = -24;
+		x_tile_position = -(tile_size / 2);
 	}
 	else if(animate_horiz == true && way == RIGHT)
 	{
-		x_tile_position = - 24;
+		x_tile_position = -(tile_size / 2);
 		mine_x = mine_x - 1;
 	}
 
 	// Apply the background layer
-	for(int y = mine_y; y < (mine_y + 11); y++)
+	for(int y = mine_y; y < (mine_y + view_rows + 1); y++)
 	{
-		for(int x = mine_x; x < (mine_x + 17); x++)
+		for(int x = mine_x; x < (mine_x + view_columns + 1); x++)
 		{
 			// Apply the appropriate graphic for the location.
-			if(mine->get_explored(x,y) == false)
+			if(!in_mine(x, y))
 			{
-				apply_surface(x_tile_position, y_tile_position, dirt_graphic, return_screen());	
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_DIRT);
+			}
+			else if(mine->get_explored(x,y) == false)
+			{
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_DIRT);	
 			}
 			else if(mine->get_explored(x,y) == true
 					&& mine->get_contents(x,y) != ELEVATOR 
@@ -632,7 +685,7 @@ void SDL_Objects::display_background_layer(PlayerData *player, MineData *mine, d
 					&& mine->get_contents(x,y) != PLATINUM
 					&& mine->get_contents(x,y) != DYNAMITE)
 			{
-				apply_surface(x_tile_position, y_tile_position, explored_graphic, return_screen());
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_EXPLORED);
 			}		
 			// Allow the elevator to vary with going up and down.
 			// Below code is sloppy, but since the elevator is a background item
@@ -642,140 +695,149 @@ void SDL_Objects::display_background_layer(PlayerData *player, MineData *mine, d
 					&& (player->get_location_x() != x && player->get_location_x() != y + 1)
 					&& animate_vert == true)
 			{
-				apply_surface(x_tile_position, y_tile_position, mineshaft_graphic, return_screen());
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_SHAFT);
 			}
 			else if(mine->get_explored(x,y) == true
 					&& mine->get_contents(x,y) == SHAFT)
 			{
-				apply_surface(x_tile_position, y_tile_position, mineshaft_graphic, return_screen());
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_SHAFT);
 			}
 			else if(mine->get_explored(x,y) == true
 					&& mine->get_contents(x,y) == GRANITE)
 			{
-				apply_surface(x_tile_position, y_tile_position, granite_graphic, return_screen());
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_GRANITE);
 			}
 			else if(mine->get_explored(x,y) == true
 					&& mine->get_contents(x,y) == CAVE_IN)
 			{
-				apply_surface(x_tile_position, y_tile_position, cave_in_graphic, return_screen());
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_CAVE_IN);
 			}
 			else if(mine->get_explored(x,y) == true
 					&& mine->get_contents(x,y) == SPRING)
 			{
-				apply_surface(x_tile_position, y_tile_position, spring_graphic, return_screen());
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_SPRING);
 			}
 			else if(mine->get_explored(x,y) == true
 					&& mine->get_contents(x,y) == WATER)
 			{
-				apply_surface(x_tile_position, y_tile_position, water_graphic, return_screen());
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_WATER);
 			}
 			// The below else ifs come into effect if dynamite has uncovered minerals.
 			else if(mine->get_explored(x,y) == true
 					&& mine->get_contents(x,y) == COAL)
 			{
-				apply_surface(x_tile_position, y_tile_position, explored_graphic, return_screen());
-				apply_surface(x_tile_position, y_tile_position, coal_graphic, return_screen());
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_EXPLORED);
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_COAL);
 			}
 			else if(mine->get_explored(x,y) == true
 					&& mine->get_contents(x,y) == SILVER)
 			{
-				apply_surface(x_tile_position, y_tile_position, explored_graphic, return_screen());
-				apply_surface(x_tile_position, y_tile_position, silver_graphic, return_screen());
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_EXPLORED);
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_SILVER);
 			}
 			else if(mine->get_explored(x,y) == true
 					&& mine->get_contents(x,y) == GOLD)
 			{
-				apply_surface(x_tile_position, y_tile_position, explored_graphic, return_screen());
-				apply_surface(x_tile_position, y_tile_position, gold_graphic, return_screen());
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_EXPLORED);
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_GOLD);
 			}
 			else if(mine->get_explored(x,y) == true
 					&& mine->get_contents(x,y) == PLATINUM)
 			{
-				apply_surface(x_tile_position, y_tile_position, explored_graphic, return_screen());
-				apply_surface(x_tile_position, y_tile_position, platinum_graphic, return_screen());
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_EXPLORED);
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_PLATINUM);
 			}
 			else if(mine->get_explored(x,y) == true
 					&& mine->get_contents(x,y) == DYNAMITE)
 			{
-				apply_surface(x_tile_position, y_tile_position, explored_graphic, return_screen());
-				apply_surface(x_tile_position, y_tile_position, dynamite_graphic, return_screen());				
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_EXPLORED);
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_DYNAMITE);				
 			}
 			else if(mine->get_explored(x,y) == true
 					&& mine->get_contents(x,y) == DIAMOND)
 			{
-				apply_surface(x_tile_position, y_tile_position, explored_graphic, return_screen());
-				apply_surface(x_tile_position, y_tile_position, diamond_graphic, return_screen());								
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_EXPLORED);
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_DIAMOND);								
 			}
-			x_tile_position += 48;
+			x_tile_position += tile_size;
 		}
-		if(animate_horiz == true){x_tile_position = -24;}
+		if(animate_horiz == true){x_tile_position = -(tile_size / 2);}
 		else{x_tile_position = 0;}
 
-		y_tile_position += 48;
+		y_tile_position += tile_size;
 	}
 }
 
 void SDL_Objects::display_sprite_layer(PlayerData *player, MineData *mine, direction way, bool animate_vert, bool animate_horiz,
 										int mine_x, int mine_y)
 {
+	Profile_Scope sprite_scope(&profiler, PHASE_SPRITES);
+	
 	int y_tile_position = 0;
 	int x_tile_position = 0;
 		
 	// Show the area of the screen that is to be shown.
-	// Below variables store position on the 48x48 grid.
+	// Below variables store position on the grid of tiles.
 	if(animate_vert == true && way == UP)
 	{
-		y_tile_position = -24;	
+		y_tile_position = -(tile_size / 2);	
 	}
 	else if(animate_vert == true && way == DOWN)
 	{
-		y_tile_position = -24;
+		y_tile_position = -(tile_size / 2);
 		mine_y = mine_y - 1;
 	}
 	
 	if(animate_horiz == true && way == LEFT)
 	{
-		x_tile_position = -24;
+		x_tile_position = -(tile_size / 2);
 	}
 	else if(animate_horiz == true && way == RIGHT)
 	{
-		x_tile_position = -24;
+		x_tile_position = -(tile_size / 2);
 		mine_x = mine_x - 1;
 	}
 	
 	// Apply the sprite layer.
-	for(int y = mine_y; y < (mine_y + 11); y++)
+	for(int y = mine_y; y < (mine_y + view_rows + 1); y++)
 	{
-		for(int x = mine_x; x < (mine_x + 17); x++)
+		for(int x = mine_x; x < (mine_x + view_columns + 1); x++)
 		{		
+			// Nothing but dirt lies beyond the edge of the mine.
+			if(!in_mine(x, y))
+			{
+				x_tile_position += tile_size;
+				continue;
+			}
+			
 			// Apply the elevator on screen.
 			if(mine->get_explored(x,y) == true
 					&& mine->get_contents(x,y) == ELEVATOR
 					&& way == UP
 					&& (player->get_location_x() == x && player->get_location_y() == y))
 			{
-					apply_surface(x_tile_position, y_tile_position, mineshaft_graphic, return_screen());
-					apply_surface(x_tile_position, y_tile_position + 24, elevator_graphic, return_screen());
+					draw_tile(x_tile_position, y_tile_position, GRAPHIC_SHAFT);
+					draw_tile(x_tile_position, y_tile_position + tile_size / 2, GRAPHIC_ELEVATOR);
 			}
 			else if(mine->get_explored(x,y) == true
 					&& mine->get_contents(x,y) == ELEVATOR
 					&& way == DOWN
 					&& (player->get_location_x() == x && player->get_location_y() == y))
 			{
-					apply_surface(x_tile_position, y_tile_position, mineshaft_graphic, return_screen());
-					apply_surface(x_tile_position, y_tile_position - 24, elevator_graphic, return_screen());				
+					draw_tile(x_tile_position, y_tile_position, GRAPHIC_SHAFT);
+					draw_tile(x_tile_position, y_tile_position - tile_size / 2, GRAPHIC_ELEVATOR);				
 			}
 			else if(mine->get_explored(x,y) == true
 					&& mine->get_contents(x,y) == ELEVATOR
 					&& (player->get_location_x() != x && player->get_location_y() != y))
 			{
-				apply_surface(x_tile_position, y_tile_position, elevator_graphic, return_screen());
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_ELEVATOR);
 			}
 			else if(mine->get_explored(x,y) == true
 					&& mine->get_contents(x,y) == ELEVATOR
 					&& animate_horiz == false)
 			{
-				apply_surface(x_tile_position, y_tile_position, elevator_graphic, return_screen());				
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_ELEVATOR);				
 			}
 			
 			// Applies the little miner dude on the screen.
@@ -785,11 +847,11 @@ void SDL_Objects::display_sprite_layer(PlayerData *player, MineData *mine, direc
 			{
 				if(which_animation())
 				{
-					apply_surface(x_tile_position, y_tile_position + 24, miner_down_graphic_1, return_screen());
+					draw_tile(x_tile_position, y_tile_position + tile_size / 2, GRAPHIC_MINER_DOWN_1);
 				}
 				else 
 				{
-					apply_surface(x_tile_position, y_tile_position + 24, miner_down_graphic_2, return_screen());
+					draw_tile(x_tile_position, y_tile_position + tile_size / 2, GRAPHIC_MINER_DOWN_2);
 				}
 			}
 			else if(x == player->get_location_x() && y == player->get_location_y() 
@@ -799,11 +861,11 @@ void SDL_Objects::display_sprite_layer(PlayerData *player, MineData *mine, direc
 			{
 				if(which_animation())
 				{
-					apply_surface(x_tile_position, y_tile_position - 24, miner_down_graphic_1, return_screen());
+					draw_tile(x_tile_position, y_tile_position - tile_size / 2, GRAPHIC_MINER_DOWN_1);
 				}
 				else 
 				{
-					apply_surface(x_tile_position, y_tile_position - 24, miner_down_graphic_2, return_screen());
+					draw_tile(x_tile_position, y_tile_position - tile_size / 2, GRAPHIC_MINER_DOWN_2);
 				}
 			}
 			else if(x == player->get_location_x() && y == player->get_location_y() 
@@ -812,11 +874,11 @@ void SDL_Objects::display_sprite_layer(PlayerData *player, MineData *mine, direc
 			{
 				if(which_animation())
 				{
-					apply_surface(x_tile_position + 24, y_tile_position, miner_down_graphic_1, return_screen());
+					draw_tile(x_tile_position + tile_size / 2, y_tile_position, GRAPHIC_MINER_DOWN_1);
 				}
 				else 
 				{
-					apply_surface(x_tile_position + 24, y_tile_position, miner_down_graphic_2, return_screen());
+					draw_tile(x_tile_position + tile_size / 2, y_tile_position, GRAPHIC_MINER_DOWN_2);
 				}
 			}
 			else if(x == player->get_location_x() && y == player->get_location_y()
@@ -825,94 +887,92 @@ void SDL_Objects::display_sprite_layer(PlayerData *player, MineData *mine, direc
 			{
 				if(which_animation())
 				{
-					apply_surface(x_tile_position - 24, y_tile_position, miner_down_graphic_1, return_screen());
+					draw_tile(x_tile_position - tile_size / 2, y_tile_position, GRAPHIC_MINER_DOWN_1);
 				}
 				else 
 				{
-					apply_surface(x_tile_position - 24, y_tile_position, miner_down_graphic_2, return_screen());
+					draw_tile(x_tile_position - tile_size / 2, y_tile_position, GRAPHIC_MINER_DOWN_2);
 				}
 			}
 			else if(x == player->get_location_x() && y == player->get_location_y())
 			{
-				apply_surface(x_tile_position, y_tile_position, miner_move_graphic, return_screen());
+				draw_tile(x_tile_position, y_tile_position, GRAPHIC_MINER_MOVE);
 			}
 									
-			x_tile_position += 48;
+			x_tile_position += tile_size;
 		}
 		
-		if(animate_horiz == true) { x_tile_position = -24; }
+		if(animate_horiz == true) { x_tile_position = -(tile_size / 2); }
 		else { x_tile_position = 0; }
 
-		y_tile_position += 48;
+		y_tile_position += tile_size;
 	}
 }
 
-void SDL_Objects::display_found_minerals_animated(PlayerData *player, MineData *mine, direction way,
-											bool animate_vert, bool animate_horiz, int mine_x, int mine_y)
+// Draw the live particles, with origin_x, origin_y the pixel of the
+// mine, at tile_size, that is at the top left of the screen.
+void SDL_Objects::display_particles(int origin_x, int origin_y)
 {
-	int y_tile_position = 0;
-	int x_tile_position = 0;
-		
-	// Show the area of the screen that is to be shown.
-	// Below variables store position on the 48x48 grid.
-	if(animate_vert == true && way == UP)
-	{	
-		y_tile_position = -24;
-	}
-	else if(animate_vert == true && way == DOWN)
-	{
-		y_tile_position = -24;
-		mine_y = mine_y - 1;
-	}
+	Profile_Scope particle_scope(&profiler, PHASE_PARTICLES);
 	
-	if(animate_horiz == true && way == LEFT)
-	{		
-		x_tile_position = -24;
-	}
-	else if(animate_horiz == true && way == RIGHT)
-	{
-		x_tile_position = -24;
-		mine_x = mine_x - 1;
-	}
-
-	for(int y = mine_y; y < (mine_y + 11); y++)
+	Uint32 debris_colour = SDL_MapRGB(return_screen()->format, 110, 85, 60);
+	Uint32 splash_colour = SDL_MapRGB(return_screen()->format, 70, 130, 220);
+	
+	for(int index = 0; index < particles.get_count(); index++)
 	{
-		for(int x = mine_x; x < (mine_x + 17); x++)
-		{	
-			if(x == mine->return_recently_found_x() && y == mine->return_recently_found_y())
+		const Particle &particle = particles.get_particle(index);
+		
+		// Particles move in the mine's pixels at PARTICLE_TILE_SIZE.
+		int screen_x = (particle.x * tile_size / PARTICLE_TILE_SIZE) - origin_x;
+		int screen_y = (particle.y * tile_size / PARTICLE_TILE_SIZE) - origin_y;
+		int size = particle.size * tile_size / PARTICLE_TILE_SIZE;
+		
+		if(size < 1)
+		{
+			size = 1;
+		}
+		
+		if(particle.kind == PARTICLE_PICKUP)
+		{
+			if(particle.material == COAL)
 			{
-				if(mine->return_recently_found_material() == COAL)
-				{
-					apply_surface(x_tile_position,
-						y_tile_position - 96 + (mine->return_recently_found_countdown() * 4), coal_graphic, return_screen());
-				}
-				else if(mine->return_recently_found_material() == SILVER)
-				{
-					apply_surface(x_tile_position,
-						y_tile_position - 96 + (mine->return_recently_found_countdown() * 4), silver_graphic, return_screen());
-				}
-				else if(mine->return_recently_found_material() == GOLD)
-				{
-					apply_surface(x_tile_position,
-						y_tile_position - 96 + (mine->return_recently_found_countdown() * 4), gold_graphic, return_screen());
-				}
-				else if(mine->return_recently_found_material() == PLATINUM)
-				{
-					apply_surface(x_tile_position,
-						y_tile_position - 96 + (mine->return_recently_found_countdown() * 4), platinum_graphic, return_screen());
-				}
-				else if(mine->return_recently_found_material() == DIAMOND)
-				{
-					apply_surface(x_tile_position,
-						y_tile_position - 96 + (mine->return_recently_found_countdown() * 4), diamond_graphic, return_screen());
-				}					
-			}				
-			x_tile_position += 48;
+				draw_tile(screen_x, screen_y, GRAPHIC_COAL);
+			}
+			else if(particle.material == SILVER)
+			{
+				draw_tile(screen_x, screen_y, GRAPHIC_SILVER);
+			}
+			else if(particle.material == GOLD)
+			{
+				draw_tile(screen_x, screen_y, GRAPHIC_GOLD);
+			}
+			else if(particle.material == PLATINUM)
+			{
+				draw_tile(screen_x, screen_y, GRAPHIC_PLATINUM);
+			}
+			else if(particle.material == DIAMOND)
+			{
+				draw_tile(screen_x, screen_y, GRAPHIC_DIAMOND);
+			}
+		}
+		// Debris and drops are small enough to be plain squares.
+		else if(screen_x >= 0 && screen_y >= 0)
+		{
+			SDL_Rect square;
+				square.x = screen_x - (size / 2);
+				square.y = screen_y - (size / 2);
+				square.w = size;
+				square.h = size;
+			
+			if(particle.kind == PARTICLE_DEBRIS)
+			{
+				SDL_FillRect(return_screen(), &square, debris_colour);
+			}
+			else
+			{
+				SDL_FillRect(return_screen(), &square, splash_colour);
+			}
 		}
-	
-		if(animate_horiz == true) { x_tile_position = -24; }
-		else { x_tile_position = 0; }
-			y_tile_position += 48;
 	}
 }
 
@@ -931,32 +991,354 @@ bool SDL_Objects::which_animation()
 	}
 }
 
-// Updates the text in the HUD and clears out older information.
-void SDL_Objects::update_status_text(std::string new_text)
+// Flip the screen, ending the profiler's frame.
+void SDL_Objects::flip_screen()
+{
+	if(profiler.is_overlay_visible())
+	{
+		display_profiler_overlay();
+	}
+	
+	{
+		Profile_Scope flip_scope(&profiler, PHASE_FLIP);
+		SDL_Flip(return_screen());
+	}
+	
+	profiler.end_frame();
+}
+
+// Draw the per-phase timings in the top left corner of the screen.
+void SDL_Objects::display_profiler_overlay()
 {
-	for(int x = 6; x >= 0; x--)
+	std::stringstream temp_stringstream;
+	
+	// Don't count the overlay's own blits and text against the frame.
+	profiler.set_counting(false);
+	
+	SDL_Rect backdrop;
+		backdrop.x = origin_x;
+		backdrop.y = origin_y;
+		backdrop.w = 250;
+		backdrop.h = 15 * (PHASE_COUNT + 2) + 4;
+	
+	SDL_FillRect(return_screen(), &backdrop, SDL_MapRGB(return_screen()->format, 0, 0, 0));
+	
+	apply_text(4, 2, "phase          p50 ms     p99 ms", news_font, return_screen());
+	
+	temp_stringstream << std::fixed << std::setprecision(2);
+	
+	for(int phase = 0; phase < PHASE_COUNT; phase++)
 	{
-		player_status[x + 1] = player_status[x];
+		temp_stringstream.str("");
+		temp_stringstream << Frame_Profiler::get_phase_name((profile_phase)phase);
+		apply_text(4, 17 + (phase * 15), temp_stringstream.str(), news_font, return_screen());
+		
+		temp_stringstream.str("");
+		temp_stringstream << (profiler.get_percentile((profile_phase)phase, 50) / 1000000.0);
+		apply_text(120, 17 + (phase * 15), temp_stringstream.str(), news_font, return_screen());
+		
+		temp_stringstream.str("");
+		temp_stringstream << (profiler.get_percentile((profile_phase)phase, 99) / 1000000.0);
+		apply_text(185, 17 + (phase * 15), temp_stringstream.str(), news_font, return_screen());
 	}
 	
-	player_status[0] = new_text;
+	temp_stringstream.str("");
+	temp_stringstream << "blits/frame: " << profiler.get_average_blits()
+		<< "   text/frame: " << profiler.get_average_text();
+	apply_text(4, 17 + (PHASE_COUNT * 15), temp_stringstream.str(), news_font, return_screen());
+	
+	profiler.set_counting(true);
 }
 
-// Provides the text within player_status
+// Access to the frame profiler.
+Frame_Profiler *SDL_Objects::return_profiler()
+{
+	return &profiler;
+}
+
+// Updates the text in the HUD and clears out older information.
+void SDL_Objects::update_status_text(std::string new_text)
+{
+	status_log.add(new_text);
+}
+
+// Fills each %d in the text from the numbers when it's shown.
+void SDL_Objects::update_status_text(std::string new_text, int arg0, int arg1)
+{
+	status_log.add(status_log.intern(new_text), arg0, arg1);
+}
+
+// Provides the line of the newsfeed that is array lines back from the newest.
 std::string SDL_Objects::return_status_text(int array)
 {
-	return player_status[array];
+	if(status_log.get_end() - status_first <= (unsigned int)array)
+	{
+		return "";
+	}
+	
+	return status_log.get_text(status_log.get_end() - 1 - array);
 }
 
-// Clear out the text in the HUD.
+// Clear out the text in the HUD. The scrollback still has it.
 void SDL_Objects::clear_status_text()
 {
-	for(int x = 6; x >= 0; x--)
+	status_first = status_log.get_end();
+}
+
+// A log line rendered in the news font, from the cache if it's there.
+SDL_Surface *SDL_Objects::get_status_line(unsigned int sequence)
+{
+	int slot = sequence & (STATUS_LINE_CACHE - 1);
+	
+	if(status_lines[slot] == NULL || status_line_sequence[slot] != sequence)
+	{
+		Profile_Scope text_scope(&profiler, PHASE_TEXT);
+		profiler.count_text();
+		
+		SDL_FreeSurface(status_lines[slot]);
+		
+		SDL_Color text_color;
+			text_color.r = 255;
+			text_color.g = 255;
+			text_color.b = 255;
+		
+		status_lines[slot] = TTF_RenderText_Blended(news_font, status_log.get_text(sequence).c_str(), text_color);
+		status_line_sequence[slot] = sequence;
+	}
+	
+	return status_lines[slot];
+}
+
+// Draw the newsfeed again over its piece of the HUD graphic, if a line
+// has been added or the HUD cleared since it was last drawn.
+void SDL_Objects::update_status_panel()
+{
+	if(status_panel != NULL && status_panel_end == status_log.get_end() && status_panel_first == status_first)
 	{
-		player_status[x] = "";
+		return;
+	}
+	
+	SDL_Rect panel_area;
+		panel_area.x = 250;
+		panel_area.y = 0;
+		panel_area.w = hud_graphic->w - 250;
+		panel_area.h = hud_graphic->h;
+	
+	if(status_panel == NULL)
+	{
+		SDL_PixelFormat *format = return_screen()->format;
+		
+		status_panel = SDL_CreateRGBSurface(SDL_SWSURFACE, panel_area.w, panel_area.h, format->BitsPerPixel,
+											format->Rmask, format->Gmask, format->Bmask, format->Amask);
+		
+		if(status_panel == NULL)
+		{
+			return;
+		}
+	}
+	
+	SDL_FillRect(status_panel, NULL, SDL_MapRGB(status_panel->format, 0, 0, 0));
+	SDL_BlitSurface(hud_graphic, &panel_area, status_panel, NULL);
+	
+	for(int line = 0; line < STATUS_HUD_LINES; line++)
+	{
+		if(status_log.get_end() - status_first <= (unsigned int)line)
+		{
+			break;
+		}
+		
+		apply_surface(0, line * STATUS_LINE_HEIGHT, get_status_line(status_log.get_end() - 1 - line), status_panel);
+	}
+	
+	status_panel_end = status_log.get_end();
+	status_panel_first = status_first;
+}
+
+// Draw a page of the status log over the mine, oldest at the top,
+// ending lines_back lines before the newest.
+int SDL_Objects::display_status_log(int lines_back)
+{
+	int kept = status_log.get_end() - status_log.get_begin();
+	int furthest_back = kept - STATUS_PAGE_LINES;
+	
+	if(furthest_back < 0)
+	{
+		furthest_back = 0;
+	}
+	
+	if(lines_back > furthest_back)
+	{
+		lines_back = furthest_back;
+	}
+	else if(lines_back < 0)
+	{
+		lines_back = 0;
+	}
+	
+	SDL_Rect backdrop;
+		backdrop.x = 0;
+		backdrop.y = 0;
+		backdrop.w = return_screen()->w;
+		backdrop.h = view_height;
+	
+	SDL_FillRect(return_screen(), &backdrop, SDL_MapRGB(return_screen()->format, 0, 0, 0));
+	
+	unsigned int page_end = status_log.get_end() - lines_back;
+	unsigned int page_begin = status_log.get_begin();
+	
+	if(page_end - page_begin > (unsigned int)STATUS_PAGE_LINES)
+	{
+		page_begin = page_end - STATUS_PAGE_LINES;
+	}
+	
+	int y = 4;
+	
+	for(unsigned int sequence = page_begin; sequence != page_end; sequence++)
+	{
+		apply_to_window(8, y, get_status_line(sequence));
+		y += STATUS_LINE_HEIGHT;
+	}
+	
+	return furthest_back;
+}
+
+// Turns the game's events into status text and animations.
+void SDL_Objects::handle_event(const Game_Event &event)
+{
+	switch(event.type)
+	{
+		case EVENT_GRANITE_CHIPPED:
+			update_status_text("You chip away at the granite!");
+			break;
+		case EVENT_GRANITE_BLOCKED:
+			update_status_text("You can't dig through granite!");
+			break;
+		case EVENT_SPRING_HIT:
+			update_status_text("Oh no, a spring!");
+			particles.spawn_splash(event.x, event.y, 8);
+			break;
+		case EVENT_CAVE_IN:
+			update_status_text("Ow, a cave-in!");
+			particles.spawn_debris(event.x, event.y, 8);
+			break;
+		case EVENT_COLLAPSE:
+			update_status_text("You hear the mine collapse nearby!");
+			break;
+		case EVENT_MINERAL_FOUND:
+			// Begin the animation of finding the item.
+			particles.spawn_pickup(event.x, event.y, event.material);
+			
+			if(event.material == COAL)
+			{
+				update_status_text("You found some coal!");
+			}
+			else if(event.material == SILVER)
+			{
+				update_status_text("You found some silver!");
+			}
+			else if(event.material == GOLD)
+			{
+				update_status_text("You found some gold!");
+			}
+			else if(event.material == PLATINUM)
+			{
+				update_status_text("You found some platinum!");
+			}
+			else if(event.material == DIAMOND)
+			{
+				update_status_text("You found the diamond!");
+			}
+			break;
+		case EVENT_BUCKET_USED:
+			update_status_text("You use your bucket!");
+			particles.spawn_splash(event.x, event.y, 6);
+			break;
+		case EVENT_DROWNING:
+			update_status_text("You start to drown!");
+			particles.spawn_splash(event.x, event.y, 4);
+			break;
+		case EVENT_INSURANCE_CLAIMED:
+			update_status_text("Thank goodness for insurance!");
+			break;
+		case EVENT_INSURANCE_EXPIRED:
+			update_status_text("Your insurance has run out.");
+			break;
+		case EVENT_ELEVATOR_TO_BOTTOM:
+			update_status_text("To the depths!");
+			break;
+		case EVENT_ELEVATOR_TO_TOP:
+			update_status_text("Daylight!");
+			break;
+		case EVENT_ELEVATOR_REFUSED:
+			update_status_text("You can't do that now!");
+			break;
+		case EVENT_AUTOPILOT_ROUTE:
+			update_status_text("Off you go: %d steps, about $%d.", event.amount, event.value);
+			break;
+		case EVENT_AUTOPILOT_NO_ROUTE:
+			update_status_text("You can't see a way there!");
+			break;
+		case EVENT_AUTOPILOT_NO_TIP:
+			update_status_text("Buy a tip at the tavern first!");
+			break;
+		case EVENT_AUTOPILOT_ARRIVED:
+			update_status_text("You've arrived!");
+			break;
+		case EVENT_AUTOPILOT_STOPPED:
+			update_status_text("You can't go any further!");
+			break;
+		case EVENT_DYNAMITE_LIT:
+			update_status_text("You light the dynamite. RUN!");
+			break;
+		case EVENT_DYNAMITE_EXPLODED:
+			particles.spawn_debris(event.x, event.y, 16);
+			break;
+		case EVENT_NO_DYNAMITE:
+			update_status_text("You don't have any dynamite!");
+			break;
+		case EVENT_BLAST_INJURY:
+			update_status_text("You were too close to the blast!");
+			break;
+		case EVENT_ITEM_OWNED:
+			if(event.amount == ITEM_DYNAMITE)
+			{
+				update_status_text("You can't carry any more dynamite!");
+			}
+			else
+			{
+				update_status_text("You already own that!");
+			}
+			break;
+		case EVENT_ITEM_UNAFFORDABLE:
+			update_status_text("You can't afford that!");
+			break;
+		case EVENT_INSURANCE_UNAFFORDABLE:
+			update_status_text("You can't afford insurance!");
+			break;
+		case EVENT_INSURANCE_MAXED:
+			update_status_text("You already have insurance for max turns!");
+			break;
+		case EVENT_TIP_UNAFFORDABLE:
+			update_status_text("You can't afford that tip!");
+			break;
+		default:
+			// Nothing to show for the rest.
+			break;
 	}
 }
 
+// Move the particles on a frame.
+void SDL_Objects::step_particles()
+{
+	particles.step();
+}
+
+// Returns true while any particles are still moving.
+bool SDL_Objects::particles_active()
+{
+	return particles.get_count() > 0;
+}
+
 // Returns the pointer to the main screen.
 SDL_Surface* SDL_Objects::return_screen()
 {
@@ -973,13 +1355,60 @@ void SDL_Objects::apply_surface(int x, int y, SDL_Surface *source, SDL_Surface *
 	offset.x = x;
 	offset.y = y;
 	
+	// The screens are drawn in the layout, centred in the window.
+	if(destination == screen)
+	{
+		offset.x += origin_x;
+		offset.y += origin_y;
+	}
+	
 	// Blit the surface.
 	SDL_BlitSurface(source, NULL, destination, &offset);
+	profiler.count_blit();
+}
+
+// Draw a surface on the window, not the layout.
+void SDL_Objects::apply_to_window(int x, int y, SDL_Surface *source)
+{
+	SDL_Rect offset;
+		offset.x = x;
+		offset.y = y;
+	
+	SDL_BlitSurface(source, NULL, return_screen(), &offset);
+	profiler.count_blit();
+}
+
+// Draw a tile of the mine, already scaled in the atlas.
+void SDL_Objects::draw_tile(int x, int y, mine_tile tile)
+{
+	tile_atlas.draw(tile, x, y, return_screen());
+	profiler.count_blit();
+}
+
+// Show a part of the layout on the window.
+void SDL_Objects::update_rect(int x, int y, int w, int h)
+{
+	SDL_UpdateRect(return_screen(), x + origin_x, y + origin_y, w, h);
+}
+
+// Clear the window to black, outside the layout as well as in it.
+void SDL_Objects::clear_screen()
+{
+	SDL_FillRect(return_screen(), NULL, SDL_MapRGB(return_screen()->format, 0, 0, 0));
+}
+
+// Height of the mine's view, above the HUD.
+int SDL_Objects::get_view_height()
+{
+	return view_height;
 }
 
 // Allows a line of text via SDL_ttf to be applied to a surface
 void SDL_Objects::apply_text(int x, int y, std::string input_string, TTF_Font *font, SDL_Surface *destination)
 {
+	Profile_Scope text_scope(&profiler, PHASE_TEXT);
+	profiler.count_text();
+	
 	// Make a temporary surface to hold the text.
 	SDL_Surface *temp_surface;
 	
@@ -999,6 +1428,9 @@ void SDL_Objects::apply_text(int x, int y, std::string input_string, TTF_Font *f
 // Allows a colored line of text to be applied to a surface
 void SDL_Objects::apply_colored_text(int x, int y, int r, int g, int b, std::string input_string, TTF_Font *font, SDL_Surface *destination)
 {
+	Profile_Scope text_scope(&profiler, PHASE_TEXT);
+	profiler.count_text();
+	
 	// Make a temporary surface to hold the text.
 	SDL_Surface *temp_surface;
 	
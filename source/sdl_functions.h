@@ -35,10 +35,49 @@
 #include "SDL_ttf/SDL_ttf.h"
 
 #include "timer.h"
+#include "profiler.h"
+#include "game_events.h"
+#include "particles.h"
+#include "status_log.h"
+#include "asset_preloader.h"
+#include "tile_atlas.h"
 
 class PlayerData;
 class MineData;
 
+// The town's screens, the menus and the HUD are drawn at this size,
+// centred in the window if it's bigger. The mine's view fills the
+// window above the HUD, with as many tiles as it takes.
+const int LAYOUT_WIDTH = 768;
+const int LAYOUT_HEIGHT = 480;
+const int HUD_HEIGHT = 96;
+
+// Sizes a mine tile can be drawn at, in pixels. The graphics are drawn
+// at DEFAULT_TILE_SIZE.
+const int DEFAULT_TILE_SIZE = 48;
+const int MIN_TILE_SIZE = 16;
+const int MAX_TILE_SIZE = 128;
+
+// The window, and the size of a mine tile in it. Chosen with the
+// --resolution and --tile options.
+struct Display_Settings
+{
+	int width;
+	int height;
+	int tile_size;
+};
+
+// Status log lines shown in the HUD's newsfeed and on each page of the
+// scrollback, and the pixels between them.
+const int STATUS_HUD_LINES = 7;
+const int STATUS_PAGE_LINES = 25;
+const int STATUS_LINE_HEIGHT = 15;
+
+// Rendered status log lines kept, by sequence number. A power of two,
+// and more than a page, so paging back and forth only renders the
+// lines that come into view.
+const int STATUS_LINE_CACHE = 64;
+
 // Below enumeration allows to specify which direction is being travelled in the above animation function.
 enum direction
 {
@@ -50,7 +89,8 @@ enum direction
 };
 
 // Class to hold data pertaining to SDL
-class SDL_Objects
+// Listens to the game's events to update the HUD and start animations.
+class SDL_Objects : public Game_Event_Sink
 {
 	private:
 		SDL_Surface *screen;	// Main screen in program.
@@ -94,51 +134,148 @@ class SDL_Objects
 		SDL_Surface *water_graphic;
 		SDL_Surface *cave_in_graphic;
 		
+		// The above are only loaded once the start screen is done with.
+		bool graphics_loaded;
+		
+		// The mine's tiles at tile_size, built by load_graphics.
+		Tile_Atlas tile_atlas;
+		int tile_size;
+		
+		// Tiles across and down the mine's view, counting any cut off
+		// at the right and bottom, and the height of the view in pixels.
+		int view_columns;
+		int view_rows;
+		int view_height;
+		
+		// Where the layout the screens are drawn in is in the window.
+		int origin_x;
+		int origin_y;
+		
+		// Draw a tile of the mine at x, y in the window.
+		void draw_tile(int x, int y, mine_tile tile);
+		
+		// Draw a surface at x, y in the window, not the layout.
+		void apply_to_window(int x, int y, SDL_Surface *source);
+		
+		// The mine tile at the top left of the view. Away from the mine's
+		// edges the view follows the player, and following is set.
+		int get_view_x(PlayerData *player, MineData *mine, bool &following);
+		int get_view_y(PlayerData *player, MineData *mine, bool &following);
+		
 		TTF_Font *status_font;		// Font used in display of user's health and money.
 		
 		TTF_Font *news_font;		// Font used in the HUD newsfeed.
 		
-		std::string player_status[8];	// Updates the player's status in the HUD.
+		// Everything the player has been told this session.
+		Status_Log status_log;
+		unsigned int status_first;		// First entry the HUD shows since it was cleared.
+		
+		// Rendered log lines, in slot sequence % STATUS_LINE_CACHE.
+		SDL_Surface *status_lines[STATUS_LINE_CACHE];
+		unsigned int status_line_sequence[STATUS_LINE_CACHE];
+		
+		// The HUD's newsfeed over its piece of the HUD graphic. Only
+		// drawn again when a line is added or the HUD is cleared.
+		SDL_Surface *status_panel;
+		unsigned int status_panel_end;
+		unsigned int status_panel_first;
+		
+		// A log line rendered in the news font, from the cache if it's there.
+		SDL_Surface *get_status_line(unsigned int sequence);
+		
+		// Draw the newsfeed again if it has changed.
+		void update_status_panel();
 		
 		// Keeps tabs whether the player wants to quit the game or to menu.
 		bool quitSDL;
 		bool quit_to_menu;
+		
+		// Times the drawing phases of each frame in the mine.
+		Frame_Profiler profiler;
+		
+		// Minerals rising out of where they were found, debris and splashes.
+		Particle_Pool particles;
 				
 	public:	
-		SDL_Objects();		
+		SDL_Objects(const Display_Settings &settings);		
 		
 		~SDL_Objects();
+		
+		// Load the HUD and mine graphics, preloaded while the start
+		// screen was shown. Needed before the town; does nothing once
+		// they're loaded.
+		void load_graphics();
 
 		// Function to update and display the HUD
 		void display_hud(PlayerData *player);
 		
 		// Function to update the screen when in the mine.
 		void update_mine_graphics(PlayerData *player, MineData *mine, direction way);
-			void display_found_minerals(PlayerData *player, MineData *mine);
 		void animate_mine_graphics(PlayerData *player, MineData *mine, direction way);
 			void display_background_layer(PlayerData *player, MineData *mine, direction way, bool animate_vert, bool animate_horiz,int mine_x, int mine_y);
 			void display_sprite_layer(PlayerData *player, MineData *mine, direction way, bool animate_vert, bool animate_horiz, int mine_x, int mine_y);
-			void display_found_minerals_animated(PlayerData *player, MineData *mine, direction way, bool animate_vert, bool animate_horiz, int mine_x, int mine_y);
+		
+		// Draw the live particles, with origin_x, origin_y the pixel of the
+		// mine that is at the top left of the screen.
+		void display_particles(int origin_x, int origin_y);
 		
 		// Function to tell which animation graphic to use
 		bool which_animation();
 		
-		// Updates the text in the HUD and clears out older information.
+		// Flip the screen, ending the profiler's frame.
+		// Draws the profiler overlay first if it is visible.
+		void flip_screen();
+		
+		// Draw the per-phase timings in the top left corner of the screen.
+		void display_profiler_overlay();
+		
+		// Access to the frame profiler.
+		Frame_Profiler *return_profiler();
+		
+		// Adds a line to the status log, which the HUD shows the newest of.
+		// The second form fills each %d in the text from the numbers.
 		void update_status_text(std::string new_text);
+		void update_status_text(std::string new_text, int arg0, int arg1);
 		
-		// Provides the text within player_status
+		// Provides the line of the HUD's newsfeed that is array lines
+		// back from the newest.
 		std::string return_status_text(int array);
 		
-		// Clear out the text in the HUD.
+		// Clear out the text in the HUD. The scrollback still has it.
 		void clear_status_text();
 		
+		// Draw a page of the status log over the mine, ending lines_back
+		// lines before the newest. Returns how far back it can go.
+		int display_status_log(int lines_back);
+		
+		// Turns the game's events into status text and animations.
+		void handle_event(const Game_Event &event);
+		
+		// Move the particles on a frame.
+		void step_particles();
+		
+		// Returns true while any particles are still moving.
+		bool particles_active();
+		
 		// Function to set a pointer to *screen
 		void set_screen(SDL_Surface *screen);
 		
 		// Return the location of *screen
 		SDL_Surface *return_screen();
 		
+		// Show a part of the layout that has been drawn on, as
+		// SDL_UpdateRect does for the window.
+		void update_rect(int x, int y, int w, int h);
+		
+		// Clear the whole window, for a screen that doesn't cover the
+		// parts outside the layout.
+		void clear_screen();
+		
+		// Height of the mine's view, above the HUD.
+		int get_view_height();
+		
 		// Allows an instance of SDL_Surface to be applied to another surface.
+		// On the screen, x and y are in the layout.
 		void apply_surface(int x, int y, SDL_Surface *source, SDL_Surface *destination);
 		
 		// Allows a line of text via SDL_ttf to be applied to a . Used in store.
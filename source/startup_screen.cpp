@@ -31,13 +31,20 @@
 #include "sdl_functions.h"
 #include "classes.h"
 #include "timer.h"
+#include "trace.h"
 #include "startup_screen.h"
 #include "save_load.h"
+#include "save_slot_menu.h"
 #include "high_scores.h"
 #include "instructions.h"
 
 void startup_screen(PlayerData *player, MineData *mine, SDL_Objects *sdl)
 {
+	Trace_Zone zone("startup_screen", TRACE_SCREEN);
+	
+	// The screen is drawn in the layout, so clear whatever's around it.
+	sdl->clear_screen();
+
 	// Create the store object to store data in.
 	Start_Screen screen_data;
 	
@@ -99,7 +106,9 @@ void startup_screen(PlayerData *player, MineData *mine, SDL_Objects *sdl)
 		{
 			if(selection.return_vert() == 0)
 			{
-				// Start a new game.				
+				// Start a new game, in a new mine from its seed.
+				mine->randomize_mine();
+				
 				sdl->set_quit_to_menu(false);
 				exit = true;
 				
@@ -107,12 +116,33 @@ void startup_screen(PlayerData *player, MineData *mine, SDL_Objects *sdl)
 			}
 			else if(selection.return_vert() == 1)
 			{
-				// Load a previously saved game.
-				load_game(mine, player);
+				// Load a previously saved game from the slot the player
+				// picks, or start a new one if there isn't one there.
+				int slot = choose_save_slot(sdl, false);
+				bool loaded = false;
 				
-				sdl->set_quit_to_menu(false);
-				exit = true;
+				if(slot == SLOT_CHOICE_AUTOSAVE)
+				{
+					loaded = load_game(mine, player);
+				}
+				else if(slot != SLOT_CHOICE_NONE)
+				{
+					loaded = load_game(mine, player, slot);
+				}
+				
+				// Backing out of the slots goes back to the menu.
+				if(slot != SLOT_CHOICE_NONE)
+				{
+					if(!loaded)
+					{
+						mine->randomize_mine();
+					}
+					
+					sdl->set_quit_to_menu(false);
+					exit = true;
+				}
 				
+				update_screen = true;
 				SDL_Delay(sdl->ENTER_WAIT);
 			}
 			else if(selection.return_vert() == 2)
@@ -151,16 +181,16 @@ void startup_screen(PlayerData *player, MineData *mine, SDL_Objects *sdl)
 
 Start_Screen::Start_Screen()
 {
-	background = IMG_Load("./Graphics/start_screen/background.png");
-	miner_sdl_logo = IMG_Load("./Graphics/start_screen/miner_sdl_logo.png");
-	new_game_button = IMG_Load("./Graphics/start_screen/new_game.png");
-	load_game_button = IMG_Load("./Graphics/start_screen/load_game.png");
-	high_score_button = IMG_Load("./Graphics/start_screen/high_score.png");
-	instructions_button = IMG_Load("./Graphics/start_screen/instructions.png");
-    copyright_info = IMG_Load("./Graphics/start_screen/copyright.png");
-	exit_game_button = IMG_Load("./Graphics/start_screen/exit_game.png");
+	background = load_image("graphics/start_screen/background.png");
+	miner_sdl_logo = load_image("graphics/start_screen/miner_sdl_logo.png");
+	new_game_button = load_image("graphics/start_screen/new_game.png");
+	load_game_button = load_image("graphics/start_screen/load_game.png");
+	high_score_button = load_image("graphics/start_screen/high_score.png");
+	instructions_button = load_image("graphics/start_screen/instructions.png");
+    copyright_info = load_image("graphics/start_screen/copyright.png");
+	exit_game_button = load_image("graphics/start_screen/exit_game.png");
 	
-	arrow = IMG_Load("./Graphics/start_screen/arrow.png");
+	arrow = load_image("graphics/start_screen/arrow.png");
 }
 
 Start_Screen::~Start_Screen()
@@ -212,7 +242,7 @@ void Start_Screen::animate_arrow_up(SDL_Objects *sdl, Selection_Arrow *selection
         
 		sdl->apply_surface(selection->return_arrow_x(), temp, arrow, sdl->return_screen());
 		
-        SDL_UpdateRect(sdl->return_screen(), 410, 200, 70, 280);
+        sdl->update_rect(410, 200, 70, 280);
 		SDL_Delay(sdl->MENU_ANIMATION_WAIT);
 	}	
 }
@@ -236,7 +266,7 @@ void Start_Screen::animate_arrow_down(SDL_Objects *sdl, Selection_Arrow *selecti
         
 		sdl->apply_surface(selection->return_arrow_x(), temp, arrow, sdl->return_screen());
 		
-        SDL_UpdateRect(sdl->return_screen(), 410, 200, 70, 280);
+        sdl->update_rect(410, 200, 70, 280);
 		SDL_Delay(sdl->MENU_ANIMATION_WAIT);
 	}		
 }
@@ -0,0 +1,112 @@
+/*
+ status_log.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Everything the player has been told this session.
+*/
+
+#include <sstream>
+
+#include "status_log.h"
+
+Status_Log::Status_Log()
+{
+	end = 0;
+}
+
+// The number for a message's text, adding it if it's new.
+int Status_Log::intern(const std::string &text)
+{
+	std::map<std::string, int>::iterator found = message_numbers.find(text);
+
+	if(found != message_numbers.end())
+	{
+		return found->second;
+	}
+
+	int message = messages.size();
+
+	messages.push_back(text);
+	message_numbers[text] = message;
+
+	return message;
+}
+
+// Add an entry, overwriting the oldest once the log is full.
+void Status_Log::add(int message, int arg0, int arg1)
+{
+	Status_Entry &entry = entries[end & (STATUS_LOG_CAPACITY - 1)];
+
+	entry.message = message;
+	entry.args[0] = arg0;
+	entry.args[1] = arg1;
+
+	end++;
+}
+
+void Status_Log::add(const std::string &text)
+{
+	add(intern(text));
+}
+
+unsigned int Status_Log::get_begin()
+{
+	if(end < (unsigned int)STATUS_LOG_CAPACITY)
+	{
+		return 0;
+	}
+
+	return end - STATUS_LOG_CAPACITY;
+}
+
+unsigned int Status_Log::get_end()
+{
+	return end;
+}
+
+// The text of an entry, with its numbers filled in.
+std::string Status_Log::get_text(unsigned int sequence)
+{
+	const Status_Entry &entry = entries[sequence & (STATUS_LOG_CAPACITY - 1)];
+	const std::string &text = messages[entry.message];
+
+	// Most messages have nothing to fill in.
+	if(text.find("%d") == std::string::npos)
+	{
+		return text;
+	}
+
+	std::stringstream filled;
+	int arg = 0;
+
+	for(unsigned int index = 0; index < text.size(); index++)
+	{
+		if(text[index] == '%' && index + 1 < text.size() && text[index + 1] == 'd' && arg < STATUS_ARGS)
+		{
+			filled << entry.args[arg];
+			arg++;
+			index++;
+		}
+		else
+		{
+			filled << text[index];
+		}
+	}
+
+	return filled.str();
+}
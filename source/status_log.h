@@ -0,0 +1,85 @@
+/*
+ status_log.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Everything the player has been told this session, for the HUD's
+ newsfeed and the scrollback.
+
+ Each message's text is kept once and referred to by its number, so
+ an entry is only the number and up to STATUS_ARGS numbers to put in
+ place of each %d in the text. Entries are kept in a fixed ring, the
+ oldest making way once it is full.
+
+ Every entry added gets the next sequence number, which never goes
+ back, so code that draws the log can tell which lines it already has.
+ Nothing here uses SDL.
+*/
+
+#ifndef STATUS_LOG
+#define STATUS_LOG
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Entries kept. A power of two, so a sequence number finds its slot
+// with a mask.
+const int STATUS_LOG_CAPACITY = 4096;
+
+// Numbers each entry can fill in.
+const int STATUS_ARGS = 2;
+
+struct Status_Entry
+{
+	int message;
+	int args[STATUS_ARGS];
+};
+
+class Status_Log
+{
+	private:
+		// The text of every message, by number.
+		std::vector<std::string> messages;
+		std::map<std::string, int> message_numbers;
+
+		Status_Entry entries[STATUS_LOG_CAPACITY];
+
+		// Sequence number the next entry will get. The entries kept are
+		// get_begin() to end - 1.
+		unsigned int end;
+
+	public:
+		Status_Log();
+
+		// The number for a message's text, adding it if it's new.
+		int intern(const std::string &text);
+
+		// Add an entry. Any %d in the message's text is filled from the args.
+		void add(int message, int arg0 = 0, int arg1 = 0);
+		void add(const std::string &text);
+
+		// Sequence numbers of the oldest entry kept and of the next entry.
+		unsigned int get_begin();
+		unsigned int get_end();
+
+		// The text of an entry, with its numbers filled in.
+		// sequence has to be from get_begin() to get_end() - 1.
+		std::string get_text(unsigned int sequence);
+};
+
+#endif
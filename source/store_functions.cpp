@@ -30,10 +30,14 @@
 #include "sdl_functions.h"
 #include "classes.h"
 #include "store_functions.h"
+#include "economy.h"
 #include "timer.h"
+#include "trace.h"
 
 void store(PlayerData *player, SDL_Objects *sdl)
 {
+	Trace_Zone zone("store", TRACE_SCREEN);
+
 	// Create the store object to store data in.
 	Store_Objects store_data;
 	
@@ -116,104 +120,32 @@ void store(PlayerData *player, SDL_Objects *sdl)
 			if(store_selection.return_horiz() == 0 && store_selection.return_vert() == 0)
 			{
 				// Purchase the shovel.
-				if(!player->get_has_shovel() && player->get_money() >= 250)
-				{
-					player->change_has_shovel(true);
-					player->change_money(-250);
-				}
-				else if(player->get_has_shovel())
-				{
-					sdl->update_status_text("You already own that!");
-				}
-				else
-				{
-					sdl->update_status_text("You can't afford that!");
-				}
+				buy_item(player, ITEM_SHOVEL);
 			}
 			else if(store_selection.return_horiz() == 1 && store_selection.return_vert() == 0)
 			{
 				// Purchase the pickaxe.
-				if(!player->get_has_axe() && player->get_money() >= 200)
-				{
-					player->change_has_axe(true);
-					player->change_money(-200);
-				}
-				else if(player->get_has_axe())
-				{
-					sdl->update_status_text("You already own that!");
-				}
-				else
-				{
-					sdl->update_status_text("You can't afford that!");
-				}
+				buy_item(player, ITEM_AXE);
 			}	
 			else if(store_selection.return_horiz() == 2 && store_selection.return_vert() == 0)
 			{
 				// Purchase the bucket.
-				if(!player->get_has_bucket() && player->get_money() >= 250)
-				{
-					player->change_has_bucket(true);
-					player->change_money(-250);
-				}
-				else if(player->get_has_bucket())
-				{
-					sdl->update_status_text("You already own that!");
-				}
-				else
-				{
-					sdl->update_status_text("You can't afford that!");
-				}
+				buy_item(player, ITEM_BUCKET);
 			}
 			else if(store_selection.return_horiz() == 0 && store_selection.return_vert() == 1)
 			{
 				// Purchase dynamite.
-				if(!player->get_has_dynamite() && player->get_money() >= 500)
-				{
-					player->change_has_dynamite(true);
-					player->change_money(-500);
-				}
-				else if(player->get_has_dynamite())
-				{
-					sdl->update_status_text("You already own that!");
-				}
-				else
-				{
-					sdl->update_status_text("You can't afford that!");
-				}
+				buy_item(player, ITEM_DYNAMITE);
 			}
 			else if(store_selection.return_horiz() == 1 && store_selection.return_vert() == 1)
 			{
 				// Purchase the flashlight.
-				if(!player->get_has_flashlight() && player->get_money() >= 300)
-				{
-					player->change_has_flashlight(true);
-					player->change_money(-300);
-				}
-				else if(player->get_has_flashlight())
-				{
-					sdl->update_status_text("You already own that!");
-				}
-				else
-				{
-					sdl->update_status_text("You can't afford that!");
-				}
+				buy_item(player, ITEM_FLASHLIGHT);
 			}
 			else if(store_selection.return_horiz() == 2 && store_selection.return_vert() == 1)
 			{
 				// Purchase the hard hat.
-				if(!player->get_has_hardhat() && player->get_money() >= 200)
-				{
-					player->change_has_hardhat(true);
-					player->change_money(-200);
-				}
-				else if(player->get_has_hardhat())
-				{
-					sdl->update_status_text("You already own that!");
-				}				
-				else
-				{
-					sdl->update_status_text("You can't afford that!");
-				}
+				buy_item(player, ITEM_HARDHAT);
 			}
 			else if(store_selection.return_vert() == 2)
 			{
@@ -249,22 +181,22 @@ void store(PlayerData *player, SDL_Objects *sdl)
 Store_Objects::Store_Objects()
 {
 	// Background graphic for the store.
-	store_graphic = IMG_Load("./Graphics/store/store.png");
+	store_graphic = load_image("graphics/store/store.png");
 	
 	// Graphic for the selection box.
-	selection_box = IMG_Load("./Graphics/store/selection_box.png");
+	selection_box = load_image("graphics/store/selection_box.png");
 	
 	// Individiual items' graphics.
-	shovel_graphic = IMG_Load("./Graphics/store/shovel.png");
-	pickaxe_graphic = IMG_Load("./Graphics/store/pickaxe.png");
-	bucket_graphic = IMG_Load("./Graphics/store/bucket.png");
-	dynamite_graphic = IMG_Load("./Graphics/store/dynamite.png");
-	flashlight_graphic = IMG_Load("./Graphics/store/flashlight.png");
-	hardhat_graphic = IMG_Load("./Graphics/store/hardhat.png");
+	shovel_graphic = load_image("graphics/store/shovel.png");
+	pickaxe_graphic = load_image("graphics/store/pickaxe.png");
+	bucket_graphic = load_image("graphics/store/bucket.png");
+	dynamite_graphic = load_image("graphics/store/dynamite.png");
+	flashlight_graphic = load_image("graphics/store/flashlight.png");
+	hardhat_graphic = load_image("graphics/store/hardhat.png");
 	
 	// Fonts used in the shop.
-	header_font = TTF_OpenFont("./Fonts/DejaVuSans-Bold.ttf", 28);
-	display_font = TTF_OpenFont("./Fonts/DejaVuSans-Bold.ttf", 20);
+	header_font = open_font("Fonts/DejaVuSans-Bold.ttf", 28);
+	display_font = open_font("Fonts/DejaVuSans-Bold.ttf", 20);
 }
 
 Store_Objects::~Store_Objects()
@@ -36,12 +36,18 @@
 #include "sdl_functions.h"
 #include "classes.h"
 #include "tavern.h"
+#include "economy.h"
 #include "timer.h"
+#include "trace.h"
 #include "endgame_screens.h"
 #include "high_scores.h"
+#include "autosave.h"
+#include "game_statistics.h"
 
 void tavern(PlayerData *player, MineData *mine, SDL_Objects *sdl)
 {
+	Trace_Zone zone("tavern", TRACE_SCREEN);
+
 	// Initialize the tavern class object.
 	Tavern_Objects tavern_data;
 	
@@ -102,7 +108,7 @@ void tavern(PlayerData *player, MineData *mine, SDL_Objects *sdl)
 			{
 				// Let the player try to see Mimi
 				tavern_data.update_tavern_graphics_no_overlay(sdl, player, &tavern_arrow);
-				if(tavern_data.see_mimi(player, sdl, mine))
+				if(tavern_data.see_mimi(player, sdl))
 				{
 					exit = true;
 					sdl->set_quit_to_menu(true);
@@ -115,14 +121,9 @@ void tavern(PlayerData *player, MineData *mine, SDL_Objects *sdl)
 			else if(tavern_arrow.return_vert() == 1)
 			{
 				// Let the player try to get a cheap hint.
-				if(player->get_money() >= 250)
-				{	
-					player->change_money(-250);
-					tavern_data.get_tip(player, mine, sdl, CHEAP);
-				}
-				else
+				if(buy_tip(player, CHEAP))
 				{
-					sdl->update_status_text("You can't afford that tip!");
+					tavern_data.get_tip(player, mine, sdl, CHEAP);
 				}
 				
 				update_screen = true;
@@ -130,29 +131,19 @@ void tavern(PlayerData *player, MineData *mine, SDL_Objects *sdl)
 			else if(tavern_arrow.return_vert() == 2)
 			{
 				// Let the player try to get a medium hint.
-				if(player->get_money() >= 750)
+				if(buy_tip(player, GOOD))
 				{
-					player->change_money(-750);
 					tavern_data.get_tip(player, mine, sdl, GOOD);
 				}
-				else
-				{
-					sdl->update_status_text("You can't afford that tip!");
-				}
 				
 				update_screen = true;
 			}
 			else if(tavern_arrow.return_vert() == 3)
 			{
 				// Let the player try to get the best tip
-				if(player->get_money() >= 1500)
-				{	
-					player->change_money(-1500);
-					tavern_data.get_tip(player, mine, sdl, BEST);
-				}
-				else
+				if(buy_tip(player, BEST))
 				{
-					sdl->update_status_text("You can't afford that tip!");
+					tavern_data.get_tip(player, mine, sdl, BEST);
 				}
 				
 				update_screen = true;
@@ -183,7 +174,7 @@ void tavern(PlayerData *player, MineData *mine, SDL_Objects *sdl)
 		if(update_screen)
 		{
 			tavern_data.update_tavern_graphics(sdl, player, &tavern_arrow);	
-			SDL_UpdateRect(sdl->return_screen(), 500, 0, 70, 380);
+			sdl->update_rect(500, 0, 70, 380);
 			sdl->display_hud(player);
 			SDL_Flip(sdl->return_screen());
 		}
@@ -195,34 +186,34 @@ void tavern(PlayerData *player, MineData *mine, SDL_Objects *sdl)
 Tavern_Objects::Tavern_Objects()
 {
 	// Background graphic for the tavern.
-	tavern_graphic = IMG_Load("./Graphics/tavern/tavern_screen.png");
+	tavern_graphic = load_image("graphics/tavern/tavern_screen.png");
 	
 	// Individual buttons for the tavern options.
-	see_mimi_button = IMG_Load("./Graphics/tavern/see_mimi_button.png");
-	tavern_transparency = IMG_Load("./Graphics/tavern/tavern_transparency.png");
-	cheap_tip_button = IMG_Load("./Graphics/tavern/cheap_tip_button.png");
-	good_tip_button = IMG_Load("./Graphics/tavern/good_tip_button.png");
-	best_tip_button = IMG_Load("./Graphics/tavern/best_tip_button.png");
-	exit_tavern_button = IMG_Load("./Graphics/tavern/exit_tavern.png");
+	see_mimi_button = load_image("graphics/tavern/see_mimi_button.png");
+	tavern_transparency = load_image("graphics/tavern/tavern_transparency.png");
+	cheap_tip_button = load_image("graphics/tavern/cheap_tip_button.png");
+	good_tip_button = load_image("graphics/tavern/good_tip_button.png");
+	best_tip_button = load_image("graphics/tavern/best_tip_button.png");
+	exit_tavern_button = load_image("graphics/tavern/exit_tavern.png");
 	
 	// Pointing arrow for the menu.
-	arrow_graphic = IMG_Load("./Graphics/tavern/arrow.png");
+	arrow_graphic = load_image("graphics/tavern/arrow.png");
 	
 	// Load the minimap used in the tips.
-	minimap = IMG_Load("./Graphics/tavern/cheat_map.png");
-	minimap_big_overlay = IMG_Load("./Graphics/tavern/large_overlay.png");
-	minimap_medium_overlay = IMG_Load("./Graphics/tavern/medium_overlay.png");
-	minimap_small_overlay = IMG_Load("./Graphics/tavern/small_overlay.png");
-	minimap_explored_area = IMG_Load("./Graphics/tavern/explored_pixel.png");
+	minimap = load_image("graphics/tavern/cheat_map.png");
+	minimap_big_overlay = load_image("graphics/tavern/large_overlay.png");
+	minimap_medium_overlay = load_image("graphics/tavern/medium_overlay.png");
+	minimap_small_overlay = load_image("graphics/tavern/small_overlay.png");
+	minimap_explored_area = load_image("graphics/tavern/explored_pixel.png");
 	
 	// Mimi graphics.
-	mimi_happy = IMG_Load("./Graphics/tavern/mimi_happy.png");
-	mimi_sad = IMG_Load("./Graphics/tavern/mimi_unimpressed.png");
-	mimi_talk_window = IMG_Load("./Graphics/tavern/mimi_talk_window.png");
+	mimi_happy = load_image("graphics/tavern/mimi_happy.png");
+	mimi_sad = load_image("graphics/tavern/mimi_unimpressed.png");
+	mimi_talk_window = load_image("graphics/tavern/mimi_talk_window.png");
 	
 	// Load the fonts.
-	header_font = TTF_OpenFont("./Fonts/DejaVuSans-Bold.ttf", 28);
-	display_font = TTF_OpenFont("./Fonts/DejaVuSans-Bold.ttf", 20);
+	header_font = open_font("Fonts/DejaVuSans-Bold.ttf", 28);
+	display_font = open_font("Fonts/DejaVuSans-Bold.ttf", 20);
 }
 
 Tavern_Objects::~Tavern_Objects()
@@ -364,7 +355,7 @@ void Tavern_Objects::animate_arrow_up(SDL_Objects *sdl, Selection_Arrow *selecti
         sdl->apply_surface(576, 256, exit_tavern_button, sdl->return_screen());
 
         sdl->apply_surface(selection->return_arrow_x(), temp, arrow_graphic, sdl->return_screen());
-		SDL_UpdateRect(sdl->return_screen(), 515, 0, 55, 380);
+		sdl->update_rect(515, 0, 55, 380);
 		SDL_Delay(sdl->MENU_ANIMATION_WAIT);
 	}
 }
@@ -392,14 +383,14 @@ void Tavern_Objects::animate_arrow_down(SDL_Objects *sdl, Selection_Arrow *selec
 
 		sdl->apply_surface(selection->return_arrow_x(), temp, arrow_graphic, sdl->return_screen());
 
-		SDL_UpdateRect(sdl->return_screen(), 515, 0, 55, 380);
+		sdl->update_rect(515, 0, 55, 380);
 		SDL_Delay(sdl->MENU_ANIMATION_WAIT);
 	}
 }
 	
 // Functions that respond to player actions.
 // Return true if the player wins the game.
-bool Tavern_Objects::see_mimi(PlayerData *player, SDL_Objects *sdl, MineData *mine)
+bool Tavern_Objects::see_mimi(PlayerData *player, SDL_Objects *sdl)
 {	
 	srand( time(NULL) );		// Seed the random number generator.
 								// Used for Mimi's responses to the player.
@@ -505,7 +496,9 @@ bool Tavern_Objects::see_mimi(PlayerData *player, SDL_Objects *sdl, MineData *mi
 		wait_for_enter(sdl);
 
 		// Show the ending screen, followed by the high score then quit to menu.
-		display_ending(sdl, player, mine);
+		get_game_statistics()->finish_game(player, GAME_WON);
+		get_autosave()->end_game();
+		display_ending(sdl, player);
 		display_high_scores(sdl, player, true);
 		
 		exit = true;
@@ -521,7 +514,9 @@ bool Tavern_Objects::see_mimi(PlayerData *player, SDL_Objects *sdl, MineData *mi
 		wait_for_enter(sdl);
 		
 		// Show the ending screen, followed by the high score then quit to menu.
-		display_ending(sdl, player, mine);
+		get_game_statistics()->finish_game(player, GAME_WON);
+		get_autosave()->end_game();
+		display_ending(sdl, player);
 		display_high_scores(sdl, player, true);
 		
 		exit = true;
@@ -539,8 +534,10 @@ bool Tavern_Objects::see_mimi(PlayerData *player, SDL_Objects *sdl, MineData *mi
 
 void Tavern_Objects::get_tip(PlayerData *player, MineData *mine, SDL_Objects *sdl, tip_amount tip)
 {
+	make_tip_region(player, mine, tip);
+	
 	show_map(mine, sdl);
-	display_tip(mine, sdl, tip);
+	display_tip(player, sdl, tip);
 		
 	sdl->display_hud(player);	
 	SDL_Flip(sdl->return_screen());
@@ -576,42 +573,23 @@ void Tavern_Objects::show_map(MineData *mine, SDL_Objects *sdl)
 }
 
 // Display the tip on the map. 
-void Tavern_Objects::display_tip(MineData *mine, SDL_Objects *sdl, tip_amount tip)
+void Tavern_Objects::display_tip(PlayerData *player, SDL_Objects *sdl, tip_amount tip)
 {
+	// The map shows each tile as 2x2 pixels, to the right of the menu.
+	int x_position = 192 + (player->get_tip_x() * 2);
+	int y_position = player->get_tip_y() * 2;
+	
 	if(tip == CHEAP)
 	{
-		if(mine->get_diamond_x() <= 96 && mine->get_diamond_y() <= 96)
-		{
-			sdl->apply_surface(192, 0, minimap_big_overlay, sdl->return_screen());
-		}
-		else if(mine->get_diamond_x() <= 96 && mine->get_diamond_y() > 96)
-		{
-			sdl->apply_surface(192, 192, minimap_big_overlay, sdl->return_screen());
-		}
-		else if(mine->get_diamond_x() > 96 && mine->get_diamond_y() <= 96)
-		{
-			sdl->apply_surface(384, 0, minimap_big_overlay, sdl->return_screen());
-		}
-		else if(mine->get_diamond_x() > 96 && mine->get_diamond_y() > 96)
-		{
-			sdl->apply_surface(384, 192, minimap_big_overlay, sdl->return_screen());
-		}	
+		sdl->apply_surface(x_position, y_position, minimap_big_overlay, sdl->return_screen());
 	}
 	else if(tip == GOOD)
 	{
-		int random_area_x = 0;
-		int random_area_y = 0;
-		
-		srand( time(NULL) );		// Seed the random number generator.
-		
-		random_area_x = rand() % 24;
-		random_area_y = rand() % 48;
-		
-		sdl->apply_surface(192 + ((mine->get_diamond_x() * 2) - random_area_x), ((mine->get_diamond_y() * 2) - random_area_y), minimap_medium_overlay, sdl->return_screen());
+		sdl->apply_surface(x_position, y_position, minimap_medium_overlay, sdl->return_screen());
 	}
 	else if(tip == BEST)
 	{
-		sdl->apply_surface(192 + ((mine->get_diamond_x() * 2) - 3), ((mine->get_diamond_y() * 2) - 3), minimap_small_overlay, sdl->return_screen());
+		sdl->apply_surface(x_position, y_position, minimap_small_overlay, sdl->return_screen());
 	}
 }
 
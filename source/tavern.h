@@ -32,14 +32,7 @@
 #include "SDL/SDL.h"
 #include "classes.h"
 #include "sdl_functions.h"
-
-// Enumerations for the amount of tip chosen.
-enum tip_amount
-{
-	CHEAP,
-	GOOD,
-	BEST
-};
+#include "economy.h"
 
 // The main function for the tavern
 void tavern(PlayerData *player, MineData *mine, SDL_Objects *sdl);
@@ -86,14 +79,14 @@ class Tavern_Objects
 		void animate_arrow_down(SDL_Objects *sdl, Selection_Arrow *selection);
 		
 		// Functions that respond to player actions.
-		bool see_mimi(PlayerData *player, SDL_Objects *sdl, MineData *mine);
+		bool see_mimi(PlayerData *player, SDL_Objects *sdl);
 		void get_tip(PlayerData *player, MineData *mine, SDL_Objects *sdl, tip_amount tip);
 
 		// Show the player the map of where the diamond is.
 		void show_map(MineData *mine, SDL_Objects *sdl);
 
 		// Display the tip on the map. 
-		void display_tip(MineData *mine, SDL_Objects *sdl, tip_amount tip);
+		void display_tip(PlayerData *player, SDL_Objects *sdl, tip_amount tip);
 		
 		// Function that waits for the player to press enter.
 		void wait_for_enter(SDL_Objects *sdl);
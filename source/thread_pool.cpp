@@ -0,0 +1,177 @@
+/*
+ thread_pool.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ A work-stealing thread pool for the headless tools.
+*/
+
+#include <cstddef>
+
+#include "thread_pool.h"
+
+// Starts the threads. A count of 0 uses one per core.
+Thread_Pool::Thread_Pool(int thread_count)
+{
+	if(thread_count <= 0)
+	{
+		thread_count = std::thread::hardware_concurrency();
+	}
+
+	if(thread_count <= 0)
+	{
+		thread_count = 1;
+	}
+
+	this->thread_count = thread_count;
+	queues = new Worker_Queue[thread_count];
+
+	current_function = NULL;
+	generation = 0;
+	active_workers = 0;
+	stopping = false;
+
+	for(int worker = 0; worker < thread_count; worker++)
+	{
+		threads.push_back(std::thread(&Thread_Pool::worker_loop, this, worker));
+	}
+}
+
+Thread_Pool::~Thread_Pool()
+{
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		stopping = true;
+	}
+
+	start_condition.notify_all();
+
+	for(int worker = 0; worker < thread_count; worker++)
+	{
+		threads[worker].join();
+	}
+
+	delete [] queues;
+}
+
+int Thread_Pool::get_thread_count()
+{
+	return thread_count;
+}
+
+// Run every task, returning once they have all finished.
+void Thread_Pool::run(int task_count, const Task_Function &function)
+{
+	// Deal the tasks out in turn so each worker starts with a fair share.
+	for(int task = 0; task < task_count; task++)
+	{
+		Worker_Queue &queue = queues[task % thread_count];
+
+		std::lock_guard<std::mutex> lock(queue.queue_mutex);
+		queue.tasks.push_back(task);
+	}
+
+	std::unique_lock<std::mutex> lock(pool_mutex);
+
+	current_function = &function;
+	active_workers = thread_count;
+	generation++;
+
+	start_condition.notify_all();
+
+	// Every worker has to check in as idle before the function can go
+	// out of scope, not just every task to have been taken.
+	while(active_workers > 0)
+	{
+		done_condition.wait(lock);
+	}
+
+	current_function = NULL;
+}
+
+// Take a task from the back of a worker's own queue, or steal one from
+// the front of another's.
+bool Thread_Pool::take_task(int worker, int &task)
+{
+	{
+		Worker_Queue &own = queues[worker];
+		std::lock_guard<std::mutex> lock(own.queue_mutex);
+
+		if(!own.tasks.empty())
+		{
+			task = own.tasks.back();
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+
+	for(int offset = 1; offset < thread_count; offset++)
+	{
+		Worker_Queue &victim = queues[(worker + offset) % thread_count];
+		std::lock_guard<std::mutex> lock(victim.queue_mutex);
+
+		if(!victim.tasks.empty())
+		{
+			task = victim.tasks.front();
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void Thread_Pool::worker_loop(int worker)
+{
+	int seen_generation = 0;
+
+	while(true)
+	{
+		const Task_Function *function;
+
+		{
+			std::unique_lock<std::mutex> lock(pool_mutex);
+
+			while(!stopping && generation == seen_generation)
+			{
+				start_condition.wait(lock);
+			}
+
+			if(stopping)
+			{
+				return;
+			}
+
+			seen_generation = generation;
+			function = current_function;
+		}
+
+		int task;
+
+		while(take_task(worker, task))
+		{
+			(*function)(task, worker);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex);
+			active_workers--;
+		}
+
+		done_condition.notify_one();
+	}
+}
@@ -0,0 +1,84 @@
+/*
+ thread_pool.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ A work-stealing thread pool for the headless tools.
+
+ Tasks are numbered 0 to task_count - 1 and dealt out evenly to each
+ worker's own queue. A worker takes from the back of its own queue and,
+ once that is empty, steals from the front of the others, so uneven
+ tasks (short and long games) still keep every core busy.
+*/
+
+#ifndef THREAD_POOL
+#define THREAD_POOL
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+class Thread_Pool
+{
+	public:
+		// Called with the task number and the worker (0 to thread count - 1).
+		typedef std::function<void (int task, int worker)> Task_Function;
+
+	private:
+		// Each worker's queue, padded so neighbouring queues don't share
+		// a cache line.
+		struct Worker_Queue
+		{
+			std::mutex queue_mutex;
+			std::deque<int> tasks;
+			char padding[64];
+		};
+
+		std::vector<std::thread> threads;
+		Worker_Queue *queues;
+		int thread_count;
+
+		// Guards everything below.
+		std::mutex pool_mutex;
+		std::condition_variable start_condition;
+		std::condition_variable done_condition;
+
+		const Task_Function *current_function;
+		int generation;		// Bumped each time run() hands out tasks.
+		int active_workers;	// Workers still looking for tasks.
+		bool stopping;
+
+		// Take a task from a worker's own queue, or steal one.
+		bool take_task(int worker, int &task);
+
+		void worker_loop(int worker);
+
+	public:
+		// Starts the threads. A count of 0 uses one per core.
+		Thread_Pool(int thread_count);
+		~Thread_Pool();
+
+		int get_thread_count();
+
+		// Run every task, returning once they have all finished.
+		void run(int task_count, const Task_Function &function);
+};
+
+#endif
@@ -0,0 +1,317 @@
+/*
+ tile_atlas.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ The mine's tiles, scaled once and kept together in one surface.
+*/
+
+#include <cmath>
+#include <vector>
+
+#include "SDL/SDL.h"
+
+#include "tile_atlas.h"
+
+// The source pixels, and how much of each, that make up one pixel of
+// the resampled row or column.
+struct Filter_Taps
+{
+	int first;
+	std::vector<float> weights;
+};
+
+// Catmull-Rom: sharp, without the ringing of a wider filter.
+static float catmull_rom(float distance)
+{
+	distance = fabsf(distance);
+	
+	if(distance < 1.0f)
+	{
+		return (1.5f * distance - 2.5f) * distance * distance + 1.0f;
+	}
+	else if(distance < 2.0f)
+	{
+		return ((-0.5f * distance + 2.5f) * distance - 4.0f) * distance + 2.0f;
+	}
+	
+	return 0.0f;
+}
+
+// The taps for every pixel of a row or column resampled from
+// source_size to destination_size pixels. Pixels beyond the edge are
+// the edge pixel.
+static std::vector<Filter_Taps> make_taps(int source_size, int destination_size)
+{
+	std::vector<Filter_Taps> taps(destination_size);
+	
+	float scale = (float)source_size / destination_size;
+	
+	// Shrinking, the filter is stretched so every source pixel counts.
+	float stretch = scale > 1.0f ? scale : 1.0f;
+	float radius = 2.0f * stretch;
+	
+	for(int pixel = 0; pixel < destination_size; pixel++)
+	{
+		float centre = (pixel + 0.5f) * scale - 0.5f;
+		int first = (int)floorf(centre - radius) + 1;
+		int last = (int)floorf(centre + radius);
+		
+		std::vector<float> weights(source_size, 0.0f);
+		float total = 0.0f;
+		
+		for(int tap = first; tap <= last; tap++)
+		{
+			float weight = catmull_rom((tap - centre) / stretch);
+			int source = tap < 0 ? 0 : (tap >= source_size ? source_size - 1 : tap);
+			
+			weights[source] += weight;
+			total += weight;
+		}
+		
+		// Keep only the source pixels that count, normalised.
+		int low = 0;
+		int high = source_size - 1;
+		
+		while(low < high && weights[low] == 0.0f)
+		{
+			low++;
+		}
+		
+		while(high > low && weights[high] == 0.0f)
+		{
+			high--;
+		}
+		
+		taps[pixel].first = low;
+		
+		for(int source = low; source <= high; source++)
+		{
+			taps[pixel].weights.push_back(total != 0.0f ? weights[source] / total : 0.0f);
+		}
+	}
+	
+	return taps;
+}
+
+void resample_rgba(const unsigned char *source, int source_width, int source_height,
+                   unsigned char *destination, int destination_width, int destination_height)
+{
+	// Premultiplied, so a transparent pixel's colour counts for nothing.
+	std::vector<float> pixels(source_width * source_height * 4);
+	
+	for(int pixel = 0; pixel < source_width * source_height; pixel++)
+	{
+		float alpha = source[pixel * 4 + 3] / 255.0f;
+		
+		pixels[pixel * 4] = source[pixel * 4] * alpha;
+		pixels[pixel * 4 + 1] = source[pixel * 4 + 1] * alpha;
+		pixels[pixel * 4 + 2] = source[pixel * 4 + 2] * alpha;
+		pixels[pixel * 4 + 3] = source[pixel * 4 + 3];
+	}
+	
+	std::vector<Filter_Taps> across = make_taps(source_width, destination_width);
+	std::vector<Filter_Taps> down = make_taps(source_height, destination_height);
+	
+	// Rows first, then columns.
+	std::vector<float> rows(destination_width * source_height * 4, 0.0f);
+	
+	for(int y = 0; y < source_height; y++)
+	{
+		for(int x = 0; x < destination_width; x++)
+		{
+			const Filter_Taps &taps = across[x];
+			float *out = &rows[(y * destination_width + x) * 4];
+			
+			for(size_t tap = 0; tap < taps.weights.size(); tap++)
+			{
+				const float *in = &pixels[(y * source_width + taps.first + tap) * 4];
+				
+				for(int channel = 0; channel < 4; channel++)
+				{
+					out[channel] += in[channel] * taps.weights[tap];
+				}
+			}
+		}
+	}
+	
+	for(int y = 0; y < destination_height; y++)
+	{
+		const Filter_Taps &taps = down[y];
+		
+		for(int x = 0; x < destination_width; x++)
+		{
+			float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			
+			for(size_t tap = 0; tap < taps.weights.size(); tap++)
+			{
+				const float *in = &rows[((taps.first + tap) * destination_width + x) * 4];
+				
+				for(int channel = 0; channel < 4; channel++)
+				{
+					sum[channel] += in[channel] * taps.weights[tap];
+				}
+			}
+			
+			// The filter overshoots a little at hard edges.
+			float alpha = sum[3] < 0.0f ? 0.0f : (sum[3] > 255.0f ? 255.0f : sum[3]);
+			unsigned char *out = &destination[(y * destination_width + x) * 4];
+			
+			for(int channel = 0; channel < 3; channel++)
+			{
+				float value = alpha > 0.0f ? sum[channel] * 255.0f / alpha : 0.0f;
+				value = value < 0.0f ? 0.0f : (value > 255.0f ? 255.0f : value);
+				
+				out[channel] = (unsigned char)(value + 0.5f);
+			}
+			
+			out[3] = (unsigned char)(alpha + 0.5f);
+		}
+	}
+}
+
+Tile_Atlas::Tile_Atlas()
+{
+	atlas = NULL;
+	tile_size = 0;
+}
+
+Tile_Atlas::~Tile_Atlas()
+{
+	clear();
+}
+
+void Tile_Atlas::clear()
+{
+	SDL_FreeSurface(atlas);
+	atlas = NULL;
+	tile_size = 0;
+}
+
+bool Tile_Atlas::build(SDL_Surface *const tiles[GRAPHIC_COUNT], int size)
+{
+	clear();
+	
+	int rows = (GRAPHIC_COUNT + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS;
+	
+	// Built in a format known here, then converted for the screen once.
+	SDL_Surface *building = SDL_CreateRGBSurface(SDL_SWSURFACE | SDL_SRCALPHA, ATLAS_COLUMNS * size, rows * size, 32,
+	                                             0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+	
+	if(building == NULL)
+	{
+		return false;
+	}
+	
+	SDL_FillRect(building, NULL, SDL_MapRGBA(building->format, 0, 0, 0, 0));
+	
+	std::vector<unsigned char> source;
+	std::vector<unsigned char> scaled(size * size * 4);
+	
+	for(int tile = 0; tile < GRAPHIC_COUNT; tile++)
+	{
+		cells[tile].x = (tile % ATLAS_COLUMNS) * size;
+		cells[tile].y = (tile / ATLAS_COLUMNS) * size;
+		cells[tile].w = size;
+		cells[tile].h = size;
+		
+		if(tiles[tile] == NULL)
+		{
+			continue;
+		}
+		
+		// Read the graphic's pixels as RGBA, whatever its format.
+		SDL_Surface *converted = SDL_ConvertSurface(tiles[tile], building->format, SDL_SWSURFACE);
+		
+		if(converted == NULL)
+		{
+			continue;
+		}
+		
+		int width = converted->w;
+		int height = converted->h;
+		source.resize(width * height * 4);
+		
+		SDL_LockSurface(converted);
+		
+		for(int y = 0; y < height; y++)
+		{
+			const Uint32 *row = (const Uint32 *)((const Uint8 *)converted->pixels + y * converted->pitch);
+			
+			for(int x = 0; x < width; x++)
+			{
+				unsigned char *pixel = &source[(y * width + x) * 4];
+				SDL_GetRGBA(row[x], converted->format, &pixel[0], &pixel[1], &pixel[2], &pixel[3]);
+			}
+		}
+		
+		SDL_UnlockSurface(converted);
+		SDL_FreeSurface(converted);
+		
+		resample_rgba(&source[0], width, height, &scaled[0], size, size);
+		
+		SDL_LockSurface(building);
+		
+		for(int y = 0; y < size; y++)
+		{
+			Uint32 *row = (Uint32 *)((Uint8 *)building->pixels + (cells[tile].y + y) * building->pitch) + cells[tile].x;
+			
+			for(int x = 0; x < size; x++)
+			{
+				const unsigned char *pixel = &scaled[(y * size + x) * 4];
+				row[x] = SDL_MapRGBA(building->format, pixel[0], pixel[1], pixel[2], pixel[3]);
+			}
+		}
+		
+		SDL_UnlockSurface(building);
+	}
+	
+	// In the screen's format, so drawing a tile doesn't convert it.
+	atlas = SDL_DisplayFormatAlpha(building);
+	
+	if(atlas == NULL)
+	{
+		atlas = building;
+	}
+	else
+	{
+		SDL_FreeSurface(building);
+	}
+	
+	tile_size = size;
+	return true;
+}
+
+int Tile_Atlas::get_tile_size()
+{
+	return tile_size;
+}
+
+bool Tile_Atlas::draw(mine_tile tile, int x, int y, SDL_Surface *destination)
+{
+	if(atlas == NULL)
+	{
+		return false;
+	}
+	
+	SDL_Rect offset;
+		offset.x = x;
+		offset.y = y;
+	
+	SDL_BlitSurface(atlas, &cells[tile], destination, &offset);
+	return true;
+}
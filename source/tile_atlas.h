@@ -0,0 +1,99 @@
+/*
+ tile_atlas.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ The mine's tiles, scaled to the tile size on screen once and kept
+ together in one surface.
+
+ The tile graphics are drawn at 48 pixels. When the game is run with
+ another tile size (see Display_Settings), each is resampled once, as
+ the atlas is built, with a Catmull-Rom filter widened to cover every
+ source pixel when shrinking, on alpha-premultiplied colour so edges
+ don't pick up the colour of transparent pixels. Drawing a tile is then
+ a plain blit of its cell, the same cost at any size.
+*/
+
+#ifndef TILE_ATLAS
+#define TILE_ATLAS
+
+#include "SDL/SDL.h"
+
+// Every graphic drawn in the mine view.
+enum mine_tile
+{
+	GRAPHIC_DIRT,
+	GRAPHIC_EXPLORED,
+	GRAPHIC_HINT,
+	GRAPHIC_ELEVATOR,
+	GRAPHIC_SHAFT,
+	GRAPHIC_GRANITE,
+	GRAPHIC_CAVE_IN,
+	GRAPHIC_SPRING,
+	GRAPHIC_WATER,
+	GRAPHIC_COAL,
+	GRAPHIC_SILVER,
+	GRAPHIC_GOLD,
+	GRAPHIC_PLATINUM,
+	GRAPHIC_DYNAMITE,
+	GRAPHIC_DIAMOND,
+	GRAPHIC_MINER,
+	GRAPHIC_MINER_DOWN_1,
+	GRAPHIC_MINER_DOWN_2,
+	GRAPHIC_MINER_MOVE,
+	GRAPHIC_COUNT
+};
+
+// Cells across the atlas.
+const int ATLAS_COLUMNS = 8;
+
+// Resample RGBA pixels (four bytes each, rows packed) from one size to
+// another.
+void resample_rgba(const unsigned char *source, int source_width, int source_height,
+                   unsigned char *destination, int destination_width, int destination_height);
+
+class Tile_Atlas
+{
+	private:
+		SDL_Surface *atlas;
+		int tile_size;
+		
+		// Where each tile is in the atlas.
+		SDL_Rect cells[GRAPHIC_COUNT];
+		
+		// Can't be copied; the surface would be freed twice.
+		Tile_Atlas(const Tile_Atlas &);
+		Tile_Atlas &operator=(const Tile_Atlas &);
+		
+	public:
+		Tile_Atlas();
+		~Tile_Atlas();
+		
+		// Build the atlas from a graphic for each tile, scaled to size
+		// pixels square. A missing graphic leaves its cell clear.
+		// Returns false if the atlas can't be made.
+		bool build(SDL_Surface *const tiles[GRAPHIC_COUNT], int size);
+		void clear();
+		
+		int get_tile_size();
+		
+		// Draw a tile with its top left at x, y. Returns false if there's
+		// no atlas.
+		bool draw(mine_tile tile, int x, int y, SDL_Surface *destination);
+};
+
+#endif
@@ -8,34 +8,147 @@
  it under the terms of the GNU General Public License as published by
  the Free Software Foundation, either version 3 of the License, or
  (at your option) any later version.
- 
+
  MinerSDL is distributed in the hope that it will be useful,
  but WITHOUT ANY WARRANTY; without even the implied warranty of
  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
  GNU General Public License for more details.
- 
+
  You should have received a copy of the GNU General Public License
  along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
  ---------------------------------------
- Provides timer based functionality to programs that use SDL.
+ Provides timer based functionality to the program.
+
+ Time is kept in nanoseconds from a monotonic clock. The millisecond
+ functions are kept for the screens that only need coarse timing.
 */
 
-#include "SDL/SDL.h"
+#include <chrono>
 
 #include "timer.h"
 
+Timer_Histogram::Timer_Histogram()
+{
+	clear();
+}
+
+// Add a sample to the histogram.
+void Timer_Histogram::add_sample(long long nanoseconds)
+{
+	// Find the highest set bit to pick the bucket.
+	int bucket = 0;
+
+	for(long long value = nanoseconds; value > 1 && bucket < TIMER_HISTOGRAM_BUCKETS - 1; value >>= 1)
+	{
+		bucket++;
+	}
+
+	buckets[bucket]++;
+
+	if(sample_count == 0 || nanoseconds < sample_min)
+	{
+		sample_min = nanoseconds;
+	}
+
+	if(sample_count == 0 || nanoseconds > sample_max)
+	{
+		sample_max = nanoseconds;
+	}
+
+	sample_count++;
+	sample_total += nanoseconds;
+}
+
+// Remove all samples.
+void Timer_Histogram::clear()
+{
+	for(int bucket = 0; bucket < TIMER_HISTOGRAM_BUCKETS; bucket++)
+	{
+		buckets[bucket] = 0;
+	}
+
+	sample_count = 0;
+	sample_total = 0;
+	sample_min = 0;
+	sample_max = 0;
+}
+
+long long Timer_Histogram::get_count()
+{
+	return sample_count;
+}
+
+long long Timer_Histogram::get_min()
+{
+	return sample_min;
+}
+
+long long Timer_Histogram::get_max()
+{
+	return sample_max;
+}
+
+long long Timer_Histogram::get_mean()
+{
+	if(sample_count == 0)
+	{
+		return 0;
+	}
+
+	return sample_total / sample_count;
+}
+
+// Returns the upper edge of the bucket holding the given percentile.
+long long Timer_Histogram::get_percentile(int percentile)
+{
+	if(sample_count == 0)
+	{
+		return 0;
+	}
+
+	long long wanted = (sample_count * percentile + 99) / 100;
+	long long seen = 0;
+
+	for(int bucket = 0; bucket < TIMER_HISTOGRAM_BUCKETS; bucket++)
+	{
+		seen += buckets[bucket];
+
+		if(seen >= wanted && buckets[bucket] > 0)
+		{
+			// Never report more than the largest sample seen.
+			long long edge = (long long)1 << (bucket + 1);
+			return (edge < sample_max) ? edge : sample_max;
+		}
+	}
+
+	return sample_max;
+}
+
+long long Timer_Histogram::get_bucket(int bucket)
+{
+	return buckets[bucket];
+}
+
 Timer::Timer()
 {
 	// Set all variables to zero.
 	start_time = 0;
 	current_time = 0;
 	reference_time = 0;
-	
+	lap_time = 0;
+
 	// Timer is not active at time of creation.
 	active = false;
 }
 
-// Return 
+// Returns the current time of the monotonic clock in nanoseconds.
+long long Timer::get_ticks_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Return
 bool Timer::is_timer_active()
 {
 	return active;
@@ -44,7 +157,8 @@ bool Timer::is_timer_active()
 // Start the timer.
 void Timer::begin_timer()
 {
-	start_time = SDL_GetTicks();
+	start_time = get_ticks_ns();
+	lap_time = start_time;
 	active = true;
 }
 
@@ -54,37 +168,68 @@ void Timer::stop_timer()
 	start_time = 0;
 	current_time = 0;
 	reference_time = 0;
+	lap_time = 0;
 	active = false;
 }
 
-// Set the reference timer aga#include <string>inst the start timer.
+// Set the reference timer against the start timer.
 void Timer::set_reference_time()
 {
-	reference_time = SDL_GetTicks();
+	reference_time = get_ticks_ns();
 }
 
 // Reset the timer but keep it running.
 void Timer::reset_timer()
 {
-	start_time = SDL_GetTicks();
+	start_time = get_ticks_ns();
+	lap_time = start_time;
 	reference_time = 0;
 }
 
 // Check the current time since the clock has been started.
 int Timer::check_timer()
 {
-	current_time = SDL_GetTicks() - start_time;
-	
-	return current_time;
+	return (int)(check_timer_ns() / 1000000);
 }
 
 // Check the reference timer against the start timer.
 int Timer::check_reference_timer()
 {
-	int temp;
-	
-	temp = SDL_GetTicks() - start_time;
+	long long temp;
+
+	temp = get_ticks_ns() - start_time;
 	temp = reference_time - temp;
-	
-	return temp;
+
+	return (int)(temp / 1000000);
+}
+
+// Check the current time since the clock has been started, in nanoseconds.
+long long Timer::check_timer_ns()
+{
+	current_time = get_ticks_ns() - start_time;
+
+	return current_time;
+}
+
+// Add the time since the last lap to the histogram.
+long long Timer::record_lap()
+{
+	long long now = get_ticks_ns();
+	long long lap = now - lap_time;
+
+	lap_time = now;
+	histogram.add_sample(lap);
+
+	return lap;
+}
+
+// Start a new lap without recording the last one.
+void Timer::begin_lap()
+{
+	lap_time = get_ticks_ns();
+}
+
+Timer_Histogram *Timer::return_histogram()
+{
+	return &histogram;
 }
@@ -8,44 +8,92 @@
  it under the terms of the GNU General Public License as published by
  the Free Software Foundation, either version 3 of the License, or
  (at your option) any later version.
- 
+
  MinerSDL is distributed in the hope that it will be useful,
  but WITHOUT ANY WARRANTY; without even the implied warranty of
  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
  GNU General Public License for more details.
- 
+
  You should have received a copy of the GNU General Public License
  along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
  ---------------------------------------
- Provides timer based functionality to programs that use SDL.
+ Provides timer based functionality to the program.
+
+ Time is kept in nanoseconds from a monotonic clock. The millisecond
+ functions are kept for the screens that only need coarse timing.
 */
 
 #ifndef TIMER_CLASS
 #define TIMER_CLASS
 
-#include "SDL/SDL.h"
+// Number of power-of-two buckets in a Timer_Histogram.
+// Bucket n holds samples from 2^n up to 2^(n+1) nanoseconds.
+const int TIMER_HISTOGRAM_BUCKETS = 48;
+
+// Accumulates timing samples into power-of-two buckets.
+class Timer_Histogram
+{
+	private:
+		long long buckets[TIMER_HISTOGRAM_BUCKETS];
+
+		long long sample_count;
+		long long sample_total;
+		long long sample_min;
+		long long sample_max;
+	public:
+		Timer_Histogram();
+
+		void add_sample(long long nanoseconds);	// Add a sample to the histogram.
+		void clear();							// Remove all samples.
+
+		long long get_count();
+		long long get_min();
+		long long get_max();
+		long long get_mean();
+
+		// Returns the upper edge of the bucket holding the given percentile (0-100).
+		long long get_percentile(int percentile);
+
+		// Returns the number of samples in a bucket.
+		long long get_bucket(int bucket);
+};
 
 class Timer
 {
 	private:
-		int start_time;			// Stores beginning time.
-		int current_time;		// Time that is used to compare to start_time.
-		int reference_time;		// Time that is stored as a reference to current_time.
-		
+		long long start_time;		// Stores beginning time.
+		long long current_time;		// Time that is used to compare to start_time.
+		long long reference_time;	// Time that is stored as a reference to current_time.
+		long long lap_time;			// Time the last lap was recorded.
+
 		bool active;
+
+		Timer_Histogram histogram;	// Collects the laps recorded by record_lap().
 	public:
 		Timer();
-	
+
+		// Returns the current time of the monotonic clock in nanoseconds.
+		static long long get_ticks_ns();
+
 		bool is_timer_active();		// Checks to see if the timer is currently running.
-		
+
 		void begin_timer();			// Start the timer.
 		void stop_timer();			// Stop and reset the timer.
 		void set_reference_time();	// Set the reference timer against the start timer.
 		void reset_timer();			// Reset the timer but keep it running.
-		
-		
+
+
 		int check_timer();			// Returns the difference between start_time and current_time
 		int check_reference_timer(); 	// Returns difference between current_time and start_time
+
+		long long check_timer_ns();	// Same as check_timer(), in nanoseconds.
+
+		// Adds the time since the last lap (or since the timer began)
+		// to the histogram. Returns the lap in nanoseconds.
+		long long record_lap();
+		void begin_lap();			// Start a new lap without recording the last one.
+
+		Timer_Histogram *return_histogram();
 };
 
 #endif
@@ -0,0 +1,277 @@
+/*
+ asset_bench.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Benchmark for the asset archive: how long the game's images take to
+ be ready to draw, decoded from their PNGs as the game did before the
+ archive, against mapped from the archive.
+
+ Times every asset, and the ones loaded before the start screen shows
+ (the HUD, the mine, the start screen and the font), three ways:
+	decode		read and decode each PNG, as IMG_Load does
+	map			map the archive and look each asset up, which is all
+				the game does until an image is drawn
+	map+touch	the same, then read every page of each image, as
+				drawing it the first time does
+ With --cold each file is dropped from the operating system's cache
+ before it's loaded, as after a reboot. Run pack_assets first.
+
+ Usage:
+	asset_bench [--archive FILE] [--repeats N] [--cold]
+
+ Build (from the source directory):
+	g++ -std=c++11 -O2 -I. tools/asset_bench.cpp asset_archive.cpp mapped_file.cpp
+		timer.cpp trace.cpp -lpng -lpthread -o asset_bench
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "asset_archive.h"
+#include "timer.h"
+#include "tools/asset_files.h"
+
+static const char *const STARTUP_PREFIXES[] = { "graphics/hud/", "graphics/mine/dirt", "graphics/mine/elevator",
+	"graphics/mine/shaft", "graphics/mine/miner", "graphics/mine/granite", "graphics/mine/explored",
+	"graphics/mine/hint", "graphics/mine/dynamite", "graphics/mine/diamond", "graphics/mine/platinum",
+	"graphics/mine/gold", "graphics/mine/silver", "graphics/mine/coal", "graphics/mine/spring",
+	"graphics/mine/water", "graphics/mine/cave-in", "graphics/start_screen/", "Fonts/" };
+static const int STARTUP_PREFIX_COUNT = sizeof(STARTUP_PREFIXES) / sizeof(STARTUP_PREFIXES[0]);
+
+static const int PAGE_SIZE = 4096;
+
+// What's read from the pages touched, kept so the reads aren't dropped.
+static volatile unsigned int touched;
+
+static bool loaded_at_startup(const std::string &name)
+{
+	for(int prefix = 0; prefix < STARTUP_PREFIX_COUNT; prefix++)
+	{
+		if(name.compare(0, strlen(STARTUP_PREFIXES[prefix]), STARTUP_PREFIXES[prefix]) == 0)
+		{
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+// Drops a file's pages from the operating system's cache.
+static void uncache(const std::string &path)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	
+	if(fd >= 0)
+	{
+		fdatasync(fd);
+		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		close(fd);
+	}
+}
+
+static bool read_file(const std::string &path, std::vector<unsigned char> &contents)
+{
+	FILE *file = fopen(path.c_str(), "rb");
+	
+	if(file == NULL)
+	{
+		return false;
+	}
+	
+	fseek(file, 0, SEEK_END);
+	contents.resize(ftell(file));
+	fseek(file, 0, SEEK_SET);
+	bool ok = contents.empty() || fread(&contents[0], 1, contents.size(), file) == contents.size();
+	fclose(file);
+	return ok;
+}
+
+// Loads the assets from their own files. Returns the nanoseconds taken,
+// or -1 if one couldn't be loaded.
+static long long time_decode(const std::vector<std::string> &names, bool cold)
+{
+	if(cold)
+	{
+		for(size_t asset = 0; asset < names.size(); asset++)
+		{
+			uncache(names[asset]);
+		}
+	}
+	
+	long long start = Timer::get_ticks_ns();
+	std::vector<unsigned char> data;
+	
+	for(size_t asset = 0; asset < names.size(); asset++)
+	{
+		int width;
+		int height;
+		std::string error;
+		
+		if(is_png(names[asset]) ? !decode_png(names[asset], width, height, data, error)
+		                        : !read_file(names[asset], data))
+		{
+			printf("%s: can't be loaded.\n", names[asset].c_str());
+			return -1;
+		}
+	}
+	
+	return Timer::get_ticks_ns() - start;
+}
+
+// Loads the assets from the archive, reading every page of each if
+// touch is set. Returns the nanoseconds taken, or -1 if the archive
+// doesn't hold them all.
+static long long time_map(const char *path, const std::vector<std::string> &names, bool touch, bool cold)
+{
+	if(cold)
+	{
+		uncache(path);
+	}
+	
+	long long start = Timer::get_ticks_ns();
+	Asset_Archive archive;
+	
+	if(!archive.open(path))
+	{
+		printf("Unable to open %s; run pack_assets first.\n", path);
+		return -1;
+	}
+	
+	for(size_t asset = 0; asset < names.size(); asset++)
+	{
+		Asset_Entry entry;
+		
+		if(!archive.get_asset(names[asset], entry))
+		{
+			printf("%s isn't in %s; run pack_assets again.\n", names[asset].c_str(), path);
+			return -1;
+		}
+		
+		const unsigned char *data = archive.get_data(entry);
+		
+		if(touch)
+		{
+			for(long long byte = 0; byte < entry.size; byte += PAGE_SIZE)
+			{
+				touched += data[byte];
+			}
+		}
+	}
+	
+	long long taken = Timer::get_ticks_ns() - start;
+	
+	// Unmapped before the next run drops it from the cache.
+	archive.close();
+	return taken;
+}
+
+static bool bench_set(const char *set, const char *archive_path, const std::vector<std::string> &names,
+                      int repeats, bool cold)
+{
+	long long decode = 0;
+	long long map = 0;
+	long long touch = 0;
+	
+	for(int repeat = 0; repeat < repeats; repeat++)
+	{
+		long long decode_ns = time_decode(names, cold);
+		long long map_ns = time_map(archive_path, names, false, cold);
+		long long touch_ns = time_map(archive_path, names, true, cold);
+		
+		if(decode_ns < 0 || map_ns < 0 || touch_ns < 0)
+		{
+			return false;
+		}
+		
+		decode += decode_ns;
+		map += map_ns;
+		touch += touch_ns;
+	}
+	
+	printf("%-10s %7d %11.3f %11.3f %12.3f\n", set, (int)names.size(), decode / 1e6 / repeats,
+	       map / 1e6 / repeats, touch / 1e6 / repeats);
+	
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *archive_path = ASSET_ARCHIVE_FILE;
+	int repeats = 5;
+	bool cold = false;
+	
+	for(int arg = 1; arg < argc; arg++)
+	{
+		if(strcmp(argv[arg], "--archive") == 0 && arg + 1 < argc)
+		{
+			archive_path = argv[++arg];
+		}
+		else if(strcmp(argv[arg], "--repeats") == 0 && arg + 1 < argc)
+		{
+			repeats = atoi(argv[++arg]);
+		}
+		else if(strcmp(argv[arg], "--cold") == 0)
+		{
+			cold = true;
+		}
+		else
+		{
+			printf("Usage: asset_bench [--archive FILE] [--repeats N] [--cold]\n");
+			return 1;
+		}
+	}
+	
+	if(repeats < 1)
+	{
+		repeats = 1;
+	}
+	
+	std::vector<std::string> names = find_assets();
+	std::vector<std::string> startup;
+	
+	if(names.empty())
+	{
+		printf("No assets found; run from the source directory.\n");
+		return 1;
+	}
+	
+	for(size_t asset = 0; asset < names.size(); asset++)
+	{
+		if(loaded_at_startup(names[asset]))
+		{
+			startup.push_back(names[asset]);
+		}
+	}
+	
+	printf("%s cache, mean of %d\n", cold ? "Cold" : "Warm", repeats);
+	printf("%-10s %7s %11s %11s %12s\n", "assets", "files", "decode ms", "map ms", "map+touch ms");
+	
+	if(!bench_set("start-up", archive_path, startup, repeats, cold)
+	   || !bench_set("all", archive_path, names, repeats, cold))
+	{
+		return 1;
+	}
+	
+	return 0;
+}
@@ -0,0 +1,136 @@
+/*
+ asset_files.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Finding and decoding the game's assets, for the asset packer
+ (tools/pack_assets.cpp) and its benchmark (tools/asset_bench.cpp).
+
+ PNGs are decoded with libpng, as SDL_image does when the game loads
+ them itself, into the 32-bit pixels the archive keeps.
+*/
+
+#ifndef ASSET_FILES
+#define ASSET_FILES
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <png.h>
+
+// Where the game's assets are, under the source directory.
+const char *const ASSET_DIRECTORIES[] = { "graphics", "Fonts" };
+const int ASSET_DIRECTORY_COUNT = 2;
+
+// Which bits of a decoded pixel, read as a little-endian number, are
+// red, green, blue and alpha. libpng's BGRA order; the screen is 32-bit
+// without alpha in the same order, so blitting these needs no swizzle.
+const unsigned int ASSET_PIXEL_MASKS[4] = { 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000 };
+
+inline bool is_png(const std::string &path)
+{
+	return path.size() > 4 && path.compare(path.size() - 4, 4, ".png") == 0;
+}
+
+// Adds every file under a directory to files, by its path from there,
+// skipping hidden ones.
+inline void find_asset_files(const std::string &directory, std::vector<std::string> &files)
+{
+	DIR *dir = opendir(directory.c_str());
+	
+	if(dir == NULL)
+	{
+		return;
+	}
+	
+	while(struct dirent *item = readdir(dir))
+	{
+		if(item->d_name[0] == '.')
+		{
+			continue;
+		}
+		
+		std::string path = directory + "/" + item->d_name;
+		struct stat status;
+		
+		if(stat(path.c_str(), &status) != 0)
+		{
+			continue;
+		}
+		
+		if(S_ISDIR(status.st_mode))
+		{
+			find_asset_files(path, files);
+		}
+		else if(S_ISREG(status.st_mode))
+		{
+			files.push_back(path);
+		}
+	}
+	
+	closedir(dir);
+}
+
+// Every asset the game loads, sorted as the archive's index is.
+inline std::vector<std::string> find_assets()
+{
+	std::vector<std::string> files;
+	
+	for(int directory = 0; directory < ASSET_DIRECTORY_COUNT; directory++)
+	{
+		find_asset_files(ASSET_DIRECTORIES[directory], files);
+	}
+	
+	std::sort(files.begin(), files.end());
+	return files;
+}
+
+// Decodes a PNG into rows of 32-bit pixels, ASSET_PIXEL_MASKS order.
+// Returns false, with the reason in error, if it can't.
+inline bool decode_png(const std::string &path, int &width, int &height, std::vector<unsigned char> &pixels,
+                       std::string &error)
+{
+	png_image image;
+	memset(&image, 0, sizeof(image));
+	image.version = PNG_IMAGE_VERSION;
+	
+	if(!png_image_begin_read_from_file(&image, path.c_str()))
+	{
+		error = image.message;
+		return false;
+	}
+	
+	image.format = PNG_FORMAT_BGRA;
+	width = image.width;
+	height = image.height;
+	pixels.resize(PNG_IMAGE_SIZE(image));
+	
+	if(!png_image_finish_read(&image, NULL, &pixels[0], 0, NULL))
+	{
+		error = image.message;
+		png_image_free(&image);
+		return false;
+	}
+	
+	return true;
+}
+
+#endif
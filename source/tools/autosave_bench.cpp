@@ -0,0 +1,285 @@
+/*
+ autosave_bench.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Benchmark for saving while the game is played.
+
+ Plays turns as fast as it can, as the mine loop would if the player
+ held a key down, and times each one. Compares playing without saving,
+ writing a full save on the same thread every JOURNAL_BATCH_TURNS
+ turns, and the autosave's checkpoints and journal on its own thread.
+ Reports the median, 99th percentile and worst turn for each, and the
+ bytes written per save.
+
+ Then checks the autosave can be loaded back as it was last handed
+ over, and, with the end of its journal cut off as if the game had
+ crashed while writing, as it was one batch before.
+
+ Usage:
+	autosave_bench [--turns N] [--seed N]
+
+ Build (from the source directory):
+	g++ -std=c++11 -O2 -I. tools/autosave_bench.cpp autosave.cpp save_load.cpp
+		mapped_file.cpp classes.cpp game_events.cpp game_statistics.cpp game_random.cpp
+		game_rules.cpp economy.cpp game_recorder.cpp market.cpp
+		turn_scheduler.cpp timer.cpp trace.cpp -lpthread -o autosave_bench
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include <unistd.h>
+
+#include "classes.h"
+#include "autosave.h"
+#include "save_load.h"
+#include "game_random.h"
+#include "game_rules.h"
+#include "mapped_file.h"
+#include "timer.h"
+
+static const char *BENCH_SAVE_FILE = "bench_autosave";
+
+// How the game is saved while it's played.
+enum bench_saving
+{
+	SAVING_NONE,
+	SAVING_BLOCKING,	// write_save on the game's thread.
+	SAVING_AUTOSAVE,	// Autosave::update.
+	SAVING_COUNT
+};
+
+static const char *saving_names[SAVING_COUNT] = { "none", "blocking", "autosave" };
+
+// What the game was when it was handed to the autosave.
+struct Handed_Over
+{
+	unsigned long long tile_checksum;
+	int money;
+	int turn;
+};
+
+// Play turns, timing each. Games that end are started again, and the
+// turn that ends one isn't counted.
+static void play(bench_saving saving, int turns, unsigned int seed, Autosave *autosave, std::vector<long long> &times,
+				 std::vector<Handed_Over> &handed_over)
+{
+	MineData *mine = new MineData(seed);
+	PlayerData player;
+	player.reset(seed);
+	autosave->restart();
+
+	Game_Random random;
+	random.seed(seed);
+
+	times.clear();
+	handed_over.clear();
+
+	while((int)times.size() < turns)
+	{
+		long long start = Timer::get_ticks_ns();
+
+		int x = player.get_location_x();
+		int y = player.get_location_y();
+		int roll = random.next_int(10);
+
+		if(roll < 4)
+		{
+			y++;
+		}
+		else if(roll < 7)
+		{
+			x++;
+		}
+		else if(roll < 9)
+		{
+			x--;
+		}
+		else
+		{
+			y--;
+		}
+
+		player.change_location(x, y, mine);
+
+		// Keep the player going, so the games are long.
+		if(player.get_health() < 50)
+		{
+			player.change_health(50);
+		}
+
+		if(player.get_money() < 100)
+		{
+			player.change_money(1000);
+		}
+
+		bool handed = false;
+
+		if(saving == SAVING_BLOCKING && player.get_turn_number() % JOURNAL_BATCH_TURNS == 0)
+		{
+			write_save(BENCH_SAVE_FILE, mine, &player);
+		}
+		else if(saving == SAVING_AUTOSAVE)
+		{
+			handed = autosave->update(mine, &player);
+		}
+
+		long long elapsed = Timer::get_ticks_ns() - start;
+
+		if(player.get_money() < 0)
+		{
+			seed++;
+			player.reset(seed);
+			mine->reset(seed);
+			autosave->restart();
+			continue;
+		}
+
+		if(handed)
+		{
+			Handed_Over state;
+			state.tile_checksum = mine->get_tile_checksum();
+			state.money = player.get_money();
+			state.turn = player.get_turn_number();
+			handed_over.push_back(state);
+		}
+
+		times.push_back(elapsed);
+	}
+
+	delete mine;
+}
+
+// Load the autosave and see if it's the game as it was handed over.
+static bool check_autosave(const Handed_Over &expected)
+{
+	MineData *mine = new MineData;
+	PlayerData player;
+
+	bool loaded = read_save(AUTOSAVE_FILE, mine, &player, JOURNAL_FILE);
+	bool same = loaded && mine->get_tile_checksum() == expected.tile_checksum
+		&& player.get_money() == expected.money && player.get_turn_number() == expected.turn;
+
+	delete mine;
+
+	return same;
+}
+
+int main(int argc, char *argv[])
+{
+	int turns = 20000;
+	unsigned int seed = 1;
+
+	for(int arg = 1; arg < argc; arg++)
+	{
+		if(strcmp(argv[arg], "--turns") == 0 && arg + 1 < argc)
+		{
+			turns = atoi(argv[++arg]);
+		}
+		else if(strcmp(argv[arg], "--seed") == 0 && arg + 1 < argc)
+		{
+			seed = atoi(argv[++arg]);
+		}
+		else
+		{
+			printf("Usage: autosave_bench [--turns N] [--seed N]\n");
+			return 1;
+		}
+	}
+
+	if(turns < 1)
+	{
+		turns = 1;
+	}
+
+	Autosave *autosave = get_autosave();
+	std::vector<long long> times;
+	std::vector<Handed_Over> handed_over;
+
+	printf("%-10s %10s %10s %10s %8s %12s\n", "saving", "p50 us", "p99 us", "worst us", "saves", "bytes/save");
+
+	for(int saving = 0; saving < SAVING_COUNT; saving++)
+	{
+		int checkpoints_before = autosave->get_checkpoints_written();
+		int batches_before = autosave->get_batches_written();
+		long long bytes_before = autosave->get_bytes_written();
+
+		play((bench_saving)saving, turns, seed, autosave, times, handed_over);
+		autosave->finish();
+
+		std::sort(times.begin(), times.end());
+
+		printf("%-10s %10.1f %10.1f %10.1f", saving_names[saving], times[times.size() / 2] / 1000.0,
+			   times[times.size() * 99 / 100] / 1000.0, times.back() / 1000.0);
+
+		if(saving == SAVING_BLOCKING)
+		{
+			Mapped_File file;
+			file.open(BENCH_SAVE_FILE);
+			printf(" %8d %12lld\n", turns / JOURNAL_BATCH_TURNS, file.get_size());
+		}
+		else if(saving == SAVING_AUTOSAVE)
+		{
+			int checkpoints = autosave->get_checkpoints_written() - checkpoints_before;
+			int batches = autosave->get_batches_written() - batches_before;
+			long long bytes = autosave->get_bytes_written() - bytes_before;
+
+			Mapped_File file;
+			file.open(AUTOSAVE_FILE);
+
+			printf(" %8d %12lld  (%d checkpoints of %lld)\n", batches, batches > 0 ? bytes / batches : 0,
+				   checkpoints, file.get_size());
+		}
+		else
+		{
+			printf("\n");
+		}
+	}
+
+	bool ok = !handed_over.empty() && check_autosave(handed_over.back());
+	printf("Autosave loads as last handed over: %s\n", ok ? "yes" : "NO");
+
+	// Cut the last batch short, as a crash while writing it would.
+	Mapped_File journal;
+	journal.open(JOURNAL_FILE);
+	long long journal_size = journal.get_size();
+	journal.close();
+
+	if(handed_over.size() >= 2 && journal_size > JOURNAL_HEADER_SIZE && truncate(JOURNAL_FILE, journal_size - 5) == 0)
+	{
+		bool recovered = check_autosave(handed_over[handed_over.size() - 2]);
+		printf("With the last batch cut short, loads as one batch before: %s\n", recovered ? "yes" : "NO");
+		ok = ok && recovered;
+	}
+
+	autosave->stop();
+
+	if(autosave->get_saves_failed() > 0)
+	{
+		printf("%d saves couldn't be written.\n", autosave->get_saves_failed());
+	}
+
+	remove(BENCH_SAVE_FILE);
+	remove(AUTOSAVE_FILE);
+	remove(JOURNAL_FILE);
+
+	return ok ? 0 : 2;
+}
@@ -0,0 +1,87 @@
+/*
+ convert_save.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Converts a game saved in the old text format (player_save and
+ mine_save) to the binary format the game now saves in (game_save).
+
+ The game still loads text saves when there's no newer one, so this
+ is only needed to convert them ahead of time. The text files are left
+ as they were.
+
+ Usage:
+	convert_save [PLAYER_FILE MINE_FILE [OUTPUT]]
+
+ Build (from the source directory):
+	g++ -std=c++11 -O2 -I. tools/convert_save.cpp save_load.cpp autosave.cpp
+		mapped_file.cpp classes.cpp game_events.cpp game_statistics.cpp game_random.cpp game_rules.cpp
+		economy.cpp game_recorder.cpp market.cpp turn_scheduler.cpp timer.cpp
+		trace.cpp -lpthread -o convert_save
+*/
+
+#include <cstdio>
+
+#include "classes.h"
+#include "save_load.h"
+
+int main(int argc, char *argv[])
+{
+	const char *player_path = TEXT_PLAYER_FILE;
+	const char *mine_path = TEXT_MINE_FILE;
+	const char *output_path = SAVE_FILE;
+
+	if(argc == 3 || argc == 4)
+	{
+		player_path = argv[1];
+		mine_path = argv[2];
+
+		if(argc == 4)
+		{
+			output_path = argv[3];
+		}
+	}
+	else if(argc != 1)
+	{
+		printf("Usage: convert_save [PLAYER_FILE MINE_FILE [OUTPUT]]\n");
+		return 1;
+	}
+
+	// Too big for the stack to hold comfortably. Left empty for the save.
+	MineData *mine = new MineData;
+	PlayerData player;
+
+	if(!read_text_save(player_path, mine_path, mine, &player))
+	{
+		printf("%s and %s aren't a whole text save.\n", player_path, mine_path);
+		delete mine;
+		return 1;
+	}
+
+	if(!write_save(output_path, mine, &player))
+	{
+		printf("Unable to write %s.\n", output_path);
+		delete mine;
+		return 1;
+	}
+
+	printf("Converted %s and %s to %s: turn %d, $%d.\n", player_path, mine_path, output_path,
+		   player.get_turn_number(), player.get_money());
+
+	delete mine;
+	return 0;
+}
@@ -0,0 +1,280 @@
+/*
+ leaderboard_bench.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Benchmark for the leaderboard.
+
+ Scores a million games (by default) with random money, from a
+ thousand seeds over a year of days, and times ranking them, looking
+ up ranks and pages of the boards, writing the file, loading it back
+ and appending a score to it. Then checks every board against the
+ entries sorted the slow way, and that the loaded leaderboard ranks
+ the same as the one written.
+
+ Usage:
+	leaderboard_bench [--entries N] [--seed N]
+
+ Build (from the source directory):
+	g++ -std=c++11 -O2 -I. tools/leaderboard_bench.cpp leaderboard.cpp
+		mapped_file.cpp game_random.cpp timer.cpp trace.cpp -lpthread
+		-o leaderboard_bench
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "leaderboard.h"
+#include "mapped_file.h"
+#include "game_random.h"
+#include "timer.h"
+
+static const char *BENCH_LEADERBOARD_FILE = "bench_leaderboard";
+
+static const int BENCH_SEEDS = 1000;
+static const int BENCH_DAYS = 365;
+static const int BENCH_PAGE = 10;
+
+// Entries in the order they rank, worked out by sorting.
+struct Sorted_Entry
+{
+	int money;
+	int entry;
+};
+
+static bool sorts_before(const Sorted_Entry &one, const Sorted_Entry &other)
+{
+	if(one.money != other.money)
+	{
+		return one.money > other.money;
+	}
+	
+	return one.entry < other.entry;
+}
+
+// Check a board against its entries sorted, every entry and every rank
+// of a score one either side.
+static bool check_board(Leaderboard &board, leaderboard_board kind, unsigned int key, std::vector<Sorted_Entry> &sorted)
+{
+	std::sort(sorted.begin(), sorted.end(), sorts_before);
+	
+	if(board.get_board_count(kind, key) != (int)sorted.size())
+	{
+		return false;
+	}
+	
+	std::vector<int> page;
+	
+	for(int first = 0; first < (int)sorted.size(); first += BENCH_PAGE)
+	{
+		board.get_page(kind, key, first, BENCH_PAGE, page);
+		
+		for(unsigned int place = 0; place < page.size(); place++)
+		{
+			if(page[place] != sorted[first + place].entry)
+			{
+				return false;
+			}
+		}
+	}
+	
+	for(unsigned int place = 0; place < sorted.size(); place++)
+	{
+		// A score ranks after every one at least as good.
+		int money = sorted[place].money;
+		unsigned int at_least = place + 1;
+		
+		while(at_least < sorted.size() && sorted[at_least].money == money)
+		{
+			at_least++;
+		}
+		
+		if(board.get_rank(kind, key, money) != (int)at_least + 1)
+		{
+			return false;
+		}
+	}
+	
+	return true;
+}
+
+static double seconds_since(long long start)
+{
+	return (Timer::get_ticks_ns() - start) / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+	int entries = 1000000;
+	unsigned int seed = 1;
+
+	for(int arg = 1; arg < argc; arg++)
+	{
+		if(strcmp(argv[arg], "--entries") == 0 && arg + 1 < argc)
+		{
+			entries = atoi(argv[++arg]);
+		}
+		else if(strcmp(argv[arg], "--seed") == 0 && arg + 1 < argc)
+		{
+			seed = atoi(argv[++arg]);
+		}
+		else
+		{
+			printf("Usage: leaderboard_bench [--entries N] [--seed N]\n");
+			return 1;
+		}
+	}
+
+	if(entries < 1)
+	{
+		entries = 1;
+	}
+
+	Game_Random random;
+	random.seed(seed);
+	
+	std::vector<Score_Entry> scores(entries);
+	
+	for(int entry = 0; entry < entries; entry++)
+	{
+		Score_Entry &score = scores[entry];
+		
+		memset(score.name, 0, sizeof(score.name));
+		snprintf(score.name, sizeof(score.name), "Miner %d", entry % 100000);
+		
+		// Most games end poor, a few rich; plenty of ties.
+		score.money = random.next_int(2000) - 200;
+		
+		if(random.next_int(10) == 0)
+		{
+			score.money += random.next_int(20000);
+		}
+		
+		score.seed = random.next_int(BENCH_SEEDS);
+		score.day = 20000 + random.next_int(BENCH_DAYS);
+		score.flags = random.next_int(4);
+	}
+	
+	Leaderboard board;
+	
+	long long start = Timer::get_ticks_ns();
+	
+	for(int entry = 0; entry < entries; entry++)
+	{
+		board.add(scores[entry]);
+	}
+	
+	double add_seconds = seconds_since(start);
+	printf("Ranked %d entries on 3 boards: %.2f s, %.0f ns each\n", entries, add_seconds, add_seconds * 1e9 / entries);
+	
+	// Ranks of random scores.
+	const int lookups = 1000000;
+	long long rank_total = 0;
+	start = Timer::get_ticks_ns();
+	
+	for(int lookup = 0; lookup < lookups; lookup++)
+	{
+		rank_total += board.get_rank(BOARD_ALL_TIME, 0, random.next_int(22000) - 200);
+	}
+	
+	double rank_seconds = seconds_since(start);
+	printf("Rank lookups: %.0f ns each (mean rank %lld)\n", rank_seconds * 1e9 / lookups, rank_total / lookups);
+	
+	// Pages of ten from random places, all time and for a seed.
+	const int pages = 100000;
+	std::vector<int> page;
+	start = Timer::get_ticks_ns();
+	
+	for(int query = 0; query < pages; query++)
+	{
+		board.get_page(BOARD_ALL_TIME, 0, random.next_int(entries), BENCH_PAGE, page);
+		board.get_page(BOARD_SEED, random.next_int(BENCH_SEEDS), 0, BENCH_PAGE, page);
+	}
+	
+	double page_seconds = seconds_since(start);
+	printf("Pages of %d: %.0f ns each\n", BENCH_PAGE, page_seconds * 1e9 / (pages * 2));
+	
+	start = Timer::get_ticks_ns();
+	bool written = board.write(BENCH_LEADERBOARD_FILE);
+	double write_seconds = seconds_since(start);
+	
+	Mapped_File file;
+	file.open(BENCH_LEADERBOARD_FILE);
+	long long file_size = file.get_size();
+	file.close();
+	
+	printf("Write: %.3f s, %lld bytes (%.1f a score)%s\n", write_seconds, file_size, (double)file_size / entries,
+		   written ? "" : "  FAILED");
+	
+	Leaderboard loaded;
+	start = Timer::get_ticks_ns();
+	bool ok = loaded.load(BENCH_LEADERBOARD_FILE);
+	double load_seconds = seconds_since(start);
+	printf("Load: %.3f s\n", load_seconds);
+	
+	// Appending a score writes one entry, however many there are.
+	start = Timer::get_ticks_ns();
+	bool appended = loaded.add_to_file(BENCH_LEADERBOARD_FILE, scores[0]);
+	double append_seconds = seconds_since(start);
+	printf("Append a score: %.0f us%s\n", append_seconds * 1e6, appended ? "" : "  FAILED");
+	
+	// Check every board against sorting.
+	std::vector<Sorted_Entry> all_time;
+	std::vector<std::vector<Sorted_Entry> > by_seed(BENCH_SEEDS);
+	std::vector<std::vector<Sorted_Entry> > by_day(BENCH_DAYS);
+	
+	for(int entry = 0; entry < entries; entry++)
+	{
+		Sorted_Entry sorted = { scores[entry].money, entry };
+		
+		all_time.push_back(sorted);
+		by_seed[scores[entry].seed].push_back(sorted);
+		by_day[scores[entry].day - 20000].push_back(sorted);
+	}
+	
+	ok = ok && check_board(board, BOARD_ALL_TIME, 0, all_time);
+	
+	for(int key = 0; key < BENCH_SEEDS && ok; key++)
+	{
+		ok = check_board(board, BOARD_SEED, key, by_seed[key]);
+	}
+	
+	for(int key = 0; key < BENCH_DAYS && ok; key++)
+	{
+		ok = check_board(board, BOARD_DAY, 20000 + key, by_day[key]);
+	}
+	
+	printf("Boards rank as sorted: %s\n", ok ? "yes" : "NO");
+	
+	// The loaded leaderboard, with the appended score taken off the end.
+	Sorted_Entry extra = { scores[0].money, entries };
+	all_time.push_back(extra);
+	bool loaded_ok = loaded.get_count() == entries + 1 && check_board(loaded, BOARD_ALL_TIME, 0, all_time);
+	
+	Leaderboard reloaded;
+	loaded_ok = loaded_ok && reloaded.load(BENCH_LEADERBOARD_FILE) && reloaded.get_count() == entries + 1 &&
+				check_board(reloaded, BOARD_ALL_TIME, 0, all_time) &&
+				strcmp(reloaded.get_entry(entries - 1).name, scores[entries - 1].name) == 0;
+	printf("Loads rank the same: %s\n", loaded_ok ? "yes" : "NO");
+	
+	remove(BENCH_LEADERBOARD_FILE);
+
+	return ok && loaded_ok ? 0 : 2;
+}
@@ -0,0 +1,559 @@
+/*
+ load_client.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Load generator for the game server (tools/server.cpp). Linux only.
+
+ Keeps --sessions games open at once, spread over --threads threads
+ that each wait on their own sessions with epoll. Every session has
+ one action in flight at a time: it sends an action, waits for the
+ reply and picks the next. A session that has finished its game, or
+ played --actions actions, is closed and a new one started, so the
+ server's session slots keep being reused.
+
+ Reports how long actions took to be answered (p50, p99, p99.9) and
+ how many sessions the server kept going per core. The server's CPU
+ time is asked for before and after, so this is the server's own
+ usage, not the client's.
+
+ Usage:
+	load_client [--port N | --socket PATH] [--sessions N] [--threads N]
+				[--seconds N] [--actions N]
+
+ Build (from the source directory):
+	g++ -std=c++11 -O2 -I. -Itools tools/load_client.cpp game_random.cpp
+		game_recorder.cpp classes.cpp game_events.cpp game_rules.cpp
+		economy.cpp market.cpp turn_scheduler.cpp timer.cpp trace.cpp
+		-lpthread -o load_client
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "game_random.h"
+#include "game_recorder.h"
+#include "server_protocol.h"
+#include "timer.h"
+
+struct Load_Settings
+{
+	int port;
+	const char *socket_path;
+	int sessions;
+	int threads;
+	int seconds;
+	int actions;			// Most actions a session plays before starting again.
+};
+
+// One of the client's games.
+struct Load_Session
+{
+	int fd;
+	Game_Random choices;
+	int actions;
+	long long sent_at;		// When the action in flight was sent.
+
+	int reply_length;
+	unsigned char reply[SERVER_REPLY_SIZE];
+};
+
+// What one thread saw. Only that thread writes to it.
+struct Load_Totals
+{
+	std::vector<unsigned int> latencies;	// Nanoseconds for each action.
+	long long sessions_started;
+	long long sessions_finished;			// Games that ended, rather than hit --actions.
+	long long failures;
+};
+
+// Connect to the server. Returns the socket, or -1.
+static int connect_to_server(const Load_Settings &settings)
+{
+	int fd = -1;
+
+	if(settings.socket_path != NULL)
+	{
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+		sockaddr_un address;
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		strncpy(address.sun_path, settings.socket_path, sizeof(address.sun_path) - 1);
+
+		if(fd < 0 || connect(fd, (sockaddr *)&address, sizeof(address)) < 0)
+		{
+			if(fd >= 0)
+			{
+				close(fd);
+			}
+
+			return -1;
+		}
+	}
+	else
+	{
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+
+		sockaddr_in address;
+		memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_port = htons(settings.port);
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		if(fd < 0 || connect(fd, (sockaddr *)&address, sizeof(address)) < 0)
+		{
+			if(fd >= 0)
+			{
+				close(fd);
+			}
+
+			return -1;
+		}
+
+		int on = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+	}
+
+	return fd;
+}
+
+// Send all of a message on a blocking socket.
+static bool send_all(int fd, const unsigned char *data, int length)
+{
+	while(length > 0)
+	{
+		ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+
+		if(sent <= 0)
+		{
+			return false;
+		}
+
+		data += sent;
+		length -= sent;
+	}
+
+	return true;
+}
+
+// Ask the server for its totals.
+static bool ask_stats(const Load_Settings &settings, Server_Stats &stats)
+{
+	int fd = connect_to_server(settings);
+
+	if(fd < 0)
+	{
+		return false;
+	}
+
+	unsigned char data[SERVER_STATS_SIZE];
+	int received = 0;
+
+	bool ok = send_all(fd, (const unsigned char *)SERVER_STATS_MAGIC, 4);
+
+	while(ok && received < SERVER_STATS_SIZE)
+	{
+		ssize_t length = recv(fd, data + received, SERVER_STATS_SIZE - received, 0);
+
+		if(length <= 0)
+		{
+			ok = false;
+		}
+		else
+		{
+			received += length;
+		}
+	}
+
+	close(fd);
+
+	if(ok)
+	{
+		read_stats(data, stats);
+	}
+
+	return ok;
+}
+
+// Choose an action, much as a player digging about would: mostly
+// moves, each of which ends its turn, with the odd trip to the bank,
+// the store or the hospital.
+static int choose_action(Load_Session &session, unsigned char *action)
+{
+	int roll = session.choices.next_int(100);
+
+	if(roll < 40)
+	{
+		action[0] = ACTION_MOVE_DOWN;
+	}
+	else if(roll < 60)
+	{
+		action[0] = ACTION_MOVE_RIGHT;
+	}
+	else if(roll < 75)
+	{
+		action[0] = ACTION_MOVE_LEFT;
+	}
+	else if(roll < 88)
+	{
+		action[0] = ACTION_MOVE_UP;
+	}
+	else if(roll < 91)
+	{
+		action[0] = ACTION_SELL_ALL;
+		return 1;
+	}
+	else if(roll < 93)
+	{
+		action[0] = ACTION_NEW_PRICES;
+		return 1;
+	}
+	else if(roll < 95)
+	{
+		action[0] = ACTION_BUY_ITEM;
+		action[1] = (unsigned char)session.choices.next_int(6);
+		return 2;
+	}
+	else if(roll < 97)
+	{
+		action[0] = ACTION_FULL_HEAL;
+		return 1;
+	}
+	else if(roll < 98)
+	{
+		action[0] = ACTION_LIGHT_DYNAMITE;
+		return 1;
+	}
+	else
+	{
+		action[0] = ACTION_ELEVATOR_TOP;
+		return 1;
+	}
+
+	return 1;
+}
+
+// Send a session's next action.
+static bool send_action(Load_Session &session)
+{
+	unsigned char action[8];
+	int length = choose_action(session, action);
+
+	session.sent_at = Timer::get_ticks_ns();
+	session.reply_length = 0;
+
+	return send_all(session.fd, action, length);
+}
+
+// Start a new game on a session. Returns false if it can't connect.
+static bool start_session(const Load_Settings &settings, Load_Session &session, unsigned int seed, int epoll_fd,
+						  int tag)
+{
+	session.fd = connect_to_server(settings);
+
+	if(session.fd < 0)
+	{
+		return false;
+	}
+
+	session.choices.seed(((unsigned long long)seed << 32) | 0x10AD);
+	session.actions = 0;
+
+	Game_Recorder header;
+	header.start(seed, seed);
+
+	if(!send_all(session.fd, header.get_data().data(), header.get_data().size()))
+	{
+		close(session.fd);
+		return false;
+	}
+
+	epoll_event event;
+	event.events = EPOLLIN;
+	event.data.u32 = tag;
+	epoll_ctl(epoll_fd, EPOLL_CTL_ADD, session.fd, &event);
+
+	return send_action(session);
+}
+
+static void end_session(Load_Session &session, int epoll_fd)
+{
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, session.fd, NULL);
+	close(session.fd);
+	session.fd = -1;
+}
+
+// One thread's sessions.
+static void run_thread(const Load_Settings *settings, int thread, int session_count, long long stop_at,
+					   Load_Totals *totals)
+{
+	int epoll_fd = epoll_create1(0);
+	std::vector<Load_Session> sessions(session_count);
+
+	// Each thread's games get their own run of seeds.
+	unsigned int next_seed = thread * 1000000 + 1;
+
+	for(int index = 0; index < session_count; index++)
+	{
+		if(start_session(*settings, sessions[index], next_seed++, epoll_fd, index))
+		{
+			totals->sessions_started++;
+		}
+		else
+		{
+			totals->failures++;
+		}
+	}
+
+	epoll_event events[256];
+
+	while(Timer::get_ticks_ns() < stop_at)
+	{
+		int count = epoll_wait(epoll_fd, events, 256, 100);
+
+		for(int event = 0; event < count; event++)
+		{
+			int index = events[event].data.u32;
+			Load_Session &session = sessions[index];
+
+			ssize_t received = recv(session.fd, session.reply + session.reply_length,
+									SERVER_REPLY_SIZE - session.reply_length, MSG_DONTWAIT);
+
+			if(received <= 0)
+			{
+				if(received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+				{
+					continue;
+				}
+
+				totals->failures++;
+				end_session(session, epoll_fd);
+			}
+			else
+			{
+				session.reply_length += received;
+
+				if(session.reply_length < SERVER_REPLY_SIZE)
+				{
+					continue;
+				}
+
+				totals->latencies.push_back((unsigned int)(Timer::get_ticks_ns() - session.sent_at));
+				session.actions++;
+
+				Server_Reply reply;
+				read_reply(session.reply, reply);
+
+				bool over = reply.state == SESSION_DEAD || reply.state == SESSION_BROKE;
+
+				if(over)
+				{
+					totals->sessions_finished++;
+				}
+
+				if(!over && session.actions < settings->actions)
+				{
+					if(!send_action(session))
+					{
+						totals->failures++;
+						end_session(session, epoll_fd);
+					}
+
+					continue;
+				}
+
+				end_session(session, epoll_fd);
+			}
+
+			// Keep the number of open sessions up.
+			if(start_session(*settings, session, next_seed++, epoll_fd, index))
+			{
+				totals->sessions_started++;
+			}
+			else
+			{
+				totals->failures++;
+			}
+		}
+	}
+
+	for(int index = 0; index < session_count; index++)
+	{
+		if(sessions[index].fd >= 0)
+		{
+			end_session(sessions[index], epoll_fd);
+		}
+	}
+
+	close(epoll_fd);
+}
+
+static void print_usage()
+{
+	printf("Usage: load_client [--port N | --socket PATH] [--sessions N] [--threads N] [--seconds N] [--actions N]\n");
+}
+
+int main(int argc, char *argv[])
+{
+	Load_Settings settings;
+	settings.port = SERVER_DEFAULT_PORT;
+	settings.socket_path = NULL;
+	settings.sessions = 1000;
+	settings.threads = 1;
+	settings.seconds = 10;
+	settings.actions = 2000;
+
+	for(int arg = 1; arg < argc; arg++)
+	{
+		bool has_value = arg + 1 < argc;
+
+		if(strcmp(argv[arg], "--port") == 0 && has_value)
+		{
+			settings.port = atoi(argv[++arg]);
+		}
+		else if(strcmp(argv[arg], "--socket") == 0 && has_value)
+		{
+			settings.socket_path = argv[++arg];
+		}
+		else if(strcmp(argv[arg], "--sessions") == 0 && has_value)
+		{
+			settings.sessions = atoi(argv[++arg]);
+		}
+		else if(strcmp(argv[arg], "--threads") == 0 && has_value)
+		{
+			settings.threads = atoi(argv[++arg]);
+		}
+		else if(strcmp(argv[arg], "--seconds") == 0 && has_value)
+		{
+			settings.seconds = atoi(argv[++arg]);
+		}
+		else if(strcmp(argv[arg], "--actions") == 0 && has_value)
+		{
+			settings.actions = atoi(argv[++arg]);
+		}
+		else
+		{
+			print_usage();
+			return 1;
+		}
+	}
+
+	if(settings.threads < 1)
+	{
+		settings.threads = 1;
+	}
+
+	Server_Stats before;
+
+	if(!ask_stats(settings, before))
+	{
+		printf("Couldn't reach the server.\n");
+		return 1;
+	}
+
+	long long start = Timer::get_ticks_ns();
+	long long stop_at = start + settings.seconds * 1000000000LL;
+
+	std::vector<Load_Totals> totals(settings.threads);
+	std::vector<std::thread> threads;
+
+	for(int thread = 0; thread < settings.threads; thread++)
+	{
+		// Share the sessions out as evenly as they go.
+		int count = settings.sessions / settings.threads + (thread < settings.sessions % settings.threads ? 1 : 0);
+
+		totals[thread].sessions_started = 0;
+		totals[thread].sessions_finished = 0;
+		totals[thread].failures = 0;
+
+		threads.push_back(std::thread(run_thread, &settings, thread, count, stop_at, &totals[thread]));
+	}
+
+	// Ask while the sessions are still open.
+	usleep((useconds_t)(settings.seconds * 1000000LL * 9 / 10));
+
+	Server_Stats during;
+	bool have_during = ask_stats(settings, during);
+
+	for(unsigned int thread = 0; thread < threads.size(); thread++)
+	{
+		threads[thread].join();
+	}
+
+	double seconds = (Timer::get_ticks_ns() - start) / 1e9;
+
+	Server_Stats after;
+
+	if(!ask_stats(settings, after))
+	{
+		printf("Lost the server.\n");
+		return 1;
+	}
+
+	std::vector<unsigned int> latencies;
+	long long started = 0;
+	long long finished = 0;
+	long long failures = 0;
+
+	for(int thread = 0; thread < settings.threads; thread++)
+	{
+		latencies.insert(latencies.end(), totals[thread].latencies.begin(), totals[thread].latencies.end());
+		started += totals[thread].sessions_started;
+		finished += totals[thread].sessions_finished;
+		failures += totals[thread].failures;
+	}
+
+	if(latencies.empty())
+	{
+		printf("No actions were answered.\n");
+		return 1;
+	}
+
+	std::sort(latencies.begin(), latencies.end());
+
+	long long actions = latencies.size();
+	double server_cores = (after.cpu_ns - before.cpu_ns) / 1e9 / seconds;
+	long long open = have_during ? during.sessions_open : settings.sessions;
+
+	printf("%lld sessions open at once, %lld started, %lld games finished, %lld failures\n", open, started,
+		   finished, failures);
+	printf("%lld actions in %.1f s: %.0f actions/s\n", actions, seconds, actions / seconds);
+	printf("Latency: p50 %.1f us  p99 %.1f us  p99.9 %.1f us  max %.1f us\n",
+		   latencies[actions / 2] / 1000.0,
+		   latencies[actions * 99 / 100] / 1000.0,
+		   latencies[actions * 999 / 1000] / 1000.0,
+		   latencies[actions - 1] / 1000.0);
+	printf("Server used %.2f cores over %lld threads: %.0f sessions per core, %.0f actions per core-second\n",
+		   server_cores, after.threads, server_cores > 0 ? open / server_cores : 0.0,
+		   server_cores > 0 ? actions / seconds / server_cores : 0.0);
+
+	return 0;
+}
@@ -0,0 +1,229 @@
+/*
+ pack_assets.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Packs the game's graphics and font into the asset archive the game
+ maps when it starts (see asset_archive.h).
+
+ Every PNG under graphics/ is decoded into 32-bit pixels, so the game
+ draws them from the archive without decoding anything; everything
+ else, the font under Fonts/, is stored as it is. The archive is read
+ back once it's written, to check it holds what was packed. Run it
+ again whenever the graphics change; the game loads an image that
+ isn't in the archive from its file.
+
+ Usage:
+	pack_assets [OUTPUT]
+
+ Build (from the source directory):
+	g++ -std=c++11 -O2 -I. tools/pack_assets.cpp asset_archive.cpp mapped_file.cpp
+		timer.cpp trace.cpp -lpng -lpthread -o pack_assets
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "asset_archive.h"
+#include "tools/asset_files.h"
+
+static void write_le(unsigned char *data, unsigned long long value, int bytes)
+{
+	for(int byte = 0; byte < bytes; byte++)
+	{
+		data[byte] = (unsigned char)(value >> (byte * 8));
+	}
+}
+
+static bool read_file(const std::string &path, std::vector<unsigned char> &contents)
+{
+	FILE *file = fopen(path.c_str(), "rb");
+	
+	if(file == NULL)
+	{
+		return false;
+	}
+	
+	contents.clear();
+	unsigned char block[65536];
+	size_t count;
+	
+	while((count = fread(block, 1, sizeof(block), file)) > 0)
+	{
+		contents.insert(contents.end(), block, block + count);
+	}
+	
+	bool ok = !ferror(file);
+	fclose(file);
+	return ok;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *output_path = ASSET_ARCHIVE_FILE;
+	
+	if(argc == 2)
+	{
+		output_path = argv[1];
+	}
+	else if(argc != 1)
+	{
+		printf("Usage: pack_assets [OUTPUT]\n");
+		return 1;
+	}
+	
+	std::vector<std::string> names = find_assets();
+	
+	if(names.empty())
+	{
+		printf("No assets found; run from the source directory.\n");
+		return 1;
+	}
+	
+	for(size_t asset = 0; asset < names.size(); asset++)
+	{
+		if((int)names[asset].size() >= ASSET_NAME_SIZE)
+		{
+			printf("%s: path is too long for the archive.\n", names[asset].c_str());
+			return 1;
+		}
+	}
+	
+	// The index goes first, then each asset's data. Each entry is filled
+	// in as its data is added behind the index.
+	long long index_end = ASSET_ARCHIVE_HEADER_SIZE + (long long)names.size() * ASSET_ENTRY_SIZE;
+	std::vector<unsigned char> archive(index_end, 0);
+	
+	memcpy(&archive[0], ASSET_ARCHIVE_MAGIC, 4);
+	write_le(&archive[4], ASSET_ARCHIVE_VERSION, 2);
+	write_le(&archive[6], ASSET_ENTRY_SIZE, 2);
+	write_le(&archive[8], names.size(), 4);
+	
+	std::vector<std::vector<unsigned char> > contents(names.size());
+	long long source_bytes = 0;
+	int images = 0;
+	
+	for(size_t asset = 0; asset < names.size(); asset++)
+	{
+		std::vector<unsigned char> &data = contents[asset];
+		
+		if(!read_file(names[asset], data))
+		{
+			printf("%s: can't be read.\n", names[asset].c_str());
+			return 1;
+		}
+		
+		source_bytes += data.size();
+		
+		asset_kind kind = ASSET_FILE;
+		int width = 0;
+		int height = 0;
+		
+		if(is_png(names[asset]))
+		{
+			std::string error;
+			
+			if(!decode_png(names[asset], width, height, data, error))
+			{
+				printf("%s: %s\n", names[asset].c_str(), error.c_str());
+				return 1;
+			}
+			
+			kind = ASSET_IMAGE;
+			images++;
+		}
+		
+		// Aligned, so the pixels can be used where they lie.
+		while(archive.size() % ASSET_ALIGNMENT != 0)
+		{
+			archive.push_back(0);
+		}
+		
+		long long offset = archive.size();
+		archive.insert(archive.end(), data.begin(), data.end());
+		
+		unsigned char *entry = &archive[ASSET_ARCHIVE_HEADER_SIZE + asset * ASSET_ENTRY_SIZE];
+		memcpy(entry, names[asset].c_str(), names[asset].size());
+		unsigned char *fields = entry + ASSET_NAME_SIZE;
+		
+		write_le(fields, kind, 4);
+		
+		if(kind == ASSET_IMAGE)
+		{
+			write_le(fields + 4, width, 4);
+			write_le(fields + 8, height, 4);
+			write_le(fields + 12, width * 4, 4);
+			
+			for(int mask = 0; mask < 4; mask++)
+			{
+				write_le(fields + 16 + mask * 4, ASSET_PIXEL_MASKS[mask], 4);
+			}
+		}
+		
+		write_le(fields + 32, offset, 8);
+		write_le(fields + 40, data.size(), 8);
+	}
+	
+	// Written beside the old archive and moved over it, so a game
+	// starting meanwhile never maps half an archive.
+	std::string temp_path = std::string(output_path) + ".tmp";
+	FILE *file = fopen(temp_path.c_str(), "wb");
+	
+	if(file == NULL)
+	{
+		printf("Unable to write %s.\n", temp_path.c_str());
+		return 1;
+	}
+	
+	bool written = fwrite(&archive[0], 1, archive.size(), file) == archive.size();
+	written = fclose(file) == 0 && written;
+	
+	if(!written || rename(temp_path.c_str(), output_path) != 0)
+	{
+		printf("Unable to write %s.\n", output_path);
+		remove(temp_path.c_str());
+		return 1;
+	}
+	
+	// Read it back the way the game will.
+	Asset_Archive check;
+	
+	if(!check.open(output_path) || check.get_count() != (int)names.size())
+	{
+		printf("%s doesn't read back.\n", output_path);
+		return 1;
+	}
+	
+	for(size_t asset = 0; asset < names.size(); asset++)
+	{
+		Asset_Entry entry;
+		
+		if(!check.get_asset(names[asset], entry) || entry.size != (long long)contents[asset].size()
+		   || memcmp(check.get_data(entry), &contents[asset][0], entry.size) != 0)
+		{
+			printf("%s doesn't read back from %s.\n", names[asset].c_str(), output_path);
+			return 1;
+		}
+	}
+	
+	printf("Packed %d images and %d other files (%lld bytes) into %s (%lld bytes).\n", images,
+	       (int)names.size() - images, source_bytes, output_path, (long long)archive.size());
+	
+	return 0;
+}
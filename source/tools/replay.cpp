@@ -0,0 +1,126 @@
+/*
+ replay.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Plays back a recorded game headless, as fast as it will go.
+
+ Checks the game against every checksum in the recording and says
+ which turn it first stopped matching, if it did. Reports how the
+ game ended up and how many turns were replayed per millisecond,
+ not counting making the mine.
+
+ The game records itself to last_game.replay; the simulator records
+ its first game with --record.
+
+ Usage:
+	replay FILE [--repeats N]
+
+ Build (from the source directory):
+	g++ -std=c++11 -O2 -I. tools/replay.cpp classes.cpp game_events.cpp
+		game_random.cpp game_rules.cpp economy.cpp game_recorder.cpp
+		market.cpp turn_scheduler.cpp timer.cpp trace.cpp -lpthread -o replay
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "classes.h"
+#include "game_recorder.h"
+#include "timer.h"
+
+static const char *result_names[3] = { "ok", "bad recording", "diverged" };
+
+int main(int argc, char *argv[])
+{
+	const char *path = NULL;
+	int repeats = 1;
+
+	for(int arg = 1; arg < argc; arg++)
+	{
+		if(strcmp(argv[arg], "--repeats") == 0 && arg + 1 < argc)
+		{
+			repeats = atoi(argv[++arg]);
+		}
+		else if(path == NULL && argv[arg][0] != '-')
+		{
+			path = argv[arg];
+		}
+		else
+		{
+			path = NULL;
+			break;
+		}
+	}
+
+	if(path == NULL)
+	{
+		printf("Usage: replay FILE [--repeats N]\n");
+		return 1;
+	}
+
+	if(repeats < 1)
+	{
+		repeats = 1;
+	}
+
+	Game_Replayer replayer;
+
+	if(!replayer.load(path))
+	{
+		printf("%s isn't a recording.\n", path);
+		return 1;
+	}
+
+	replay_result result = REPLAY_OK;
+	long long total_ns = 0;
+
+	for(int repeat = 0; repeat < repeats; repeat++)
+	{
+		MineData *mine = new MineData(replayer.get_mine_seed());
+		PlayerData player;
+
+		long long start = Timer::get_ticks_ns();
+		result = replayer.run(&player, mine);
+		total_ns += Timer::get_ticks_ns() - start;
+
+		if(repeat == repeats - 1)
+		{
+			printf("%s: seeds %u/%u, %d actions, %d turns, %d checksums: %s\n", path,
+				   replayer.get_player_seed(), replayer.get_mine_seed(), replayer.get_actions(),
+				   replayer.get_turns(), replayer.get_checksums(), result_names[result]);
+
+			if(result == REPLAY_DIVERGED)
+			{
+				printf("First checksum that didn't match was at turn %d.\n", replayer.get_diverged_turn());
+			}
+
+			printf("Ended on turn %d with $%d, %d health, at %d, %d.\n", player.get_turn_number(),
+				   player.get_money(), player.get_health(), player.get_location_x(), player.get_location_y());
+		}
+
+		delete mine;
+	}
+
+	double ms = total_ns / 1000000.0 / repeats;
+
+	printf("%.3f ms per replay, %.0f turns/ms\n", ms,
+		   ms > 0 ? replayer.get_turns() / ms : 0.0);
+
+	return result == REPLAY_OK ? 0 : 2;
+}
@@ -0,0 +1,331 @@
+/*
+ save_bench.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Benchmark for saving and loading games.
+
+ Makes a mine from a seed, digs part of it out, and times saving and
+ loading it in the old text format and in the binary format, with the
+ file sizes. Then checks that both loads give back the mine that was
+ saved, apart from the last row and column, which the text format
+ never kept.
+
+ Then packs and unpacks the tiles of a new mine, one with tunnels dug
+ across it and one dug out at random, and reports how much smaller
+ the packed tiles are than a byte a tile, and how fast they're packed
+ and unpacked, in MB of tiles a second.
+
+ Usage:
+	save_bench [--seed N] [--repeats N]
+
+ Build (from the source directory):
+	g++ -std=c++11 -O2 -I. tools/save_bench.cpp save_load.cpp autosave.cpp
+		mapped_file.cpp classes.cpp game_events.cpp game_statistics.cpp game_random.cpp game_rules.cpp
+		economy.cpp game_recorder.cpp market.cpp turn_scheduler.cpp timer.cpp
+		trace.cpp -lpthread -o save_bench
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include "classes.h"
+#include "save_load.h"
+#include "game_random.h"
+#include "timer.h"
+
+static const char *BENCH_PLAYER_FILE = "bench_player_save";
+static const char *BENCH_MINE_FILE = "bench_mine_save";
+static const char *BENCH_SAVE_FILE = "bench_game_save";
+
+// The text format, as the game used to write it: one value a line,
+// flushed after each, leaving out the last row and column.
+static void write_text_save(MineData *mine, PlayerData *player)
+{
+	std::ofstream player_out(BENCH_PLAYER_FILE, std::ios::binary);
+	
+		player_out << player->get_health() << std::endl;
+		player_out << player->get_money() << std::endl;
+	
+		player_out << player->get_coal() << std::endl;
+		player_out << player->get_silver() << std::endl;
+		player_out << player->get_gold() << std::endl;
+		player_out << player->get_platinum() << std::endl;
+	
+		player_out << player->get_turn_number() << std::endl;
+		player_out << player->get_insurance_turn_number() << std::endl;
+		player_out << player->get_previous_turn_number() << std::endl;
+	
+		player_out << player->get_has_axe() << std::endl;
+		player_out << player->get_has_bucket() << std::endl;
+		player_out << player->get_has_diamond() << std::endl;
+		player_out << player->get_dynamite() << std::endl;
+		player_out << player->get_has_flashlight() << std::endl;
+		player_out << player->get_has_hardhat() << std::endl;
+		player_out << player->get_has_insurance() << std::endl;
+		player_out << player->get_has_shovel() << std::endl;
+	
+	player_out.close();
+	
+	std::ofstream mine_out(BENCH_MINE_FILE, std::ios::binary);
+	
+		for(int x = 0; x <= (mine->get_map_x() - 1); x++)
+		{
+			for(int y = 0; y <= (mine->get_map_y() - 1); y++)
+			{
+				mine_out << mine->get_contents(x, y) << std::endl;
+			}
+		}
+		
+		for(int x = 0; x <= (mine->get_map_x() - 1); x++)
+		{
+			for(int y = 0; y <= (mine->get_map_y() - 1); y++)
+			{
+				mine_out << mine->get_explored(x, y) << std::endl;
+			}
+		}
+		
+		mine_out << mine->get_diamond_x() << std::endl;
+		mine_out << mine->get_diamond_y() << std::endl;
+	
+	mine_out.close();
+}
+
+static long long file_size(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+
+	if(file == NULL)
+	{
+		return 0;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long long size = ftell(file);
+	fclose(file);
+
+	return size;
+}
+
+// Count the tiles that differ, leaving out the last row and column if asked.
+static int count_differences(MineData *a, MineData *b, bool whole_mine)
+{
+	int last_x = whole_mine ? a->get_map_x() : a->get_map_x() - 1;
+	int last_y = whole_mine ? a->get_map_y() : a->get_map_y() - 1;
+	int differences = 0;
+
+	for(int y = 0; y <= last_y; y++)
+	{
+		for(int x = 0; x <= last_x; x++)
+		{
+			if(a->get_contents(x, y) != b->get_contents(x, y) || a->get_explored(x, y) != b->get_explored(x, y))
+			{
+				differences++;
+			}
+		}
+	}
+
+	return differences;
+}
+
+// How the mine is dug out for packing.
+enum bench_layout
+{
+	LAYOUT_NEW,			// Nothing dug out.
+	LAYOUT_TUNNELS,		// Every fourth row dug out, with a shaft down the middle.
+	LAYOUT_RANDOM,		// A third of the tiles dug out, anywhere.
+	LAYOUT_COUNT
+};
+
+static const char *layout_names[LAYOUT_COUNT] = { "new", "tunnels", "random" };
+
+static void dig_out(MineData *mine, bench_layout layout, unsigned int seed)
+{
+	Game_Random random;
+	random.seed(seed);
+
+	for(int y = 0; y <= mine->get_map_y(); y++)
+	{
+		for(int x = 1; x <= mine->get_map_x(); x++)
+		{
+			bool dig = false;
+
+			if(layout == LAYOUT_TUNNELS)
+			{
+				dig = y % 4 == 0 || x == mine->get_map_x() / 2;
+			}
+			else if(layout == LAYOUT_RANDOM)
+			{
+				dig = random.next_int(3) == 0;
+			}
+
+			if(dig)
+			{
+				mine->set_contents(x, y, EXPLORED);
+				mine->set_explored(x, y, true);
+			}
+		}
+	}
+}
+
+// Pack and unpack a mine's tiles. Returns false if they don't come back the same.
+static bool bench_packing(MineData *mine, const char *name, int repeats)
+{
+	std::vector<unsigned char> materials;
+	unsigned char explored[SAVE_EXPLORED_SIZE];
+	unsigned char *unpacked = new unsigned char[MINE_TILES];
+
+	long long start = Timer::get_ticks_ns();
+
+	for(int repeat = 0; repeat < repeats; repeat++)
+	{
+		pack_explored(mine->get_tiles(), explored);
+		pack_materials(mine->get_tiles(), materials);
+	}
+
+	long long pack_ns = Timer::get_ticks_ns() - start;
+	bool same = true;
+
+	start = Timer::get_ticks_ns();
+
+	for(int repeat = 0; repeat < repeats; repeat++)
+	{
+		same = unpack_materials(&materials[0], materials.size(), unpacked) && same;
+		unpack_explored(explored, unpacked);
+	}
+
+	long long unpack_ns = Timer::get_ticks_ns() - start;
+
+	for(int index = 0; index < MINE_TILES; index++)
+	{
+		if(unpacked[index] != (mine->get_tiles()[index] & (TILE_MATERIAL_MASK | TILE_EXPLORED)))
+		{
+			same = false;
+		}
+	}
+
+	int packed_size = SAVE_EXPLORED_SIZE + 4 + materials.size();
+	double megabytes = (double)MINE_TILES * repeats / 1e6;
+
+	printf("%-8s %8d %8d %8.1fx %10.0f %10.0f %s\n", name, MINE_TILES, packed_size,
+		   (double)MINE_TILES / packed_size, megabytes / (pack_ns / 1e9), megabytes / (unpack_ns / 1e9),
+		   same ? "" : "DIFFERS");
+
+	delete [] unpacked;
+
+	return same;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int seed = 1;
+	int repeats = 20;
+
+	for(int arg = 1; arg < argc; arg++)
+	{
+		if(strcmp(argv[arg], "--seed") == 0 && arg + 1 < argc)
+		{
+			seed = atoi(argv[++arg]);
+		}
+		else if(strcmp(argv[arg], "--repeats") == 0 && arg + 1 < argc)
+		{
+			repeats = atoi(argv[++arg]);
+		}
+		else
+		{
+			printf("Usage: save_bench [--seed N] [--repeats N]\n");
+			return 1;
+		}
+	}
+
+	if(repeats < 1)
+	{
+		repeats = 1;
+	}
+
+	MineData *mine = new MineData(seed);
+	MineData *loaded = new MineData;
+	PlayerData player;
+	PlayerData loaded_player;
+	player.reset(seed);
+
+	// Dig out a third of the mine, in the last row and column too.
+	dig_out(mine, LAYOUT_RANDOM, seed);
+
+	player.change_money(1234);
+	player.set_turn_number(321);
+
+	long long text_save = 0;
+	long long text_load = 0;
+	long long binary_save = 0;
+	long long binary_load = 0;
+
+	for(int repeat = 0; repeat < repeats; repeat++)
+	{
+		long long start = Timer::get_ticks_ns();
+		write_text_save(mine, &player);
+		text_save += Timer::get_ticks_ns() - start;
+
+		start = Timer::get_ticks_ns();
+		read_text_save(BENCH_PLAYER_FILE, BENCH_MINE_FILE, loaded, &loaded_player);
+		text_load += Timer::get_ticks_ns() - start;
+
+		start = Timer::get_ticks_ns();
+		write_save(BENCH_SAVE_FILE, mine, &player);
+		binary_save += Timer::get_ticks_ns() - start;
+
+		start = Timer::get_ticks_ns();
+		read_save(BENCH_SAVE_FILE, loaded, &loaded_player);
+		binary_load += Timer::get_ticks_ns() - start;
+	}
+
+	printf("%-8s %10s %10s %10s\n", "format", "save ms", "load ms", "bytes");
+	printf("%-8s %10.3f %10.3f %10lld\n", "text", text_save / 1e6 / repeats, text_load / 1e6 / repeats,
+		   file_size(BENCH_PLAYER_FILE) + file_size(BENCH_MINE_FILE));
+	printf("%-8s %10.3f %10.3f %10lld\n", "binary", binary_save / 1e6 / repeats, binary_load / 1e6 / repeats,
+		   file_size(BENCH_SAVE_FILE));
+
+	bool text_ok = read_text_save(BENCH_PLAYER_FILE, BENCH_MINE_FILE, loaded, &loaded_player)
+		&& count_differences(mine, loaded, false) == 0;
+	bool binary_ok = read_save(BENCH_SAVE_FILE, loaded, &loaded_player) && count_differences(mine, loaded, true) == 0
+		&& loaded->get_tile_checksum() == mine->get_tile_checksum()
+		&& loaded_player.get_money() == player.get_money();
+
+	printf("Text load %s, binary load %s.\n", text_ok ? "matches" : "DIFFERS", binary_ok ? "matches" : "DIFFERS");
+
+	remove(BENCH_PLAYER_FILE);
+	remove(BENCH_MINE_FILE);
+	remove(BENCH_SAVE_FILE);
+
+	printf("\n%-8s %8s %8s %9s %10s %10s\n", "mine", "tiles", "packed", "ratio", "pack MB/s", "unpack MB/s");
+
+	bool packing_ok = true;
+
+	for(int layout = 0; layout < LAYOUT_COUNT; layout++)
+	{
+		mine->reset(seed);
+		dig_out(mine, (bench_layout)layout, seed);
+		packing_ok = bench_packing(mine, layout_names[layout], repeats * 10) && packing_ok;
+	}
+
+	delete mine;
+	delete loaded;
+
+	return text_ok && binary_ok && packing_ok ? 0 : 2;
+}
@@ -0,0 +1,778 @@
+/*
+ server.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Hosts many headless games at once over a socket, for web clients and
+ tournaments. Linux only.
+
+ Each connection is one session: a player and a mine, played with
+ actions in the recording's format (see tools/server_protocol.h).
+
+ The sessions are split between worker threads ("shards"). Each shard
+ has its own epoll loop, its own arena of session slots and the scratch
+ its sessions' mines share while an action is carried out, and takes
+ new connections straight off the shared listening socket, so shards
+ never hand sessions to each other or share a lock. A slot is only
+ ever used by its shard, and is reused once its session closes.
+
+ Runs until interrupted, or for --seconds, then prints its totals.
+
+ Usage:
+	server [--port N | --socket PATH] [--threads N] [--sessions N]
+		   [--seconds N]
+
+	--sessions is how many sessions each shard can hold at once.
+
+ Build (from the source directory):
+	g++ -std=c++11 -O2 -I. -Itools tools/server.cpp classes.cpp
+		game_events.cpp game_random.cpp game_rules.cpp economy.cpp
+		game_recorder.cpp market.cpp turn_scheduler.cpp timer.cpp
+		trace.cpp -lpthread -o server
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <ctime>
+#include <new>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "classes.h"
+#include "game_rules.h"
+#include "game_recorder.h"
+#include "server_protocol.h"
+#include "timer.h"
+
+// Bytes buffered each way for a session. The input buffer holds
+// actions that have arrived but haven't been carried out; the output
+// buffer holds replies the client hasn't taken yet.
+const int SESSION_BUFFER = 4096;
+
+// Events taken from epoll at a time.
+const int SHARD_EVENTS = 256;
+
+// epoll's tag for the listening socket, which isn't a slot.
+const unsigned int LISTENER_TAG = 0xFFFFFFFF;
+
+// Set by SIGINT and SIGTERM.
+static volatile sig_atomic_t stopping = 0;
+
+static void stop_server(int)
+{
+	stopping = 1;
+}
+
+// A session's game.
+struct Session_Game
+{
+	PlayerData player;
+	MineData mine;
+
+	// The mine works through its turns in the shard's scratch.
+	Session_Game(unsigned int player_seed, unsigned int mine_seed, Mine_Scratch *scratch)
+	{
+		player.set_seed(player_seed);
+		mine.set_scratch(scratch);
+		mine.reset(mine_seed);
+	}
+};
+
+// One connection and, once its header has arrived, its game.
+struct Session
+{
+	int fd;
+	bool has_game;
+	int state;				// session_state after the last action.
+	bool closing;			// Close once the output has been sent.
+	bool waiting_to_write;	// Waiting on EPOLLOUT, not EPOLLIN.
+
+	int in_length;
+	int out_start;
+	int out_length;
+	unsigned char in[SESSION_BUFFER];
+	unsigned char out[SESSION_BUFFER];
+
+	// The game is built in place here, so it comes out of the arena too.
+	alignas(Session_Game) unsigned char game_storage[sizeof(Session_Game)];
+
+	Session_Game *game()
+	{
+		return reinterpret_cast<Session_Game *>(game_storage);
+	}
+};
+
+// A shard's sessions, in slots reserved up front. The memory is only
+// mapped, so slots cost nothing until they are used, and a slot freed
+// by one session is the first given to the next, while its pages are
+// still in memory.
+class Session_Arena
+{
+	private:
+		Session *slots;
+		int capacity;
+		std::vector<int> free_slots;
+
+	public:
+		Session_Arena(int capacity)
+		{
+			this->capacity = capacity;
+
+			void *memory = mmap(NULL, (size_t)capacity * sizeof(Session), PROT_READ | PROT_WRITE,
+								MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+			if(memory == MAP_FAILED)
+			{
+				slots = NULL;
+				this->capacity = 0;
+				return;
+			}
+
+			slots = (Session *)memory;
+
+			// Lowest slots on top, so the same few are reused when it's quiet.
+			for(int slot = capacity - 1; slot >= 0; slot--)
+			{
+				free_slots.push_back(slot);
+			}
+		}
+
+		~Session_Arena()
+		{
+			if(slots != NULL)
+			{
+				munmap(slots, (size_t)capacity * sizeof(Session));
+			}
+		}
+
+		// Returns the slot number, or -1 if they are all in use.
+		int acquire()
+		{
+			if(free_slots.empty())
+			{
+				return -1;
+			}
+
+			int slot = free_slots.back();
+			free_slots.pop_back();
+
+			return slot;
+		}
+
+		void release(int slot)
+		{
+			free_slots.push_back(slot);
+		}
+
+		Session *get(int slot)
+		{
+			return &slots[slot];
+		}
+};
+
+// Totals kept by each shard. Only the shard writes them; anyone may read.
+struct Shard_Totals
+{
+	std::atomic<long long> sessions_open;
+	std::atomic<long long> sessions_started;
+	std::atomic<long long> sessions_peak;
+	std::atomic<long long> actions;
+	char padding[64];
+};
+
+struct Server_Settings
+{
+	int port;
+	const char *socket_path;	// A Unix socket instead of TCP, or NULL.
+	int threads;
+	int sessions;				// Per shard.
+	int seconds;				// 0 to run until interrupted.
+};
+
+class Shard
+{
+	private:
+		int epoll_fd;
+		int listen_fd;
+		Session_Arena arena;
+		Shard_Totals *totals;
+
+		// Shared by the sessions' mines, since only one acts at a time.
+		Mine_Scratch *scratch;
+
+		// Every shard's totals, for answering a stats request.
+		std::vector<Shard_Totals *> *all_totals;
+
+		void accept_sessions();
+		void close_session(int slot);
+
+		// Carry out whatever complete actions have arrived. Returns false
+		// if the session should be closed.
+		bool handle_input(Session *session);
+
+		// Send what it can. Returns false if the connection has gone.
+		bool flush_output(Session *session);
+
+		// Wait for the socket to be readable, or writable.
+		void watch(int slot, bool for_writing);
+
+		bool answer_stats(Session *session);
+
+	public:
+		Shard(int listen_fd, int capacity, Shard_Totals *totals, std::vector<Shard_Totals *> *all_totals);
+		~Shard();
+
+		void run();
+};
+
+Shard::Shard(int listen_fd, int capacity, Shard_Totals *totals, std::vector<Shard_Totals *> *all_totals)
+	: arena(capacity)
+{
+	this->listen_fd = listen_fd;
+	this->totals = totals;
+	this->all_totals = all_totals;
+
+	scratch = new Mine_Scratch;
+
+	epoll_fd = epoll_create1(0);
+
+	// Each new connection wakes only one shard.
+	epoll_event event;
+	event.events = EPOLLIN | EPOLLEXCLUSIVE;
+	event.data.u32 = LISTENER_TAG;
+	epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+}
+
+Shard::~Shard()
+{
+	close(epoll_fd);
+	delete scratch;
+}
+
+void Shard::watch(int slot, bool for_writing)
+{
+	Session *session = arena.get(slot);
+
+	if(session->waiting_to_write == for_writing)
+	{
+		return;
+	}
+
+	epoll_event event;
+	event.events = for_writing ? EPOLLOUT : EPOLLIN;
+	event.data.u32 = slot;
+	epoll_ctl(epoll_fd, EPOLL_CTL_MOD, session->fd, &event);
+
+	session->waiting_to_write = for_writing;
+}
+
+// Take every connection waiting, for as long as there are free slots.
+void Shard::accept_sessions()
+{
+	while(true)
+	{
+		int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK);
+
+		if(fd < 0)
+		{
+			// EAGAIN: another shard got there first, or there are no more.
+			return;
+		}
+
+		int slot = arena.acquire();
+
+		if(slot < 0)
+		{
+			close(fd);
+			continue;
+		}
+
+		int on = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+		Session *session = arena.get(slot);
+		session->fd = fd;
+		session->has_game = false;
+		session->state = SESSION_PLAYING;
+		session->closing = false;
+		session->waiting_to_write = false;
+		session->in_length = 0;
+		session->out_start = 0;
+		session->out_length = 0;
+
+		epoll_event event;
+		event.events = EPOLLIN;
+		event.data.u32 = slot;
+		epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+
+		long long open = totals->sessions_open.fetch_add(1, std::memory_order_relaxed) + 1;
+
+		if(open > totals->sessions_peak.load(std::memory_order_relaxed))
+		{
+			totals->sessions_peak.store(open, std::memory_order_relaxed);
+		}
+	}
+}
+
+void Shard::close_session(int slot)
+{
+	Session *session = arena.get(slot);
+
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, session->fd, NULL);
+	close(session->fd);
+
+	if(session->has_game)
+	{
+		session->game()->~Session_Game();
+		session->has_game = false;
+	}
+
+	arena.release(slot);
+	totals->sessions_open.fetch_sub(1, std::memory_order_relaxed);
+}
+
+// Send the server's totals and close.
+bool Shard::answer_stats(Session *session)
+{
+	Server_Stats stats;
+	memset(&stats, 0, sizeof(stats));
+
+	for(unsigned int shard = 0; shard < all_totals->size(); shard++)
+	{
+		Shard_Totals *shard_totals = (*all_totals)[shard];
+
+		stats.sessions_open += shard_totals->sessions_open.load(std::memory_order_relaxed);
+		stats.sessions_started += shard_totals->sessions_started.load(std::memory_order_relaxed);
+		stats.sessions_peak += shard_totals->sessions_peak.load(std::memory_order_relaxed);
+		stats.actions += shard_totals->actions.load(std::memory_order_relaxed);
+	}
+
+	// Don't count the stats request itself.
+	stats.sessions_open--;
+
+	timespec cpu;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu);
+	stats.cpu_ns = (long long)cpu.tv_sec * 1000000000LL + cpu.tv_nsec;
+	stats.threads = all_totals->size();
+
+	write_stats(session->out + session->out_length, stats);
+	session->out_length += SERVER_STATS_SIZE;
+	session->in_length = 0;
+	session->closing = true;
+
+	return true;
+}
+
+// Carry out whatever complete actions have arrived.
+bool Shard::handle_input(Session *session)
+{
+	int position = 0;
+
+	if(!session->has_game)
+	{
+		if(session->in_length >= 4 && memcmp(session->in, SERVER_STATS_MAGIC, 4) == 0)
+		{
+			return answer_stats(session);
+		}
+
+		if(session->in_length < RECORD_HEADER_SIZE)
+		{
+			return true;
+		}
+
+		unsigned int player_seed = 0;
+		unsigned int mine_seed = 0;
+
+		if(!read_record_header(session->in, session->in_length, player_seed, mine_seed))
+		{
+			return false;
+		}
+
+		new (session->game_storage) Session_Game(player_seed, mine_seed, scratch);
+		session->has_game = true;
+		position = RECORD_HEADER_SIZE;
+
+		totals->sessions_started.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	PlayerData *player = &session->game()->player;
+	MineData *mine = &session->game()->mine;
+	long long actions = 0;
+
+	// Stop once there's no room for another reply; the rest waits until
+	// the client has taken some.
+	while(position < session->in_length
+		  && session->out_start + session->out_length + SERVER_REPLY_SIZE <= SESSION_BUFFER)
+	{
+		int length = get_action_length(session->in[position]);
+
+		if(length == 0)
+		{
+			return false;
+		}
+		else if(session->in_length - position < length)
+		{
+			break;
+		}
+
+		Server_Reply reply;
+		reply.action = session->in[position];
+		reply.state = SESSION_PLAYING;
+
+		// A game that's over only answers.
+		if(session->state != SESSION_DEAD && session->state != SESSION_BROKE)
+		{
+			perform_action(player, mine, session->in + position, length, length);
+		}
+
+		position += length;
+		actions++;
+
+		if(!player->check_health())
+		{
+			reply.state = SESSION_DEAD;
+		}
+		else if(player->get_money() < 0)
+		{
+			reply.state = SESSION_BROKE;
+		}
+		else if(can_win_game(player))
+		{
+			reply.state = SESSION_CAN_WIN;
+		}
+
+		reply.x = player->get_location_x();
+		reply.y = player->get_location_y();
+		reply.health = player->get_health();
+		reply.money = player->get_money();
+		reply.turn = player->get_turn_number();
+		session->state = reply.state;
+
+		write_reply(session->out + session->out_start + session->out_length, reply);
+		session->out_length += SERVER_REPLY_SIZE;
+	}
+
+	totals->actions.fetch_add(actions, std::memory_order_relaxed);
+
+	// Keep what's left of a part-sent action for next time.
+	memmove(session->in, session->in + position, session->in_length - position);
+	session->in_length -= position;
+
+	return true;
+}
+
+// Send what it can.
+bool Shard::flush_output(Session *session)
+{
+	while(session->out_length > 0)
+	{
+		ssize_t sent = send(session->fd, session->out + session->out_start, session->out_length, MSG_NOSIGNAL);
+
+		if(sent < 0)
+		{
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		}
+
+		session->out_start += sent;
+		session->out_length -= sent;
+	}
+
+	session->out_start = 0;
+
+	return true;
+}
+
+void Shard::run()
+{
+	epoll_event events[SHARD_EVENTS];
+
+	while(!stopping)
+	{
+		// Wake now and then to see if the server is stopping.
+		int count = epoll_wait(epoll_fd, events, SHARD_EVENTS, 100);
+
+		for(int index = 0; index < count; index++)
+		{
+			unsigned int slot = events[index].data.u32;
+
+			if(slot == LISTENER_TAG)
+			{
+				accept_sessions();
+				continue;
+			}
+
+			Session *session = arena.get(slot);
+			bool keep = true;
+
+			if(events[index].events & (EPOLLERR | EPOLLHUP))
+			{
+				keep = false;
+			}
+
+			if(keep && (events[index].events & EPOLLIN))
+			{
+				ssize_t received = recv(session->fd, session->in + session->in_length,
+										SESSION_BUFFER - session->in_length, 0);
+
+				if(received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+				{
+					keep = false;
+				}
+				else if(received > 0)
+				{
+					session->in_length += received;
+				}
+			}
+
+			// After writing, there may be actions that were waiting for room.
+			if(keep)
+			{
+				keep = handle_input(session) && flush_output(session);
+			}
+
+			if(keep && session->closing && session->out_length == 0)
+			{
+				keep = false;
+			}
+
+			if(!keep)
+			{
+				close_session(slot);
+				continue;
+			}
+
+			// Only read more once the replies have all gone.
+			watch(slot, session->out_length > 0);
+		}
+	}
+}
+
+// Open the listening socket. Returns -1 if it can't be.
+static int open_listener(const Server_Settings &settings)
+{
+	int fd = -1;
+
+	if(settings.socket_path != NULL)
+	{
+		fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+
+		sockaddr_un address;
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		strncpy(address.sun_path, settings.socket_path, sizeof(address.sun_path) - 1);
+
+		unlink(settings.socket_path);
+
+		if(fd < 0 || bind(fd, (sockaddr *)&address, sizeof(address)) < 0)
+		{
+			return -1;
+		}
+	}
+	else
+	{
+		fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+
+		int on = 1;
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+		sockaddr_in address;
+		memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_port = htons(settings.port);
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		if(fd < 0 || bind(fd, (sockaddr *)&address, sizeof(address)) < 0)
+		{
+			return -1;
+		}
+	}
+
+	if(listen(fd, SOMAXCONN) < 0)
+	{
+		return -1;
+	}
+
+	return fd;
+}
+
+static void print_usage()
+{
+	printf("Usage: server [--port N | --socket PATH] [--threads N] [--sessions N] [--seconds N]\n");
+}
+
+int main(int argc, char *argv[])
+{
+	Server_Settings settings;
+	settings.port = SERVER_DEFAULT_PORT;
+	settings.socket_path = NULL;
+	settings.threads = 0;
+	settings.sessions = 4096;
+	settings.seconds = 0;
+
+	for(int arg = 1; arg < argc; arg++)
+	{
+		bool has_value = arg + 1 < argc;
+
+		if(strcmp(argv[arg], "--port") == 0 && has_value)
+		{
+			settings.port = atoi(argv[++arg]);
+		}
+		else if(strcmp(argv[arg], "--socket") == 0 && has_value)
+		{
+			settings.socket_path = argv[++arg];
+		}
+		else if(strcmp(argv[arg], "--threads") == 0 && has_value)
+		{
+			settings.threads = atoi(argv[++arg]);
+		}
+		else if(strcmp(argv[arg], "--sessions") == 0 && has_value)
+		{
+			settings.sessions = atoi(argv[++arg]);
+		}
+		else if(strcmp(argv[arg], "--seconds") == 0 && has_value)
+		{
+			settings.seconds = atoi(argv[++arg]);
+		}
+		else
+		{
+			print_usage();
+			return 1;
+		}
+	}
+
+	if(settings.threads <= 0)
+	{
+		settings.threads = std::thread::hardware_concurrency();
+
+		if(settings.threads <= 0)
+		{
+			settings.threads = 1;
+		}
+	}
+
+	int listen_fd = open_listener(settings);
+
+	if(listen_fd < 0)
+	{
+		printf("Couldn't listen: %s\n", strerror(errno));
+		return 1;
+	}
+
+	signal(SIGINT, stop_server);
+	signal(SIGTERM, stop_server);
+	signal(SIGPIPE, SIG_IGN);
+
+	std::vector<Shard_Totals *> totals(settings.threads);
+	std::vector<Shard *> shards(settings.threads);
+
+	for(int shard = 0; shard < settings.threads; shard++)
+	{
+		totals[shard] = new Shard_Totals;
+		totals[shard]->sessions_open = 0;
+		totals[shard]->sessions_started = 0;
+		totals[shard]->sessions_peak = 0;
+		totals[shard]->actions = 0;
+	}
+
+	for(int shard = 0; shard < settings.threads; shard++)
+	{
+		shards[shard] = new Shard(listen_fd, settings.sessions, totals[shard], &totals);
+	}
+
+	if(settings.socket_path != NULL)
+	{
+		printf("Listening on %s with %d threads, %d sessions each.\n", settings.socket_path,
+			   settings.threads, settings.sessions);
+	}
+	else
+	{
+		printf("Listening on 127.0.0.1:%d with %d threads, %d sessions each.\n", settings.port,
+			   settings.threads, settings.sessions);
+	}
+
+	fflush(stdout);
+
+	long long start = Timer::get_ticks_ns();
+	std::vector<std::thread> threads;
+
+	for(int shard = 0; shard < settings.threads; shard++)
+	{
+		threads.push_back(std::thread(&Shard::run, shards[shard]));
+	}
+
+	while(!stopping)
+	{
+		usleep(100000);
+
+		if(settings.seconds > 0 && Timer::get_ticks_ns() - start >= settings.seconds * 1000000000LL)
+		{
+			stopping = 1;
+		}
+	}
+
+	for(unsigned int thread = 0; thread < threads.size(); thread++)
+	{
+		threads[thread].join();
+	}
+
+	double seconds = (Timer::get_ticks_ns() - start) / 1e9;
+	long long started = 0;
+	long long peak = 0;
+	long long actions = 0;
+
+	for(int shard = 0; shard < settings.threads; shard++)
+	{
+		started += totals[shard]->sessions_started;
+		peak += totals[shard]->sessions_peak;
+		actions += totals[shard]->actions;
+
+		delete shards[shard];
+		delete totals[shard];
+	}
+
+	timespec cpu;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu);
+	double cpu_seconds = cpu.tv_sec + cpu.tv_nsec / 1e9;
+
+	printf("%.1f s, %lld sessions started, peak %lld open, %lld actions (%.0f/s)\n", seconds, started, peak,
+		   actions, actions / seconds);
+	printf("%.2f s of CPU, %.0f actions per CPU second\n", cpu_seconds,
+		   cpu_seconds > 0 ? actions / cpu_seconds : 0.0);
+
+	close(listen_fd);
+
+	if(settings.socket_path != NULL)
+	{
+		unlink(settings.socket_path);
+	}
+
+	return 0;
+}
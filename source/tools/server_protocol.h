@@ -0,0 +1,146 @@
+/*
+ server_protocol.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ What the game server (tools/server.cpp) and its load generator
+ (tools/load_client.cpp) say to each other.
+
+ A client starts a game by sending a recording's header with the
+ seeds (see game_recorder.h), then sends actions in the recording's
+ format. The server answers every action with a SERVER_REPLY_SIZE
+ reply saying where the game stands. A game that is over still
+ answers, but nothing more happens to it.
+
+ A client that sends SERVER_STATS_MAGIC instead of a header gets one
+ SERVER_STATS_SIZE reply with the server's totals, and is then
+ disconnected.
+
+ Everything is little-endian.
+*/
+
+#ifndef SERVER_PROTOCOL
+#define SERVER_PROTOCOL
+
+#include "game_recorder.h"
+
+// Where the server listens unless told otherwise.
+const int SERVER_DEFAULT_PORT = 7411;
+
+const char SERVER_STATS_MAGIC[4] = { 'M', 'S', 'T', 'A' };
+
+// How a session's game stands.
+enum session_state
+{
+	SESSION_PLAYING,
+	SESSION_DEAD,
+	SESSION_BROKE,
+	SESSION_CAN_WIN		// Has the diamond and the money to win at the tavern.
+};
+
+// uint8 action, uint8 session_state, int16 x, int16 y, int16 health,
+// int32 money, int32 turn.
+const int SERVER_REPLY_SIZE = 16;
+
+struct Server_Reply
+{
+	int action;
+	int state;
+	int x;
+	int y;
+	int health;
+	int money;
+	int turn;
+};
+
+// uint64 sessions open, sessions started, peak sessions open, actions
+// carried out, nanoseconds of CPU the server has used, and worker threads.
+const int SERVER_STATS_SIZE = 48;
+
+struct Server_Stats
+{
+	long long sessions_open;
+	long long sessions_started;
+	long long sessions_peak;
+	long long actions;
+	long long cpu_ns;
+	long long threads;
+};
+
+inline void write_le(unsigned char *data, unsigned long long value, int bytes)
+{
+	for(int byte = 0; byte < bytes; byte++)
+	{
+		data[byte] = (unsigned char)(value >> (byte * 8));
+	}
+}
+
+inline unsigned long long read_le(const unsigned char *data, int bytes)
+{
+	unsigned long long value = 0;
+
+	for(int byte = 0; byte < bytes; byte++)
+	{
+		value |= (unsigned long long)data[byte] << (byte * 8);
+	}
+
+	return value;
+}
+
+inline void write_reply(unsigned char *data, const Server_Reply &reply)
+{
+	data[0] = (unsigned char)reply.action;
+	data[1] = (unsigned char)reply.state;
+	write_le(data + 2, reply.x, 2);
+	write_le(data + 4, reply.y, 2);
+	write_le(data + 6, reply.health, 2);
+	write_le(data + 8, reply.money, 4);
+	write_le(data + 12, reply.turn, 4);
+}
+
+inline void read_reply(const unsigned char *data, Server_Reply &reply)
+{
+	reply.action = data[0];
+	reply.state = data[1];
+	reply.x = (short)read_le(data + 2, 2);
+	reply.y = (short)read_le(data + 4, 2);
+	reply.health = (short)read_le(data + 6, 2);
+	reply.money = (int)read_le(data + 8, 4);
+	reply.turn = (int)read_le(data + 12, 4);
+}
+
+inline void write_stats(unsigned char *data, const Server_Stats &stats)
+{
+	write_le(data, stats.sessions_open, 8);
+	write_le(data + 8, stats.sessions_started, 8);
+	write_le(data + 16, stats.sessions_peak, 8);
+	write_le(data + 24, stats.actions, 8);
+	write_le(data + 32, stats.cpu_ns, 8);
+	write_le(data + 40, stats.threads, 8);
+}
+
+inline void read_stats(const unsigned char *data, Server_Stats &stats)
+{
+	stats.sessions_open = read_le(data, 8);
+	stats.sessions_started = read_le(data + 8, 8);
+	stats.sessions_peak = read_le(data + 16, 8);
+	stats.actions = read_le(data + 24, 8);
+	stats.cpu_ns = read_le(data + 32, 8);
+	stats.threads = read_le(data + 40, 8);
+}
+
+#endif
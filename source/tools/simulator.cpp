@@ -0,0 +1,1042 @@
+/*
+ simulator.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Batch Monte Carlo simulator for game balance.
+
+ Plays many games headless, one per seed, with a scripted or a
+ heuristic player, spread over every core. Reports how often games are
+ won, lost to death or debt, or run out of turns, along with the
+ spread of money and turns at the end, and how many games per second
+ were played.
+
+ With --record, the first game is recorded to a file that
+ tools/replay.cpp can play back.
+
+ Usage:
+	simulator [--games N] [--threads N] [--seed N] [--max-turns N]
+			  [--strategy scripted|heuristic] [--record FILE]
+
+ Build (from the source directory):
+	g++ -std=c++11 -O2 -I. tools/simulator.cpp classes.cpp game_events.cpp
+		game_random.cpp game_rules.cpp economy.cpp autopilot.cpp
+		thread_pool.cpp timer.cpp trace.cpp turn_scheduler.cpp
+		game_recorder.cpp market.cpp -lpthread -o simulator
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "classes.h"
+#include "game_rules.h"
+#include "economy.h"
+#include "autopilot.h"
+#include "game_random.h"
+#include "game_recorder.h"
+#include "thread_pool.h"
+#include "timer.h"
+
+// How a game ended.
+enum game_outcome
+{
+	OUTCOME_WON,
+	OUTCOME_DIED,
+	OUTCOME_BROKE,
+	OUTCOME_TIMED_OUT,
+	OUTCOME_STRANDED,		// Couldn't find the way back to the elevator.
+	OUTCOME_COUNT
+};
+
+// How the simulated player decides what to do.
+enum sim_strategy
+{
+	STRATEGY_SCRIPTED,		// Dig straight along a new row each trip.
+	STRATEGY_HEURISTIC		// Wander towards unexplored ground, buy tips, chase the diamond.
+};
+
+// Games handed to the pool at a time.
+const int GAMES_PER_TASK = 16;
+
+// Money and turn histograms.
+const int MONEY_BUCKET_SIZE = 250;
+const int MONEY_MIN = -1000;
+const int MONEY_BUCKETS = 128;
+const int TURN_BUCKET_SIZE = 25;
+const int TURN_BUCKETS = 256;
+
+// Money kept back when shopping, so the player can still afford to dig.
+const int SHOPPING_RESERVE = 1000;
+
+// Money kept back in the mine to pay for the way home, on top of what
+// the way back is thought to cost, and how many steps apart that's priced.
+const int DIGGING_RESERVE = 100;
+const int WAY_BACK_CHECK_STEPS = 4;
+
+// The tip the heuristic player buys, and what it saves before buying
+// it. Whatever is left after the tip digs towards it a trip at a time,
+// selling what turns up on the way.
+const tip_amount HEURISTIC_TIP = BEST;
+const int TIP_SAVINGS = 2500;
+
+// Fixed-width histogram of integer samples.
+struct Sim_Histogram
+{
+	long long buckets[TURN_BUCKETS > MONEY_BUCKETS ? TURN_BUCKETS : MONEY_BUCKETS];
+	int bucket_count;
+	int bucket_size;
+	int minimum;
+
+	void clear(int bucket_count, int bucket_size, int minimum)
+	{
+		this->bucket_count = bucket_count;
+		this->bucket_size = bucket_size;
+		this->minimum = minimum;
+
+		memset(buckets, 0, sizeof(buckets));
+	}
+
+	void add(int value)
+	{
+		int bucket = (value - minimum) / bucket_size;
+
+		if(value < minimum || bucket < 0)
+		{
+			bucket = 0;
+		}
+		else if(bucket >= bucket_count)
+		{
+			bucket = bucket_count - 1;
+		}
+
+		buckets[bucket]++;
+	}
+
+	void merge(const Sim_Histogram &other)
+	{
+		for(int bucket = 0; bucket < bucket_count; bucket++)
+		{
+			buckets[bucket] += other.buckets[bucket];
+		}
+	}
+
+	// Returns the lower edge of the bucket holding the given percentile.
+	int get_percentile(int percentile, long long total)
+	{
+		long long wanted = (total * percentile + 99) / 100;
+		long long seen = 0;
+
+		for(int bucket = 0; bucket < bucket_count; bucket++)
+		{
+			seen += buckets[bucket];
+
+			if(seen >= wanted && seen > 0)
+			{
+				return minimum + bucket * bucket_size;
+			}
+		}
+
+		return minimum + (bucket_count - 1) * bucket_size;
+	}
+};
+
+// Results gathered by one worker. Only that worker writes to it, so no
+// locking is needed; the workers' totals are merged once all are done.
+// Padded so two workers' hot counters never share a cache line.
+struct Sim_Totals
+{
+	long long games;
+	long long outcomes[OUTCOME_COUNT];
+	long long money_total;
+	long long turns_total;
+	long long diamonds_found;
+	Sim_Histogram money;
+	Sim_Histogram turns;
+	char padding[64];
+
+	void clear()
+	{
+		games = 0;
+		money_total = 0;
+		turns_total = 0;
+		diamonds_found = 0;
+
+		for(int outcome = 0; outcome < OUTCOME_COUNT; outcome++)
+		{
+			outcomes[outcome] = 0;
+		}
+
+		money.clear(MONEY_BUCKETS, MONEY_BUCKET_SIZE, MONEY_MIN);
+		turns.clear(TURN_BUCKETS, TURN_BUCKET_SIZE, 0);
+	}
+
+	void merge(const Sim_Totals &other)
+	{
+		games += other.games;
+		money_total += other.money_total;
+		turns_total += other.turns_total;
+		diamonds_found += other.diamonds_found;
+
+		for(int outcome = 0; outcome < OUTCOME_COUNT; outcome++)
+		{
+			outcomes[outcome] += other.outcomes[outcome];
+		}
+
+		money.merge(other.money);
+		turns.merge(other.turns);
+	}
+};
+
+// Settings for a batch of games.
+struct Sim_Settings
+{
+	long long games;
+	int threads;
+	unsigned int first_seed;
+	int max_turns;
+	sim_strategy strategy;
+	const char *record_path;	// Where to record the first game, or NULL.
+};
+
+// One simulated game.
+class Sim_Game
+{
+	private:
+		PlayerData *player;
+		MineData *mine;
+		const Sim_Settings *settings;
+		Autopilot *autopilot;
+
+		// The player's own choices, kept apart from the game's numbers.
+		Game_Random choices;
+
+		int trip_number;
+		bool last_trip_moved;	// False if the last trip couldn't leave the elevator.
+
+		// Where the player has stepped this trip, to find the way back.
+		std::vector<int> trail_x;
+		std::vector<int> trail_y;
+
+		// Whether a tip has been bought and the diamond not yet found,
+		// and the level in the middle of the tip's area.
+		bool knows_diamond;
+		int target_y;
+
+		// Returns true and sets the outcome if the game is over.
+		bool check_game_over(game_outcome &outcome);
+
+		// Try to move one tile. Returns true if the player moved.
+		bool step(int x, int y);
+
+		// Returns true if a tile is worth trying to step onto.
+		bool can_try(int x, int y);
+
+		// Choose the next tile to dig towards. Returns false to head home.
+		bool choose_step(int trip_steps, int &x, int &y);
+
+		// Follow the autopilot until it stops, or money is down to the
+		// reserve. Returns true if the game ended.
+		bool follow_autopilot(game_outcome &outcome, int reserve = 0);
+
+		// Dig the tip's area tile by tile, nearest first, until the diamond
+		// turns up or money is down to the reserve. Returns true if the
+		// game ended.
+		bool search_tip(game_outcome &outcome);
+
+		// Money not to spend in the store.
+		int get_shopping_reserve();
+
+		// Money to keep in the mine for the way back to the elevator.
+		int get_way_back_cost();
+
+		void visit_town();
+		bool mine_trip(game_outcome &outcome);
+
+	public:
+		Sim_Game(PlayerData *player, MineData *mine, const Sim_Settings *settings, Autopilot *autopilot,
+				 unsigned int seed);
+
+		game_outcome play();
+};
+
+Sim_Game::Sim_Game(PlayerData *player, MineData *mine, const Sim_Settings *settings, Autopilot *autopilot,
+				   unsigned int seed)
+{
+	this->player = player;
+	this->mine = mine;
+	this->settings = settings;
+	this->autopilot = autopilot;
+
+	choices.seed(((unsigned long long)seed << 32) | 0x5EED);
+	trip_number = 0;
+	last_trip_moved = true;
+	knows_diamond = false;
+	target_y = 0;
+}
+
+bool Sim_Game::check_game_over(game_outcome &outcome)
+{
+	if(!player->check_health())
+	{
+		outcome = OUTCOME_DIED;
+		return true;
+	}
+
+	if(player->get_money() < 0)
+	{
+		outcome = OUTCOME_BROKE;
+		return true;
+	}
+
+	if(player->get_turn_number() >= settings->max_turns)
+	{
+		outcome = OUTCOME_TIMED_OUT;
+		return true;
+	}
+
+	return false;
+}
+
+bool Sim_Game::step(int x, int y)
+{
+	int old_x = player->get_location_x();
+	int old_y = player->get_location_y();
+
+	player->change_location(x, y, mine);
+
+	return player->get_location_x() != old_x || player->get_location_y() != old_y;
+}
+
+// Known hazards are avoided unless the player has the tool for them,
+// and springs and cave-ins always.
+bool Sim_Game::can_try(int x, int y)
+{
+	if(x < 1 || y < 0 || x >= mine->get_map_x() || y >= mine->get_map_y())
+	{
+		return false;
+	}
+
+	if(!mine->get_explored(x, y))
+	{
+		return true;
+	}
+
+	materials contents = mine->get_contents(x, y);
+
+	if(contents == WATER)
+	{
+		return player->get_has_bucket();
+	}
+
+	if(contents == GRANITE)
+	{
+		return player->get_has_axe();
+	}
+
+	// A known spring or cave-in hurts the player every time.
+	if(contents == SPRING || contents == CAVE_IN)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool Sim_Game::choose_step(int trip_steps, int &x, int &y)
+{
+	int here_x = player->get_location_x();
+	int here_y = player->get_location_y();
+
+	if(settings->strategy == STRATEGY_SCRIPTED)
+	{
+		// Straight along the row, dropping a row to get around anything in the way.
+		if(trip_steps >= 40)
+		{
+			return false;
+		}
+
+		if(can_try(here_x + 1, here_y))
+		{
+			x = here_x + 1;
+			y = here_y;
+		}
+		else
+		{
+			x = here_x;
+			y = here_y + 1;
+		}
+
+		return can_try(x, y);
+	}
+
+	// Heuristic: prefer unexplored ground. Ties are broken at random.
+	const int move_x[4] = { 1, 0, 0, -1 };
+	const int move_y[4] = { 0, 1, -1, 0 };
+
+	int best_score = -1000000;
+	bool found = false;
+
+	if(trip_steps >= 300)
+	{
+		return false;
+	}
+
+	for(int move = 0; move < 4; move++)
+	{
+		int next_x = here_x + move_x[move];
+		int next_y = here_y + move_y[move];
+
+		if(!can_try(next_x, next_y))
+		{
+			continue;
+		}
+
+		int score = choices.next_int(8);
+
+		if(!mine->get_explored(next_x, next_y))
+		{
+			score += 32;
+		}
+
+		if(score > best_score)
+		{
+			best_score = score;
+			x = next_x;
+			y = next_y;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+bool Sim_Game::follow_autopilot(game_outcome &outcome, int reserve)
+{
+	while(autopilot->is_active())
+	{
+		if(player->get_money() <= reserve)
+		{
+			autopilot->stop();
+			break;
+		}
+
+		autopilot->step(player, mine);
+
+		if(check_game_over(outcome))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool Sim_Game::search_tip(game_outcome &outcome)
+{
+	int left = player->get_tip_x();
+	int top = player->get_tip_y();
+	int right = left + player->get_tip_width() - 1;
+	int bottom = top + player->get_tip_height() - 1;
+
+	// The area may hang over the edge of the mine.
+	if(left < 1)
+	{
+		left = 1;
+	}
+
+	if(top < 0)
+	{
+		top = 0;
+	}
+
+	if(right > mine->get_map_x() - 1)
+	{
+		right = mine->get_map_x() - 1;
+	}
+
+	if(bottom > mine->get_map_y() - 1)
+	{
+		bottom = mine->get_map_y() - 1;
+	}
+
+	while(!player->get_has_diamond() && player->get_health() > 40)
+	{
+		int reserve = DIGGING_RESERVE + get_way_back_cost();
+
+		if(player->get_money() <= reserve)
+		{
+			return false;
+		}
+
+		int here_x = player->get_location_x();
+		int here_y = player->get_location_y();
+		int best_distance = -1;
+		int best_x = 0;
+		int best_y = 0;
+
+		for(int y = top; y <= bottom; y++)
+		{
+			for(int x = left; x <= right; x++)
+			{
+				int distance = abs(x - here_x) + abs(y - here_y);
+
+				if(!mine->get_explored(x, y) && (best_distance < 0 || distance < best_distance))
+				{
+					best_distance = distance;
+					best_x = x;
+					best_y = y;
+				}
+			}
+		}
+
+		if(best_distance < 0 || !autopilot->set_target(player, mine, best_x, best_y, 1, 1))
+		{
+			return false;
+		}
+
+		if(follow_autopilot(outcome, reserve))
+		{
+			return true;
+		}
+
+		// Out of money on the way, or there's no getting to it.
+		if(!mine->get_explored(best_x, best_y))
+		{
+			return false;
+		}
+	}
+
+	return false;
+}
+
+// Digging back through a cave-in costs money, so the scripted player
+// keeps enough to redig the whole trail. The heuristic player prices the
+// autopilot's way back, which is mostly through tunnels already dug.
+int Sim_Game::get_way_back_cost()
+{
+	if(settings->strategy == STRATEGY_SCRIPTED)
+	{
+		return DIG_COST * (int)trail_x.size();
+	}
+
+	// With no way back known, the trail is retraced.
+	if(!autopilot->head_for_elevator(player, mine))
+	{
+		return DIG_COST * (int)trail_x.size();
+	}
+
+	int cost = autopilot->get_route_cost();
+	autopilot->stop();
+
+	return cost;
+}
+
+// The heuristic player saves for the tip, then once the diamond is
+// found, for Mimi, so the store doesn't eat what a win needs.
+int Sim_Game::get_shopping_reserve()
+{
+	if(settings->strategy == STRATEGY_HEURISTIC)
+	{
+		if(player->get_has_diamond())
+		{
+			return MIMI_MONEY;
+		}
+
+		if(!knows_diamond)
+		{
+			return TIP_SAVINGS;
+		}
+	}
+
+	return SHOPPING_RESERVE;
+}
+
+void Sim_Game::visit_town()
+{
+	// The bank.
+	randomize_mineral_values(player);
+	sell_all_minerals(player);
+
+	// The hospital, a day at a time, keeping enough to go down again.
+	while(player->get_health() < 100 && player->get_money() - HOSPITAL_DAY_PRICE >= DIGGING_RESERVE)
+	{
+		stay_one_day(player);
+	}
+
+	// The store. The shovel and the hardhat pay for themselves, in digging
+	// and in the hospital; the rest only once there's money to spare.
+	const store_item needed[2] = { ITEM_SHOVEL, ITEM_HARDHAT };
+
+	for(int item = 0; item < 2; item++)
+	{
+		if(player->get_money() >= get_item_price(needed[item]) + DIGGING_RESERVE)
+		{
+			buy_item(player, needed[item]);
+		}
+	}
+
+	const store_item wanted[2] = { ITEM_BUCKET, ITEM_AXE };
+	int reserve = get_shopping_reserve();
+
+	for(int item = 0; item < 2; item++)
+	{
+		if(player->get_money() - get_item_price(wanted[item]) >= reserve)
+		{
+			buy_item(player, wanted[item]);
+		}
+	}
+
+	if(player->get_money() - INSURANCE_PRICE >= reserve && !player->get_has_insurance())
+	{
+		buy_insurance(player);
+	}
+
+	// The tavern.
+	if(settings->strategy == STRATEGY_HEURISTIC && !knows_diamond && !player->get_has_diamond()
+		&& player->get_money() >= TIP_SAVINGS)
+	{
+		if(buy_tip(player, HEURISTIC_TIP))
+		{
+			make_tip_region(player, mine, HEURISTIC_TIP);
+
+			knows_diamond = true;
+			target_y = player->get_tip_y() + player->get_tip_height() / 2;
+		}
+	}
+}
+
+// Go down, dig, and come back up. Returns true if the game ended.
+bool Sim_Game::mine_trip(game_outcome &outcome)
+{
+	trip_number++;
+
+	// Restore the player to the origin of the mine.
+	player->change_location(0, 0, mine);
+
+	// Pick a level and ride the elevator down to it.
+	int level;
+
+	if(knows_diamond)
+	{
+		// Try a nearby level if the diamond's own level was blocked last time.
+		level = target_y;
+
+		if(!last_trip_moved)
+		{
+			level += choices.next_int(21) - 10;
+		}
+
+		if(level < 0)
+		{
+			level = 0;
+		}
+		else if(level > mine->get_map_y() - 1)
+		{
+			level = mine->get_map_y() - 1;
+		}
+	}
+	else if(settings->strategy == STRATEGY_SCRIPTED)
+	{
+		level = (trip_number * 3) % (mine->get_map_y() - 1);
+	}
+	else
+	{
+		level = choices.next_int(mine->get_map_y() / 2);
+	}
+
+	// The elevator charges for every level down.
+	if(level > player->get_money() - DIGGING_RESERVE)
+	{
+		level = player->get_money() - DIGGING_RESERVE;
+	}
+
+	while(player->get_location_y() < level)
+	{
+		if(!step(0, player->get_location_y() + 1))
+		{
+			break;
+		}
+
+		if(check_game_over(outcome))
+		{
+			return true;
+		}
+	}
+
+	// Dig out from the elevator.
+	trail_x.clear();
+	trail_y.clear();
+	trail_x.push_back(player->get_location_x());
+	trail_y.push_back(player->get_location_y());
+
+	int trip_steps = 0;
+	int stuck = 0;
+
+	// Once the tip is known, let the autopilot dig through its area.
+	// Whatever money is left afterwards goes on prospecting.
+	if(knows_diamond)
+	{
+		if(search_tip(outcome))
+		{
+			return true;
+		}
+
+		trail_x.push_back(player->get_location_x());
+		trail_y.push_back(player->get_location_y());
+
+		if(player->get_has_diamond())
+		{
+			knows_diamond = false;
+		}
+	}
+
+	int way_back_cost = 0;
+
+	while(player->get_health() > 40 && stuck < 8)
+	{
+		// Pricing the way back can take a search, so it's done every few steps.
+		if(trip_steps % WAY_BACK_CHECK_STEPS == 0)
+		{
+			way_back_cost = get_way_back_cost();
+		}
+
+		if(player->get_money() <= DIGGING_RESERVE + way_back_cost)
+		{
+			break;
+		}
+
+		int x, y;
+
+		if(!choose_step(trip_steps, x, y))
+		{
+			break;
+		}
+
+		if(step(x, y))
+		{
+			trail_x.push_back(x);
+			trail_y.push_back(y);
+			stuck = 0;
+		}
+		else
+		{
+			stuck++;
+		}
+
+		trip_steps++;
+
+		if(check_game_over(outcome))
+		{
+			return true;
+		}
+	}
+
+	last_trip_moved = trail_x.size() > 1;
+
+	// The autopilot knows the cheapest way back; the trail is kept in
+	// case it can't find one.
+	if(settings->strategy == STRATEGY_HEURISTIC && player->get_location_x() != 0)
+	{
+		if(autopilot->head_for_elevator(player, mine))
+		{
+			if(follow_autopilot(outcome))
+			{
+				return true;
+			}
+		}
+
+		if(player->get_location_x() == 0)
+		{
+			trail_x.resize(1);
+			trail_y.resize(1);
+		}
+	}
+
+	// Retrace the trail back to the elevator. Water may have flowed
+	// over it since, so give up after a few failed tries.
+	int attempts = 0;
+
+	while(trail_x.size() > 1 && attempts < 4)
+	{
+		int back_x = trail_x[trail_x.size() - 2];
+		int back_y = trail_y[trail_y.size() - 2];
+
+		if(step(back_x, back_y))
+		{
+			trail_x.pop_back();
+			trail_y.pop_back();
+			attempts = 0;
+		}
+		else
+		{
+			attempts++;
+		}
+
+		if(check_game_over(outcome))
+		{
+			return true;
+		}
+	}
+
+	if(player->get_location_x() != 0)
+	{
+		outcome = OUTCOME_STRANDED;
+		return true;
+	}
+
+	// Ride back up and leave.
+	move_elevator_to_top(mine, player);
+	player->change_location(0, -1, mine);
+
+	return check_game_over(outcome);
+}
+
+game_outcome Sim_Game::play()
+{
+	game_outcome outcome = OUTCOME_TIMED_OUT;
+
+	// Each trip takes at least one turn unless the player is stuck, so
+	// this only stops a player who can no longer move at all.
+	for(int trips = 0; trips < settings->max_turns; trips++)
+	{
+		visit_town();
+
+		if(can_win_game(player))
+		{
+			return OUTCOME_WON;
+		}
+
+		// Nothing left to dig with is as much a loss as debt.
+		if(player->get_money() <= DIGGING_RESERVE)
+		{
+			return OUTCOME_BROKE;
+		}
+
+		if(mine_trip(outcome))
+		{
+			return outcome;
+		}
+	}
+
+	return OUTCOME_TIMED_OUT;
+}
+
+// Print a line of the outcome table.
+static void print_outcome(const char *name, long long count, long long games)
+{
+	printf("  %-10s %10lld  %6.2f%%\n", name, count, games > 0 ? (100.0 * count / games) : 0.0);
+}
+
+static void print_usage()
+{
+	printf("Usage: simulator [--games N] [--threads N] [--seed N] [--max-turns N]\n");
+	printf("                 [--strategy scripted|heuristic] [--record FILE]\n");
+}
+
+int main(int argc, char *argv[])
+{
+	Sim_Settings settings;
+	settings.games = 10000;
+	settings.threads = 0;
+	settings.first_seed = 1;
+	settings.max_turns = 5000;
+	settings.strategy = STRATEGY_HEURISTIC;
+	settings.record_path = NULL;
+
+	for(int arg = 1; arg < argc; arg++)
+	{
+		bool has_value = arg + 1 < argc;
+
+		if(strcmp(argv[arg], "--games") == 0 && has_value)
+		{
+			settings.games = atoll(argv[++arg]);
+		}
+		else if(strcmp(argv[arg], "--threads") == 0 && has_value)
+		{
+			settings.threads = atoi(argv[++arg]);
+		}
+		else if(strcmp(argv[arg], "--seed") == 0 && has_value)
+		{
+			settings.first_seed = strtoul(argv[++arg], NULL, 10);
+		}
+		else if(strcmp(argv[arg], "--max-turns") == 0 && has_value)
+		{
+			settings.max_turns = atoi(argv[++arg]);
+		}
+		else if(strcmp(argv[arg], "--record") == 0 && has_value)
+		{
+			settings.record_path = argv[++arg];
+		}
+		else if(strcmp(argv[arg], "--strategy") == 0 && has_value)
+		{
+			arg++;
+
+			if(strcmp(argv[arg], "scripted") == 0)
+			{
+				settings.strategy = STRATEGY_SCRIPTED;
+			}
+			else if(strcmp(argv[arg], "heuristic") == 0)
+			{
+				settings.strategy = STRATEGY_HEURISTIC;
+			}
+			else
+			{
+				print_usage();
+				return 1;
+			}
+		}
+		else
+		{
+			print_usage();
+			return 1;
+		}
+	}
+
+	Thread_Pool pool(settings.threads);
+
+	std::vector<Sim_Totals> totals(pool.get_thread_count());
+
+	for(int worker = 0; worker < pool.get_thread_count(); worker++)
+	{
+		totals[worker].clear();
+	}
+
+	// One autopilot, player and mine per worker, reused for every game
+	// it plays. The mines are too big for a worker's stack to hold
+	// comfortably.
+	std::vector<Autopilot *> autopilots(pool.get_thread_count());
+	std::vector<PlayerData *> players(pool.get_thread_count());
+	std::vector<MineData *> mines(pool.get_thread_count());
+
+	for(int worker = 0; worker < pool.get_thread_count(); worker++)
+	{
+		autopilots[worker] = new Autopilot;
+		players[worker] = new PlayerData;
+		mines[worker] = new MineData;
+	}
+
+	int task_count = (int)((settings.games + GAMES_PER_TASK - 1) / GAMES_PER_TASK);
+
+	// Only the first game is recorded, so only one task touches this.
+	Game_Recorder recorder;
+
+	long long start_time = Timer::get_ticks_ns();
+
+	pool.run(task_count, [&](int task, int worker)
+	{
+		Sim_Totals &worker_totals = totals[worker];
+
+		long long first_game = (long long)task * GAMES_PER_TASK;
+		long long last_game = first_game + GAMES_PER_TASK;
+
+		if(last_game > settings.games)
+		{
+			last_game = settings.games;
+		}
+
+		for(long long game = first_game; game < last_game; game++)
+		{
+			unsigned int seed = settings.first_seed + (unsigned int)game;
+
+			PlayerData &player = *players[worker];
+			MineData *mine = mines[worker];
+			player.reset(seed);
+			mine->reset(seed);
+
+			if(game == 0 && settings.record_path != NULL)
+			{
+				player.set_recorder(&recorder);
+				recorder.start(player.get_seed(), mine->get_seed());
+			}
+			else
+			{
+				player.set_recorder(NULL);
+			}
+
+			Sim_Game sim_game(&player, mine, &settings, autopilots[worker], seed);
+			game_outcome outcome = sim_game.play();
+
+			worker_totals.games++;
+			worker_totals.outcomes[outcome]++;
+			worker_totals.money_total += player.get_money();
+			worker_totals.turns_total += player.get_turn_number();
+			worker_totals.money.add(player.get_money());
+			worker_totals.turns.add(player.get_turn_number());
+
+			if(player.get_has_diamond())
+			{
+				worker_totals.diamonds_found++;
+			}
+		}
+	});
+
+	long long elapsed = Timer::get_ticks_ns() - start_time;
+
+	if(settings.record_path != NULL && !recorder.save(settings.record_path))
+	{
+		printf("Unable to write the recording to %s\n", settings.record_path);
+	}
+
+	for(int worker = 0; worker < pool.get_thread_count(); worker++)
+	{
+		delete autopilots[worker];
+		delete players[worker];
+		delete mines[worker];
+	}
+
+	Sim_Totals all;
+	all.clear();
+
+	for(int worker = 0; worker < pool.get_thread_count(); worker++)
+	{
+		all.merge(totals[worker]);
+	}
+
+	double seconds = elapsed / 1000000000.0;
+
+	printf("%lld games, %s player, %d threads, seeds %u to %u\n", all.games,
+		   settings.strategy == STRATEGY_SCRIPTED ? "scripted" : "heuristic",
+		   pool.get_thread_count(), settings.first_seed,
+		   settings.first_seed + (unsigned int)(settings.games - 1));
+
+	printf("\nOutcomes:\n");
+	print_outcome("won", all.outcomes[OUTCOME_WON], all.games);
+	print_outcome("died", all.outcomes[OUTCOME_DIED], all.games);
+	print_outcome("broke", all.outcomes[OUTCOME_BROKE], all.games);
+	print_outcome("timed out", all.outcomes[OUTCOME_TIMED_OUT], all.games);
+	print_outcome("stranded", all.outcomes[OUTCOME_STRANDED], all.games);
+	print_outcome("diamond", all.diamonds_found, all.games);
+
+	if(all.games > 0)
+	{
+		printf("\nMoney at end:  mean %lld  p10 %d  p50 %d  p90 %d  (buckets of $%d)\n",
+			   all.money_total / all.games,
+			   all.money.get_percentile(10, all.games), all.money.get_percentile(50, all.games),
+			   all.money.get_percentile(90, all.games), MONEY_BUCKET_SIZE);
+
+		printf("Turns:         mean %lld  p10 %d  p50 %d  p90 %d  (buckets of %d)\n",
+			   all.turns_total / all.games,
+			   all.turns.get_percentile(10, all.games), all.turns.get_percentile(50, all.games),
+			   all.turns.get_percentile(90, all.games), TURN_BUCKET_SIZE);
+	}
+
+	printf("\n%.2f s, %.0f games/sec\n", seconds, seconds > 0 ? all.games / seconds : 0.0);
+
+	return 0;
+}
@@ -0,0 +1,237 @@
+/*
+ water_bench.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Benchmark for the water in the mine.
+
+ Floods mines that have been dug out, entirely or in rows of tunnels,
+ from a number of springs, and runs turns until the water stops.
+ Reports how many tiles of water moved each turn, the time per turn,
+ and for comparison the time just to look over every tile once, which
+ is what a turn would cost if the whole mine were scanned.
+
+ Usage:
+	water_bench [--springs N] [--seed N] [--repeats N]
+
+ Build (from the source directory):
+	g++ -std=c++11 -O2 -I. tools/water_bench.cpp classes.cpp game_events.cpp
+		game_random.cpp timer.cpp trace.cpp turn_scheduler.cpp game_recorder.cpp
+		economy.cpp game_rules.cpp market.cpp -lpthread -o water_bench
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "classes.h"
+#include "game_random.h"
+#include "timer.h"
+
+// How the mine is dug out before it's flooded.
+enum bench_layout
+{
+	LAYOUT_OPEN,		// Every tile dug out.
+	LAYOUT_TUNNELS,		// Every other row dug out, joined at alternate ends.
+	LAYOUT_COUNT
+};
+
+static const char *layout_names[LAYOUT_COUNT] = { "open", "tunnels" };
+
+static void dig_out(MineData *mine, bench_layout layout)
+{
+	for(int y = 0; y <= mine->get_map_y(); y++)
+	{
+		for(int x = 1; x <= mine->get_map_x(); x++)
+		{
+			bool open = true;
+
+			if(layout == LAYOUT_TUNNELS && y % 2 == 1)
+			{
+				// Join each tunnel to the next at alternate ends.
+				open = (y % 4 == 1) ? (x == mine->get_map_x()) : (x == 1);
+			}
+
+			if(open)
+			{
+				mine->set_contents(x, y, EXPLORED);
+				mine->set_explored(x, y, true);
+			}
+			else
+			{
+				mine->set_contents(x, y, GRANITE);
+				mine->set_explored(x, y, true);
+			}
+		}
+	}
+}
+
+static volatile int scan_result;
+
+// Time for one look over every tile, as a full scan of the mine would need.
+static double scan_ns(MineData *mine, int repeats)
+{
+	const volatile unsigned char *tiles = mine->get_tiles();
+	int water = 0;
+
+	long long start = Timer::get_ticks_ns();
+
+	for(int repeat = 0; repeat < repeats; repeat++)
+	{
+		for(int index = 0; index < MINE_TILES; index++)
+		{
+			if((tiles[index] & TILE_MATERIAL_MASK) == WATER)
+			{
+				water++;
+			}
+		}
+	}
+
+	long long elapsed = Timer::get_ticks_ns() - start;
+
+	// Keep the loop from being optimised away.
+	scan_result = water;
+
+	return (double)elapsed / repeats;
+}
+
+static void run(bench_layout layout, int springs, unsigned int seed, int repeats)
+{
+	long long total_ns = 0;
+	long long total_turns = 0;
+	long long total_moved = 0;
+	int most_moved = 0;
+	int flooded = 0;
+
+	for(int repeat = 0; repeat < repeats; repeat++)
+	{
+		MineData *mine = new MineData(seed + repeat);
+		dig_out(mine, layout);
+
+		Game_Random random;
+		random.seed(seed + repeat);
+
+		for(int spring = 0; spring < springs; spring++)
+		{
+			int x = WATER_MIN_X + random.next_int(mine->get_map_x() - WATER_MIN_X);
+			int y = random.next_int(mine->get_map_y());
+
+			if(mine->get_contents(x, y) == EXPLORED)
+			{
+				mine->set_contents(x, y, SPRING);
+				mine->water_flow(x, y);
+			}
+		}
+
+		long long start = Timer::get_ticks_ns();
+
+		while(mine->get_water_active() > 0)
+		{
+			int moved = mine->water_turn();
+
+			total_moved += moved;
+			total_turns++;
+
+			if(moved > most_moved)
+			{
+				most_moved = moved;
+			}
+		}
+
+		total_ns += Timer::get_ticks_ns() - start;
+
+		if(repeat == 0)
+		{
+			for(int y = 0; y <= mine->get_map_y(); y++)
+			{
+				for(int x = 0; x <= mine->get_map_x(); x++)
+				{
+					if(mine->get_contents(x, y) == WATER)
+					{
+						flooded++;
+					}
+				}
+			}
+
+			printf("%-8s %7d springs  %6d tiles flooded  full scan %8.1f us/turn\n",
+				   layout_names[layout], springs, flooded, scan_ns(mine, 20) / 1000.0);
+		}
+
+		delete mine;
+	}
+
+	double turns = total_turns > 0 ? (double)total_turns : 1.0;
+
+	printf("         %7.1f turns  %8.1f tiles moved/turn (most %d)  %8.2f us/turn  %6.1f ns/tile\n",
+		   turns / repeats, total_moved / turns, most_moved, total_ns / turns / 1000.0,
+		   total_moved > 0 ? (double)total_ns / total_moved : 0.0);
+}
+
+int main(int argc, char *argv[])
+{
+	int springs = 0;
+	unsigned int seed = 1;
+	int repeats = 10;
+
+	for(int arg = 1; arg < argc; arg++)
+	{
+		bool has_value = arg + 1 < argc;
+
+		if(strcmp(argv[arg], "--springs") == 0 && has_value)
+		{
+			springs = atoi(argv[++arg]);
+		}
+		else if(strcmp(argv[arg], "--seed") == 0 && has_value)
+		{
+			seed = strtoul(argv[++arg], NULL, 10);
+		}
+		else if(strcmp(argv[arg], "--repeats") == 0 && has_value)
+		{
+			repeats = atoi(argv[++arg]);
+		}
+		else
+		{
+			printf("Usage: water_bench [--springs N] [--seed N] [--repeats N]\n");
+			return 1;
+		}
+	}
+
+	if(repeats < 1)
+	{
+		repeats = 1;
+	}
+
+	// Without a count, try a range from a single spring to a mine riddled with them.
+	const int spring_counts[4] = { 1, 16, 256, 4096 };
+
+	for(int layout = 0; layout < LAYOUT_COUNT; layout++)
+	{
+		if(springs > 0)
+		{
+			run((bench_layout)layout, springs, seed, repeats);
+		}
+		else
+		{
+			for(int count = 0; count < 4; count++)
+			{
+				run((bench_layout)layout, spring_counts[count], seed, repeats);
+			}
+		}
+	}
+
+	return 0;
+}
@@ -35,6 +35,7 @@
 #include "town_functions.h"
 #include "classes.h"
 #include "timer.h"
+#include "trace.h"
 
 // Files for the different stores and mine.
 #include "bank_functions.h"
@@ -44,9 +45,46 @@
 #include "tavern.h"
 #include "popup_menu.h"
 
+// The graphics of where each of the town's buttons leads, top to bottom.
+static const char *const TOWN_DESTINATION_GRAPHICS[] =
+{
+	"graphics/bank/",
+	"graphics/tavern/",
+	"graphics/hospital/",
+	"graphics/store/",
+	"graphics/mine/map/"
+};
+
+static const int TOWN_DESTINATIONS = 5;
+
+// Have the graphics of the buildings preloaded, the one the arrow is
+// on first, so going into one doesn't wait for them to load.
+static void preload_destinations(Selection_Arrow *selection)
+{
+	Asset_Preloader *preloader = get_asset_preloader();
+	
+	preloader->preload_directory(TOWN_DESTINATION_GRAPHICS[selection->return_vert()], PRELOAD_NEXT);
+	
+	for(int destination = 0; destination < TOWN_DESTINATIONS; destination++)
+	{
+		preloader->preload_directory(TOWN_DESTINATION_GRAPHICS[destination], PRELOAD_LIKELY);
+	}
+	
+	preloader->preload_directory("graphics/popup_menu/", PRELOAD_IDLE);
+	preloader->preload_directory("graphics/ending_screen/", PRELOAD_IDLE);
+	preloader->preload_directory("graphics/high_score/", PRELOAD_IDLE);
+}
+
 // Loads and displays the screen for the main town.
 void main_town(PlayerData *player, MineData *mine, SDL_Objects *sdl)
 {
+	Trace_Zone zone("main_town", TRACE_SCREEN);
+	
+	// The HUD and the mine's graphics, preloaded while the start screen
+	// was shown.
+	sdl->load_graphics();
+	sdl->clear_screen();
+
 	// Initialize the objects within the town.
 	Town_Objects town;
 		
@@ -54,6 +92,8 @@ void main_town(PlayerData *player, MineData *mine, SDL_Objects *sdl)
 	Selection_Arrow selection(1, 5, 0, 64);		// Initializes the arrow object with six places to go up/down.
 	selection.set_arrow_initial(512, 0);
 	
+	preload_destinations(&selection);
+	
 	// Initialize an event to track the user's input
 	SDL_Event user_input;
 	
@@ -94,6 +134,7 @@ void main_town(PlayerData *player, MineData *mine, SDL_Objects *sdl)
 			if(selection.move_down())
 			{
 				town.animate_arrow_down(sdl, &selection);
+				preload_destinations(&selection);
 			}
 			update_screen = true;
 		}
@@ -102,6 +143,7 @@ void main_town(PlayerData *player, MineData *mine, SDL_Objects *sdl)
 			if(selection.move_up())
 			{
 				town.animate_arrow_up(sdl, &selection);
+				preload_destinations(&selection);
 			}
 			update_screen = true;
 		}
@@ -161,8 +203,10 @@ void main_town(PlayerData *player, MineData *mine, SDL_Objects *sdl)
 				mine_function(player, sdl, mine);
 				
 				// Only refresh the screen if the player isn't quitting.
+				// The mine's view filled the window around the town.
 				if(!sdl->return_quitSDL() && !sdl->return_quit_to_menu())
 				{ 
+					sdl->clear_screen();
 					town.update_town_graphics(sdl, &selection);
 					SDL_Flip(sdl->return_screen());
 				}
@@ -187,7 +231,7 @@ void main_town(PlayerData *player, MineData *mine, SDL_Objects *sdl)
 		{	
 			// Apply the graphics on screen and update them.
 			town.update_town_graphics(sdl, &selection);	
-			SDL_UpdateRect(sdl->return_screen(), 500, 0, 70, 380);
+			sdl->update_rect(500, 0, 70, 380);
 		}
 		
 		SDL_Delay(sdl->SDL_WAIT);
@@ -197,17 +241,17 @@ void main_town(PlayerData *player, MineData *mine, SDL_Objects *sdl)
 
 Town_Objects::Town_Objects()
 {
-	town_graphic = IMG_Load("./Graphics/town/town.png");
+	town_graphic = load_image("graphics/town/town.png");
 	
-	bank_graphic = IMG_Load("./Graphics/town/bank_button.png");
-	tavern_graphic = IMG_Load("./Graphics/town/bar_button.png");
-	hospital_graphic = IMG_Load("./Graphics/town/hospital_button.png");
-	store_graphic = IMG_Load("./Graphics/town/store_button.png");
-	mine_graphic = IMG_Load("./Graphics/town/mine_button.png");
+	bank_graphic = load_image("graphics/town/bank_button.png");
+	tavern_graphic = load_image("graphics/town/bar_button.png");
+	hospital_graphic = load_image("graphics/town/hospital_button.png");
+	store_graphic = load_image("graphics/town/store_button.png");
+	mine_graphic = load_image("graphics/town/mine_button.png");
 	
-	arrow_graphic = IMG_Load("./Graphics/town/arrow.png");
+	arrow_graphic = load_image("graphics/town/arrow.png");
 
-	display_font = TTF_OpenFont("./Fonts/DejaVuSans-Bold.ttf", 28);
+	display_font = open_font("Fonts/DejaVuSans-Bold.ttf", 28);
 }
 
 Town_Objects::~Town_Objects()
@@ -255,7 +299,7 @@ void Town_Objects::animate_arrow_down(SDL_Objects *sdl, Selection_Arrow *selecti
         sdl->apply_surface(576, 256, mine_graphic, sdl->return_screen());
         
 		sdl->apply_surface(selection->return_arrow_x(), temp, arrow_graphic, sdl->return_screen());
-		SDL_UpdateRect(sdl->return_screen(), 500, 0, 70, 380);
+		sdl->update_rect(500, 0, 70, 380);
 		SDL_Delay(sdl->MENU_ANIMATION_WAIT);
 	}
 }
@@ -277,7 +321,7 @@ void Town_Objects::animate_arrow_up(SDL_Objects *sdl, Selection_Arrow *selection
         sdl->apply_surface(576, 256, mine_graphic, sdl->return_screen());
         
 		sdl->apply_surface(selection->return_arrow_x(), temp, arrow_graphic, sdl->return_screen());
-		SDL_UpdateRect(sdl->return_screen(), 500, 0, 70, 380);
+		sdl->update_rect(500, 0, 70, 380);
 		SDL_Delay(sdl->MENU_ANIMATION_WAIT);
 	}
 }
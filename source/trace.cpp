@@ -0,0 +1,172 @@
+/*
+ trace.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Session trace recorder.
+
+ Writes scoped zones to a file in the Chrome trace_event JSON format,
+ which can be opened in chrome://tracing or Perfetto. Recording is
+ started with the --trace <file> command line option.
+*/
+
+#include <thread>
+#include <functional>	// For std::hash of the thread id.
+
+#include "trace.h"
+#include "timer.h"
+
+Trace_Recorder::Trace_Recorder()
+{
+	origin_time = 0;
+	active = false;
+	first_event = true;
+}
+
+Trace_Recorder::~Trace_Recorder()
+{
+	stop();
+}
+
+// Start recording to a file.
+bool Trace_Recorder::start(const char *filename)
+{
+	std::lock_guard<std::mutex> lock(trace_mutex);
+
+	trace_out.open(filename, std::ios::binary);
+
+	if(!trace_out)
+	{
+		return false;
+	}
+
+	trace_out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	origin_time = Timer::get_ticks_ns();
+	first_event = true;
+	active = true;
+
+	return true;
+}
+
+// Finish the JSON and close the file.
+void Trace_Recorder::stop()
+{
+	std::lock_guard<std::mutex> lock(trace_mutex);
+
+	if(active)
+	{
+		trace_out << "\n]}\n";
+		trace_out.close();
+		active = false;
+	}
+}
+
+bool Trace_Recorder::is_active()
+{
+	return active;
+}
+
+// Writes the separator between events, along with the fields they share.
+void Trace_Recorder::begin_event()
+{
+	if(!first_event)
+	{
+		trace_out << ",";
+	}
+	first_event = false;
+
+	// Thread ids only need to be stable, not small.
+	unsigned int thread_id = (unsigned int)std::hash<std::thread::id>()(std::this_thread::get_id());
+
+	trace_out << "\n{\"pid\":1,\"tid\":" << thread_id;
+}
+
+// Record a complete ('X') zone.
+void Trace_Recorder::add_zone(const char *name, const char *category, long long start_ns, long long end_ns)
+{
+	if(!active)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(trace_mutex);
+
+	if(!active)
+	{
+		return;
+	}
+
+	begin_event();
+
+	// The viewer expects microseconds. Keep the fraction so short zones aren't lost.
+	trace_out << ",\"ph\":\"X\",\"name\":\"" << name << "\",\"cat\":\"" << category
+		<< "\",\"ts\":" << ((start_ns - origin_time) / 1000.0)
+		<< ",\"dur\":" << ((end_ns - start_ns) / 1000.0) << "}";
+}
+
+// Record a histogram's statistics as an instant ('i') event.
+void Trace_Recorder::add_histogram(const char *name, const char *category, Timer_Histogram *histogram)
+{
+	if(!active)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(trace_mutex);
+
+	if(!active)
+	{
+		return;
+	}
+
+	begin_event();
+
+	trace_out << ",\"ph\":\"i\",\"s\":\"p\",\"name\":\"" << name << "\",\"cat\":\"" << category
+		<< "\",\"ts\":" << ((Timer::get_ticks_ns() - origin_time) / 1000.0)
+		<< ",\"args\":{\"count\":" << histogram->get_count()
+		<< ",\"min_us\":" << (histogram->get_min() / 1000.0)
+		<< ",\"mean_us\":" << (histogram->get_mean() / 1000.0)
+		<< ",\"p50_us\":" << (histogram->get_percentile(50) / 1000.0)
+		<< ",\"p99_us\":" << (histogram->get_percentile(99) / 1000.0)
+		<< ",\"max_us\":" << (histogram->get_max() / 1000.0) << "}}";
+}
+
+// Returns the recorder shared by the whole program.
+Trace_Recorder *get_trace_recorder()
+{
+	static Trace_Recorder recorder;
+
+	return &recorder;
+}
+
+Trace_Zone::Trace_Zone(const char *name, const char *category)
+{
+	this->name = name;
+	this->category = category;
+
+	// Skip reading the clock when nothing is being recorded.
+	start_time = get_trace_recorder()->is_active() ? Timer::get_ticks_ns() : 0;
+}
+
+Trace_Zone::~Trace_Zone()
+{
+	if(start_time != 0)
+	{
+		get_trace_recorder()->add_zone(name, category, start_time, Timer::get_ticks_ns());
+	}
+}
@@ -0,0 +1,93 @@
+/*
+ trace.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Session trace recorder.
+
+ Writes scoped zones to a file in the Chrome trace_event JSON format,
+ which can be opened in chrome://tracing or Perfetto. Recording is
+ started with the --trace <file> command line option.
+*/
+
+#ifndef TRACE_RECORDER
+#define TRACE_RECORDER
+
+#include <fstream>
+#include <mutex>
+#include <atomic>
+
+class Timer_Histogram;
+
+// Categories used for the zones, shown as 'cat' in the trace viewer.
+#define TRACE_SCREEN "screen"
+#define TRACE_LOGIC "logic"
+#define TRACE_IO "io"
+
+class Trace_Recorder
+{
+	private:
+		std::ofstream trace_out;
+
+		// Time the recording started. Zones are written relative to this.
+		long long origin_time;
+
+		std::atomic<bool> active;
+		bool first_event;
+
+		// Zones may be closed from more than one thread.
+		std::mutex trace_mutex;
+
+		// Writes the separator between events.
+		void begin_event();
+
+	public:
+		Trace_Recorder();
+		~Trace_Recorder();
+
+		// Start recording to a file. Returns false if it can't be opened.
+		bool start(const char *filename);
+
+		// Finish the JSON and close the file.
+		void stop();
+
+		bool is_active();
+
+		// Record a complete zone. Times are from Timer::get_ticks_ns().
+		void add_zone(const char *name, const char *category, long long start_ns, long long end_ns);
+
+		// Record a histogram's statistics as an instant event.
+		void add_histogram(const char *name, const char *category, Timer_Histogram *histogram);
+};
+
+// Returns the recorder shared by the whole program.
+Trace_Recorder *get_trace_recorder();
+
+// Records the enclosing scope as a zone when tracing is active.
+class Trace_Zone
+{
+	private:
+		const char *name;
+		const char *category;
+		long long start_time;
+
+	public:
+		Trace_Zone(const char *name, const char *category);
+		~Trace_Zone();
+};
+
+#endif
@@ -0,0 +1,224 @@
+/*
+ turn_scheduler.cpp
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Things set to happen on a later turn, kept in a hashed timer wheel.
+*/
+
+#include "turn_scheduler.h"
+
+Turn_Scheduler::Turn_Scheduler()
+{
+	clear(0);
+}
+
+// Drop every effect and start counting from a turn.
+void Turn_Scheduler::clear(int turn)
+{
+	for(int effect = 0; effect < SCHEDULER_CAPACITY; effect++)
+	{
+		effects[effect].type = EFFECT_NONE;
+		effects[effect].next = effect + 1;
+	}
+
+	effects[SCHEDULER_CAPACITY - 1].next = -1;
+	free_list = 0;
+	pending = 0;
+
+	for(int slot = 0; slot < SCHEDULER_SLOTS; slot++)
+	{
+		slot_head[slot] = -1;
+		slot_tail[slot] = -1;
+	}
+
+	due_head = -1;
+	due_tail = -1;
+
+	next_turn = turn;
+}
+
+// Add an effect to the end of a list.
+void Turn_Scheduler::append(int &head, int &tail, int effect)
+{
+	effects[effect].next = -1;
+
+	if(tail == -1)
+	{
+		head = effect;
+	}
+	else
+	{
+		effects[tail].next = effect;
+	}
+
+	tail = effect;
+}
+
+// Put an effect back in the pool.
+void Turn_Scheduler::release(int effect)
+{
+	effects[effect].type = EFFECT_NONE;
+	effects[effect].next = free_list;
+	free_list = effect;
+	pending--;
+}
+
+// Have an effect happen on a turn.
+bool Turn_Scheduler::schedule(int turn, scheduled_effect type, int x, int y)
+{
+	if(free_list == -1)
+	{
+		return false;
+	}
+
+	int effect = free_list;
+	free_list = effects[effect].next;
+	pending++;
+
+	effects[effect].turn = turn;
+	effects[effect].type = type;
+	effects[effect].x = x;
+	effects[effect].y = y;
+
+	if(turn < next_turn)
+	{
+		// Its slot has already been looked at.
+		append(due_head, due_tail, effect);
+	}
+	else
+	{
+		int slot = turn & (SCHEDULER_SLOTS - 1);
+		append(slot_head[slot], slot_tail[slot], effect);
+	}
+
+	return true;
+}
+
+// Remove waiting effects of a type at x, y. This looks through every
+// slot, but is only needed when a blast sets off another charge early.
+int Turn_Scheduler::cancel(scheduled_effect type, int x, int y)
+{
+	int removed = 0;
+
+	for(int list = 0; list <= SCHEDULER_SLOTS; list++)
+	{
+		int &head = (list < SCHEDULER_SLOTS) ? slot_head[list] : due_head;
+		int &tail = (list < SCHEDULER_SLOTS) ? slot_tail[list] : due_tail;
+
+		int previous = -1;
+		int effect = head;
+
+		while(effect != -1)
+		{
+			int next = effects[effect].next;
+
+			if(effects[effect].type == type && effects[effect].x == x && effects[effect].y == y)
+			{
+				if(previous == -1)
+				{
+					head = next;
+				}
+				else
+				{
+					effects[previous].next = next;
+				}
+
+				if(tail == effect)
+				{
+					tail = previous;
+				}
+
+				release(effect);
+				removed++;
+			}
+			else
+			{
+				previous = effect;
+			}
+
+			effect = next;
+		}
+	}
+
+	return removed;
+}
+
+// Take the next effect due on or before a turn.
+bool Turn_Scheduler::next_due(int turn, Scheduled_Effect &effect)
+{
+	while(due_head == -1 && next_turn <= turn)
+	{
+		if(pending == 0)
+		{
+			// Nothing to find in the slots in between.
+			next_turn = turn + 1;
+			break;
+		}
+
+		int slot = next_turn & (SCHEDULER_SLOTS - 1);
+
+		// Move what's due this turn to the due list, leaving effects for
+		// later times round the wheel where they are.
+		int waiting = slot_head[slot];
+		slot_head[slot] = -1;
+		slot_tail[slot] = -1;
+
+		while(waiting != -1)
+		{
+			int next = effects[waiting].next;
+
+			if(effects[waiting].turn <= next_turn)
+			{
+				append(due_head, due_tail, waiting);
+			}
+			else
+			{
+				append(slot_head[slot], slot_tail[slot], waiting);
+			}
+
+			waiting = next;
+		}
+
+		next_turn++;
+	}
+
+	if(due_head == -1)
+	{
+		return false;
+	}
+
+	int first = due_head;
+
+	due_head = effects[first].next;
+
+	if(due_head == -1)
+	{
+		due_tail = -1;
+	}
+
+	effect = effects[first];
+	effect.next = -1;
+	release(first);
+
+	return true;
+}
+
+int Turn_Scheduler::get_pending()
+{
+	return pending;
+}
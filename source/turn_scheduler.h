@@ -0,0 +1,107 @@
+/*
+ turn_scheduler.h
+ ---------------------------------------
+ This file is a part of MinerSDL.
+ MinerSDL is Copyright Kyle Poole, 2011.
+ ---------------------------------------
+ MinerSDL is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ MinerSDL is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with MinerSDL.  If not, see <http://www.gnu.org/licenses/>.
+ ---------------------------------------
+ Things set to happen on a later turn: lit dynamite, insurance
+ running out.
+
+ Effects are kept in a hashed timer wheel: one list per slot, and an
+ effect goes in the slot for its turn modulo the number of slots.
+ Scheduling appends to a list and each turn only looks at its own
+ slot, so neither depends on how many effects are waiting. Effects
+ more than a wheel's turn away just stay in their slot until their
+ turn comes round.
+
+ Effects come from a fixed pool in the object, so scheduling never
+ allocates. What an effect does is up to the rules (game_rules.cpp);
+ a new kind of timed hazard only needs a type here and a case there.
+*/
+
+#ifndef TURN_SCHEDULER
+#define TURN_SCHEDULER
+
+// Number of slots in the wheel. A power of two so the slot is a mask.
+const int SCHEDULER_SLOTS = 64;
+
+// Most effects that can be waiting at once.
+const int SCHEDULER_CAPACITY = 256;
+
+enum scheduled_effect
+{
+	EFFECT_NONE,
+	EFFECT_DYNAMITE,			// A charge at x, y goes off.
+	EFFECT_INSURANCE_EXPIRY		// The player's insurance may have run out.
+};
+
+struct Scheduled_Effect
+{
+	int turn;
+	scheduled_effect type;
+	int x;
+	int y;
+
+	int next;		// Next effect in the same slot, or -1.
+};
+
+class Turn_Scheduler
+{
+	private:
+		Scheduled_Effect effects[SCHEDULER_CAPACITY];
+		int free_list;		// Unused effects, linked through next.
+		int pending;
+
+		// First and last effect in each slot, -1 if it's empty.
+		int slot_head[SCHEDULER_SLOTS];
+		int slot_tail[SCHEDULER_SLOTS];
+
+		// Effects that have come due but haven't been handed out yet,
+		// in the order they were scheduled.
+		int due_head;
+		int due_tail;
+
+		// The next turn whose slot hasn't been looked at.
+		int next_turn;
+
+		void append(int &head, int &tail, int effect);
+		void release(int effect);
+
+	public:
+		Turn_Scheduler();
+
+		// Drop every effect and start counting from a turn, for a new
+		// or loaded game.
+		void clear(int turn);
+
+		// Have an effect happen on a turn. A turn that has already
+		// passed happens on the next call to next_due.
+		// Returns false if too many effects are waiting.
+		bool schedule(int turn, scheduled_effect type, int x, int y);
+
+		// Remove waiting effects of a type at x, y.
+		// Returns how many were removed.
+		int cancel(scheduled_effect type, int x, int y);
+
+		// Take the next effect due on or before a turn.
+		// Returns false once there are none left.
+		bool next_due(int turn, Scheduled_Effect &effect);
+
+		// Effects still waiting, due or not.
+		int get_pending();
+};
+
+#endif